@@ -0,0 +1,106 @@
+/**
+ * Copyright 2015 JiKai. All rights reserved.
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file.
+ **/
+
+#include "arena.h"
+
+void arenaInitAt(Arena* arena, size_t block_size, const char* owner) {
+    arena->cur        = NULL;
+    arena->spare      = NULL;
+    arena->block_size = block_size > 0 ? block_size : ARENA_BLOCK_SIZE;
+    arena->reserved   = 0;
+    arena->allocated  = 0;
+    arena->owner      = owner;
+}
+
+static ArenaBlock* arenaNewBlock(Arena* arena, size_t size) {
+    ArenaBlock* block;
+    if (size <= arena->block_size && arena->spare != NULL) {
+        block = arena->spare;
+        arena->spare = NULL;
+    }
+    else {
+        size  = size > arena->block_size ? size : arena->block_size;
+#ifdef CPLUS_MEM_STATS
+        block = (ArenaBlock*)memStatsAlloc(sizeof(ArenaBlock) + size, arena->owner);
+#else
+        block = (ArenaBlock*)mem_alloc(sizeof(ArenaBlock) + size);
+#endif
+        block->size      = size;
+        arena->reserved += sizeof(ArenaBlock) + size;
+    }
+    block->used = 0;
+    block->prev = arena->cur;
+    arena->cur  = block;
+    return block;
+}
+
+static void arenaFreeBlock(Arena* arena, ArenaBlock* block) {
+    if (arena->spare == NULL && block->size == arena->block_size) {
+        arena->spare = block;
+        return;
+    }
+    arena->reserved -= sizeof(ArenaBlock) + block->size;
+    mem_free(block);
+}
+
+void* arenaAlloc(Arena* arena, size_t size) {
+    ArenaBlock* block = arena->cur;
+    void*       ptr;
+    size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    if (block == NULL || block->used + size > block->size) {
+        block = arenaNewBlock(arena, size);
+    }
+    ptr = block->data + block->used;
+    block->used      += size;
+    arena->allocated += size;
+    return ptr;
+}
+
+void* arenaCalloc(Arena* arena, size_t size) {
+    void* ptr = arenaAlloc(arena, size);
+    memset(ptr, 0, size);
+    return ptr;
+}
+
+// copy the string with its length and add the '\0'.
+char* arenaStrdup(Arena* arena, const char* str, size_t len) {
+    char* copy = (char*)arenaAlloc(arena, len + 1);
+    memcpy(copy, str, len);
+    copy[len] = '\0';
+    return copy;
+}
+
+ArenaMark arenaMark(Arena* arena) {
+    ArenaMark mark;
+    mark.block     = arena->cur;
+    mark.used      = arena->cur != NULL ? arena->cur->used : 0;
+    mark.allocated = arena->allocated;
+    return mark;
+}
+
+void arenaRewind(Arena* arena, ArenaMark mark) {
+    ArenaBlock* block;
+    while ((block = arena->cur) != mark.block) {
+        arena->cur = block->prev;
+        arenaFreeBlock(arena, block);
+    }
+    if (arena->cur != NULL) {
+        arena->cur->used = mark.used;
+    }
+    arena->allocated = mark.allocated;
+}
+
+void arenaDestroy(Arena* arena) {
+    ArenaBlock* block;
+    while ((block = arena->cur) != NULL) {
+        arena->cur = block->prev;
+        mem_free(block);
+    }
+    mem_free(arena->spare);
+    arena->spare     = NULL;
+    arena->reserved  = 0;
+    arena->allocated = 0;
+}
@@ -0,0 +1,64 @@
+/**
+ * Copyright 2015 JiKai. All rights reserved.
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file.
+ *
+ *     The arena.h and arena.c implement a bump allocator.
+ * the memory is taken from big blocks and released all at
+ * once, so the small objects living as long as each other,
+ * like the nodes of an AST, do not cost a malloc each.
+ **/
+
+#ifndef CPLUS_ARENA_H
+#define CPLUS_ARENA_H
+
+#include "common.h"
+
+#define ARENA_ALIGN      8
+#define ARENA_BLOCK_SIZE 65536
+
+typedef struct ArenaBlock ArenaBlock;
+struct ArenaBlock {
+    ArenaBlock* prev;
+    size_t      size;
+    size_t      used;
+    char        data[] __attribute__((aligned(ARENA_ALIGN)));
+};
+
+// the objects bigger than the block size get the blocks of their own.
+// one released block is kept as the spare, so an arena rewound again
+// and again at the edge of a block does not call malloc every time.
+//
+typedef struct Arena {
+    ArenaBlock* cur;
+    ArenaBlock* spare;
+    size_t      block_size;
+    size_t      reserved;   // the bytes of all blocks
+    size_t      allocated;  // the bytes handed out
+    const char* owner;      // the file calling the arenaInit, see CPLUS_MEM_STATS
+}Arena;
+
+// the position of an arena. rewinding to it releases everything allocated
+// after it, the marks must be rewound in the reverse order.
+typedef struct ArenaMark {
+    ArenaBlock* block;
+    size_t      used;
+    size_t      allocated;
+}ArenaMark;
+
+extern void      arenaInitAt (Arena* arena, size_t block_size, const char* owner);
+extern void*     arenaAlloc  (Arena* arena, size_t size);
+extern void*     arenaCalloc (Arena* arena, size_t size);
+extern char*     arenaStrdup (Arena* arena, const char* str, size_t len);
+extern ArenaMark arenaMark   (Arena* arena);
+extern void      arenaRewind (Arena* arena, ArenaMark mark);
+extern void      arenaDestroy(Arena* arena);
+
+// the blocks of the arena are counted for the file creating it, not for
+// the arena.c, so the memory stats tell which phase the arena serves.
+#define arenaInit(arena, block_size) arenaInitAt((arena), (block_size), __FILE__)
+
+// allocate an object of the type from the arena.
+#define arenaNew(arena, type) ((type*)arenaAlloc((arena), sizeof(type)))
+
+#endif
@@ -5,15 +5,495 @@
  **/
 
 #include "ast.h"
+#include "lexer.h"
 
 void astInit(AST* ast) {
     ast->global_scope = NULL;
+    arenaInit(&ast->arena, ARENA_BLOCK_SIZE);
 }
 
+// the AST is displayed by its flat form, so both forms are printed the same.
 void astDisplay(AST* ast) {
-
+    ASTFlat flat;
+    astFlatInit   (&flat);
+    astFlatFromAST(&flat, ast);
+    astFlatDisplay(&flat, stdout);
+    astFlatDestroy(&flat);
 }
 
 void astDestroy(AST* ast) {
+    arenaDestroy(&ast->arena);
+    ast->global_scope = NULL;
+}
+
+/****** methods of ASTFlat ******/
+
+void astFlatInit(ASTFlat* flat) {
+    flat->kinds       = NULL;
+    flat->ops         = NULL;
+    flat->lhs         = NULL;
+    flat->rhs         = NULL;
+    flat->lines       = NULL;
+    flat->cols        = NULL;
+    flat->count       = 0;
+    flat->cap         = 0;
+    flat->extra       = NULL;
+    flat->extra_count = 0;
+    flat->extra_cap   = 0;
+    flat->strs        = NULL;
+    flat->str_count   = 0;
+    flat->str_cap     = 0;
+    flat->root        = AST_INDEX_NULL;
+    // the row 0 is the null node.
+    astFlatAdd(flat, AST_NODE, 0, 0, 0, 0, 0);
+}
+
+ASTIndex astFlatAdd(ASTFlat* flat, int8 kind, int16 op, uint32 lhs, uint32 rhs, int32 line, int32 col) {
+    if (flat->count == flat->cap) {
+        flat->cap   = flat->cap == 0 ? 64 : flat->cap * 2;
+        flat->kinds = (int8*)mem_realloc(flat->kinds, sizeof(int8) * flat->cap);
+        flat->ops   = (int16*)mem_realloc(flat->ops, sizeof(int16) * flat->cap);
+        flat->lhs   = (uint32*)mem_realloc(flat->lhs, sizeof(uint32) * flat->cap);
+        flat->rhs   = (uint32*)mem_realloc(flat->rhs, sizeof(uint32) * flat->cap);
+        flat->lines = (int32*)mem_realloc(flat->lines, sizeof(int32) * flat->cap);
+        flat->cols  = (int32*)mem_realloc(flat->cols, sizeof(int32) * flat->cap);
+    }
+    flat->kinds[flat->count] = kind;
+    flat->ops  [flat->count] = op;
+    flat->lhs  [flat->count] = lhs;
+    flat->rhs  [flat->count] = rhs;
+    flat->lines[flat->count] = line;
+    flat->cols [flat->count] = col;
+    return flat->count++;
+}
+
+// append the data to the extra array and return the index of the first one.
+// the data can be NULL, then the space is reserved and filled with 0.
+uint32 astFlatAddExtra(ASTFlat* flat, uint32* data, int32 count) {
+    uint32 index = flat->extra_count;
+    if (flat->extra_count + count > flat->extra_cap) {
+        while (flat->extra_count + count > flat->extra_cap) {
+            flat->extra_cap = flat->extra_cap == 0 ? 64 : flat->extra_cap * 2;
+        }
+        flat->extra = (uint32*)mem_realloc(flat->extra, sizeof(uint32) * flat->extra_cap);
+    }
+    if (data != NULL) {
+        memcpy(flat->extra + index, data, sizeof(uint32) * count);
+    }
+    else {
+        memset(flat->extra + index, 0, sizeof(uint32) * count);
+    }
+    flat->extra_count += count;
+    return index;
+}
+
+uint32 astFlatAddStr(ASTFlat* flat, char* str) {
+    if (flat->str_count == flat->str_cap) {
+        flat->str_cap = flat->str_cap == 0 ? 16 : flat->str_cap * 2;
+        flat->strs    = (char**)mem_realloc(flat->strs, sizeof(char*) * flat->str_cap);
+    }
+    flat->strs[flat->str_count] = str;
+    return flat->str_count++;
+}
+
+// the row takes the position of the node at the index pos, because only
+// the identifiers and the literals record their positions in the AST.
+static ASTIndex astFlatAddAt(ASTFlat* flat, int8 kind, int16 op, uint32 lhs, uint32 rhs, ASTIndex pos) {
+    return astFlatAdd(flat, kind, op, lhs, rhs, flat->lines[pos], flat->cols[pos]);
+}
+
+/****** converting the AST ******/
+
+static ASTIndex astFlatExpr (ASTFlat* flat, ASTNodeExpr* expr);
+static ASTIndex astFlatNode (ASTFlat* flat, ASTNode* node);
+static ASTIndex astFlatBlock(ASTFlat* flat, ASTNodeBlock* block);
+
+// the list is reserved before its items are converted, the items are set
+// by their indexes because the extra array may be moved meanwhile.
+static uint32 astFlatReserveList(ASTFlat* flat, int32 count) {
+    uint32 list = astFlatAddExtra(flat, NULL, count + 1);
+    flat->extra[list] = count;
+    return list;
+}
+
+static uint32 astFlatStmts(ASTFlat* flat, ASTNodeStmt* stmts) {
+    ASTNodeStmt* stmt;
+    ASTIndex     item;
+    uint32       list;
+    int32        count = 0;
+    for (stmt = stmts; stmt != NULL; stmt = stmt->next) {
+        count++;
+    }
+    list = astFlatReserveList(flat, count);
+    for (stmt = stmts, count = 0; stmt != NULL; stmt = stmt->next) {
+        item = astFlatNode(flat, stmt->stmt);
+        flat->extra[list + 1 + count++] = item;
+    }
+    return list;
+}
+
+static ASTIndex astFlatID(ASTFlat* flat, ASTNodeID* id) {
+    if (id == NULL) {
+        return AST_INDEX_NULL;
+    }
+    return astFlatAdd(flat, AST_NODE_ID, 0, astFlatAddStr(flat, id->id), id->id_len, id->pos_line, id->pos_col);
+}
+
+static ASTIndex astFlatExprList(ASTFlat* flat, ASTNodeExprList* exprs) {
+    ASTIndex item;
+    uint32   list;
+    int32    i;
+    if (exprs == NULL) {
+        return AST_INDEX_NULL;
+    }
+    list = astFlatReserveList(flat, exprs->count);
+    for (i = 0; i < exprs->count; i++) {
+        item = astFlatExpr(flat, exprs->exprs[i]);
+        flat->extra[list + 1 + i] = item;
+    }
+    return astFlatAddAt(flat, AST_NODE_EXPR_LIST, 0, list, 0, exprs->count > 0 ? flat->extra[list + 1] : AST_INDEX_NULL);
+}
+
+static ASTIndex astFlatExpr(ASTFlat* flat, ASTNodeExpr* expr) {
+    ASTNodeConstLit* lit;
+    ASTIndex         lhs, rhs;
+    if (expr == NULL) {
+        return AST_INDEX_NULL;
+    }
+    switch (expr->expr_type) {
+    case AST_NODE_ID:
+        return astFlatID(flat, expr->expr.expr_id);
+
+    case AST_NODE_CONST_LIT:
+        lit = expr->expr.expr_const_lit;
+        return astFlatAdd(flat, AST_NODE_CONST_LIT, lit->const_type, astFlatAddStr(flat, lit->const_value), lit->const_len,
+            lit->pos_line, lit->pos_col);
+
+    case AST_NODE_INDEX:
+        lhs = astFlatID  (flat, expr->expr.expr_index->array);
+        rhs = astFlatExpr(flat, expr->expr.expr_index->index);
+        return astFlatAddAt(flat, AST_NODE_INDEX, 0, lhs, rhs, lhs);
+
+    case AST_NODE_FUNC_DEF:
+        return astFlatAdd(flat, AST_NODE_FUNC_DEF, 0, astFlatAddStr(flat, expr->expr.expr_func_def->func_name), 0, 0, 0);
+
+    case AST_NODE_FUNC_CALL:
+        lhs = astFlatID      (flat, expr->expr.expr_func_call->func_name);
+        rhs = astFlatExprList(flat, expr->expr.expr_func_call->func_params);
+        return astFlatAddAt(flat, AST_NODE_FUNC_CALL, 0, lhs, rhs, lhs);
+
+    case AST_NODE_EXPR_UNRY:
+        lhs = astFlatExpr(flat, expr->expr.expr_unary->oprd);
+        return astFlatAddAt(flat, AST_NODE_EXPR_UNRY, expr->expr.expr_unary->op_token_code, lhs, 0, lhs);
+
+    case AST_NODE_EXPR_BNRY:
+        lhs = astFlatExpr(flat, expr->expr.expr_binary->oprd1);
+        rhs = astFlatExpr(flat, expr->expr.expr_binary->oprd2);
+        return astFlatAddAt(flat, AST_NODE_EXPR_BNRY, expr->expr.expr_binary->op_token_code, lhs, rhs, lhs);
+
+    // the type definitions and the new expressions are not defined yet.
+    default:
+        return astFlatAdd(flat, expr->expr_type, 0, 0, 0, 0, 0);
+    }
+}
+
+static ASTIndex astFlatDecl(ASTFlat* flat, ASTNodeDecl* decl) {
+    ASTIndex type = astFlatExpr(flat, decl->decl_type);
+    uint32   data[2];
+    data[0] = astFlatAddStr(flat, decl->decl_idname);
+    data[1] = astFlatExpr  (flat, decl->decl_init);
+    return astFlatAddAt(flat, AST_NODE_DECL, 0, type, astFlatAddExtra(flat, data, 2), type);
+}
+
+static ASTIndex astFlatAssign(ASTFlat* flat, ASTNodeAssign* assign) {
+    ASTIndex lhs = astFlatExpr(flat, assign->expr_lhs);
+    ASTIndex rhs = astFlatExpr(flat, assign->expr_rhs);
+    return astFlatAddAt(flat, AST_NODE_ASSIGN, 0, lhs, rhs, lhs);
+}
+
+static ASTIndex astFlatIf(ASTFlat* flat, ASTNodeIf* node_if) {
+    ASTNodeEf* ef;
+    ASTIndex   cond = astFlatExpr(flat, node_if->cond);
+    ASTIndex   item, block;
+    uint32     data[3];
+    uint32     list;
+    int32      count = 0;
+    data[0] = astFlatBlock(flat, node_if->block);
+    for (ef = node_if->branch_ef; ef != NULL; ef = ef->next) {
+        count++;
+    }
+    list = astFlatReserveList(flat, count);
+    for (ef = node_if->branch_ef, count = 0; ef != NULL; ef = ef->next) {
+        item  = astFlatExpr (flat, ef->cond);
+        block = astFlatBlock(flat, ef->block);
+        item  = astFlatAddAt(flat, AST_NODE_EF, 0, item, block, item);
+        flat->extra[list + 1 + count++] = item;
+    }
+    data[1] = list;
+    data[2] = AST_INDEX_NULL;
+    if (node_if->branch_else != NULL) {
+        block   = astFlatBlock(flat, node_if->branch_else->block);
+        data[2] = astFlatAddAt(flat, AST_NODE_ELSE, 0, block, 0, block);
+    }
+    return astFlatAddAt(flat, AST_NODE_IF, 0, cond, astFlatAddExtra(flat, data, 3), cond);
+}
+
+static ASTIndex astFlatSwitch(ASTFlat* flat, ASTNodeSwitch* node_switch) {
+    ASTNodeSwitchCase* node_case;
+    ASTIndex           option = astFlatExpr(flat, node_switch->option);
+    ASTIndex           item, body;
+    uint32             data[2];
+    uint32             list;
+    int32              count = 0;
+    for (node_case = node_switch->branch_case; node_case != NULL; node_case = node_case->next) {
+        count++;
+    }
+    list = astFlatReserveList(flat, count);
+    for (node_case = node_switch->branch_case, count = 0; node_case != NULL; node_case = node_case->next) {
+        item = astFlatExpr(flat, node_case->value);
+        body = node_case->body != NULL ? astFlatAddAt(flat, AST_NODE_CASE_BODY, 0, astFlatStmts(flat, node_case->body->stmts), 0, item) : AST_INDEX_NULL;
+        item = astFlatAddAt(flat, AST_NODE_SWITCH_CASE, 0, item, body, item);
+        flat->extra[list + 1 + count++] = item;
+    }
+    data[0] = list;
+    data[1] = AST_INDEX_NULL;
+    if (node_switch->branch_default != NULL) {
+        item    = astFlatBlock(flat, node_switch->branch_default->block);
+        data[1] = astFlatAddAt(flat, AST_NODE_SWITCH_DEFT, 0, item, 0, item);
+    }
+    return astFlatAddAt(flat, AST_NODE_SWITCH, 0, option, astFlatAddExtra(flat, data, 2), option);
+}
+
+static ASTIndex astFlatLoopFor(ASTFlat* flat, ASTNodeLoopFor* loop) {
+    uint32   data[3];
+    ASTIndex block;
+    data[0] = loop->init_type == AST_NODE_DECL ? astFlatDecl(flat, loop->init.init_decl) :
+              loop->init.init_assign != NULL   ? astFlatAssign(flat, loop->init.init_assign) : AST_INDEX_NULL;
+    data[1] = astFlatExpr(flat, loop->cond);
+    data[2] = astFlatExpr(flat, loop->step);
+    block   = astFlatBlock(flat, loop->block);
+    return astFlatAddAt(flat, AST_NODE_LOOP_FOR, 0, astFlatAddExtra(flat, data, 3), block, data[0]);
+}
+
+static ASTIndex astFlatLoopForeach(ASTFlat* flat, ASTNodeLoopForeach* loop) {
+    uint32   data[3];
+    ASTIndex block;
+    data[0] = astFlatExpr (flat, loop->data);
+    data[1] = astFlatExpr (flat, loop->index);
+    data[2] = astFlatExpr (flat, loop->container);
+    block   = astFlatBlock(flat, loop->block);
+    return astFlatAddAt(flat, AST_NODE_LOOP_FOREACH, 0, astFlatAddExtra(flat, data, 3), block, data[0]);
+}
+
+static ASTIndex astFlatNode(ASTFlat* flat, ASTNode* node) {
+    ASTIndex lhs, rhs;
+    if (node == NULL) {
+        return AST_INDEX_NULL;
+    }
+    switch (node->node_type) {
+    case AST_NODE_BLOCK:
+        return astFlatBlock(flat, node->node.node_block);
+    case AST_NODE_EXPR:
+        return astFlatExpr(flat, node->node.node_expr);
+    case AST_NODE_DECL:
+        return astFlatDecl(flat, node->node.node_decl);
+    case AST_NODE_ASSIGN:
+        return astFlatAssign(flat, node->node.node_assign);
+    case AST_NODE_IF:
+        return astFlatIf(flat, node->node.node_if);
+    case AST_NODE_SWITCH:
+        return astFlatSwitch(flat, node->node.node_switch);
+    case AST_NODE_LOOP_FOR:
+        return astFlatLoopFor(flat, node->node.node_loop_for);
+    case AST_NODE_LOOP_WHILE:
+        lhs = astFlatExpr (flat, node->node.node_loop_while->cond);
+        rhs = astFlatBlock(flat, node->node.node_loop_while->block);
+        return astFlatAddAt(flat, AST_NODE_LOOP_WHILE, 0, lhs, rhs, lhs);
+    case AST_NODE_LOOP_INF:
+        lhs = astFlatBlock(flat, node->node.node_loop_inf->block);
+        return astFlatAddAt(flat, AST_NODE_LOOP_INF, 0, lhs, 0, lhs);
+    case AST_NODE_LOOP_FOREACH:
+        return astFlatLoopForeach(flat, node->node.node_loop_foreach);
+    // the return statements are not defined yet.
+    default:
+        return astFlatAdd(flat, node->node_type, 0, 0, 0, 0, 0);
+    }
+}
+
+static ASTIndex astFlatBlock(ASTFlat* flat, ASTNodeBlock* block) {
+    uint32 list;
+    if (block == NULL) {
+        return AST_INDEX_NULL;
+    }
+    list = astFlatStmts(flat, block->stmts);
+    return astFlatAddAt(flat, AST_NODE_BLOCK, 0, list, 0, flat->extra[list] > 0 ? flat->extra[list + 1] : AST_INDEX_NULL);
+}
+
+// the children are converted before their parents, so the root is the last
+// row of the ASTFlat.
+void astFlatFromAST(ASTFlat* flat, AST* ast) {
+    ASTNodeGlobalScope* scope = ast->global_scope;
+    ASTNodeModule*      mod;
+    ASTNodeInclude*     inc;
+    ASTIndex            item;
+    uint32              list, stmts;
+    int32               count = 0;
+    if (scope == NULL) {
+        flat->root = AST_INDEX_NULL;
+        return;
+    }
+    for (mod = scope->modules; mod != NULL; mod = mod->next) {
+        count++;
+    }
+    for (inc = scope->includes; inc != NULL; inc = inc->next) {
+        count++;
+    }
+    list = astFlatReserveList(flat, count);
+    count = 0;
+    for (mod = scope->modules; mod != NULL; mod = mod->next) {
+        item = astFlatAdd(flat, AST_NODE_MODULE, 0, astFlatAddStr(flat, mod->module), 0, mod->pos_line, 0);
+        flat->extra[list + 1 + count++] = item;
+    }
+    for (inc = scope->includes; inc != NULL; inc = inc->next) {
+        item = astFlatAdd(flat, AST_NDOE_INCLUDE, 0, astFlatAddStr(flat, inc->file), 0, inc->pos_line, 0);
+        flat->extra[list + 1 + count++] = item;
+    }
+    stmts      = astFlatStmts(flat, scope->stmts);
+    flat->root = astFlatAdd(flat, AST_NODE_GLOBAL_SCOPE, 0, list, stmts, 0, 0);
+}
+
+/****** displaying ******/
+
+static const char* ast_kind_names[] = {
+    "node", "stmt", "include", "module", "block", "case_body", "global_scope", "const",
+    "id", "expr", "expr_list", "unary", "binary", "index", "decl", "assign",
+    "if", "ef", "else", "switch", "case", "default", "for", "while",
+    "loop", "foreach", "func", "call", "return", "type_decl", "type", "new",
+    "error", "deal"
+};
+
+// the spellings of the operators from the TOKEN_OP_ASSIGN.
+static const char* ast_op_names[] = {
+    "=", "+=", "-=", "*=", "/=", "%=", "&=", "|=", "^=", ".", "(", ")", "{", "}", "++", "--",
+    "-", "$", "@", "[", "]", "*", "/", "%", "+", "-", "<<", ">>", "&", "|", "^", "!",
+    "==", "!=", "<", ">", "<=", ">=", "&&", "||"
+};
+
+static void astFlatShow(ASTFlat* flat, FILE* out, ASTIndex index, int depth);
+
+static void astFlatShowList(ASTFlat* flat, FILE* out, uint32 list, int depth) {
+    uint32 i;
+    for (i = 0; i < flat->extra[list]; i++) {
+        astFlatShow(flat, out, flat->extra[list + 1 + i], depth);
+    }
+}
+
+static void astFlatShow(ASTFlat* flat, FILE* out, ASTIndex index, int depth) {
+    uint8  kind;
+    int16  op;
+    uint32 lhs, rhs;
+    if (index == AST_INDEX_NULL) {
+        return;
+    }
+    kind = (uint8)flat->kinds[index];
+    op   = flat->ops[index];
+    lhs  = flat->lhs[index];
+    rhs  = flat->rhs[index];
+    fprintf(out, "%*s%s", depth * 2, "", kind <= AST_NODE_DEAL ? ast_kind_names[kind] : "?");
+    switch (kind) {
+    case AST_NODE_ID:
+    case AST_NODE_CONST_LIT:
+        fprintf(out, " %.*s\r\n", (int)rhs, flat->strs[lhs]);
+        return;
+    case AST_NDOE_INCLUDE:
+    case AST_NODE_MODULE:
+    case AST_NODE_FUNC_DEF:
+        fprintf(out, " %s\r\n", flat->strs[lhs]);
+        return;
+    case AST_NODE_EXPR_UNRY:
+    case AST_NODE_EXPR_BNRY:
+        fprintf(out, " %s\r\n", TOKEN_OP_ASSIGN <= op && op <= TOKEN_OP_LOGIC_OR ? ast_op_names[op - TOKEN_OP_ASSIGN] : "?");
+        break;
+    case AST_NODE_DECL:
+        fprintf(out, " %s\r\n", flat->strs[flat->extra[rhs]]);
+        break;
+    default:
+        fprintf(out, "\r\n");
+        break;
+    }
+    switch (kind) {
+    case AST_NODE_GLOBAL_SCOPE:
+        astFlatShowList(flat, out, lhs, depth + 1);
+        astFlatShowList(flat, out, rhs, depth + 1);
+        break;
+    case AST_NODE_BLOCK:
+    case AST_NODE_CASE_BODY:
+    case AST_NODE_EXPR_LIST:
+        astFlatShowList(flat, out, lhs, depth + 1);
+        break;
+    case AST_NODE_DECL:
+        astFlatShow(flat, out, lhs, depth + 1);
+        astFlatShow(flat, out, flat->extra[rhs + 1], depth + 1);
+        break;
+    case AST_NODE_IF:
+        astFlatShow    (flat, out, lhs, depth + 1);
+        astFlatShow    (flat, out, flat->extra[rhs], depth + 1);
+        astFlatShowList(flat, out, flat->extra[rhs + 1], depth);
+        astFlatShow    (flat, out, flat->extra[rhs + 2], depth);
+        break;
+    case AST_NODE_SWITCH:
+        astFlatShow    (flat, out, lhs, depth + 1);
+        astFlatShowList(flat, out, flat->extra[rhs], depth + 1);
+        astFlatShow    (flat, out, flat->extra[rhs + 1], depth + 1);
+        break;
+    case AST_NODE_LOOP_FOR:
+    case AST_NODE_LOOP_FOREACH:
+        astFlatShow(flat, out, flat->extra[lhs], depth + 1);
+        astFlatShow(flat, out, flat->extra[lhs + 1], depth + 1);
+        astFlatShow(flat, out, flat->extra[lhs + 2], depth + 1);
+        astFlatShow(flat, out, rhs, depth + 1);
+        break;
+    case AST_NODE_EXPR_UNRY:
+    case AST_NODE_EXPR_BNRY:
+    case AST_NODE_INDEX:
+    case AST_NODE_ASSIGN:
+    case AST_NODE_EF:
+    case AST_NODE_ELSE:
+    case AST_NODE_SWITCH_CASE:
+    case AST_NODE_SWITCH_DEFT:
+    case AST_NODE_LOOP_WHILE:
+    case AST_NODE_LOOP_INF:
+    case AST_NODE_FUNC_CALL:
+        astFlatShow(flat, out, lhs, depth + 1);
+        astFlatShow(flat, out, rhs, depth + 1);
+        break;
+    }
+}
+
+void astFlatDisplay(ASTFlat* flat, FILE* out) {
+    astFlatShow(flat, out, flat->root, 0);
+}
+
+// the bytes taken by the nodes and the extra data.
+size_t astFlatBytes(ASTFlat* flat) {
+    return (size_t)flat->count * (sizeof(int8) + sizeof(int16) + sizeof(uint32) * 2 + sizeof(int32) * 2) +
+           (size_t)flat->extra_count * sizeof(uint32) + (size_t)flat->str_count * sizeof(char*);
+}
 
+void astFlatDestroy(ASTFlat* flat) {
+    mem_free(flat->kinds);
+    mem_free(flat->ops);
+    mem_free(flat->lhs);
+    mem_free(flat->rhs);
+    mem_free(flat->lines);
+    mem_free(flat->cols);
+    mem_free(flat->extra);
+    mem_free(flat->strs);
+    flat->kinds = NULL;
+    flat->extra = NULL;
+    flat->strs  = NULL;
+    flat->count = flat->cap = 0;
+    flat->extra_count = flat->extra_cap = 0;
+    flat->str_count = flat->str_cap = 0;
+    flat->root  = AST_INDEX_NULL;
 }
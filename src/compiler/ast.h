@@ -12,6 +12,8 @@
 
 #include "common.h"
 #include "ident.h"
+#include "arena.h"
+#include "dynamicarr.h"
 
 #define AST_NODE                   0x00
 #define AST_NODE_STMT              0x01
@@ -144,16 +146,25 @@ struct ASTNodeGlobalScope {
     ASTNodeStmt*    stmts;
 };
 
+// note:
+//    the id is interned(see intern.h), so two identifiers are the same if
+//    their id pointers are equal.
+//
+//    the const_value may point into the source file mapped by the lexer(see
+//    LexTokenSpan in lexer.h). it is not terminated by '\0' and is valid until
+//    the source file is closed, so always use it with the const_len.
+//
 struct ASTNodeID {
     int32 pos_line;
-    int16 pos_col;
+    int32 pos_col;
     char* id;
+    int32 id_len;
 };
 
 // represent the constant literal.
 struct ASTNodeConstLit {
     int32 pos_line;
-    int16 pos_col;
+    int32 pos_col;
     // lit_type:
     //    TOKEN_CONST_INTEGER or
     //    TOKEN_CONST_FLOAT   or
@@ -163,6 +174,7 @@ struct ASTNodeConstLit {
     // lit_value:
     //    12, 5.21, "hello world", 'a'...
     char* const_value;
+    int32 const_len;
 };
 
 // represent an expression.
@@ -172,7 +184,7 @@ struct ASTNodeConstLit {
 //                 |
 //            expr_binary
 //         (oprd1,optr,oprd2)
-//           /            \
+//           |             |
 //     expr_binary       expr_unary
 // (oprd1,optr,oprd2)   (optr,oprd2)
 //    |          |              |
@@ -195,16 +207,18 @@ struct ASTNodeExpr {
     }expr;
 };
 
-typedef struct ASTNodeExprListNode {
-    ASTNodeExpr* expr;
-    struct ASTNodeExprListNode* next;
-}ASTNodeExprListNode;
-
-// represent a set of expressions separated by comma(',')
+// represent a set of expressions separated by comma(','). the
+// expressions are kept in one array allocated from the arena of
+// the AST, the exprs is NULL if the count is 0.
 struct ASTNodeExprList {
-    ASTNodeExprListNode* exprs;
+    ASTNodeExpr** exprs;
+    int32         count;
 };
 
+// the expressions of a list are collected in an ASTExprVec, then
+// copied into the arena of the AST when the list is closed.
+DYNAMIC_ARR_DEFINE(ASTExprVec, astExprVec, ASTNodeExpr*)
+
 // represent an unary expression.
 struct ASTNodeExprUnry {
     int16        op_token_code;
@@ -339,12 +353,85 @@ struct ASTNodeFuncCall {
     ASTNodeExprList* func_params;
 };
 
+// all nodes of the AST and the strings copied for them are allocated from
+// its arena, so the whole tree is released by the astDestroy() at once.
 typedef struct {
     ASTNodeGlobalScope* global_scope;
+    Arena               arena;
 }AST;
 
 extern void astInit   (AST* ast);
 extern void astDisplay(AST* ast);
 extern void astDestroy(AST* ast);
 
+// the ASTFlat is the compact form of the AST. a node is a row of the
+// parallel arrays: its kind(AST_NODE_XXX), its op, two 32-bit data and its
+// position. the children are the indexes of the rows, and the index 0 is
+// the null node. the children which do not fit in the two data are in the
+// extra array, and a list of children is stored in the extra array as its
+// length followed by the items.
+//
+// the nodes of the statements and the expressions(ASTNode, ASTNodeStmt and
+// ASTNodeExpr) are not kept, a row has the kind of the node they wrap.
+//
+//   kind              op          lhs                     rhs
+//   GLOBAL_SCOPE      -           list of modules and     list of stmts
+//                                 includes
+//   MODULE/INCLUDE    -           str                     -
+//   BLOCK/CASE_BODY   -           list of stmts           -
+//   ID                -           str                     len
+//   CONST_LIT         const type  str                     len
+//   EXPR_LIST         -           list of exprs           -
+//   EXPR_UNRY         op          oprd                    -
+//   EXPR_BNRY         op          oprd1                   oprd2
+//   INDEX             -           array                   index
+//   DECL              -           type                    extra[name str, init]
+//   ASSIGN            -           lhs                     rhs
+//   IF                -           cond                    extra[block, list of efs, else]
+//   EF                -           cond                    block
+//   ELSE/SWITCH_DEFT  -           block                   -
+//   SWITCH            -           option                  extra[list of cases, default]
+//   SWITCH_CASE       -           value                   body
+//   LOOP_FOR          -           extra[init, cond, step] block
+//   LOOP_WHILE        -           cond                    block
+//   LOOP_INF          -           block                   -
+//   LOOP_FOREACH      -           extra[data, index,      block
+//                                 container]
+//   FUNC_DEF          -           str                     -
+//   FUNC_CALL         -           name                    params
+//
+// the str is the index of the strs, which are borrowed from the AST
+// converted, so the AST must live as long as the ASTFlat.
+//
+typedef uint32 ASTIndex;
+
+#define AST_INDEX_NULL 0
+
+typedef struct ASTFlat {
+    int8*     kinds;
+    int16*    ops;
+    uint32*   lhs;
+    uint32*   rhs;
+    int32*    lines;
+    int32*    cols;
+    int32     count;
+    int32     cap;
+    uint32*   extra;
+    int32     extra_count;
+    int32     extra_cap;
+    char**    strs;
+    int32     str_count;
+    int32     str_cap;
+    ASTIndex  root;
+}ASTFlat;
+
+extern void     astFlatInit    (ASTFlat* flat);
+extern ASTIndex astFlatAdd     (ASTFlat* flat, int8 kind, int16 op, uint32 lhs, uint32 rhs, int32 line, int32 col);
+extern uint32   astFlatAddExtra(ASTFlat* flat, uint32* data, int32 count);
+extern uint32   astFlatAddStr  (ASTFlat* flat, char* str);
+extern void     astFlatFromAST (ASTFlat* flat, AST* ast);
+extern void     astFlatDisplay (ASTFlat* flat, FILE* out);
+extern size_t   astFlatBytes   (ASTFlat* flat);
+extern void     astFlatDestroy (ASTFlat* flat);
+
 #endif
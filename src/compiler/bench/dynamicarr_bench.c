@@ -0,0 +1,131 @@
+/**
+ * Copyright 2015 JiKai. All rights reserved.
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file.
+ *
+ *     This file compares the linked DynamicArrChar with the
+ * contiguous DynamicArrStr. the tokens are built char by
+ * char and read back like the lexer does, and the long
+ * strings are built by the bulk appends.
+ *
+ * build and run(in the src/compiler directory):
+ *     gcc -O2 bench/dynamicarr_bench.c common.c dynamicarr.c -o dynamicarr_bench
+ *     ./dynamicarr_bench
+ **/
+
+#include <stdio.h>
+#include <time.h>
+#include "../dynamicarr.h"
+
+#define BENCH_TOKENS  2000000
+#define BENCH_CHUNKS  200000
+#define BENCH_ROUNDS  5
+
+static char* words[] = { "request", "buffer_capacity_in_bytes", "i", "offset", "a_rather_long_identifier_of_a_function_0123456789" };
+
+static double now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+// the tokens are appended char by char, compared and copied out, then the
+// array is cleared for the next token like the LexToken does.
+static int64 tokens_linked() {
+    DynamicArrChar darr;
+    int64          sum = 0;
+    char*          str;
+    int            i, j, len;
+    dynamicArrCharInit(&darr, 16);
+    for (i = 0; i < BENCH_TOKENS; i++) {
+        len = strlen(words[i % 5]);
+        for (j = 0; j < len; j++) {
+            dynamicArrCharAppendc(&darr, words[i % 5][j]);
+        }
+        sum += dynamicArrCharEqual(&darr, "request", 7) == true;
+        str  = dynamicArrCharGetStr(&darr);
+        sum += str[len - 1];
+        mem_free(str);
+        dynamicArrCharClear(&darr);
+    }
+    dynamicArrCharDestroy(&darr);
+    return sum;
+}
+
+static int64 tokens_contiguous() {
+    DynamicArrStr dstr;
+    int64         sum = 0;
+    const char*   str;
+    int           i, j, len;
+    dynamicArrStrInit(&dstr, 16);
+    for (i = 0; i < BENCH_TOKENS; i++) {
+        len = strlen(words[i % 5]);
+        for (j = 0; j < len; j++) {
+            dynamicArrStrAppendc(&dstr, words[i % 5][j]);
+        }
+        sum += dynamicArrStrEqual(&dstr, "request", 7) == true;
+        str  = dynamicArrStrView(&dstr);
+        sum += str[len - 1];
+        dynamicArrStrClear(&dstr);
+    }
+    dynamicArrStrDestroy(&dstr);
+    return sum;
+}
+
+// one long string built by the appends of the words, then read once.
+static int64 bulk_linked() {
+    DynamicArrChar darr;
+    int64          sum;
+    char*          str;
+    int            i;
+    dynamicArrCharInit(&darr, 64);
+    for (i = 0; i < BENCH_CHUNKS; i++) {
+        dynamicArrCharAppend(&darr, words[i % 5], strlen(words[i % 5]));
+    }
+    str = dynamicArrCharGetStr(&darr);
+    sum = darr.used + str[darr.used / 2];
+    mem_free(str);
+    dynamicArrCharDestroy(&darr);
+    return sum;
+}
+
+static int64 bulk_contiguous() {
+    DynamicArrStr dstr;
+    int64         sum;
+    int           i;
+    dynamicArrStrInit(&dstr, 64);
+    for (i = 0; i < BENCH_CHUNKS; i++) {
+        dynamicArrStrAppend(&dstr, words[i % 5], strlen(words[i % 5]));
+    }
+    sum = dstr.used + dynamicArrStrView(&dstr)[dstr.used / 2];
+    dynamicArrStrDestroy(&dstr);
+    return sum;
+}
+
+static void bench(char* name, int64 (*linked)(), int64 (*contiguous)(), int64 ops) {
+    double begin, ms, best_linked = -1, best_contiguous = -1;
+    int64  sum_linked = 0, sum_contiguous = 0;
+    int    i;
+    for (i = 0; i < BENCH_ROUNDS; i++) {
+        begin           = now_ms();
+        sum_linked      = linked();
+        ms              = now_ms() - begin;
+        best_linked     = best_linked < 0 || ms < best_linked ? ms : best_linked;
+        begin           = now_ms();
+        sum_contiguous  = contiguous();
+        ms              = now_ms() - begin;
+        best_contiguous = best_contiguous < 0 || ms < best_contiguous ? ms : best_contiguous;
+    }
+    if (sum_linked != sum_contiguous) {
+        fprintf(stderr, "%s: the results are different, %lld and %lld\r\n", name, (long long)sum_linked, (long long)sum_contiguous);
+    }
+    printf("%-8s | linked %8.2fms %6.1fns/op | contiguous %8.2fms %6.1fns/op | %.2fx\r\n", name,
+        best_linked, best_linked * 1e6 / ops, best_contiguous, best_contiguous * 1e6 / ops, best_linked / best_contiguous);
+}
+
+int main() {
+    printf("the best of %d rounds\r\n", BENCH_ROUNDS);
+    bench("tokens", tokens_linked, tokens_contiguous, BENCH_TOKENS);
+    bench("bulk",   bulk_linked,   bulk_contiguous,   BENCH_CHUNKS);
+    return 0;
+}
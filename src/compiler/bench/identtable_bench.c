@@ -0,0 +1,277 @@
+/**
+ * Copyright 2015 JiKai. All rights reserved.
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file.
+ *
+ *     This file compares the hash table IdentTable with the red
+ * black tree it replaced. the tree is copied here so the two can
+ * run on the same interned names.
+ *
+ * build and run(in the src/compiler directory):
+ *     gcc -O2 bench/identtable_bench.c ident.c intern.c common.c -o identtable_bench
+ *     ./identtable_bench
+ **/
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "../ident.h"
+
+/****** the red black tree of the old IdentTable ******/
+
+#define NODE_COLOR_RED   0x00
+#define NODE_COLOR_BLACK 0x01
+
+typedef struct RBNode RBNode;
+struct RBNode {
+    Ident*  id;
+    int8    color;
+    RBNode* parent;
+    RBNode* lchild;
+    RBNode* rchild;
+};
+
+typedef struct RBTree {
+    RBNode* root;
+    int   (*cmp)(char* name1, char* name2);
+}RBTree;
+
+// the compare used before the names were interned.
+static int rbCmpChars(char* name1, char* name2) {
+    return strcmp(name1, name2);
+}
+
+// the compare used after the names were interned.
+static int rbCmpIntern(char* name1, char* name2) {
+    if (name1 == name2) {
+        return 0;
+    }
+    return internId(name1) < internId(name2) ? -1 : 1;
+}
+
+static void rbLeftRotate(RBTree* tree, RBNode* node) {
+    RBNode* r = node->rchild;
+    node->rchild = r->lchild;
+    if (r->lchild != NULL) r->lchild->parent = node;
+    r->parent = node->parent;
+    if (node->parent == NULL)              tree->root = r;
+    else if (node == node->parent->lchild) node->parent->lchild = r;
+    else                                   node->parent->rchild = r;
+    r->lchild    = node;
+    node->parent = r;
+}
+
+static void rbRightRotate(RBTree* tree, RBNode* node) {
+    RBNode* l = node->lchild;
+    node->lchild = l->rchild;
+    if (l->rchild != NULL) l->rchild->parent = node;
+    l->parent = node->parent;
+    if (node->parent == NULL)              tree->root = l;
+    else if (node == node->parent->rchild) node->parent->rchild = l;
+    else                                   node->parent->lchild = l;
+    l->rchild    = node;
+    node->parent = l;
+}
+
+static void rbAddFixup(RBTree* tree, RBNode* added) {
+    RBNode* uncle;
+    while (added->parent != NULL && added->parent->color == NODE_COLOR_RED) {
+        RBNode* grand = added->parent->parent;
+        if (added->parent == grand->lchild) {
+            uncle = grand->rchild;
+            if (uncle != NULL && uncle->color == NODE_COLOR_RED) {
+                added->parent->color = NODE_COLOR_BLACK;
+                uncle->color         = NODE_COLOR_BLACK;
+                grand->color         = NODE_COLOR_RED;
+                added = grand;
+                continue;
+            }
+            if (added == added->parent->rchild) {
+                added = added->parent;
+                rbLeftRotate(tree, added);
+            }
+            added->parent->color         = NODE_COLOR_BLACK;
+            added->parent->parent->color = NODE_COLOR_RED;
+            rbRightRotate(tree, added->parent->parent);
+        }
+        else {
+            uncle = grand->lchild;
+            if (uncle != NULL && uncle->color == NODE_COLOR_RED) {
+                added->parent->color = NODE_COLOR_BLACK;
+                uncle->color         = NODE_COLOR_BLACK;
+                grand->color         = NODE_COLOR_RED;
+                added = grand;
+                continue;
+            }
+            if (added == added->parent->lchild) {
+                added = added->parent;
+                rbRightRotate(tree, added);
+            }
+            added->parent->color         = NODE_COLOR_BLACK;
+            added->parent->parent->color = NODE_COLOR_RED;
+            rbLeftRotate(tree, added->parent->parent);
+        }
+    }
+    tree->root->color = NODE_COLOR_BLACK;
+}
+
+static error rbAdd(RBTree* tree, Ident* id) {
+    RBNode*  parent = NULL;
+    RBNode** link   = &tree->root;
+    int      cmp;
+    while (*link != NULL) {
+        parent = *link;
+        cmp = tree->cmp(id->id_name, parent->id->id_name);
+        if (cmp == 0) {
+            return new_error("err: identifier redefined.");
+        }
+        link = cmp < 0 ? &parent->lchild : &parent->rchild;
+    }
+    RBNode* create = (RBNode*)mem_alloc(sizeof(RBNode));
+    create->id     = id;
+    create->color  = NODE_COLOR_RED;
+    create->parent = parent;
+    create->lchild = NULL;
+    create->rchild = NULL;
+    *link = create;
+    rbAddFixup(tree, create);
+    return NULL;
+}
+
+static Ident* rbSearch(RBTree* tree, char* id_name) {
+    RBNode* ptr = tree->root;
+    int     cmp;
+    while (ptr != NULL) {
+        cmp = tree->cmp(id_name, ptr->id->id_name);
+        if (cmp == 0) {
+            return ptr->id;
+        }
+        ptr = cmp < 0 ? ptr->lchild : ptr->rchild;
+    }
+    return NULL;
+}
+
+static void rbDestroyNode(RBNode* node) {
+    if (node != NULL) {
+        rbDestroyNode(node->lchild);
+        rbDestroyNode(node->rchild);
+        mem_free(node);
+    }
+}
+
+/****** the benchmark ******/
+
+#define LOOKUP_ROUNDS 4
+
+static double nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+// generate names look like the ones in real programs: a few common
+// prefixes followed by a word and a number.
+static char* genName(int64 i, int64 seed) {
+    static char* prefixes[] = {"get", "set", "is", "new", "tmp", "buf", "node", "lexer", "parser", "ast"};
+    static char* words[]    = {"Count", "Value", "Index", "Name", "Token", "Scope", "Ident", "Module", "Expr", "Stmt"};
+    char buff[64];
+    int  len = snprintf(buff, sizeof(buff), "%s%s_%lld",
+        prefixes[(i * 7 + seed) % 10], words[(i * 3 + seed) % 10], (long long)(i * 2 + seed));
+    return internStr(buff, len);
+}
+
+static void benchRun(int64 count) {
+    Ident*     ids    = (Ident*)mem_alloc(sizeof(Ident) * count);
+    char**     misses = (char**)mem_alloc(sizeof(char*) * count);
+    IdentTable table;
+    RBTree     tree_chars  = {NULL, rbCmpChars};
+    RBTree     tree_intern = {NULL, rbCmpIntern};
+    double     t_begin;
+    double     t_add[3];
+    double     t_search[3];
+    int64      i, r, found = 0;
+
+    for (i = 0; i < count; i++) {
+        ids[i].id_name = genName(i, 0);
+        ids[i].id_type = ID_TYPE_UNRESOLVED;
+        ids[i].id.id_unresolved = NULL;
+        misses[i] = genName(i, 1);
+    }
+
+    // the nodes of the hash table are freed by identTableDestroy, so
+    // each table gets its own copies.
+    identTableInit(&table);
+    t_begin = nowNs();
+    for (i = 0; i < count; i++) {
+        Ident* id = identNew(NULL, ID_TYPE_UNRESOLVED);
+        *id = ids[i];
+        identTableAdd(&table, id);
+    }
+    t_add[0] = nowNs() - t_begin;
+
+    t_begin = nowNs();
+    for (i = 0; i < count; i++) rbAdd(&tree_intern, &ids[i]);
+    t_add[1] = nowNs() - t_begin;
+
+    t_begin = nowNs();
+    for (i = 0; i < count; i++) rbAdd(&tree_chars, &ids[i]);
+    t_add[2] = nowNs() - t_begin;
+
+    // half of the lookups hit and half miss.
+    t_begin = nowNs();
+    for (r = 0; r < LOOKUP_ROUNDS; r++) {
+        for (i = 0; i < count; i++) {
+            found += identTableSearch(&table, ids[i].id_name) != NULL;
+            found += identTableSearch(&table, misses[i]) != NULL;
+        }
+    }
+    t_search[0] = nowNs() - t_begin;
+
+    t_begin = nowNs();
+    for (r = 0; r < LOOKUP_ROUNDS; r++) {
+        for (i = 0; i < count; i++) {
+            found += rbSearch(&tree_intern, ids[i].id_name) != NULL;
+            found += rbSearch(&tree_intern, misses[i]) != NULL;
+        }
+    }
+    t_search[1] = nowNs() - t_begin;
+
+    t_begin = nowNs();
+    for (r = 0; r < LOOKUP_ROUNDS; r++) {
+        for (i = 0; i < count; i++) {
+            found += rbSearch(&tree_chars, ids[i].id_name) != NULL;
+            found += rbSearch(&tree_chars, misses[i]) != NULL;
+        }
+    }
+    t_search[2] = nowNs() - t_begin;
+
+    if (found != count * LOOKUP_ROUNDS * 3) {
+        fprintf(stderr, "wrong result: %lld hits, %lld expected\r\n",
+            (long long)found, (long long)(count * LOOKUP_ROUNDS * 3));
+    }
+
+    double lookups = (double)(count * LOOKUP_ROUNDS * 2);
+    printf("%8lld | add ns/op: hash %6.1f  rb-intern %6.1f  rb-chars %6.1f"
+           " | search ns/op: hash %6.1f  rb-intern %6.1f  rb-chars %6.1f\r\n",
+        (long long)count,
+        t_add[0] / count, t_add[1] / count, t_add[2] / count,
+        t_search[0] / lookups, t_search[1] / lookups, t_search[2] / lookups);
+
+    identTableDestroy(&table);
+    rbDestroyNode(tree_intern.root);
+    rbDestroyNode(tree_chars.root);
+    mem_free(ids);
+    mem_free(misses);
+}
+
+int main() {
+    // the local scopes usually hold a handful of identifiers and the
+    // module scopes hold hundreds to thousands.
+    int64 counts[] = {8, 32, 256, 4096, 65536};
+    int   i;
+    for (i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+        benchRun(counts[i]);
+    }
+    internDestroy();
+    return 0;
+}
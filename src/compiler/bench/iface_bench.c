@@ -0,0 +1,124 @@
+/**
+ * Copyright 2015 JiKai. All rights reserved.
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file.
+ *
+ *     This file measures importing a big module from its
+ * interface file. the frozen table maps the file and only
+ * makes the identifiers looked up, the rebuilt table adds
+ * all identifiers into a new IdentTable like the loader of
+ * the first format did.
+ *
+ * build and run(in the src/compiler directory):
+ *     gcc -O2 bench/iface_bench.c common.c utf.c intern.c lexer.c keyword.c scan.c dynamicarr.c arena.c \
+ *         convert.c ident.c dirscan.c module.c iface.c path.c project.c -lpthread -o iface_bench
+ *     ./iface_bench
+ **/
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "../iface.h"
+
+#define BENCH_DIR     "/tmp/cplus_iface_bench"
+#define BENCH_LOOKUPS 16
+#define BENCH_ROUNDS  50
+
+static double now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// a module named "big" which exports the count functions.
+static void create_module(int count) {
+    FILE* file;
+    int   i;
+    system("rm -rf " BENCH_DIR);
+    system("mkdir -p " BENCH_DIR "/bin " BENCH_DIR "/src/big.mod");
+    file = fopen(BENCH_DIR "/src/big.mod/big.cplus", "w");
+    for (i = 0; i < count; i++) {
+        fprintf(file, "func exported_function_%d(a int32) {\n    return a\n}\n", i);
+    }
+    fclose(file);
+}
+
+static Module* open_module(ProjectConfig* projconf) {
+    char path[] = BENCH_DIR "/src/big.mod";
+    return moduleNewByPath(path, strlen(path), projconf, NULL);
+}
+
+static int64 lookup(IdentTable* table, char** names) {
+    int64 hits = 0;
+    int   i;
+    for (i = 0; i < BENCH_LOOKUPS; i++) {
+        hits += identTableSearch(table, names[i]) != NULL ? 1 : 0;
+    }
+    return hits;
+}
+
+static void bench(ProjectConfig* projconf, int count) {
+    char        buff[64];
+    char*       names[BENCH_LOOKUPS];
+    Module*     mod;
+    IdentTable  rebuilt;
+    Ident*      id;
+    Ident*      copy;
+    uint64      hash;
+    int64       bytes;
+    int64       hits = 0;
+    uint32      iter;
+    double      begin, frozen_ns = 0, rebuilt_ns = 0;
+    int         i, round;
+
+    create_module(count);
+    mod = open_module(projconf);
+    moduleParse(mod, NULL);
+    moduleDestroy(mod);
+    for (i = 0; i < BENCH_LOOKUPS; i++) {
+        sprintf(buff, "exported_function_%d", (int)((int64)i * count / BENCH_LOOKUPS));
+        names[i] = internCStr(buff);
+    }
+
+    for (round = 0; round < BENCH_ROUNDS; round++) {
+        mod = open_module(projconf);
+        ifaceHashSources(mod, &hash, &bytes);
+        begin = now_ns();
+        if (ifaceLoad(mod, hash) != NULL) {
+            fprintf(stderr, "can not load the interface file\r\n");
+            exit(EXIT_FAILURE);
+        }
+        hits += lookup(mod->id_table, names);
+        frozen_ns += now_ns() - begin;
+
+        begin = now_ns();
+        identTableInit(&rebuilt);
+        for (iter = 0; (id = identTableNext(mod->id_table, &iter)) != NULL;) {
+            copy = identNew(NULL, ID_TYPE_UNRESOLVED);
+            *copy = *id;
+            identTableAdd(&rebuilt, copy);
+        }
+        hits += lookup(&rebuilt, names);
+        rebuilt_ns += now_ns() - begin;
+        identTableDestroy(&rebuilt);
+        moduleDestroy(mod);
+    }
+    if (hits != (int64)BENCH_LOOKUPS * BENCH_ROUNDS * 2) {
+        fprintf(stderr, "wrong result: %lld hits\r\n", hits);
+        exit(EXIT_FAILURE);
+    }
+    printf("%8d exports | load and %d lookups: frozen %9.1fus  rebuilt %9.1fus\r\n",
+           count, BENCH_LOOKUPS, frozen_ns / BENCH_ROUNDS / 1e3, rebuilt_ns / BENCH_ROUNDS / 1e3);
+}
+
+int main() {
+    ProjectConfig projconf;
+    int           count;
+    projectConfigInit(&projconf, "/usr/local/cplus-1.0/bin/cplus", BENCH_DIR "/src/big.mod");
+    for (count = 64; count <= 65536; count *= 4) {
+        bench(&projconf, count);
+    }
+    projectConfigDestroy(&projconf);
+    system("rm -rf " BENCH_DIR);
+    return 0;
+}
@@ -0,0 +1,88 @@
+/**
+ * Copyright 2015 JiKai. All rights reserved.
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file.
+ *
+ *     This file measures the throughput of the lexerParseToken
+ * on a corpus generated by the tool/corpusgen.c, in both the
+ * stream mode and the mapped mode. the best round of each
+ * mode is reported in MB/s and tokens/s.
+ *
+ * build and run(in the src/compiler directory):
+ *     make bench
+ * or:
+ *     gcc -O2 tool/corpusgen.c -o corpusgen && ./corpusgen /tmp/cplus_bench.cplus
+ *     gcc -O2 bench/lexer_bench.c common.c utf.c intern.c lexer.c keyword.c scan.c dynamicarr.c \
+ *         arena.c convert.c -o lexer_bench
+ *     ./lexer_bench /tmp/cplus_bench.cplus
+ **/
+
+#include <stdio.h>
+#include <time.h>
+#include "../lexer.h"
+
+#define BENCH_ROUNDS 5
+
+static double now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+// lex the whole file and return the number of the tokens, or -1 if the
+// lexer fails before the end of the file.
+static int64 lex(char* path, int8 mode) {
+    Lexer lexer;
+    error err;
+    int64 tokens = 0;
+    lexerInit(&lexer);
+    if ((err = lexerOpenSrcFileMode(&lexer, path, mode)) != NULL) {
+        fprintf(stderr, "%s\r\n", err);
+        lexTokenDestroy(&lexer.lextkn);
+        return -1;
+    }
+    while ((err = lexerParseToken(&lexer)) == NULL) {
+        lexerNextToken(&lexer);
+        tokens++;
+    }
+    if (ERROR_CODE(err) != LEX_ERROR_EOF) {
+        fprintf(stderr, "%s:%d: %s\r\n", path, lexer.pos_line, err);
+        tokens = -1;
+    }
+    lexerDestroy(&lexer);
+    return tokens;
+}
+
+static void bench(char* path, int8 mode, int64 size) {
+    double begin, ms, best = -1;
+    int64  tokens;
+    int    i;
+    for (i = 0; i < BENCH_ROUNDS; i++) {
+        begin  = now_ms();
+        tokens = lex(path, mode);
+        ms     = now_ms() - begin;
+        if (tokens < 0) {
+            return;
+        }
+        best = best < 0 || ms < best ? ms : best;
+    }
+    printf("%-6s | %10lld tokens | %8.2fms | %8.1f MB/s | %6.2f M tokens/s\r\n", mode == LEX_MODE_MAPPED ? "mapped" : "stream",
+        (long long)tokens, best, size / 1048576.0 / (best / 1e3), tokens / 1e6 / (best / 1e3));
+}
+
+int main(int argc, char* argv[]) {
+    FILE* file;
+    int64 size;
+    if (argc != 2 || (file = fopen(argv[1], "rb")) == NULL) {
+        fprintf(stderr, "usage: lexer_bench corpus.cplus\r\n");
+        return 1;
+    }
+    fseek(file, 0, SEEK_END);
+    size = ftell(file);
+    fclose(file);
+
+    printf("lexer: %s, %.2fMB, the best of %d rounds\r\n", argv[1], size / 1048576.0, BENCH_ROUNDS);
+    bench(argv[1], LEX_MODE_STREAM, size);
+    bench(argv[1], LEX_MODE_MAPPED, size);
+    return 0;
+}
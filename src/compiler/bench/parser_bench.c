@@ -0,0 +1,149 @@
+/**
+ * Copyright 2015 JiKai. All rights reserved.
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file.
+ *
+ *     This file measures the expression parser on a corpus
+ * generated by the tool/corpusgen.c. every statement which
+ * begins with an identifier, and the conditions of the "if"
+ * and the "for" and the values returned, are parsed by the
+ * ExprParser. the best round is reported in expression nodes
+ * per second and the bytes of the AST arena per node. the
+ * lexing is included in the time, see the lexer_bench.c for
+ * the lexing only.
+ *
+ * build and run(in the src/compiler directory):
+ *     make bench
+ * or:
+ *     gcc -O2 tool/corpusgen.c -o corpusgen && ./corpusgen /tmp/cplus_bench.cplus
+ *     gcc -O2 bench/parser_bench.c common.c utf.c intern.c lexer.c keyword.c scan.c dynamicarr.c \
+ *         arena.c convert.c expression.c -o parser_bench
+ *     ./parser_bench /tmp/cplus_bench.cplus
+ **/
+
+#include <stdio.h>
+#include <time.h>
+#include "../expression.h"
+
+#define BENCH_ROUNDS 5
+
+typedef struct {
+    int64  exprs;
+    int64  nodes;
+    int64  bytes;   // the bytes allocated from the AST arena
+    double ms;
+}ParseResult;
+
+static double now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+// the number of the ASTNodeExpr in the expression.
+static int64 count_nodes(ASTNodeExpr* expr) {
+    int64 count = 1;
+    int32 i;
+    switch (expr->expr_type) {
+    case AST_NODE_EXPR_UNRY:
+        count += count_nodes(expr->expr.expr_unary->oprd);
+        break;
+    case AST_NODE_EXPR_BNRY:
+        count += count_nodes(expr->expr.expr_binary->oprd1) + count_nodes(expr->expr.expr_binary->oprd2);
+        break;
+    case AST_NODE_INDEX:
+        count += count_nodes(expr->expr.expr_index->index);
+        break;
+    case AST_NODE_FUNC_CALL:
+        for (i = 0; i < expr->expr.expr_func_call->func_params->count; i++) {
+            count += count_nodes(expr->expr.expr_func_call->func_params->exprs[i]);
+        }
+        break;
+    }
+    return count;
+}
+
+// parse all expressions of the file. the nodes are counted only if the
+// count is true, so the rounds timed do not walk the AST. return
+// false if an expression can not be parsed.
+static bool parse(char* path, ParseResult* result, bool count) {
+    Lexer        lexer;
+    Arena        arena;
+    ExprParser   ep;
+    LexToken*    token;
+    ASTNodeExpr* expr;
+    double       begin;
+
+    lexerInit(&lexer);
+    if (lexerOpenSrcFileMapped(&lexer, path) != NULL) {
+        lexTokenDestroy(&lexer.lextkn);
+        return false;
+    }
+    arenaInit(&arena, ARENA_BLOCK_SIZE);
+    exprParserInit(&ep, &lexer, &arena);
+    result->exprs = 0;
+    result->nodes = 0;
+    begin = now_ms();
+    while (lexerParseToken(&lexer) == NULL) {
+        token = lexerReadToken(&lexer);
+        switch (token->token_code) {
+        case TOKEN_KEYWORD_IF:
+        case TOKEN_KEYWORD_FOR:
+        case TOKEN_KEYWORD_RETURN:
+            lexerNextToken(&lexer);
+        case TOKEN_ID:
+            // the token ending the expression is left in the lexer.
+            if ((expr = exprParse(&ep)) == NULL) {
+                fprintf(stderr, "%s:%d: %s\r\n", path, lexer.pos_line, ep.err);
+                exprParserDestroy(&ep);
+                arenaDestroy(&arena);
+                lexerDestroy(&lexer);
+                return false;
+            }
+            if (count == true) {
+                result->nodes += count_nodes(expr);
+            }
+            result->exprs++;
+            break;
+
+        default:
+            lexerNextToken(&lexer);
+            break;
+        }
+    }
+    result->ms    = now_ms() - begin;
+    result->bytes = arena.allocated;
+    exprParserDestroy(&ep);
+    arenaDestroy(&arena);
+    lexerDestroy(&lexer);
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    ParseResult result, best;
+    FILE*       file;
+    int64       size;
+    int         i;
+    if (argc != 2 || (file = fopen(argv[1], "rb")) == NULL) {
+        fprintf(stderr, "usage: parser_bench corpus.cplus\r\n");
+        return 1;
+    }
+    fseek(file, 0, SEEK_END);
+    size = ftell(file);
+    fclose(file);
+
+    if (parse(argv[1], &best, true) == false) {
+        return 1;
+    }
+    for (i = 0; i < BENCH_ROUNDS; i++) {
+        if (parse(argv[1], &result, false) == false) {
+            return 1;
+        }
+        best.ms = result.ms < best.ms ? result.ms : best.ms;
+    }
+    printf("parser: %s, %.2fMB, the best of %d rounds\r\n", argv[1], size / 1048576.0, BENCH_ROUNDS);
+    printf("expr   | %10lld exprs | %10lld nodes | %8.2fms | %8.1f MB/s | %6.2f M nodes/s | %5.1f bytes/node\r\n",
+        (long long)best.exprs, (long long)best.nodes, best.ms, size / 1048576.0 / (best.ms / 1e3),
+        best.nodes / 1e6 / (best.ms / 1e3), best.nodes > 0 ? (double)best.bytes / best.nodes : 0.0);
+    return 0;
+}
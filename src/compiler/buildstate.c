@@ -0,0 +1,303 @@
+/**
+ * Copyright 2015 JiKai. All rights reserved.
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file.
+ **/
+
+#include "buildstate.h"
+
+static int64 buildStateNow() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+void buildStateInit(BuildState* state, const ProjectConfig* projconf) {
+    DynamicArrStr dstr;
+    state->path      = NULL;
+    state->started   = buildStateNow();
+    state->saved     = 0;
+    state->mods      = NULL;
+    state->mod_count = 0;
+    state->mod_cap   = 0;
+    if (projconf->path_bindir != NULL && path_isdir(projconf->path_bindir) == NULL) {
+        dynamicArrStrInit   (&dstr, DYNAMIC_ARR_STR_SMALL);
+        dynamicArrStrAppend (&dstr, projconf->path_bindir, projconf->path_bindir_len);
+        dynamicArrStrAppendc(&dstr, '/');
+        dynamicArrStrAppend (&dstr, BUILD_STATE_FILE_NAME, strlen(BUILD_STATE_FILE_NAME));
+        state->path = dynamicArrStrDetach(&dstr);
+    }
+}
+
+/****** loading ******/
+
+static void buildStateDestroyMod(BuildStateMod* rec) {
+    int32 i;
+    for (i = 0; i < rec->file_count; i++) {
+        mem_free(rec->files[i].file_name);
+    }
+    mem_free(rec->files);
+    mem_free(rec->deps);
+    mem_free(rec->dep_hashes);
+}
+
+static void buildStateClear(BuildState* state) {
+    int32 i;
+    for (i = 0; i < state->mod_count; i++) {
+        buildStateDestroyMod(&state->mods[i]);
+    }
+    mem_free(state->mods);
+    state->mods      = NULL;
+    state->mod_count = 0;
+    state->mod_cap   = 0;
+    state->saved     = 0;
+}
+
+static int buildStateModCmp(const void* a, const void* b) {
+    const BuildStateMod* rec1 = (const BuildStateMod*)a;
+    const BuildStateMod* rec2 = (const BuildStateMod*)b;
+    if (rec1->mod_name == rec2->mod_name) {
+        return 0;
+    }
+    return rec1->mod_name < rec2->mod_name ? -1 : 1;
+}
+
+// return the name at the end of the line without the line break.
+static char* buildStateLineTail(char* line, int offset) {
+    int len = strlen(line);
+    while (len > offset && (line[len-1] == '\n' || line[len-1] == '\r')) {
+        len--;
+    }
+    line[len] = '\0';
+    return line + offset;
+}
+
+// read the lines of a module after its "mod" line.
+static error buildStateLoadMod(BuildStateMod* rec, FILE* file, char** line, size_t* cap) {
+    unsigned long long hash, size;
+    long long          mtime;
+    int                offset, i;
+
+    rec->deps       = (char**)mem_alloc(sizeof(char*) * (rec->dep_count + 1));
+    rec->dep_hashes = (uint64*)mem_alloc(sizeof(uint64) * (rec->dep_count + 1));
+    rec->files      = (BuildStateFile*)mem_alloc(sizeof(BuildStateFile) * (rec->file_count + 1));
+    for (i = 0; i < rec->dep_count; i++) {
+        if (getline(line, cap, file) < 0 || sscanf(*line, "dep %llx %n", &hash, &offset) != 1) {
+            rec->file_count = 0;
+            return new_error("the build state is broken.");
+        }
+        rec->dep_hashes[i] = hash;
+        rec->deps[i]       = internCStr(buildStateLineTail(*line, offset));
+    }
+    for (i = 0; i < rec->file_count; i++) {
+        if (getline(line, cap, file) < 0 || sscanf(*line, "file %lld %llu %llx %n", &mtime, &size, &hash, &offset) != 3) {
+            rec->file_count = i;
+            return new_error("the build state is broken.");
+        }
+        rec->files[i].file_name = mem_strdup(buildStateLineTail(*line, offset));
+        rec->files[i].mtime     = mtime;
+        rec->files[i].size      = size;
+        rec->files[i].hash      = hash;
+    }
+    return NULL;
+}
+
+// load the state saved by the last build. if the state is broken or saved
+// by the other versions of the compiler, it is the same as no state and
+// all modules are rebuilt.
+error buildStateLoad(BuildState* state) {
+    char*              line = NULL;
+    size_t             cap  = 0;
+    char*              name;
+    FILE*              file;
+    BuildStateMod*     rec;
+    unsigned long long src_hash, iface_hash;
+    long long          saved;
+    int                format, dep_count, file_count, offset;
+    error              err  = NULL;
+
+    if (state->path == NULL || (file = fopen(state->path, "r")) == NULL) {
+        return new_error("the build state does not exist.");
+    }
+    if (getline(&line, &cap, file) < 0 ||
+        sscanf(line, "cplus-build %d %n", &format, &offset) != 1 || format != BUILD_STATE_FORMAT ||
+        strncmp(line + offset, CPLUS_VERSION " ", strlen(CPLUS_VERSION) + 1) != 0 ||
+        sscanf(line + offset + strlen(CPLUS_VERSION) + 1, "%lld", &saved) != 1) {
+        err = new_error("the build state is saved by the other compiler.");
+    }
+    else {
+        state->saved = saved;
+    }
+    while (err == NULL && getline(&line, &cap, file) >= 0) {
+        name = (char*)mem_alloc(strlen(line) + 1);
+        if (sscanf(line, "mod %s %llx %llx %d %d", name, &src_hash, &iface_hash, &dep_count, &file_count) != 5 ||
+            dep_count < 0 || file_count < 0) {
+            mem_free(name);
+            err = new_error("the build state is broken.");
+            break;
+        }
+        if (state->mod_count == state->mod_cap) {
+            state->mod_cap = state->mod_cap == 0 ? 16 : state->mod_cap * 2;
+            state->mods    = (BuildStateMod*)mem_realloc(state->mods, sizeof(BuildStateMod) * state->mod_cap);
+        }
+        rec = &state->mods[state->mod_count++];
+        rec->mod_name   = internCStr(name);
+        rec->src_hash   = src_hash;
+        rec->iface_hash = iface_hash;
+        rec->dep_count  = dep_count;
+        rec->file_count = file_count;
+        rec->replaced   = false;
+        mem_free(name);
+        err = buildStateLoadMod(rec, file, &line, &cap);
+    }
+    free(line);
+    fclose(file);
+    if (err != NULL) {
+        buildStateClear(state);
+        return err;
+    }
+    qsort(state->mods, state->mod_count, sizeof(BuildStateMod), buildStateModCmp);
+    return NULL;
+}
+
+static BuildStateMod* buildStateGetMod(BuildState* state, char* mod_name) {
+    BuildStateMod key;
+    key.mod_name = mod_name;
+    if (state->mod_count == 0) {
+        return NULL;
+    }
+    return (BuildStateMod*)bsearch(&key, state->mods, state->mod_count, sizeof(BuildStateMod), buildStateModCmp);
+}
+
+/****** comparing ******/
+
+// copy the recorded hashes of the source files of the module into its
+// SourceFiles, so the files not changed are not read when they are hashed.
+// the both lists are sorted by the names.
+void buildStateFill(BuildState* state, Module* mod) {
+    BuildStateMod* rec = buildStateGetMod(state, mod->mod_name);
+    SourceFile*    src;
+    int32          i   = 0;
+    int            cmp;
+    if (rec == NULL) {
+        return;
+    }
+    rec->replaced = true;
+    for (src = mod->srcfiles; src != NULL && i < rec->file_count;) {
+        cmp = strcmp(src->file_name, rec->files[i].file_name);
+        if (cmp < 0) {
+            src = src->next;
+            continue;
+        }
+        if (cmp == 0 && rec->files[i].mtime < state->saved) {
+            src->mtime = rec->files[i].mtime;
+            src->size  = rec->files[i].size;
+            src->hash  = rec->files[i].hash;
+        }
+        if (cmp == 0) {
+            src = src->next;
+        }
+        i++;
+    }
+}
+
+// the last build of the module is still valid if its sources are the same,
+// and the interfaces of the modules included by it are the same. all
+// modules included must be parsed.
+bool buildStateIsValid(BuildState* state, Module* mod) {
+    BuildStateMod* rec = buildStateGetMod(state, mod->mod_name);
+    int32          i;
+    if (rec == NULL || mod->src_hash == 0 || rec->src_hash != mod->src_hash || rec->dep_count != mod->dep_count) {
+        return false;
+    }
+    for (i = 0; i < mod->dep_count; i++) {
+        if (mod->dep_mods[i] == NULL || rec->deps[i] != mod->deps[i] || rec->dep_hashes[i] != mod->dep_mods[i]->iface_hash) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/****** saving ******/
+
+static void buildStateWriteMod(FILE* file, Module* mod) {
+    SourceFile* src;
+    int32       file_count = 0;
+    int32       i;
+    for (src = mod->srcfiles; src != NULL; src = src->next) {
+        file_count++;
+    }
+    fprintf(file, "mod %s %016llx %016llx %d %d\n", mod->mod_name,
+        (unsigned long long)mod->src_hash, (unsigned long long)mod->iface_hash, mod->dep_count, file_count);
+    for (i = 0; i < mod->dep_count; i++) {
+        fprintf(file, "dep %016llx %s\n", (unsigned long long)mod->dep_mods[i]->iface_hash, mod->deps[i]);
+    }
+    for (src = mod->srcfiles; src != NULL; src = src->next) {
+        fprintf(file, "file %lld %llu %016llx %s\n", (long long)src->mtime,
+            (unsigned long long)src->size, (unsigned long long)src->hash, src->file_name);
+    }
+}
+
+static void buildStateWriteRec(FILE* file, BuildStateMod* rec) {
+    int32 i;
+    fprintf(file, "mod %s %016llx %016llx %d %d\n", rec->mod_name,
+        (unsigned long long)rec->src_hash, (unsigned long long)rec->iface_hash, rec->dep_count, rec->file_count);
+    for (i = 0; i < rec->dep_count; i++) {
+        fprintf(file, "dep %016llx %s\n", (unsigned long long)rec->dep_hashes[i], rec->deps[i]);
+    }
+    for (i = 0; i < rec->file_count; i++) {
+        fprintf(file, "file %lld %llu %016llx %s\n", (long long)rec->files[i].mtime,
+            (unsigned long long)rec->files[i].size, (unsigned long long)rec->files[i].hash, rec->files[i].file_name);
+    }
+}
+
+// save the modules of the current build and the modules recorded but not
+// in the current build. all modules passed must be built successfully.
+error buildStateSave(BuildState* state, Module** mods, int32 count) {
+    char   suffix[32];
+    char*  tmp;
+    FILE*  file;
+    int32  i;
+    error  err = NULL;
+
+    if (state->path == NULL) {
+        return new_error("the project does not have the binary directory.");
+    }
+    sprintf(suffix, ".%d.tmp", (int)getpid());
+    tmp = (char*)mem_alloc(strlen(state->path) + strlen(suffix) + 1);
+    strcpy(tmp, state->path);
+    strcat(tmp, suffix);
+    if ((file = fopen(tmp, "w")) == NULL) {
+        mem_free(tmp);
+        return new_error("can not create the build state.");
+    }
+    fprintf(file, "cplus-build %d %s %lld\n", BUILD_STATE_FORMAT, CPLUS_VERSION, (long long)state->started);
+    for (i = 0; i < count; i++) {
+        buildStateWriteMod(file, mods[i]);
+    }
+    for (i = 0; i < state->mod_count; i++) {
+        if (state->mods[i].replaced == false) {
+            buildStateWriteRec(file, &state->mods[i]);
+        }
+    }
+    if (ferror(file) != 0) {
+        err = new_error("can not write the build state.");
+    }
+    if (fclose(file) != 0 && err == NULL) {
+        err = new_error("can not write the build state.");
+    }
+    if (err == NULL && rename(tmp, state->path) != 0) {
+        err = new_error("can not write the build state.");
+    }
+    if (err != NULL) {
+        unlink(tmp);
+    }
+    mem_free(tmp);
+    return err;
+}
+
+void buildStateDestroy(BuildState* state) {
+    buildStateClear(state);
+    mem_free(state->path);
+    state->path = NULL;
+}
@@ -0,0 +1,74 @@
+/**
+ * Copyright 2015 JiKai. All rights reserved.
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file.
+ *
+ *     The buildstate.h and buildstate.c record what the last
+ * build of a project saw, so the next build only rebuilds the
+ * modules whose sources or included interfaces are changed.
+ **/
+
+#ifndef CPLUS_BUILDSTATE_H
+#define CPLUS_BUILDSTATE_H
+
+#include <time.h>
+#include <sys/stat.h>
+#include "common.h"
+#include "project.h"
+#include "module.h"
+#include "intern.h"
+
+// the state is saved in the binary directory of the project as a text file:
+//
+//   cplus-build <format> <version> <time>
+//   mod  <name> <src_hash> <iface_hash> <dep_count> <file_count>
+//   dep  <iface_hash> <name>                    -> dep_count lines
+//   file <mtime> <size> <hash> <file_name>      -> file_count lines
+//   ...
+//
+// the time is when the build saving the state started. a file modified
+// after that may have been changed while it was hashed, so its hash is
+// not trusted even if its mtime and size are the same.
+//
+// the modules not in the current build are kept in the state, so building
+// the different programs of a project does not lose their states.
+//
+#define BUILD_STATE_FILE_NAME ".cplusbuild"
+#define BUILD_STATE_FORMAT    1
+
+typedef struct BuildStateFile {
+    char*  file_name;
+    int64  mtime;
+    int64  size;
+    uint64 hash;
+}BuildStateFile;
+
+typedef struct BuildStateMod {
+    char*           mod_name;   // interned
+    uint64          src_hash;
+    uint64          iface_hash;
+    int32           dep_count;
+    char**          deps;       // interned
+    uint64*         dep_hashes; // the interface hashes of the deps when the module was built
+    int32           file_count;
+    BuildStateFile* files;      // sorted by the names like the SourceFiles
+    bool            replaced;   // the module is in the current build
+}BuildStateMod;
+
+typedef struct BuildState {
+    char*          path;      // NULL if the project does not have the binary directory
+    int64          started;   // the time the current build started
+    int64          saved;     // the time the build saving the state started
+    BuildStateMod* mods;      // sorted by the interned names
+    int32          mod_count;
+    int32          mod_cap;
+}BuildState;
+
+extern void  buildStateInit   (BuildState* state, const ProjectConfig* projconf);
+extern error buildStateLoad   (BuildState* state);
+extern void  buildStateFill   (BuildState* state, Module* mod);
+extern bool  buildStateIsValid(BuildState* state, Module* mod);
+extern error buildStateSave   (BuildState* state, Module** mods, int32 count);
+extern void  buildStateDestroy(BuildState* state);
+
+#endif
@@ -7,71 +7,170 @@
 #include "closectr.h"
 
 void closeCounterInit(CloseCounter* clsctr) {
-    clsctr->top = NULL;
+    closeCounterStackInit(&clsctr->stack, NULL);
 }
 
 void closeCounterIncrease(CloseCounter* clsctr, char left_optr) {
-    CloseCounterNode* create = (CloseCounterNode*)mem_alloc(sizeof(CloseCounterNode));
-    create->optr = left_optr;
-    if (clsctr->top != NULL) {
-        create->next = clsctr->top;
-        clsctr->top  = create;
-    }
-    else {
-        clsctr->top = create;
-    }
+    closeCounterStackPush(&clsctr->stack, left_optr);
 }
 
 error closeCounterDecrease(CloseCounter* clsctr, char right_optr) {
-    if (clsctr->top == NULL) {
+    char* top = closeCounterStackTop(&clsctr->stack);
+    if (top == NULL) {
         return new_error("err: the close_counter is empty.");
     }
     // can only process the closing for (), [] or {}.
     switch (right_optr) {
     case ')':
-        if (clsctr->top->optr != '(') {
+        if (*top != '(') {
             return new_error("err: miss match for the left opeator to close.");
         }
         break;
     case ']':
-        if (clsctr->top->optr != '[') {
+        if (*top != '[') {
             return new_error("err: miss match for the left opeator to close.");
         }
         break;
     case '}':
-        if (clsctr->top->optr != '{') {
+        if (*top != '{') {
             return new_error("err: miss match for the left opeator to close.");
         }
         break;
     default:
         return new_error("err: can only count the (), [] or {}.");
     }
-    // pop the top node in the stack and release
-    // the memory of the node.
-    CloseCounterNode* temp = clsctr->top;
-    clsctr->top = clsctr->top->next;
-    mem_free(temp);
+    // pop the top operator in the stack, the memory is
+    // kept for the next one.
+    closeCounterStackPop(&clsctr->stack);
+    return NULL;
 }
 
 // return true when there is nothing in the stack.
 bool closeCounterIsClear(CloseCounter* clsctr) {
-    if (clsctr->top == NULL) {
+    if (clsctr->stack.count == 0) {
         return true;
     }
     return false;
 }
 
 void closeCounterDestroy(CloseCounter* clsctr) {
-    if (clsctr->top == NULL) {
-        return;
+    closeCounterStackDestroy(&clsctr->stack);
+}
+
+/****** splitting the source code ******/
+
+static bool closeIsIdent(char ch) {
+    return ('a' <= ch && ch <= 'z') || ('A' <= ch && ch <= 'Z') || ('0' <= ch && ch <= '9') || ch == '_' ? true : false;
+}
+
+// return true if a top-level declaration("func" or "type") begins at the
+// line. the spaces and tabs before it are skipped.
+static bool closeIsDecl(const char* p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t')) {
+        p++;
     }
-    CloseCounterNode* temp = NULL;
-    for (;;) {
-        temp = clsctr->top;
-        if (temp == NULL) {
-            return;
+    if (end - p < 5 || (memcmp(p, "func", 4) != 0 && memcmp(p, "type", 4) != 0)) {
+        return false;
+    }
+    return closeIsIdent(p[4]) == true ? false : true;
+}
+
+// find the top-level declarations to split the source code into chunks
+// which can be lexed separately. the brace depth is tracked and the strings,
+// the chars and the comments are skipped like the lexer does, so a chunk
+// always begins at a line where a "func" or a "type" is written out of all
+// braces. every chunk except the last one is at least min_size bytes.
+//
+// the splits[i] is the beginning of the i-th chunk, the splits[0] is the
+// beginning of the source code. return the number of the chunks.
+//
+// example:
+//    include "net"        <- splits[0], line 1
+//    func get() {
+//        s = "func }"
+//    }
+//    type Request {       <- splits[1], line 5 if min_size <= the bytes above
+//    }
+//
+int32 closeCounterSplit(const char* src, int64 len, int64 min_size, CloseSplit* splits, int32 max_splits) {
+    const char* p     = src;
+    const char* end   = src + len;
+    int64       depth = 0;
+    int32       line  = 1;
+    int32       count = 1;
+    int32       embed;
+
+    splits[0].offset = 0;
+    splits[0].line   = 1;
+    while (p < end && count < max_splits) {
+        switch (*p) {
+        case '{':
+            depth++;
+            p++;
+            break;
+
+        case '}':
+            depth--;
+            p++;
+            break;
+
+        case '\r':
+        case '\n':
+            line++;
+            p++;
+            if (depth == 0 && p - src - splits[count-1].offset >= min_size && closeIsDecl(p, end) == true) {
+                splits[count].offset = p - src;
+                splits[count].line   = line;
+                count++;
+            }
+            break;
+
+        // the strings end at the next quotation, the line-feeds in them
+        // are not counted by the lexer.
+        case '"':
+            for (p++; p < end && *p != '"'; p++);
+            p++;
+            break;
+
+        // the char may be escaped or be a UTF-8 char of several bytes.
+        case '\'':
+            p += p + 1 < end && p[1] == '\\' ? 3 : 2;
+            for (; p < end && *p != '\'' && *p != '\n'; p++);
+            p += p < end && *p == '\'';
+            break;
+
+        case '/':
+            if (p + 1 < end && p[1] == '/') {
+                for (p += 2; p < end && *p != '\r' && *p != '\n'; p++);
+            }
+            else if (p + 1 < end && p[1] == '*') {
+                // the comments can be embedded, only the '\n' is counted.
+                for (p += 2, embed = 0; p < end; ) {
+                    if (p[0] == '*' && p + 1 < end && p[1] == '/') {
+                        p += 2;
+                        if (embed-- <= 0) {
+                            break;
+                        }
+                    }
+                    else if (p[0] == '/' && p + 1 < end && p[1] == '*') {
+                        p += 2;
+                        embed++;
+                    }
+                    else {
+                        line += *p == '\n';
+                        p++;
+                    }
+                }
+            }
+            else {
+                p++;
+            }
+            break;
+
+        default:
+            p++;
+            break;
         }
-        clsctr->top = clsctr->top->next;
-        mem_free(temp);
     }
+    return count;
 }
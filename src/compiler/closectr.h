@@ -12,20 +12,20 @@
 
 #include <string.h>
 #include "common.h"
+#include "dynamicarr.h"
 
-typedef struct CloseCounterNode {
-    char optr;
-    struct CloseCounterNode* next;
-}CloseCounterNode;
+DYNAMIC_ARR_DEFINE(CloseCounterStack, closeCounterStack, char)
 
 // when the close counter meet the left-side operator
 // like (, [, { or /*, it will push the operator in
 // the stack.
 // when the close counter meet the right-sideoperator
 // like ), ], } or */, it will pop the top one
-// operator in the stack.
+// operator in the stack. the operators are kept in one
+// contiguous array, so the nesting costs no allocation
+// once the array is big enough.
 typedef struct {
-    CloseCounterNode* top;
+    CloseCounterStack stack;
 }CloseCounter;
 
 extern void  closeCounterInit    (CloseCounter* clsctr);
@@ -34,4 +34,14 @@ extern error closeCounterDecrease(CloseCounter* clsctr, char right_optr);
 extern bool  closeCounterIsClear (CloseCounter* clsctr);
 extern void  closeCounterDestroy (CloseCounter* clsctr);
 
+// a place where the source code can be split, found by closeCounterSplit.
+// the line is the line number of the offset, counted the same way as the
+// lexer does.
+typedef struct CloseSplit {
+    int64 offset;
+    int32 line;
+}CloseSplit;
+
+extern int32 closeCounterSplit(const char* src, int64 len, int64 min_size, CloseSplit* splits, int32 max_splits);
+
 #endif
@@ -4,6 +4,7 @@
  * license that can be found in the LICENSE file.
  **/
 
+#include <pthread.h>
 #include "common.h"
 
 error new_error(char* errmsg) {
@@ -13,12 +14,30 @@ error new_error(char* errmsg) {
     return errmsg;
 }
 
+#ifndef CPLUS_MEM_STATS
 void* mem_alloc(size_t size) {
     void* ptr = malloc(size);
     if (ptr != NULL) {
         return ptr;
     }
-    assert("malloc panic!!!");
+    fatal("malloc panic!!!\r\n");
+    return NULL;
+}
+
+void* mem_realloc(void* ptr, size_t size) {
+    ptr = realloc(ptr, size);
+    if (ptr != NULL) {
+        return ptr;
+    }
+    fatal("realloc panic!!!\r\n");
+    return NULL;
+}
+
+char* mem_strdup(const char* str) {
+    size_t len  = strlen(str);
+    char*  copy = (char*)mem_alloc(len + 1);
+    memcpy(copy, str, len + 1);
+    return copy;
 }
 
 void mem_free (void *ptr) {
@@ -27,6 +46,463 @@ void mem_free (void *ptr) {
         ptr = NULL;
     }
 }
+#else
+/****** the allocations counted by the CPLUS_MEM_STATS ******/
+
+#define MEM_STATS_FILES 64
+#define MEM_STATS_MAGIC 0x6d656d73
+
+typedef struct MemStatsHeader {
+    size_t size;
+    int32  slot;  // the index of the file in the mem_stats_files
+    int32  magic;
+}MemStatsHeader;
+
+typedef struct MemStatsCounts {
+    int64 allocs;
+    int64 reallocs;
+    int64 frees;
+    int64 bytes;  // the bytes of all allocations and reallocations
+    int64 live;
+    int64 peak;
+    int64 hist[MEM_STATS_BUCKETS];
+}MemStatsCounts;
+
+// the files are put in the slots the first time they allocate. the name
+// is the base name of the file, and the file is the __FILE__ met first,
+// so the same file is found again without comparing the names.
+typedef struct MemStatsFile {
+    const char*    name;
+    const char*    file;
+    int32          tag;
+    MemStatsCounts counts;
+}MemStatsFile;
+
+typedef struct MemStatsTagFile {
+    const char* name;
+    int32       tag;
+}MemStatsTagFile;
+
+static const char* mem_stats_tags[MEM_TAG_COUNT] = { "other", "lexer", "parser", "ident", "module", "build", "server" };
+
+static const MemStatsTagFile mem_stats_tag_files[] = {
+    { "lexer.c",      MEM_TAG_LEXER  }, { "keyword.c",    MEM_TAG_LEXER  }, { "scan.c",       MEM_TAG_LEXER  },
+    { "utf.c",        MEM_TAG_LEXER  }, { "convert.c",    MEM_TAG_LEXER  }, { "closectr.c",   MEM_TAG_LEXER  },
+    { "closectr.h",   MEM_TAG_LEXER  }, { "parser.c",     MEM_TAG_PARSER }, { "expression.c", MEM_TAG_PARSER },
+    { "ast.c",        MEM_TAG_PARSER }, { "ast.h",        MEM_TAG_PARSER }, { "scope.c",      MEM_TAG_PARSER },
+    { "ident.c",      MEM_TAG_IDENT  }, { "intern.c",     MEM_TAG_IDENT  }, { "module.c",     MEM_TAG_MODULE },
+    { "iface.c",      MEM_TAG_MODULE }, { "modgraph.c",   MEM_TAG_MODULE }, { "dirscan.c",    MEM_TAG_MODULE },
+    { "path.c",       MEM_TAG_MODULE }, { "project.c",    MEM_TAG_MODULE }, { "buildstate.c", MEM_TAG_BUILD  },
+    { "compiler.c",   MEM_TAG_BUILD  }, { "workpool.c",   MEM_TAG_BUILD  }, { "server.c",     MEM_TAG_SERVER },
+    { "cplus.c",      MEM_TAG_SERVER },
+};
+
+static MemStatsFile   mem_stats_files[MEM_STATS_FILES];
+static MemStatsCounts mem_stats_tag_counts[MEM_TAG_COUNT];
+static MemStatsCounts mem_stats_total;
+static int32          mem_stats_registered = 0;
+
+static void memStatsAtExit() {
+    char* path = getenv("CPLUS_MEM_STATS_JSON");
+    FILE* out;
+    memStatsPrint(stderr);
+    if (path != NULL && path[0] != '\0') {
+        if ((out = fopen(path, "w")) == NULL) {
+            fprintf(stderr, "can not write the memory stats to %s.\r\n", path);
+            return;
+        }
+        memStatsPrintJson(out);
+        fclose(out);
+    }
+}
+
+static int32 memStatsTagOf(const char* name) {
+    int32 i;
+    for (i = 0; i < (int32)(sizeof(mem_stats_tag_files) / sizeof(MemStatsTagFile)); i++) {
+        if (strcmp(mem_stats_tag_files[i].name, name) == 0) {
+            return mem_stats_tag_files[i].tag;
+        }
+    }
+    return MEM_TAG_OTHER;
+}
+
+// find the slot of the file, or take a free one for it. the last slot is
+// shared by the files which do not get their own.
+static int32 memStatsSlot(const char* file) {
+    const char* name;
+    const char* cur;
+    int32       i;
+    for (i = 0; i < MEM_STATS_FILES; i++) {
+        if (__atomic_load_n(&mem_stats_files[i].file, __ATOMIC_ACQUIRE) == file) {
+            return i;
+        }
+        if (__atomic_load_n(&mem_stats_files[i].name, __ATOMIC_ACQUIRE) == NULL) {
+            break;
+        }
+    }
+    if (file == NULL) {
+        file = "(unknown)";
+    }
+    name = strrchr(file, '/') != NULL ? strrchr(file, '/') + 1 : file;
+    for (i = 0; i < MEM_STATS_FILES - 1; i++) {
+        cur = NULL;
+        if (__atomic_compare_exchange_n(&mem_stats_files[i].name, &cur, name, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            mem_stats_files[i].tag = memStatsTagOf(name);
+            __atomic_store_n(&mem_stats_files[i].file, file, __ATOMIC_RELEASE);
+            return i;
+        }
+        if (strcmp(cur, name) == 0) {
+            // the slot is being taken by another thread.
+            while (__atomic_load_n(&mem_stats_files[i].file, __ATOMIC_ACQUIRE) == NULL);
+            return i;
+        }
+    }
+    if (__atomic_exchange_n(&mem_stats_files[i].name, "(more)", __ATOMIC_ACQ_REL) == NULL) {
+        __atomic_store_n(&mem_stats_files[i].file, "(more)", __ATOMIC_RELEASE);
+    }
+    return i;
+}
+
+static int32 memStatsBucket(size_t size) {
+    size_t limit  = 16;
+    int32  bucket = 0;
+    while (limit < size && bucket < MEM_STATS_BUCKETS - 1) {
+        limit <<= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+static void memStatsLive(MemStatsCounts* counts, int64 delta) {
+    int64 live = __atomic_add_fetch(&counts->live, delta, __ATOMIC_RELAXED);
+    int64 peak = __atomic_load_n(&counts->peak, __ATOMIC_RELAXED);
+    while (live > peak && !__atomic_compare_exchange_n(&counts->peak, &peak, live, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+
+// count the size allocated or reallocated by the file in the slot.
+static void memStatsCount(int32 slot, size_t size, bool realloced) {
+    MemStatsCounts* all[3];
+    int32           bucket = memStatsBucket(size);
+    int32           i;
+    all[0] = &mem_stats_files[slot].counts;
+    all[1] = &mem_stats_tag_counts[mem_stats_files[slot].tag];
+    all[2] = &mem_stats_total;
+    for (i = 0; i < 3; i++) {
+        __atomic_add_fetch(realloced == true ? &all[i]->reallocs : &all[i]->allocs, 1, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&all[i]->bytes, size, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&all[i]->hist[bucket], 1, __ATOMIC_RELAXED);
+        memStatsLive(all[i], size);
+    }
+}
+
+// release the size from the live bytes of the file in the slot.
+static void memStatsUncount(int32 slot, size_t size, bool freed) {
+    MemStatsCounts* all[3];
+    int32           i;
+    all[0] = &mem_stats_files[slot].counts;
+    all[1] = &mem_stats_tag_counts[mem_stats_files[slot].tag];
+    all[2] = &mem_stats_total;
+    for (i = 0; i < 3; i++) {
+        if (freed == true) {
+            __atomic_add_fetch(&all[i]->frees, 1, __ATOMIC_RELAXED);
+        }
+        __atomic_sub_fetch(&all[i]->live, size, __ATOMIC_RELAXED);
+    }
+}
+
+static MemStatsHeader* memStatsHeader(void* ptr) {
+    MemStatsHeader* head = (MemStatsHeader*)((char*)ptr - MEM_STATS_HEADER);
+    if (head->magic != MEM_STATS_MAGIC) {
+        fatal("the memory released is not from the mem_alloc.\r\n");
+    }
+    return head;
+}
+
+void* memStatsAlloc(size_t size, const char* file) {
+    MemStatsHeader* head = (MemStatsHeader*)malloc(MEM_STATS_HEADER + size);
+    int32           expect = 0;
+    if (head == NULL) {
+        fatal("malloc panic!!!\r\n");
+    }
+    if (__atomic_load_n(&mem_stats_registered, __ATOMIC_RELAXED) == 0 &&
+        __atomic_compare_exchange_n(&mem_stats_registered, &expect, 1, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+        atexit(memStatsAtExit);
+    }
+    head->size  = size;
+    head->slot  = memStatsSlot(file);
+    head->magic = MEM_STATS_MAGIC;
+    memStatsCount(head->slot, size, false);
+    return (char*)head + MEM_STATS_HEADER;
+}
+
+// the block is counted for the file reallocating it from now on.
+void* memStatsRealloc(void* ptr, size_t size, const char* file) {
+    MemStatsHeader* head;
+    if (ptr == NULL) {
+        return memStatsAlloc(size, file);
+    }
+    head = memStatsHeader(ptr);
+    memStatsUncount(head->slot, head->size, false);
+    if ((head = (MemStatsHeader*)realloc(head, MEM_STATS_HEADER + size)) == NULL) {
+        fatal("realloc panic!!!\r\n");
+    }
+    head->size = size;
+    head->slot = memStatsSlot(file);
+    memStatsCount(head->slot, size, true);
+    return (char*)head + MEM_STATS_HEADER;
+}
+
+char* memStatsStrdup(const char* str, const char* file) {
+    size_t len  = strlen(str);
+    char*  copy = (char*)memStatsAlloc(len + 1, file);
+    memcpy(copy, str, len + 1);
+    return copy;
+}
+
+void memStatsFree(void* ptr) {
+    MemStatsHeader* head;
+    if (ptr == NULL) {
+        return;
+    }
+    head = memStatsHeader(ptr);
+    memStatsUncount(head->slot, head->size, true);
+    head->magic = 0;
+    free(head);
+}
+
+static void memStatsPrintCounts(FILE* out, const char* name, MemStatsCounts* counts) {
+    fprintf(out, "%-14s %10lld %10lld %10lld %12.2f %10.2f %10.2f\r\n", name, (long long)counts->allocs,
+        (long long)counts->reallocs, (long long)counts->frees, counts->bytes / 1048576.0, counts->live / 1048576.0,
+        counts->peak / 1048576.0);
+}
+
+// print the counts of the tags and the files, then the histogram of the
+// sizes of each tag.
+void memStatsPrint(FILE* out) {
+    int32 i, j;
+    fprintf(out, "memory stats, peak %.2fMB, live %.2fMB\r\n", mem_stats_total.peak / 1048576.0, mem_stats_total.live / 1048576.0);
+    fprintf(out, "%-14s %10s %10s %10s %12s %10s %10s\r\n", "tag/file", "allocs", "reallocs", "frees", "bytes(MB)", "live(MB)", "peak(MB)");
+    for (i = 0; i < MEM_TAG_COUNT; i++) {
+        if (mem_stats_tag_counts[i].allocs == 0) {
+            continue;
+        }
+        memStatsPrintCounts(out, mem_stats_tags[i], &mem_stats_tag_counts[i]);
+        for (j = 0; j < MEM_STATS_FILES && mem_stats_files[j].name != NULL; j++) {
+            if (mem_stats_files[j].tag == i) {
+                fprintf(out, "  ");
+                memStatsPrintCounts(out, mem_stats_files[j].name, &mem_stats_files[j].counts);
+            }
+        }
+    }
+    fprintf(out, "%-14s", "sizes(<=)");
+    for (j = 0; j < MEM_STATS_BUCKETS - 1; j++) {
+        16 << j >= 1024 ? fprintf(out, " %7dK", (16 << j) / 1024) : fprintf(out, " %8d", 16 << j);
+    }
+    fprintf(out, " %8s\r\n", "more");
+    for (i = 0; i < MEM_TAG_COUNT; i++) {
+        if (mem_stats_tag_counts[i].allocs == 0) {
+            continue;
+        }
+        fprintf(out, "%-14s", mem_stats_tags[i]);
+        for (j = 0; j < MEM_STATS_BUCKETS; j++) {
+            fprintf(out, " %8lld", (long long)mem_stats_tag_counts[i].hist[j]);
+        }
+        fprintf(out, "\r\n");
+    }
+}
+
+static void memStatsPrintJsonCounts(FILE* out, MemStatsCounts* counts) {
+    int32 j;
+    fprintf(out, "\"allocs\": %lld, \"reallocs\": %lld, \"frees\": %lld, \"bytes\": %lld, \"live\": %lld, \"peak\": %lld, \"histogram\": [",
+        (long long)counts->allocs, (long long)counts->reallocs, (long long)counts->frees, (long long)counts->bytes,
+        (long long)counts->live, (long long)counts->peak);
+    for (j = 0; j < MEM_STATS_BUCKETS; j++) {
+        fprintf(out, j > 0 ? ", %lld" : "%lld", (long long)counts->hist[j]);
+    }
+    fprintf(out, "]");
+}
+
+// the buckets are the upper limits of the sizes in the histograms, the
+// last bucket has no limit and is written as -1.
+void memStatsPrintJson(FILE* out) {
+    int32 i, first;
+    fprintf(out, "{\n  \"buckets\": [");
+    for (i = 0; i < MEM_STATS_BUCKETS; i++) {
+        fprintf(out, i > 0 ? ", %d" : "%d", i < MEM_STATS_BUCKETS - 1 ? 16 << i : -1);
+    }
+    fprintf(out, "],\n  \"total\": {");
+    memStatsPrintJsonCounts(out, &mem_stats_total);
+    fprintf(out, "},\n  \"tags\": {");
+    for (i = 0, first = true; i < MEM_TAG_COUNT; i++) {
+        fprintf(out, "%s\n    \"%s\": {", first == true ? "" : ",", mem_stats_tags[i]);
+        memStatsPrintJsonCounts(out, &mem_stats_tag_counts[i]);
+        fprintf(out, "}");
+        first = false;
+    }
+    fprintf(out, "\n  },\n  \"files\": {");
+    for (i = 0, first = true; i < MEM_STATS_FILES && mem_stats_files[i].name != NULL; i++) {
+        fprintf(out, "%s\n    \"%s\": {\"tag\": \"%s\", ", first == true ? "" : ",", mem_stats_files[i].name,
+            mem_stats_tags[mem_stats_files[i].tag]);
+        memStatsPrintJsonCounts(out, &mem_stats_files[i].counts);
+        fprintf(out, "}");
+        first = false;
+    }
+    fprintf(out, "\n  }\n}\n");
+}
+#endif
+
+/****** the pool of the small objects ******/
+
+#define MEM_POOL_CLASSES (MEM_POOL_MAX / MEM_POOL_ALIGN)
+
+typedef struct MemPoolFree {
+    struct MemPoolFree* next;
+}MemPoolFree;
+
+// the slabs are chained by their first MEM_POOL_ALIGN bytes, so all of
+// them can be reached.
+typedef struct MemPoolSlab {
+    struct MemPoolSlab* next;
+}MemPoolSlab;
+
+// the objects of the class i have the size (i + 1) * MEM_POOL_ALIGN. they
+// are taken from the free list first, then carved from the slab of the
+// class between the next and the end.
+typedef struct MemPool {
+    MemPoolFree* free[MEM_POOL_CLASSES];
+    char*        next[MEM_POOL_CLASSES];
+    char*        end [MEM_POOL_CLASSES];
+    bool         registered;
+}MemPool;
+
+static __thread MemPool mem_pool;
+static MemPoolFree*     mem_pool_depot[MEM_POOL_CLASSES]; // the objects left by the threads exited
+static MemPoolSlab*     mem_pool_slabs = NULL;
+static pthread_mutex_t  mem_pool_lock  = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t    mem_pool_key;
+static pthread_once_t   mem_pool_once  = PTHREAD_ONCE_INIT;
+
+// called when the thread exits, all its objects free and not carved yet
+// are put in the depot.
+static void memPoolRelease(void* arg) {
+    MemPool*     pool = (MemPool*)arg;
+    MemPoolFree* obj;
+    size_t       size;
+    int32        i;
+    pthread_mutex_lock(&mem_pool_lock);
+    for (i = 0; i < MEM_POOL_CLASSES; i++) {
+        size = (i + 1) * MEM_POOL_ALIGN;
+        for (; pool->next[i] != NULL && pool->next[i] + size <= pool->end[i]; pool->next[i] += size) {
+            obj = (MemPoolFree*)pool->next[i];
+            obj->next = mem_pool_depot[i];
+            mem_pool_depot[i] = obj;
+        }
+        while ((obj = pool->free[i]) != NULL) {
+            pool->free[i] = obj->next;
+            obj->next = mem_pool_depot[i];
+            mem_pool_depot[i] = obj;
+        }
+        pool->next[i] = NULL;
+        pool->end[i]  = NULL;
+    }
+    pthread_mutex_unlock(&mem_pool_lock);
+}
+
+static void memPoolCreateKey() {
+    pthread_key_create(&mem_pool_key, memPoolRelease);
+}
+
+static void memPoolRegister(MemPool* pool) {
+    pthread_once(&mem_pool_once, memPoolCreateKey);
+    pthread_setspecific(mem_pool_key, pool);
+    pool->registered = true;
+}
+
+static void* memPoolSysAlloc(size_t size, const char* file) {
+#ifdef CPLUS_MEM_STATS
+    return memStatsAlloc(size, file);
+#else
+    (void)file;
+    return mem_alloc(size);
+#endif
+}
+
+// take the objects of the class left in the depot, or carve a new slab.
+static void* memPoolRefill(MemPool* pool, int32 cls, const char* file) {
+    size_t       size = (cls + 1) * MEM_POOL_ALIGN;
+    MemPoolFree* obj;
+    MemPoolSlab* slab;
+    if (pool->registered != true) {
+        memPoolRegister(pool);
+    }
+    pthread_mutex_lock(&mem_pool_lock);
+    obj = mem_pool_depot[cls];
+    mem_pool_depot[cls] = NULL;
+    pthread_mutex_unlock(&mem_pool_lock);
+    if (obj != NULL) {
+        pool->free[cls] = obj->next;
+        return obj;
+    }
+
+    slab = (MemPoolSlab*)memPoolSysAlloc(MEM_POOL_SLAB, file);
+    pthread_mutex_lock(&mem_pool_lock);
+    slab->next     = mem_pool_slabs;
+    mem_pool_slabs = slab;
+    pthread_mutex_unlock(&mem_pool_lock);
+    pool->next[cls] = (char*)slab + MEM_POOL_ALIGN + size;
+    pool->end[cls]  = (char*)slab + MEM_POOL_SLAB;
+    return (char*)slab + MEM_POOL_ALIGN;
+}
+
+static void* memPoolAlloc(size_t size, const char* file) {
+    MemPool*     pool = &mem_pool;
+    MemPoolFree* obj;
+    int32        cls;
+    if (size > MEM_POOL_MAX) {
+        return memPoolSysAlloc(size, file);
+    }
+    cls = size > 0 ? (size - 1) / MEM_POOL_ALIGN : 0;
+    if ((obj = pool->free[cls]) != NULL) {
+        pool->free[cls] = obj->next;
+        return obj;
+    }
+    if (pool->next[cls] != NULL && pool->next[cls] + (cls + 1) * MEM_POOL_ALIGN <= pool->end[cls]) {
+        obj = (MemPoolFree*)pool->next[cls];
+        pool->next[cls] += (cls + 1) * MEM_POOL_ALIGN;
+        return obj;
+    }
+    return memPoolRefill(pool, cls, file);
+}
+
+#ifndef CPLUS_MEM_STATS
+void* mem_alloc_sized(size_t size) {
+    return memPoolAlloc(size, NULL);
+}
+#else
+void* memStatsAllocSized(size_t size, const char* file) {
+    return memPoolAlloc(size, file);
+}
+#endif
+
+// the object is put in the free list of the thread releasing it.
+void mem_free_sized(void* ptr, size_t size) {
+    MemPool*     pool = &mem_pool;
+    MemPoolFree* obj  = (MemPoolFree*)ptr;
+    int32        cls;
+    if (ptr == NULL) {
+        return;
+    }
+    if (size > MEM_POOL_MAX) {
+        mem_free(ptr);
+        return;
+    }
+    if (pool->registered != true) {
+        memPoolRegister(pool);
+    }
+    cls = size > 0 ? (size - 1) / MEM_POOL_ALIGN : 0;
+    obj->next = pool->free[cls];
+    pool->free[cls] = obj;
+}
 
 void debug(char* msg) {
     printf("%s\r\n", msg);
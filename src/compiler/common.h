@@ -23,6 +23,10 @@
 // #define PLATFORM_ANDROID
 // #define PLATFORM_IOS
 
+// the version of the compiler. the files generated by the compiler, such as
+// the interface files of the modules, are only valid for the same version.
+#define CPLUS_VERSION "1.0"
+
 #define true   1
 #define false -1
 typedef char                   bool;
@@ -71,12 +75,73 @@ extern error new_error(char* errmsg);
 #define NEW_ERROR_CODE(code) (error)code
 #define ERROR_CODE(err)      (int64)err
 
+// the small objects of the fixed sizes, like the identifiers and the
+// nodes of the lists and the trees, should use the mem_alloc_sized and
+// mem_free_sized. they are taken from the slabs of MEM_POOL_SLAB bytes,
+// which are carved into the size classes of MEM_POOL_ALIGN bytes, and
+// every thread keeps a free list of each class, so they cost no malloc
+// and no lock. the mem_free_sized must be given the same size as the
+// mem_alloc_sized, and the memory may be released by any thread. the
+// sizes above MEM_POOL_MAX are passed to the mem_alloc.
+//
+// the slabs are never given back to the system, the free lists of the
+// threads exiting are kept for the other threads.
+#define MEM_POOL_ALIGN 16
+#define MEM_POOL_MAX   256
+#define MEM_POOL_SLAB  65536
+
 // all operations about memory allocating/releasing must use
 // the function mem_alloc and mem_free. mem_alloc can process
 // the error automatically. mem_free will work well even
-// though you free the same memory many times.
-extern void* mem_alloc(size_t size);
-extern void  mem_free (void *ptr);
+// though you free the same memory many times. the memory
+// grown or copied must use mem_realloc and mem_strdup, so
+// the mem_free never meets a pointer from the libc.
+#ifndef CPLUS_MEM_STATS
+extern void* mem_alloc      (size_t size);
+extern void* mem_realloc    (void* ptr, size_t size);
+extern char* mem_strdup     (const char* str);
+extern void  mem_free       (void *ptr);
+extern void* mem_alloc_sized(size_t size);
+extern void  mem_free_sized (void* ptr, size_t size);
+#else
+// the build with -DCPLUS_MEM_STATS counts every allocation for the file
+// calling the mem_alloc, and the files are grouped by the tags below, so
+// the memory of each phase of the compiler can be told. the counts, the
+// bytes, the peak of the live bytes and the histogram of the sizes are
+// printed to the stderr at exit, and written as JSON to the file named
+// by the environment variable CPLUS_MEM_STATS_JSON if it is set.
+//
+// every block carries a header of MEM_STATS_HEADER bytes for its size and
+// its file, so all files of the program must be built with the flag. the
+// objects of the mem_alloc_sized are not counted one by one, but their
+// slabs are counted for the file which needs a new slab.
+#define MEM_TAG_OTHER  0
+#define MEM_TAG_LEXER  1
+#define MEM_TAG_PARSER 2
+#define MEM_TAG_IDENT  3
+#define MEM_TAG_MODULE 4
+#define MEM_TAG_BUILD  5
+#define MEM_TAG_SERVER 6
+#define MEM_TAG_COUNT  7
+
+#define MEM_STATS_HEADER  16
+#define MEM_STATS_BUCKETS 16 // the sizes up to 16, 32, ... 256K, and bigger
+
+extern void* memStatsAlloc     (size_t size, const char* file);
+extern void* memStatsRealloc   (void* ptr, size_t size, const char* file);
+extern char* memStatsStrdup    (const char* str, const char* file);
+extern void  memStatsFree      (void* ptr);
+extern void* memStatsAllocSized(size_t size, const char* file);
+extern void  mem_free_sized    (void* ptr, size_t size);
+extern void  memStatsPrint     (FILE* out);
+extern void  memStatsPrintJson (FILE* out);
+
+#define mem_alloc(size)        memStatsAlloc((size), __FILE__)
+#define mem_realloc(ptr, size) memStatsRealloc((ptr), (size), __FILE__)
+#define mem_strdup(str)        memStatsStrdup((str), __FILE__)
+#define mem_free(ptr)          memStatsFree(ptr)
+#define mem_alloc_sized(size)  memStatsAllocSized((size), __FILE__)
+#endif
 
 // other functions to debug the program.
 extern void  debug(char* msg);
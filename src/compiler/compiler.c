@@ -6,20 +6,330 @@
 
 #include "compiler.h"
 
+typedef struct CompilerTask {
+    Compiler* compiler;
+    Module*   mod;
+}CompilerTask;
+
+static void compilerParseTask  (void* arg);
+static void compilerResolveTask(void* arg);
+
 error compilerInit(Compiler* compiler, ProjectConfig* projconf) {
+    if (projconf == NULL) {
+        return new_error("the project configuration can not be NULL.");
+    }
     compiler->project_config = projconf;
-    
-    
+    compiler->jobs           = 1;
+    compiler->main_mod       = NULL;
+    compiler->mods_total     = 0;
+    compiler->mods_done      = 0;
+    compiler->mods_rebuilt   = 0;
+    compiler->mods_parsed    = 0;
+    compiler->warm           = NULL;
+    compiler->err            = NULL;
+    moduleCacheTableInit   (&compiler->cachetable);
+    moduleScheduleQueueInit(&compiler->queue);
+    modGraphInit           (&compiler->graph);
+    buildStateInit         (&compiler->build_state, projconf);
+    dirScanInit            (&compiler->scanner);
+    pthread_mutex_init(&compiler->sched_lock, NULL);
+    return NULL;
+}
+
+// only the first error is kept. the sched_lock must be held.
+static void compilerFail(Compiler* compiler, Module* mod, error err) {
+    mod->state = MODULE_STATE_FAILED;
+    mod->err   = err;
+    if (compiler->err == NULL) {
+        compiler->err = err;
+    }
+}
+
+static error compilerNotFoundErr(char* mod_name) {
+    DynamicArrStr dstr;
+    dynamicArrStrInit  (&dstr, DYNAMIC_ARR_STR_SMALL);
+    dynamicArrStrAppend(&dstr, "not found the included module: ", 31);
+    dynamicArrStrAppend(&dstr, mod_name, internLen(mod_name));
+    char* errmsg = dynamicArrStrDetach(&dstr);
+    return new_error(errmsg);
+}
+
+/****** the parse stage ******/
+
+// the modules in the warm table are reset and reused, the sched_lock must
+// be held.
+static Module* compilerNewModule(Compiler* compiler, char* mod_name) {
+    Module* mod;
+    if (compiler->warm != NULL && (mod = moduleCacheTableGetMod(compiler->warm, mod_name)) != NULL) {
+        moduleReset(mod);
+        return mod;
+    }
+    return moduleNewByName(mod_name, compiler->project_config, &compiler->scanner);
 }
 
+static Module* compilerNewMainModule(Compiler* compiler) {
+    ProjectConfig* projconf = compiler->project_config;
+    Module*        mod      = moduleNewByPath(projconf->path_buildmod, projconf->path_buildmod_len, projconf, &compiler->scanner);
+    Module*        warm;
+    if (mod != NULL && compiler->warm != NULL &&
+        (warm = moduleCacheTableGetMod(compiler->warm, mod->mod_name)) != NULL && strcmp(warm->mod_path, mod->mod_path) == 0) {
+        moduleDestroy(mod);
+        moduleReset(warm);
+        return warm;
+    }
+    return mod;
+}
+
+// record the module found and submit it to be parsed. the sched_lock
+// must be held.
+static void compilerAddModule(Compiler* compiler, Module* mod) {
+    moduleCacheTableAdd(&compiler->cachetable, mod);
+    modGraphAdd(&compiler->graph, mod);
+    buildStateFill(&compiler->build_state, mod);
+    compiler->mods_total++;
+    if (compiler->jobs > 1) {
+        CompilerTask* task = (CompilerTask*)mem_alloc(sizeof(CompilerTask));
+        task->compiler = compiler;
+        task->mod      = mod;
+        workPoolSubmit(&compiler->pool, compilerParseTask, task);
+    }
+    else {
+        moduleScheduleQueueAddMod(&compiler->queue, mod);
+    }
+}
+
+// parse the module and find the modules included by it. the new ones
+// are submitted to be parsed as well.
+static void compilerParseModule(Compiler* compiler, Module* mod) {
+    Module* dep;
+    int32   i;
+    bool    parsed = mod->parsed;
+    int64   begin  = modGraphNow();
+    error   err    = moduleParse(mod, compiler->jobs > 1 ? &compiler->pool : NULL);
+    mod->parse_ns  = modGraphNow() - begin;
+
+    pthread_mutex_lock(&compiler->sched_lock);
+    if (parsed == false) {
+        compiler->mods_parsed++;
+    }
+    if (err != NULL) {
+        compilerFail(compiler, mod, err);
+        pthread_mutex_unlock(&compiler->sched_lock);
+        return;
+    }
+    for (i = 0; i < mod->dep_count; i++) {
+        if ((dep = moduleCacheTableGetMod(&compiler->cachetable, mod->deps[i])) == NULL) {
+            if ((dep = compilerNewModule(compiler, mod->deps[i])) == NULL) {
+                compilerFail(compiler, mod, compilerNotFoundErr(mod->deps[i]));
+                break;
+            }
+            compilerAddModule(compiler, dep);
+        }
+        mod->dep_mods[i] = dep;
+    }
+    if (mod->state == MODULE_STATE_PARSE) {
+        mod->state = MODULE_STATE_WAIT;
+    }
+    pthread_mutex_unlock(&compiler->sched_lock);
+}
+
+static void compilerParseTask(void* arg) {
+    CompilerTask* task = (CompilerTask*)arg;
+    compilerParseModule(task->compiler, task->mod);
+    mem_free(task);
+}
+
+/****** the resolve stage ******/
+
+// the sched_lock must be held if the module is resolved by the workers.
+static void compilerAfterResolve(Compiler* compiler, Module* mod, error err) {
+    if (err != NULL) {
+        compilerFail(compiler, mod, err);
+        return;
+    }
+    mod->state = MODULE_STATE_DONE;
+    compiler->mods_done++;
+}
+
+// the modules whose last build is still valid are not resolved again, they
+// are done as soon as the modules they include are done.
+static error compilerResolveModule(Module* mod) {
+    int64 begin = modGraphNow();
+    error err;
+    if (mod->rebuild == false) {
+        mod->resolve_ns = 0;
+        return NULL;
+    }
+    err = moduleResolve(mod);
+    mod->resolve_ns = modGraphNow() - begin;
+    return err;
+}
+
+// every task resolves the ready module with the heaviest chain at the time
+// it runs, not the module which made it submitted. so the modules on the
+// critical path never wait behind the lighter ones.
+static void compilerResolveTask(void* arg) {
+    Compiler* compiler = (Compiler*)arg;
+    Module*   mod;
+    Module*   dependent;
+    int32     i;
+
+    pthread_mutex_lock(&compiler->sched_lock);
+    mod = modGraphPopReady(&compiler->graph);
+    pthread_mutex_unlock(&compiler->sched_lock);
+    if (mod == NULL) {
+        return;
+    }
+    error err = compilerResolveModule(mod);
+
+    pthread_mutex_lock(&compiler->sched_lock);
+    compilerAfterResolve(compiler, mod, err);
+    if (err == NULL) {
+        for (i = 0; i < mod->dependent_count; i++) {
+            dependent = mod->dependents[i];
+            if (--dependent->pending == 0) {
+                dependent->state = MODULE_STATE_RESOLVE;
+                modGraphPushReady(&compiler->graph, dependent);
+                workPoolSubmit(&compiler->pool, compilerResolveTask, compiler);
+            }
+        }
+    }
+    pthread_mutex_unlock(&compiler->sched_lock);
+}
+
+// decide which modules are rebuilt. the interfaces of all modules are known
+// after the parse stage, so it does not depend on the order.
+static void compilerCheckRebuild(Compiler* compiler) {
+    Module* mod;
+    int32   i;
+    for (i = 0; i < compiler->graph.count; i++) {
+        mod = compiler->graph.mods[i];
+        mod->rebuild = buildStateIsValid(&compiler->build_state, mod) == true ? false : true;
+        if (mod->rebuild == true) {
+            compiler->mods_rebuilt++;
+        }
+    }
+}
+
+/****** methods of Compiler ******/
+
+// the build runs in three steps:
+//   (1) parse the main module and all modules included by it. the modules
+//       are found while parsing, and they are parsed at the same time.
+//   (2) build the graph of the modules. the cycles are reported here, and
+//       the modules to rebuild are decided.
+//   (3) resolve the modules in the topological schedule. if the jobs is
+//       more than 1, the modules are resolved as soon as the modules they
+//       include are done, and the heavier chains go first.
+//
 error compilerBuild(Compiler* compiler) {
-    return NULL;
+    Module* mod;
+    error   err;
+    int32   i;
+
+    compiler->main_mod = compilerNewMainModule(compiler);
+    if (compiler->main_mod == NULL) {
+        return new_error("the build target is not a program, a module or a source file.");
+    }
+    // without the state, all modules are rebuilt.
+    buildStateLoad(&compiler->build_state);
+    if (compiler->jobs > 1) {
+        if ((err = workPoolInit(&compiler->pool, compiler->jobs)) != NULL) {
+            return err;
+        }
+        pthread_mutex_lock(&compiler->sched_lock);
+        compilerAddModule(compiler, compiler->main_mod);
+        pthread_mutex_unlock(&compiler->sched_lock);
+        workPoolWait(&compiler->pool);
+    }
+    else {
+        compilerAddModule(compiler, compiler->main_mod);
+        while ((mod = moduleScheduleQueueGetHeadMod(&compiler->queue)) != NULL) {
+            moduleScheduleQueueDelHeadMod(&compiler->queue);
+            compilerParseModule(compiler, mod);
+        }
+    }
+
+    if (compiler->err == NULL) {
+        compiler->err = modGraphBuild(&compiler->graph);
+    }
+    if (compiler->err == NULL) {
+        compilerCheckRebuild(compiler);
+    }
+    if (compiler->err == NULL) {
+        if (compiler->jobs > 1) {
+            // the workers start as soon as the first module is submitted, so
+            // the modules are seeded with the lock held.
+            pthread_mutex_lock(&compiler->sched_lock);
+            for (i = 0; i < compiler->graph.count; i++) {
+                mod = compiler->graph.mods[i];
+                if (mod->dep_count == 0) {
+                    mod->state = MODULE_STATE_RESOLVE;
+                    modGraphPushReady(&compiler->graph, mod);
+                    workPoolSubmit(&compiler->pool, compilerResolveTask, compiler);
+                }
+            }
+            pthread_mutex_unlock(&compiler->sched_lock);
+            workPoolWait(&compiler->pool);
+        }
+        else {
+            for (i = 0; i < compiler->graph.count && compiler->err == NULL; i++) {
+                mod = compiler->graph.order[i];
+                compilerAfterResolve(compiler, mod, compilerResolveModule(mod));
+            }
+        }
+    }
+    if (compiler->jobs > 1) {
+        workPoolDestroy(&compiler->pool);
+    }
+    if (compiler->err == NULL && compiler->mods_done < compiler->mods_total) {
+        compiler->err = new_error("some modules are not built.");
+    }
+    if (compiler->err == NULL) {
+        // the state only saves the time of the next build.
+        buildStateSave(&compiler->build_state, compiler->graph.mods, compiler->graph.count);
+    }
+    return compiler->err;
 }
 
 error compilerRun(Compiler* compiler) {
     return NULL;
 }
 
-void compilerDestroy(Compiler* compiler) {
+// print the graph of the modules with the timings and the critical path.
+void compilerDumpGraph(Compiler* compiler, FILE* out) {
+    modGraphDump(&compiler->graph, out);
+}
+
+// move the modules parsed into the warm table, the others are destroyed.
+static void compilerKeepModule(Module* mod, void* arg) {
+    Compiler* compiler = (Compiler*)arg;
+    Module*   warm     = moduleCacheTableGetMod(compiler->warm, mod->mod_name);
+    if (warm == mod) {
+        return;
+    }
+    if (warm == NULL && mod->parsed == true) {
+        moduleCacheTableAdd(compiler->warm, mod);
+        return;
+    }
+    moduleDestroy(mod);
+}
 
+void compilerDestroy(Compiler* compiler) {
+    moduleScheduleQueueDestroy(&compiler->queue);
+    if (compiler->warm != NULL) {
+        moduleCacheTableWalk (&compiler->cachetable, compilerKeepModule, compiler);
+        moduleCacheTableClear(&compiler->cachetable);
+    }
+    else {
+        moduleCacheTableDestroy(&compiler->cachetable);
+    }
+    modGraphDestroy  (&compiler->graph);
+    buildStateDestroy(&compiler->build_state);
+    dirScanDestroy   (&compiler->scanner);
+    pthread_mutex_destroy(&compiler->sched_lock);
+    compiler->main_mod = NULL;
+    if (compiler->warm == NULL) {
+        internDestroy();
+    }
 }
@@ -11,17 +11,57 @@
 #ifndef CPLUS_COMPILER_H
 #define CPLUS_COMPILER_H
 
+#include <pthread.h>
 #include "common.h"
 #include "project.h"
 #include "module.h"
+#include "intern.h"
+#include "workpool.h"
+#include "modgraph.h"
+#include "buildstate.h"
+#include "dirscan.h"
 
+// the Compiler compiles the module passed to the compiler and all modules
+// included by it directly or indirectly.
+//
+// the modules are parsed as soon as they are found, then they are resolved
+// in the topological schedule of the ModuleGraph(see modgraph.h). if the
+// jobs is more than 1, both stages run on the workers of the pool and the
+// files of a module are lexed by several workers, otherwise they run one by
+// one. both ways produce the same export tables.
+//
+// the build is incremental. a module is rebuilt only if its sources are
+// changed or the interfaces of the modules included by it are changed since
+// the last build(see buildstate.h). the modules not rebuilt still have their
+// export tables, loaded from their interface files(see iface.h).
+//
+// if the warm table is set, the modules parsed are taken from it and kept in
+// it after the build, so the modules not changed are not parsed again. the
+// interned strings are kept too.
+//
 typedef struct {
-    ProjectConfig*  project_config;
+    ProjectConfig*      project_config;
+    int32               jobs;        // the number of the threads compiling the modules
+    Module*             main_mod;
+    ModuleCacheTable    cachetable;  // all modules found
+    ModuleScheduleQueue queue;       // the modules waiting to be parsed when the jobs is 1
+    ModuleGraph         graph;       // the ready heap in it is guarded by the sched_lock
+    BuildState          build_state; // the state of the last build
+    DirScanner          scanner;     // the directories listed by this build
+    ModuleCacheTable*   warm;        // the modules kept between the builds by the server(see server.h)
+    WorkPool            pool;        // the workers when the jobs is more than 1
+    pthread_mutex_t     sched_lock;  // guards the cachetable and the scheduling states
+    int32               mods_total;
+    int32               mods_done;
+    int32               mods_rebuilt;
+    int32               mods_parsed; // the modules not reused from the warm table
+    error               err;         // the first error occurred
 }Compiler;
 
-extern error compilerInit   (Compiler* compiler, ProjectConfig* projconf);
-extern error compilerBuild  (Compiler* compiler);
-extern error compilerRun    (Compiler* compiler);
-extern void  compilerDestroy(Compiler* compiler);
+extern error compilerInit     (Compiler* compiler, ProjectConfig* projconf);
+extern error compilerBuild    (Compiler* compiler);
+extern error compilerRun      (Compiler* compiler);
+extern void  compilerDumpGraph(Compiler* compiler, FILE* out);
+extern void  compilerDestroy  (Compiler* compiler);
 
 #endif
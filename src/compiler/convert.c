@@ -6,35 +6,34 @@
 
 #include "convert.h"
 
-char* conv_itoa(int64 num) {
-    bool negative = false;
+// write the decimal of the num and a '\0' into the buf, which must have
+// CONV_ITOA_SIZE bytes at least. return the length without the '\0'.
+int32 conv_itoa_buf(int64 num, char* buf) {
+    char   digits[CONV_ITOA_SIZE];
+    uint64 abs = num < 0 ? -(uint64)num : (uint64)num;
+    int32  count = 0;
+    int32  len   = 0;
+    do {
+        digits[count++] = abs % 10 + '0';
+        abs /= 10;
+    } while (abs != 0);
     if (num < 0) {
-        num = -num;
-        negative = true;
-    }
-    DynamicArrChar darr;
-    dynamicArrCharInit(&darr, 64);
-    for (;;) {
-        dynamicArrCharAppendc(&darr, num%10 + 48);
-        if (num/10 == 0) {
-            break;
-        }
-        num /= 10;
-    }
-    if (negative == true) {
-        dynamicArrCharAppendc(&darr, '-');
+        buf[len++] = '-';
     }
-    char  ch;
-    char* numstr      = dynamicArrCharGetStr(&darr);
-    int64 reverse_len = darr.used;
-    int64 reverse_end = reverse_len >> 1;
-    int64 i;
-    dynamicArrCharDestroy(&darr);
-    for (i = 0; i < reverse_end; i++) {
-        ch = numstr[i];
-        numstr[i] = numstr[reverse_len-i-1];
-        numstr[reverse_len-i-1] = ch;
+    while (count > 0) {
+        buf[len++] = digits[--count];
     }
+    buf[len] = '\0';
+    return len;
+}
+
+// the string returned should be released by the mem_free. use the
+// conv_itoa_buf to write into a buffer without any allocation.
+char* conv_itoa(int64 num) {
+    char  buf[CONV_ITOA_SIZE];
+    int32 len    = conv_itoa_buf(num, buf);
+    char* numstr = (char*)mem_alloc(len + 1);
+    memcpy(numstr, buf, len + 1);
     return numstr;
 }
 
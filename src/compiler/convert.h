@@ -13,7 +13,12 @@
 #include <string.h>
 #include "dynamicarr.h"
 
+// the bytes enough for any int64 written by the conv_itoa_buf, including
+// the '-' and the '\0'.
+#define CONV_ITOA_SIZE 21
+
 extern char* conv_itoa             (int64 num);
+extern int32 conv_itoa_buf         (int64 num, char* buf);
 extern int64 conv_binary_to_decimal(char* binary_num, int64 conv_len);
 
 #endif
@@ -12,30 +12,161 @@
 #include "compiler.h"
 #include "project.h"
 #include "parser.h"
+#include "server.h"
+
+static void usage() {
+    printf("usage: cplus command [-j N] [--graph] [--server] [--socket PATH] path\r\n");
+    printf("\r\n");
+    printf("command:\r\n");
+    printf("  build    build the specific cplus project\r\n");
+    printf("  run      build and run the specific cplus project\r\n");
+    printf("  serve    serve the builds of the specific cplus project\r\n");
+    printf("  help     display the manual\r\n");
+    printf("\r\n");
+    printf("option:\r\n");
+    printf("  -j N     compile the modules with N threads. 0 means the number\r\n");
+    printf("           of the processors. the default is 1\r\n");
+    printf("  --graph  print the graph of the modules, the timings and the\r\n");
+    printf("           critical path after building\r\n");
+    printf("  --server build by the server of the project started by the\r\n");
+    printf("           serve command, \"cplus --server stop path\" stops it\r\n");
+    printf("  --socket the socket of the server. the default is the file\r\n");
+    printf("           " SERVER_SOCKET_NAME " in the binary directory of the project\r\n");
+}
+
+// serve the builds of the project until the stop request.
+static error serve(ProjectConfig* projconf, char* socket_path, int32 jobs) {
+    Server server;
+    error  err;
+    if ((err = serverInit(&server, projconf, socket_path, jobs)) != NULL) {
+        return err;
+    }
+    printf("serving %s on %s\r\n", projconf->path_srcdir, socket_path);
+    fflush(stdout);
+    err = serverRun(&server);
+    serverDestroy(&server);
+    return err;
+}
+
+// send the build or the stop request to the server.
+static error request(char* command, char* socket_path, int32 jobs, bool graph, char* target) {
+    char* path;
+    char* line;
+    error err;
+    if (strcmp(command, "stop") == 0) {
+        return serverRequest(socket_path, "stop", stdout);
+    }
+    if ((path = realpath(target, NULL)) == NULL) {
+        return new_error("the build target does not exist.");
+    }
+    line = (char*)mem_alloc(strlen(path) + 64);
+    sprintf(line, "build %d %d %s", jobs, graph == true ? 1 : 0, path);
+    err = serverRequest(socket_path, line, stdout);
+    mem_free(line);
+    free(path); // the realpath allocates it by the malloc
+    return err;
+}
 
 // command:
 //   build    build the specific cplus project
 //   run      build and run the specific cplus project
+//   serve    serve the builds of the specific cplus project
 //   test     test the specific cplus file or project
 //   format   adjust the indent of the program
 //   help     display the manual
 //
 int main(int argc, char* argv[]) {
     error err;
+    char* command = NULL;
+    char* target  = NULL;
+    char* socket  = NULL;
+    int32 jobs    = -1;
+    bool  graph   = false;
+    bool  client  = false;
+    int   i;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-j") == 0 && i+1 < argc) {
+            jobs = atoi(argv[++i]);
+        }
+        else if (strncmp(argv[i], "-j", 2) == 0) {
+            jobs = atoi(argv[i] + 2);
+        }
+        else if (strcmp(argv[i], "--graph") == 0) {
+            graph = true;
+        }
+        else if (strcmp(argv[i], "--server") == 0) {
+            client = true;
+        }
+        else if (strcmp(argv[i], "--socket") == 0 && i+1 < argc) {
+            socket = argv[++i];
+        }
+        else if (command == NULL) {
+            command = argv[i];
+        }
+        else {
+            target = argv[i];
+        }
+    }
+    if (command == NULL || strcmp(command, "help") == 0) {
+        usage();
+        return 0;
+    }
+    if (target == NULL ||
+        (client == false && strcmp(command, "build") != 0 && strcmp(command, "run") != 0 && strcmp(command, "serve") != 0) ||
+        (client == true  && strcmp(command, "build") != 0 && strcmp(command, "stop") != 0)) {
+        usage();
+        return EXIT_FAILURE;
+    }
+    // the jobs not given is 1 for the local builds, and the jobs of the
+    // server for the requests.
+    if (jobs == 0) {
+        jobs = workPoolCPUCount();
+    }
+
     ProjectConfig projconf;
-    err = projectConfigInit(&projconf, argv[0], "/home/jikai/c_projects/test/CplusProject");
+    err = projectConfigInit(&projconf, argv[0], target);
     if (err != NULL) {
         debug(err);
+        return EXIT_FAILURE;
+    }
+    if (client == true || strcmp(command, "serve") == 0) {
+        char* path = socket != NULL ? mem_strdup(socket) : serverDefaultSocket(&projconf);
+        if (client == true) {
+            err = request(command, path, jobs < 0 ? 0 : jobs, graph, target);
+        }
+        else {
+            err = serve(&projconf, path, jobs < 0 ? 1 : jobs);
+        }
+        if (err != NULL) {
+            debug(err);
+        }
+        mem_free(path);
+        projectConfigDestroy(&projconf);
+        return err != NULL ? EXIT_FAILURE : 0;
+    }
+    if (jobs < 0) {
+        jobs = 1;
     }
     Compiler compiler;
     err = compilerInit(&compiler, &projconf);
+    if (err != NULL) {
+        debug(err);
+        return EXIT_FAILURE;
+    }
+    compiler.jobs = jobs;
+    err = compilerBuild(&compiler);
+    if (graph == true) {
+        compilerDumpGraph(&compiler, stdout);
+    }
+    if (err == NULL && strcmp(command, "run") == 0) {
+        err = compilerRun(&compiler);
+    }
     if (err != NULL) {
         debug(err);
     }
-    compilerBuild  (&compiler);
     compilerDestroy(&compiler);
     
     projectConfigDestroy(&projconf);
-    return 0;
+    return err != NULL ? EXIT_FAILURE : 0;
 }
-
@@ -0,0 +1,220 @@
+/**
+ * Copyright 2015 JiKai. All rights reserved.
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file.
+ **/
+
+#include "dirscan.h"
+
+#define DIRSCAN_BUFF_SIZE    32768
+#define DIRSCAN_BUCKETS_INIT 64
+
+// the record returned by the getdents64, see "man 2 getdents".
+struct DirScanDirent {
+    uint64 d_ino;
+    int64  d_off;
+    uint16 d_reclen;
+    uint8  d_type;
+    char   d_name[];
+};
+
+void dirScanInit(DirScanner* scanner) {
+    scanner->bucket_count = DIRSCAN_BUCKETS_INIT;
+    scanner->buckets      = (DirScanDir**)mem_alloc(sizeof(DirScanDir*) * DIRSCAN_BUCKETS_INIT);
+    scanner->dir_count    = 0;
+    scanner->listed       = 0;
+    scanner->stated       = 0;
+    memset(scanner->buckets, 0, sizeof(DirScanDir*) * DIRSCAN_BUCKETS_INIT);
+    arenaInit(&scanner->arena, 16384);
+    pthread_mutex_init(&scanner->lock, NULL);
+}
+
+/****** the listings ******/
+
+static uint32 dirScanHash(const char* path, int32 path_len) {
+    uint32 hash = 2166136261u;
+    int32  i;
+    for (i = 0; i < path_len; i++) {
+        hash = (hash ^ (uint8)path[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static DirScanDir* dirScanFind(DirScanner* scanner, const char* path, int32 path_len, uint32 hash) {
+    DirScanDir* dir;
+    for (dir = scanner->buckets[hash & (scanner->bucket_count - 1)]; dir != NULL; dir = dir->next) {
+        if (dir->hash == hash && dir->path_len == path_len && memcmp(dir->path, path, path_len) == 0) {
+            return dir;
+        }
+    }
+    return NULL;
+}
+
+static void dirScanInsert(DirScanner* scanner, DirScanDir* dir) {
+    DirScanDir** buckets;
+    DirScanDir*  next;
+    int32        count, i;
+    if ((scanner->dir_count + 1) * 4 > scanner->bucket_count * 3) {
+        count   = scanner->bucket_count * 2;
+        buckets = (DirScanDir**)mem_alloc(sizeof(DirScanDir*) * count);
+        memset(buckets, 0, sizeof(DirScanDir*) * count);
+        for (i = 0; i < scanner->bucket_count; i++) {
+            for (; scanner->buckets[i] != NULL; scanner->buckets[i] = next) {
+                next = scanner->buckets[i]->next;
+                scanner->buckets[i]->next = buckets[scanner->buckets[i]->hash & (count - 1)];
+                buckets[scanner->buckets[i]->hash & (count - 1)] = scanner->buckets[i];
+            }
+        }
+        mem_free(scanner->buckets);
+        scanner->buckets      = buckets;
+        scanner->bucket_count = count;
+    }
+    dir->next = scanner->buckets[dir->hash & (scanner->bucket_count - 1)];
+    scanner->buckets[dir->hash & (scanner->bucket_count - 1)] = dir;
+    scanner->dir_count++;
+}
+
+static int dirScanEntryCmp(const void* a, const void* b) {
+    return strcmp(((const DirScanEntry*)a)->name, ((const DirScanEntry*)b)->name);
+}
+
+// the symbolic links and the entries whose types are not reported by the
+// file system are stated to get their types, like the stat() follows them.
+static void dirScanStat(DirScanner* scanner, int fd, DirScanEntry* entry, uint8 d_type) {
+    struct stat st;
+    entry->type  = d_type == DT_DIR ? DIRSCAN_DIR : DIRSCAN_OTHER;
+    entry->mtime = -1;
+    entry->size  = -1;
+    if (d_type != DT_REG && d_type != DT_LNK && d_type != DT_UNKNOWN) {
+        return;
+    }
+    scanner->stated++;
+    if (fstatat(fd, entry->name, &st, 0) != 0) {
+        return;
+    }
+    if (S_ISDIR(st.st_mode)) {
+        entry->type = DIRSCAN_DIR;
+    }
+    else if (S_ISREG(st.st_mode)) {
+        entry->type  = DIRSCAN_REG;
+        entry->mtime = (int64)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+        entry->size  = st.st_size;
+    }
+}
+
+// read all entries of the directory. the names are copied into the arena,
+// because the buffer of the getdents64 is reused.
+static void dirScanRead(DirScanner* scanner, DirScanDir* dir) {
+    char                  buff[DIRSCAN_BUFF_SIZE] __attribute__((aligned(8)));
+    struct DirScanDirent* dirent;
+    DirScanEntry*         entries = NULL;
+    int32                 count   = 0;
+    int32                 cap     = 0;
+    int64                 len, off;
+    int                   fd;
+
+    dir->exists  = false;
+    dir->entries = NULL;
+    dir->count   = 0;
+    if ((fd = open(dir->path, O_RDONLY | O_DIRECTORY | O_CLOEXEC)) < 0) {
+        return;
+    }
+    scanner->listed++;
+    while ((len = syscall(SYS_getdents64, fd, buff, sizeof(buff))) > 0) {
+        for (off = 0; off < len; off += dirent->d_reclen) {
+            dirent = (struct DirScanDirent*)(buff + off);
+            if (dirent->d_name[0] == '.' && (dirent->d_name[1] == '\0' || (dirent->d_name[1] == '.' && dirent->d_name[2] == '\0'))) {
+                continue;
+            }
+            if (count == cap) {
+                cap     = cap == 0 ? 32 : cap * 2;
+                entries = (DirScanEntry*)mem_realloc(entries, sizeof(DirScanEntry) * cap);
+            }
+            entries[count].name_len = strlen(dirent->d_name);
+            entries[count].name     = arenaStrdup(&scanner->arena, dirent->d_name, entries[count].name_len);
+            dirScanStat(scanner, fd, &entries[count], dirent->d_type);
+            count++;
+        }
+    }
+    close(fd);
+    if (len < 0) {
+        mem_free(entries);
+        return;
+    }
+    if (count > 0) {
+        qsort(entries, count, sizeof(DirScanEntry), dirScanEntryCmp);
+        dir->entries = (DirScanEntry*)arenaAlloc(&scanner->arena, sizeof(DirScanEntry) * count);
+        memcpy(dir->entries, entries, sizeof(DirScanEntry) * count);
+    }
+    dir->count  = count;
+    dir->exists = true;
+    mem_free(entries);
+}
+
+// return the listing of the directory, or NULL if it is not a directory.
+// the listing is read only once by the scanner.
+DirScanDir* dirScanList(DirScanner* scanner, const char* path, int32 path_len) {
+    uint32      hash = dirScanHash(path, path_len);
+    DirScanDir* dir;
+    pthread_mutex_lock(&scanner->lock);
+    if ((dir = dirScanFind(scanner, path, path_len, hash)) == NULL) {
+        dir = arenaNew(&scanner->arena, DirScanDir);
+        dir->path     = arenaStrdup(&scanner->arena, path, path_len);
+        dir->path_len = path_len;
+        dir->hash     = hash;
+        dirScanRead  (scanner, dir);
+        dirScanInsert(scanner, dir);
+    }
+    pthread_mutex_unlock(&scanner->lock);
+    return dir->exists == true ? dir : NULL;
+}
+
+DirScanEntry* dirScanLookup(DirScanDir* dir, const char* name, int32 name_len) {
+    int32 low  = 0;
+    int32 high = dir->count - 1;
+    int32 mid;
+    int   cmp;
+    while (low <= high) {
+        mid = (low + high) / 2;
+        if ((cmp = strncmp(dir->entries[mid].name, name, name_len)) == 0 && dir->entries[mid].name_len != name_len) {
+            cmp = dir->entries[mid].name_len < name_len ? -1 : 1;
+        }
+        if (cmp == 0) {
+            return &dir->entries[mid];
+        }
+        cmp < 0 ? (low = mid + 1) : (high = mid - 1);
+    }
+    return NULL;
+}
+
+// the path is looked up in the listing of its parent directory, so the
+// modules of a project are found without stating every path.
+//
+// example:
+//    the path "/home/user/project/src/net.mod/http.mod" is looked up in the
+//    listing of "/home/user/project/src/net.mod".
+//
+bool dirScanIsDir(DirScanner* scanner, const char* path, int32 path_len) {
+    DirScanDir*   dir;
+    DirScanEntry* entry;
+    int32         i;
+    while (path_len > 1 && path[path_len-1] == '/') {
+        path_len--;
+    }
+    for (i = path_len - 1; i > 0 && path[i] != '/'; i--);
+    if (i <= 0) {
+        return dirScanList(scanner, path, path_len) != NULL ? true : false;
+    }
+    if ((dir = dirScanList(scanner, path, i)) == NULL || (entry = dirScanLookup(dir, path + i + 1, path_len - i - 1)) == NULL) {
+        return false;
+    }
+    return entry->type == DIRSCAN_DIR ? true : false;
+}
+
+void dirScanDestroy(DirScanner* scanner) {
+    arenaDestroy(&scanner->arena);
+    mem_free(scanner->buckets);
+    scanner->buckets   = NULL;
+    scanner->dir_count = 0;
+    pthread_mutex_destroy(&scanner->lock);
+}
@@ -0,0 +1,69 @@
+/**
+ * Copyright 2015 JiKai. All rights reserved.
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file.
+ *
+ *     The dirscan.h and dirscan.c list the directories of a
+ * project for a build. every directory is read once with the
+ * getdents64 and its regular files are stated relative to the
+ * directory, then the listing is kept until the build is over.
+ **/
+
+#ifndef CPLUS_DIRSCAN_H
+#define CPLUS_DIRSCAN_H
+
+#include <fcntl.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include "common.h"
+#include "arena.h"
+
+#define DIRSCAN_OTHER 0x00
+#define DIRSCAN_DIR   0x01
+#define DIRSCAN_REG   0x02
+
+// the names of the entries are stored in the arena of the scanner, so they
+// are valid until the scanner is destroyed. the mtime and the size are -1
+// for the entries which are not regular files.
+typedef struct DirScanEntry {
+    char*  name;
+    int32  name_len;
+    uint8  type;
+    int64  mtime;
+    int64  size;
+}DirScanEntry;
+
+typedef struct DirScanDir DirScanDir;
+struct DirScanDir {
+    char*         path;
+    int32         path_len;
+    uint32        hash;
+    bool          exists;   // false if the path can not be listed
+    DirScanEntry* entries;  // sorted by the names, without "." and ".."
+    int32         count;
+    DirScanDir*   next;
+};
+
+// the listings, including the ones of the paths not existing, are cached by
+// their paths. the scanner can be used by many threads.
+//
+typedef struct DirScanner {
+    DirScanDir**    buckets;
+    int32           bucket_count;
+    int32           dir_count;
+    Arena           arena;      // the listings and the names
+    pthread_mutex_t lock;
+    int64           listed;     // the number of the directories read
+    int64           stated;     // the number of the fstatat calls
+}DirScanner;
+
+extern void          dirScanInit   (DirScanner* scanner);
+extern DirScanDir*   dirScanList   (DirScanner* scanner, const char* path, int32 path_len);
+extern DirScanEntry* dirScanLookup (DirScanDir* dir, const char* name, int32 name_len);
+extern bool          dirScanIsDir  (DirScanner* scanner, const char* path, int32 path_len);
+extern void          dirScanDestroy(DirScanner* scanner);
+
+#endif
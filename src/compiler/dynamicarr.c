@@ -19,7 +19,7 @@ error dynamicArrCharInit(DynamicArrChar* darr, int64 capacity) {
     // size is bigger than the darr->total_cap, then a new buffer will created and
     // be linked with the darr->next pointer.
     //
-    darr->first       = (DynamicArrCharNode*)mem_alloc(sizeof(DynamicArrCharNode));
+    darr->first       = (DynamicArrCharNode*)mem_alloc_sized(sizeof(DynamicArrCharNode));
     darr->first->cap  = capacity;
     darr->first->i    = 0;
     darr->first->arr  = (char*)mem_alloc(sizeof(char) * capacity);
@@ -53,7 +53,7 @@ void dynamicArrCharAppend(DynamicArrChar* darr, char* str, int64 len) {
             new_node_cap *= 2;
         }
 
-        darr->cur->next = (DynamicArrCharNode*)mem_alloc(sizeof(DynamicArrCharNode));
+        darr->cur->next = (DynamicArrCharNode*)mem_alloc_sized(sizeof(DynamicArrCharNode));
         darr->cur->next->cap  = new_node_cap;
         darr->cur->next->i    = 0;
         darr->cur->next->arr  = (char*)mem_alloc(sizeof(char) * new_node_cap);
@@ -76,7 +76,7 @@ void dynamicArrCharAppend(DynamicArrChar* darr, char* str, int64 len) {
 
 void dynamicArrCharAppendc(DynamicArrChar* darr, char ch) {
     if (darr->cur->i >= darr->cur->cap) {
-        darr->cur->next = (DynamicArrCharNode*)mem_alloc(sizeof(DynamicArrCharNode));
+        darr->cur->next = (DynamicArrCharNode*)mem_alloc_sized(sizeof(DynamicArrCharNode));
         darr->cur->next->cap  = darr->total_cap;
         darr->cur->next->i    = 0;
         darr->cur->next->arr  = (char*)mem_alloc(sizeof(char) * darr->total_cap);
@@ -115,7 +115,7 @@ void dynamicArrCharAppendDarr(DynamicArrChar* darr, DynamicArrChar* darr_src) {
             new_node_cap *= 2;
         }
 
-        darr->cur->next = (DynamicArrCharNode*)mem_alloc(sizeof(DynamicArrCharNode));
+        darr->cur->next = (DynamicArrCharNode*)mem_alloc_sized(sizeof(DynamicArrCharNode));
         darr->cur->next->cap  = new_node_cap;
         darr->cur->next->i    = 0;
         darr->cur->next->arr  = (char*)mem_alloc(sizeof(char) * new_node_cap);
@@ -166,13 +166,19 @@ bool dynamicArrCharEqual(DynamicArrChar* darr, char* str, int64 len) {
 //    because the strings are generated by malloc function.
 //
 char* dynamicArrCharGetStr(DynamicArrChar* darr) {
-    int64 i;
-    int64 j = 0;
     // alloc an extra byte to add an '\0'. because when the string is using
     // outside the dynamic array, it will be used to do some operation like
     // strcmp or strcpy, and they all think the '\0' is the end of a string.
     //
     char* str = (char*)mem_alloc((sizeof(char)*darr->used) + 1);
+    dynamicArrCharCopyStr(darr, str);
+    return str;
+}
+
+// copy the content and an '\0' into the str, which must have used+1 bytes.
+void dynamicArrCharCopyStr(DynamicArrChar* darr, char* str) {
+    int64 i;
+    int64 j = 0;
     DynamicArrCharNode* node;
     for (node = darr->first; node != NULL; node = node->next) {
         for (i = 0; i < node->i; i++) {
@@ -181,7 +187,6 @@ char* dynamicArrCharGetStr(DynamicArrChar* darr) {
         }
     }
     str[darr->used] = '\0';
-    return str;
 }
 
 // DynamicArrCharClear is used to clear the content in the dynamic char array.
@@ -206,7 +211,7 @@ void dynamicArrCharClear(DynamicArrChar* darr) {
         del  = node;
         node = node->next;
         mem_free(del->arr);
-        mem_free(del);
+        mem_free_sized(del, sizeof(DynamicArrCharNode));
     }
 }
 
@@ -222,6 +227,114 @@ void dynamicArrCharDestroy(DynamicArrChar* darr) {
         del  = node;
         node = node->next;
         mem_free(del->arr);
-        mem_free(del);
+        mem_free_sized(del, sizeof(DynamicArrCharNode));
     }
 }
+
+/****** the contiguous char-type dynamic array ******/
+
+// the capacity not bigger than DYNAMIC_ARR_STR_SMALL is always rounded up
+// to it, because the small buffer costs nothing more.
+error dynamicArrStrInit(DynamicArrStr* dstr, int64 capacity) {
+    if (capacity <= 0) {
+        return new_error("err: the capacity of the dynamic char array should be a positive number!");
+    }
+    dstr->heap     = NULL;
+    dstr->cap      = DYNAMIC_ARR_STR_SMALL;
+    dstr->used     = 0;
+    dstr->small[0] = '\0';
+    if (capacity > dstr->cap) {
+        dstr->heap    = (char*)mem_alloc(sizeof(char) * capacity + 1);
+        dstr->heap[0] = '\0';
+        dstr->cap     = capacity;
+    }
+    return NULL;
+}
+
+// make sure the array can hold the need bytes. the capacity is doubled until
+// it is enough, so appending n bytes one by one only reallocs log(n) times.
+// the content is moved to the heap when it can not fit in the small buffer.
+void dynamicArrStrReserve(DynamicArrStr* dstr, int64 need) {
+    int64 cap = dstr->cap;
+    if (need <= cap) {
+        return;
+    }
+    while (cap < need) {
+        cap *= 2;
+    }
+    if (dstr->heap == NULL) {
+        dstr->heap = (char*)mem_alloc(sizeof(char) * cap + 1);
+        memcpy(dstr->heap, dstr->small, dstr->used + 1);
+    }
+    else {
+        dstr->heap = (char*)mem_realloc(dstr->heap, sizeof(char) * cap + 1);
+    }
+    dstr->cap = cap;
+}
+
+void dynamicArrStrAppend(DynamicArrStr* dstr, const char* str, int64 len) {
+    char* arr;
+    dynamicArrStrReserve(dstr, dstr->used + len);
+    arr = dynamicArrStrData(dstr);
+    memcpy(arr + dstr->used, str, len);
+    dstr->used += len;
+    arr[dstr->used] = '\0';
+}
+
+void dynamicArrStrAppendc(DynamicArrStr* dstr, char ch) {
+    char* arr;
+    if (dstr->used >= dstr->cap) {
+        dynamicArrStrReserve(dstr, dstr->used + 1);
+    }
+    arr = dynamicArrStrData(dstr);
+    arr[dstr->used++] = ch;
+    arr[dstr->used]   = '\0';
+}
+
+void dynamicArrStrAppendDstr(DynamicArrStr* dstr, DynamicArrStr* dstr_src) {
+    dynamicArrStrAppend(dstr, dynamicArrStrData(dstr_src), dstr_src->used);
+}
+
+bool dynamicArrStrEqual(DynamicArrStr* dstr, const char* str, int64 len) {
+    return dstr->used == len && memcmp(dynamicArrStrData(dstr), str, len) == 0 ? true : false;
+}
+
+const char* dynamicArrStrView(DynamicArrStr* dstr) {
+    return dynamicArrStrData(dstr);
+}
+
+// like the dynamicArrCharGetStr, the copy returned should be released by
+// the mem_free. use the dynamicArrStrView if the copy is not kept.
+char* dynamicArrStrGetStr(DynamicArrStr* dstr) {
+    char* str = (char*)mem_alloc(sizeof(char) * dstr->used + 1);
+    memcpy(str, dynamicArrStrData(dstr), dstr->used + 1);
+    return str;
+}
+
+// take the content away as a string which should be released by the
+// mem_free, and the array becomes empty. the buffer on the heap is given
+// away without copying, so building a long string and keeping it only
+// allocates for the building.
+char* dynamicArrStrDetach(DynamicArrStr* dstr) {
+    char* str = dstr->heap != NULL ? dstr->heap : dynamicArrStrGetStr(dstr);
+    dstr->heap     = NULL;
+    dstr->cap      = DYNAMIC_ARR_STR_SMALL;
+    dstr->used     = 0;
+    dstr->small[0] = '\0';
+    return str;
+}
+
+// the buffer is kept by the clear, so the array can be reused without
+// allocating again.
+void dynamicArrStrClear(DynamicArrStr* dstr) {
+    dstr->used = 0;
+    dynamicArrStrData(dstr)[0] = '\0';
+}
+
+void dynamicArrStrDestroy(DynamicArrStr* dstr) {
+    mem_free(dstr->heap);
+    dstr->heap     = NULL;
+    dstr->cap      = DYNAMIC_ARR_STR_SMALL;
+    dstr->used     = 0;
+    dstr->small[0] = '\0';
+}
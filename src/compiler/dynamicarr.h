@@ -11,6 +11,7 @@
 #define CPLUS_DYNAMICARR_H
 
 #include "common.h"
+#include "arena.h"
 
 typedef struct DynamicArrCharNode DynamicArrCharNode;
 typedef struct DynamicArrChar     DynamicArrChar;
@@ -40,7 +41,145 @@ extern void  dynamicArrCharAppendc   (DynamicArrChar* darr, char  ch);
 extern void  dynamicArrCharAppendDarr(DynamicArrChar* darr, DynamicArrChar* darr_src);
 extern bool  dynamicArrCharEqual     (DynamicArrChar* darr, char* str, int64 len);
 extern char* dynamicArrCharGetStr    (DynamicArrChar* darr);
+extern void  dynamicArrCharCopyStr   (DynamicArrChar* darr, char* str);
 extern void  dynamicArrCharClear     (DynamicArrChar* darr);
 extern void  dynamicArrCharDestroy   (DynamicArrChar* darr);
 
+// this is the contiguous char-type dynamic array. its content is kept in one
+// buffer which is doubled by the realloc when being full, and the content
+// is always followed by a '\0'. so the content can be borrowed as a string
+// by the dynamicArrStrView without any copying, but the view is only valid
+// until the next append, clear or destroy.
+//
+// the short content is kept in the small buffer inside the array, and it
+// is only moved to the heap when it is longer than DYNAMIC_ARR_STR_SMALL
+// bytes. so the most tokens and paths are built without any allocation.
+// the heap is NULL until then, so the array can be copied by value while
+// the content is in the small buffer.
+//
+#define DYNAMIC_ARR_STR_SMALL 32
+typedef struct DynamicArrStr {
+    char* heap;  // the buffer on the heap, NULL if the small one is used
+    int64 cap;   // the capacity, not counting the byte of the '\0'
+    int64 used;
+    char  small[DYNAMIC_ARR_STR_SMALL + 1];
+}DynamicArrStr;
+
+#define dynamicArrStrData(dstr) ((dstr)->heap != NULL ? (dstr)->heap : (dstr)->small)
+
+extern error       dynamicArrStrInit      (DynamicArrStr* dstr, int64 capacity);
+extern void        dynamicArrStrReserve   (DynamicArrStr* dstr, int64 need);
+extern void        dynamicArrStrAppend    (DynamicArrStr* dstr, const char* str, int64 len);
+extern void        dynamicArrStrAppendc   (DynamicArrStr* dstr, char ch);
+extern void        dynamicArrStrAppendDstr(DynamicArrStr* dstr, DynamicArrStr* dstr_src);
+extern bool        dynamicArrStrEqual     (DynamicArrStr* dstr, const char* str, int64 len);
+extern const char* dynamicArrStrView      (DynamicArrStr* dstr);
+extern char*       dynamicArrStrGetStr    (DynamicArrStr* dstr);
+extern char*       dynamicArrStrDetach    (DynamicArrStr* dstr);
+extern void        dynamicArrStrClear     (DynamicArrStr* dstr);
+extern void        dynamicArrStrDestroy   (DynamicArrStr* dstr);
+
+// DYNAMIC_ARR_DEFINE generates a typed dynamic array whose elements are
+// contiguous, like:
+//    DYNAMIC_ARR_DEFINE(ASTExprVec, astExprVec, ASTNodeExpr*)
+// defines the struct ASTExprVec and the functions below:
+//    astExprVecInit    (vec, arena)      -> the arena may be NULL
+//    astExprVecReserve (vec, need)       -> make room for the need elements
+//    astExprVecPush    (vec, item)
+//    astExprVecPop     (vec)             -> the vec must not be empty
+//    astExprVecTop     (vec)             -> the pointer to the last element
+//    astExprVecTruncate(vec, count)      -> drop the elements after count
+//    astExprVecDup     (vec, from, arena)-> copy the elements from the index
+//                                           into the arena, NULL if none
+//    astExprVecClear   (vec)
+//    astExprVecDestroy (vec)
+// the capacity is doubled when being full. if the vec is given an arena,
+// the elements are allocated from it and the old ones are left in it when
+// the vec grows, so nothing has to be destroyed. otherwise they are kept
+// by the mem_realloc and released by the Destroy. iterate the elements by the
+// dynamicArrForEach.
+//
+#define DYNAMIC_ARR_DEFINE(Name, prefix, T)                                           \
+typedef struct Name {                                                                 \
+    T*     arr;                                                                       \
+    int32  count;                                                                     \
+    int32  cap;                                                                       \
+    Arena* arena;  /* NULL if the elements are on the heap */                         \
+}Name;                                                                                \
+                                                                                      \
+static inline void prefix##Init(Name* vec, Arena* arena) {                            \
+    vec->arr   = NULL;                                                                \
+    vec->count = 0;                                                                   \
+    vec->cap   = 0;                                                                   \
+    vec->arena = arena;                                                               \
+}                                                                                     \
+                                                                                      \
+static inline void prefix##Reserve(Name* vec, int32 need) {                           \
+    int32 cap = vec->cap > 0 ? vec->cap : 8;                                          \
+    T*    arr;                                                                        \
+    if (need <= vec->cap) {                                                           \
+        return;                                                                       \
+    }                                                                                 \
+    while (cap < need) {                                                              \
+        cap *= 2;                                                                     \
+    }                                                                                 \
+    if (vec->arena != NULL) {                                                         \
+        arr = (T*)arenaAlloc(vec->arena, sizeof(T) * cap);                            \
+        if (vec->count > 0) {                                                         \
+            memcpy(arr, vec->arr, sizeof(T) * vec->count);                            \
+        }                                                                             \
+    }                                                                                 \
+    else {                                                                            \
+        arr = (T*)mem_realloc(vec->arr, sizeof(T) * cap);                             \
+    }                                                                                 \
+    vec->arr = arr;                                                                   \
+    vec->cap = cap;                                                                   \
+}                                                                                     \
+                                                                                      \
+static inline void prefix##Push(Name* vec, T item) {                                  \
+    if (vec->count >= vec->cap) {                                                     \
+        prefix##Reserve(vec, vec->count + 1);                                         \
+    }                                                                                 \
+    vec->arr[vec->count++] = item;                                                    \
+}                                                                                     \
+                                                                                      \
+static inline T prefix##Pop(Name* vec) {                                              \
+    return vec->arr[--vec->count];                                                    \
+}                                                                                     \
+                                                                                      \
+static inline T* prefix##Top(Name* vec) {                                             \
+    return vec->count > 0 ? &vec->arr[vec->count - 1] : NULL;                         \
+}                                                                                     \
+                                                                                      \
+static inline void prefix##Truncate(Name* vec, int32 count) {                         \
+    if (count < vec->count) {                                                         \
+        vec->count = count;                                                           \
+    }                                                                                 \
+}                                                                                     \
+                                                                                      \
+static inline T* prefix##Dup(Name* vec, int32 from, Arena* arena) {                   \
+    T* arr;                                                                           \
+    if (from >= vec->count) {                                                         \
+        return NULL;                                                                  \
+    }                                                                                 \
+    arr = (T*)arenaAlloc(arena, sizeof(T) * (vec->count - from));                     \
+    memcpy(arr, vec->arr + from, sizeof(T) * (vec->count - from));                    \
+    return arr;                                                                       \
+}                                                                                     \
+                                                                                      \
+static inline void prefix##Clear(Name* vec) {                                         \
+    vec->count = 0;                                                                   \
+}                                                                                     \
+                                                                                      \
+static inline void prefix##Destroy(Name* vec) {                                       \
+    if (vec->arena == NULL) {                                                         \
+        mem_free(vec->arr);                                                           \
+    }                                                                                 \
+    vec->arr   = NULL;                                                                \
+    vec->count = 0;                                                                   \
+    vec->cap   = 0;                                                                   \
+}
+
+#define dynamicArrForEach(vec, i) for ((i) = 0; (i) < (vec)->count; (i)++)
+
 #endif
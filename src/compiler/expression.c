@@ -24,171 +24,368 @@ int8 getOptrPriority(int16 op_token_code) {
     return OP_PRIORITY_NULL;
 }
 
-/****** methods of OptrStack ******/
+/****** the binding of the operators ******/
 
-void optrStackInit(OptrStack* optrstk) {
-    optrstk->top = NULL;
-}
+#define P_NULL OP_PRIORITY_NULL
 
-void optrStackPush(OptrStack* optrstk, OptrInfo op) {
-    OptrStackNode* create = (OptrStackNode*)mem_alloc(sizeof(OptrStackNode));
-    create->op   = op;
-    create->next = NULL;
-    if (optrstk->top != NULL) {
-        create->next = optrstk->top;
-        optrstk->top = create;
-    }
-    else {
-        optrstk->top = create;
-    }
-}
+// the bindings of the operators from TOKEN_OP_ASSIGN to TOKEN_OP_COLON. the
+// priorities are the ones of getOptrPriority. the '-' is also the prefix '-'
+// (TOKEN_OP_NEG), because the lexer does not tell them apart.
+static const OptrBinding optr_bindings[] = {
+    // prefix         infix          postfix
+    { P_NULL,        P_NULL,        P_NULL        }, // =
+    { P_NULL,        P_NULL,        P_NULL        }, // +=
+    { P_NULL,        P_NULL,        P_NULL        }, // -=
+    { P_NULL,        P_NULL,        P_NULL        }, // *=
+    { P_NULL,        P_NULL,        P_NULL        }, // /=
+    { P_NULL,        P_NULL,        P_NULL        }, // %=
+    { P_NULL,        P_NULL,        P_NULL        }, // &=
+    { P_NULL,        P_NULL,        P_NULL        }, // |=
+    { P_NULL,        P_NULL,        P_NULL        }, // ^=
+    { P_NULL,        OP_PRIORITY_0, P_NULL        }, // .
+    { P_NULL,        P_NULL,        OP_PRIORITY_0 }, // ( of the function call
+    { P_NULL,        P_NULL,        P_NULL        }, // )
+    { P_NULL,        P_NULL,        P_NULL        }, // {
+    { P_NULL,        P_NULL,        P_NULL        }, // }
+    { P_NULL,        P_NULL,        OP_PRIORITY_1 }, // ++
+    { P_NULL,        P_NULL,        OP_PRIORITY_1 }, // --
+    { OP_PRIORITY_1, P_NULL,        P_NULL        }, // -(negative)
+    { OP_PRIORITY_1, P_NULL,        P_NULL        }, // $
+    { OP_PRIORITY_1, P_NULL,        P_NULL        }, // @
+    { P_NULL,        P_NULL,        OP_PRIORITY_1 }, // [
+    { P_NULL,        P_NULL,        P_NULL        }, // ]
+    { P_NULL,        OP_PRIORITY_2, P_NULL        }, // *
+    { P_NULL,        OP_PRIORITY_2, P_NULL        }, // /
+    { P_NULL,        OP_PRIORITY_2, P_NULL        }, // %
+    { P_NULL,        OP_PRIORITY_3, P_NULL        }, // +
+    { OP_PRIORITY_1, OP_PRIORITY_3, P_NULL        }, // -
+    { P_NULL,        OP_PRIORITY_4, P_NULL        }, // <<
+    { P_NULL,        OP_PRIORITY_4, P_NULL        }, // >>
+    { P_NULL,        OP_PRIORITY_5, P_NULL        }, // &
+    { P_NULL,        OP_PRIORITY_5, P_NULL        }, // |
+    { P_NULL,        OP_PRIORITY_5, P_NULL        }, // ^
+    { OP_PRIORITY_6, P_NULL,        P_NULL        }, // !
+    { P_NULL,        OP_PRIORITY_7, P_NULL        }, // ==
+    { P_NULL,        OP_PRIORITY_7, P_NULL        }, // !=
+    { P_NULL,        OP_PRIORITY_7, P_NULL        }, // <
+    { P_NULL,        OP_PRIORITY_7, P_NULL        }, // >
+    { P_NULL,        OP_PRIORITY_7, P_NULL        }, // <=
+    { P_NULL,        OP_PRIORITY_7, P_NULL        }, // >=
+    { P_NULL,        OP_PRIORITY_8, P_NULL        }, // &&
+    { P_NULL,        OP_PRIORITY_9, P_NULL        }, // ||
+};
 
-// return true if the stack is empty.
-bool optrStackIsEmpty(OptrStack* optrstk) {
-    if (optrstk->top == NULL) {
-        return true;
+#undef P_NULL
+
+// return NULL if the token is not an operator of the expressions.
+const OptrBinding* getOptrBinding(int16 op_token_code) {
+    if (op_token_code < TOKEN_OP_ASSIGN || op_token_code > TOKEN_OP_LOGIC_OR) {
+        return NULL;
     }
-    return false;
+    return &optr_bindings[op_token_code - TOKEN_OP_ASSIGN];
 }
 
-OptrInfo* optrStackTop(OptrStack* optrstk) {
-    return &optrstk->top->op;
+/****** methods of ExprParser ******/
+
+void exprParserInit(ExprParser* ep, Lexer* lexer, Arena* ast_arena) {
+    ep->lexer     = lexer;
+    ep->cur_token = NULL;
+    ep->ast_arena = ast_arena;
+    ep->err       = NULL;
+    ep->depth     = 0;
+    ep->nested    = 0;
+    astExprVecInit(&ep->params, NULL);
 }
 
-void optrStackPop(OptrStack* optrstk) {
-    OptrStackNode* temp = optrstk->top;
-    optrstk->top = optrstk->top->next;
-    mem_free(temp);
+void exprParserDestroy(ExprParser* ep) {
+    astExprVecDestroy(&ep->params);
 }
 
-void optrStackDestroy(OptrStack* optrstk) {
-    OptrStackNode* temp;
-    for (;;) {
-        if (optrstk->top == NULL) {
-            return;
+// parse the current token without consuming it. the cur_token is NULL at
+// the end of the file or if the lexer fails.
+static void exprPeek(ExprParser* ep) {
+    error err = lexerParseToken(ep->lexer);
+    if (err != NULL) {
+        if (ERROR_CODE(err) != LEX_ERROR_EOF && ep->err == NULL) {
+            ep->err = err;
         }
-        temp = optrstk->top;
-        optrstk->top = optrstk->top->next;
-        mem_free(temp);
+        ep->cur_token = NULL;
+        return;
     }
+    ep->cur_token = lexerReadToken(ep->lexer);
 }
 
-/****** methods of OprdStack ******/
-
-void oprdStackInit(OprdStack* oprdstk) {
-    oprdstk->top        = NULL;
-    oprdstk->oprd_count = 0;
+static void exprNext(ExprParser* ep) {
+    lexerNextToken(ep->lexer);
+    exprPeek(ep);
 }
 
-void oprdStackPush(OprdStack* oprdstk, ASTNodeExpr* oprdexpr) {
-    OprdStackNode* create = (OprdStackNode*)mem_alloc(sizeof(OprdStackNode));
-    create->oprd = oprdexpr;
-    create->next = NULL;
-    if (oprdstk->top != NULL) {
-        create->next = oprdstk->top;
-        oprdstk->top = create;
+static void exprSkipLinefeed(ExprParser* ep) {
+    while (ep->cur_token != NULL && ep->cur_token->token_code == TOKEN_LINEFEED) {
+        exprNext(ep);
     }
-    else {
-        oprdstk->top = create;
+}
+
+static bool exprMeet(ExprParser* ep, int16 token_code) {
+    return ep->cur_token != NULL && ep->cur_token->token_code == token_code ? true : false;
+}
+
+// only the first error is kept.
+static ASTNodeExpr* exprFail(ExprParser* ep, char* errmsg) {
+    if (ep->err == NULL) {
+        ep->err = new_error(errmsg);
     }
-    oprdstk->oprd_count++;
+    return NULL;
 }
 
-// return true if the stack is empty.
-bool oprdStackIsEmpty(OprdStack* oprdstk) {
-    if (oprdstk->top == NULL) {
-        return true;
+// the content of the token is borrowed from the source code if the token is
+// a span of it, otherwise it is copied into the arena of the AST.
+static char* exprTokenContent(ExprParser* ep) {
+    char* content = lexTokenSpanPtr(ep->cur_token);
+    if (content != NULL) {
+        return content;
     }
-    return false;
+    return arenaStrdup(ep->ast_arena, dynamicArrStrView(&ep->cur_token->token), ep->cur_token->token.used);
 }
 
-ASTNodeExpr* oprdStackTop(OprdStack* oprdstk) {
-    return oprdstk->top->oprd;
+static ASTNodeExpr* exprNewID(ExprParser* ep) {
+    ASTNodeExpr* expr = arenaNew(ep->ast_arena, ASTNodeExpr);
+    ASTNodeID*   id   = arenaNew(ep->ast_arena, ASTNodeID);
+    id->pos_line = ep->cur_token->span.line;
+    id->pos_col  = ep->cur_token->span.col;
+    id->id       = ep->cur_token->token_intern != NULL ? ep->cur_token->token_intern : exprTokenContent(ep);
+    id->id_len   = ep->cur_token->token_len;
+    expr->expr_type    = AST_NODE_ID;
+    expr->expr.expr_id = id;
+    exprNext(ep);
+    return expr;
 }
 
-void oprdStackPop(OprdStack* oprdstk) {
-    oprdstk->top = oprdstk->top->next;
-    oprdstk->oprd_count--;
+static ASTNodeExpr* exprNewConstLit(ExprParser* ep) {
+    ASTNodeExpr*     expr = arenaNew(ep->ast_arena, ASTNodeExpr);
+    ASTNodeConstLit* lit  = arenaNew(ep->ast_arena, ASTNodeConstLit);
+    lit->pos_line    = ep->cur_token->span.line;
+    lit->pos_col     = ep->cur_token->span.col;
+    lit->const_type  = ep->cur_token->token_code;
+    lit->const_value = exprTokenContent(ep);
+    lit->const_len   = ep->cur_token->token_len;
+    expr->expr_type           = AST_NODE_CONST_LIT;
+    expr->expr.expr_const_lit = lit;
+    exprNext(ep);
+    return expr;
 }
 
-error oprdStackCalcuOnce(OprdStack* oprdstk, OptrInfo op) {
-    switch (op.op_type) {
-    case OP_TYPE_LUNARY:
-    case OP_TYPE_RUNARY: {
-            // get the operand of the unary operator
-            if (oprdStackIsEmpty(oprdstk) == true) {
-                return new_error("no enough operands.");
-            }
-            ASTNodeExpr* oprd = oprdStackTop(oprdstk);
-            oprdStackPop(oprdstk);
+static ASTNodeExpr* exprNewUnary(ExprParser* ep, int16 op_token_code, ASTNodeExpr* oprd) {
+    ASTNodeExpr* expr = arenaNew(ep->ast_arena, ASTNodeExpr);
+    expr->expr_type       = AST_NODE_EXPR_UNRY;
+    expr->expr.expr_unary = arenaNew(ep->ast_arena, ASTNodeExprUnry);
+    expr->expr.expr_unary->op_token_code = op_token_code;
+    expr->expr.expr_unary->oprd          = oprd;
+    return expr;
+}
 
-            // get the result expression
-            ASTNodeExpr* calcu_ret = (ASTNodeExpr*)mem_alloc(sizeof(ASTNodeExpr*));
-            calcu_ret->expr_type = AST_NODE_EXPR_UNRY;
-            calcu_ret->expr.expr_unary = (ASTNodeExprUnry*)mem_alloc(sizeof(ASTNodeExprUnry));
-            calcu_ret->expr.expr_unary->op_token_code = op.op_token_code;
-            calcu_ret->expr.expr_unary->oprd = oprd;
-            oprdStackPush(oprdstk, calcu_ret);
-        }
-        break;
+static ASTNodeExpr* exprNewBinary(ExprParser* ep, int16 op_token_code, ASTNodeExpr* oprd1, ASTNodeExpr* oprd2) {
+    ASTNodeExpr* expr = arenaNew(ep->ast_arena, ASTNodeExpr);
+    expr->expr_type        = AST_NODE_EXPR_BNRY;
+    expr->expr.expr_binary = arenaNew(ep->ast_arena, ASTNodeExprBnry);
+    expr->expr.expr_binary->op_token_code = op_token_code;
+    expr->expr.expr_binary->oprd1         = oprd1;
+    expr->expr.expr_binary->oprd2         = oprd2;
+    return expr;
+}
 
-    case OP_TYPE_BINARY: {
-            // get the two operands of the binary operator
-            if (oprdStackIsEmpty(oprdstk) == true) {
-                return new_error("no enough operands.");
-            }
-            ASTNodeExpr* oprd2 = oprdStackTop(oprdstk);
-            oprdStackPop(oprdstk);
-            if (oprdStackIsEmpty(oprdstk) == true) {
-                return new_error("no enough operands.");
-            }
-            ASTNodeExpr* oprd1 = oprdStackTop(oprdstk);
-            oprdStackPop(oprdstk);
-
-            // get the result expression
-            ASTNodeExpr* calcu_ret = (ASTNodeExpr*)mem_alloc(sizeof(ASTNodeExpr));
-            calcu_ret->expr_type = AST_NODE_EXPR_BNRY;
-            calcu_ret->expr.expr_binary = (ASTNodeExprBnry*)mem_alloc(sizeof(ASTNodeExprBnry));
-            calcu_ret->expr.expr_binary->op_token_code = op.op_token_code;
-            calcu_ret->expr.expr_binary->oprd1 = oprd1;
-            calcu_ret->expr.expr_binary->oprd2 = oprd2;
-            oprdStackPush(oprdstk, calcu_ret);
+static ASTNodeExpr* exprParseBp(ExprParser* ep, int8 min_priority);
+
+// parse the operand with its prefix operators.
+static ASTNodeExpr* exprParseOperand(ExprParser* ep) {
+    const OptrBinding* binding;
+    ASTNodeExpr*       expr;
+    int16              token_code;
+
+    exprSkipLinefeed(ep);
+    if (ep->cur_token == NULL) {
+        return exprFail(ep, "miss the operand at the end of the file.");
+    }
+    token_code = ep->cur_token->token_code;
+    if (tokenIsID(token_code) || tokenIsPrimType(token_code)) {
+        return exprNewID(ep);
+    }
+    if (tokenIsConstLit(token_code)) {
+        return exprNewConstLit(ep);
+    }
+    if (token_code == TOKEN_OP_LPARENTHESE) {
+        ep->nested++;
+        exprNext(ep);
+        if ((expr = exprParseBp(ep, OP_PRIORITY_NULL)) == NULL) {
+            return NULL;
         }
-        break;
+        exprSkipLinefeed(ep);
+        if (exprMeet(ep, TOKEN_OP_RPARENTHESE) == false) {
+            return exprFail(ep, "miss the ) to close the parenthesized expression.");
+        }
+        ep->nested--;
+        exprNext(ep);
+        return expr;
     }
-
-    return NULL;
+    if ((binding = getOptrBinding(token_code)) != NULL && binding->prefix != OP_PRIORITY_NULL) {
+        exprNext(ep);
+        if ((expr = exprParseBp(ep, binding->prefix)) == NULL) {
+            return NULL;
+        }
+        return exprNewUnary(ep, token_code == TOKEN_OP_SUB ? TOKEN_OP_NEG : token_code, expr);
+    }
+    return exprFail(ep, "unexpected token in the expression.");
 }
 
-error oprdStackCalcu(OprdStack* oprdstk, OptrStack* optrstk) {
-    error     err;
-    OptrInfo* top_optr;
+// parse the parameters of the function call, the ( has been met. the
+// parameters are pushed in the ep->params above the base, and copied into
+// the arena as one array when the ) is met.
+static ASTNodeExprList* exprParseParams(ExprParser* ep) {
+    ASTNodeExprList* params = arenaNew(ep->ast_arena, ASTNodeExprList);
+    ASTNodeExpr*     param;
+    int32            base   = ep->params.count;
+    params->exprs = NULL;
+    params->count = 0;
+    exprNext(ep);
+    exprSkipLinefeed(ep);
+    if (exprMeet(ep, TOKEN_OP_RPARENTHESE) == true) {
+        return params;
+    }
     for (;;) {
-        top_optr = optrStackIsEmpty(optrstk) == false ? (optrStackTop(optrstk)) : NULL;
-        if (top_optr == NULL || top_optr->op_token_code == TOKEN_OP_LPARENTHESE) {
+        if ((param = exprParseBp(ep, OP_PRIORITY_NULL)) == NULL) {
+            astExprVecTruncate(&ep->params, base);
             return NULL;
         }
-        if ((err = oprdStackCalcuOnce(oprdstk, *top_optr)) != NULL) {
-            return err;
+        astExprVecPush(&ep->params, param);
+
+        exprSkipLinefeed(ep);
+        if (exprMeet(ep, TOKEN_OP_RPARENTHESE) == true) {
+            params->count = ep->params.count - base;
+            params->exprs = astExprVecDup(&ep->params, base, ep->ast_arena);
+            astExprVecTruncate(&ep->params, base);
+            return params;
+        }
+        if (exprMeet(ep, TOKEN_OP_COMMA) == false) {
+            astExprVecTruncate(&ep->params, base);
+            exprFail(ep, "miss the ) to close the function call.");
+            return NULL;
         }
+        exprNext(ep);
     }
 }
 
-ASTNodeExpr* oprdStackGetResult(OprdStack* oprdstk) {
-    if (oprdstk->oprd_count == 1)
-        return oprdStackTop(oprdstk);
-    else
-        return (void*)-1;
+// parse the postfix operator following the operand.
+static ASTNodeExpr* exprParsePostfix(ExprParser* ep, ASTNodeExpr* oprd) {
+    ASTNodeExpr* expr;
+    ASTNodeExpr* index;
+    int16        token_code = ep->cur_token->token_code;
+
+    switch (token_code) {
+    case TOKEN_OP_INC:
+    case TOKEN_OP_DEC:
+        exprNext(ep);
+        return exprNewUnary(ep, token_code, oprd);
+
+    case TOKEN_OP_LBRACKET:
+        if (oprd->expr_type != AST_NODE_ID) {
+            return exprFail(ep, "only the identifiers can be indexed.");
+        }
+        ep->nested++;
+        exprNext(ep);
+        if ((index = exprParseBp(ep, OP_PRIORITY_NULL)) == NULL) {
+            return NULL;
+        }
+        exprSkipLinefeed(ep);
+        if (exprMeet(ep, TOKEN_OP_RBRACKET) == false) {
+            return exprFail(ep, "miss the ] to close the indexing.");
+        }
+        ep->nested--;
+        exprNext(ep);
+        expr = arenaNew(ep->ast_arena, ASTNodeExpr);
+        expr->expr_type       = AST_NODE_INDEX;
+        expr->expr.expr_index = arenaNew(ep->ast_arena, ASTNodeIndex);
+        expr->expr.expr_index->array = oprd->expr.expr_id;
+        expr->expr.expr_index->index = index;
+        return expr;
+
+    case TOKEN_OP_LPARENTHESE:
+        if (oprd->expr_type != AST_NODE_ID) {
+            return exprFail(ep, "only the named functions can be called.");
+        }
+        expr = arenaNew(ep->ast_arena, ASTNodeExpr);
+        expr->expr_type           = AST_NODE_FUNC_CALL;
+        expr->expr.expr_func_call = arenaNew(ep->ast_arena, ASTNodeFuncCall);
+        expr->expr.expr_func_call->func_name = oprd->expr.expr_id;
+        ep->nested++;
+        if ((expr->expr.expr_func_call->func_params = exprParseParams(ep)) == NULL) {
+            return NULL;
+        }
+        ep->nested--;
+        exprNext(ep);
+        return expr;
+    }
+    return exprFail(ep, "unexpected postfix operator.");
 }
 
-void oprdStackDestroy(OprdStack* oprdstk) {
-    OprdStackNode* temp;
+// parse the expression whose operators bind tighter than the min_priority.
+// a binary operator takes the operands on its right side which bind tighter
+// than itself, so the operators of the same priority are left associative.
+// a postfix operator binding as tight as the min_priority is still taken,
+// so the $p++ is $(p++) and the mod.func(x) is mod.(func(x)).
+//
+// example:
+//    a + b * c - d
+//    => exprParseBp(NULL) takes a, then + binds tighter than NULL, so
+//       exprParseBp(+) takes b * c and stops before the -, which does not
+//       bind tighter than +. the loop goes on with (a + (b * c)) - d.
+//
+static ASTNodeExpr* exprParseBp(ExprParser* ep, int8 min_priority) {
+    const OptrBinding* binding;
+    ASTNodeExpr*       lhs;
+    ASTNodeExpr*       rhs;
+    int16              token_code;
+
+    if (++ep->depth > EXPR_MAX_DEPTH) {
+        return exprFail(ep, "the expression is nested too deeply.");
+    }
+    if ((lhs = exprParseOperand(ep)) == NULL) {
+        return NULL;
+    }
     for (;;) {
-        if (oprdstk->top == NULL) {
-            return;
+        if (ep->nested > 0) {
+            exprSkipLinefeed(ep);
         }
-        temp = oprdstk->top;
-        oprdstk->top = oprdstk->top->next;
-        mem_free(temp);
+        if (ep->cur_token == NULL || (binding = getOptrBinding(token_code = ep->cur_token->token_code)) == NULL) {
+            break;
+        }
+        if (binding->postfix != OP_PRIORITY_NULL && binding->postfix >= min_priority) {
+            if ((lhs = exprParsePostfix(ep, lhs)) == NULL) {
+                return NULL;
+            }
+            continue;
+        }
+        if (binding->infix != OP_PRIORITY_NULL && binding->infix > min_priority) {
+            exprNext(ep);
+            if ((rhs = exprParseBp(ep, binding->infix)) == NULL) {
+                return NULL;
+            }
+            lhs = exprNewBinary(ep, token_code, lhs, rhs);
+            continue;
+        }
+        break;
     }
-}
\ No newline at end of file
+    ep->depth--;
+    return lhs;
+}
+
+// parse one expression. NULL is returned if any error occurs, and the error
+// is saved in the ep->err.
+ASTNodeExpr* exprParse(ExprParser* ep) {
+    ASTNodeExpr* expr;
+    ep->err    = NULL;
+    ep->depth  = 0;
+    ep->nested = 0;
+    exprPeek(ep);
+    expr = exprParseBp(ep, OP_PRIORITY_NULL);
+    return ep->err == NULL ? expr : NULL;
+}
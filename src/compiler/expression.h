@@ -13,6 +13,7 @@
 #include "common.h"
 #include "lexer.h"
 #include "ast.h"
+#include "arena.h"
 
 // the priority with a smaller number has the higher precedence.
 #define OP_PRIORITY_NULL -1
@@ -33,50 +34,41 @@ extern int8 getOptrPriority(int16 op_token_code);
 #define OP_TYPE_RUNARY   EXTRA_INFO_OP_RUNARY
 #define OP_TYPE_BINARY   EXTRA_INFO_OP_BINARY
 #define OP_TYPE_EXPR_END EXTRA_INFO_EXPR_END
-typedef struct OptrInfo {
-    int16 op_token_code; // TOKEN_OP_XXX
-    int8  op_type;       // OP_TYPE_LUNARY or OP_TYPE_RUNARY or OP_TYPE_BINARY
-    int8  op_priority;   // OP_PRIORITY_0 to OP_PRIORITY_9
-}OptrInfo;
 
-typedef struct OptrStackNode {
-    OptrInfo op;
-    struct OptrStackNode* next;
-}OptrStackNode;
+// the OptrBinding records how tight an operator binds as a prefix, a binary
+// and a postfix operator. the values are the priorities of getOptrPriority,
+// and OP_PRIORITY_NULL means the operator can not be used in that place.
+typedef struct OptrBinding {
+    int8 prefix;
+    int8 infix;
+    int8 postfix;
+}OptrBinding;
 
-// the OptrStack is used to save a set of operators' information
-// to assist to parse the expression.
-typedef struct {
-    OptrStackNode* top;
-}OptrStack;
+extern const OptrBinding* getOptrBinding(int16 op_token_code);
 
-extern void      optrStackInit   (OptrStack* optrstk);
-extern void      optrStackPush   (OptrStack* optrstk, OptrInfo op);
-extern bool      optrStackIsEmpty(OptrStack* optrstk);
-extern OptrInfo* optrStackTop    (OptrStack* optrstk);
-extern void      optrStackPop    (OptrStack* optrstk);
-extern void      optrStackDestroy(OptrStack* optrstk);
+// the ExprParser parses an expression by the precedence climbing. the
+// tokens are read from the lexer, and the nodes are allocated from the
+// arena of the AST, so nothing is allocated for the operators.
+//
+// the expression ends at the first token which can not continue it, and
+// the token is left in the lexer for the caller. the line-feeds are
+// skipped after the operators and inside the parentheses and brackets.
+//
+#define EXPR_MAX_DEPTH 512
+typedef struct ExprParser {
+    Lexer*    lexer;
+    LexToken* cur_token; // NULL at the end of the file
+    Arena*    ast_arena;
+    error     err;       // the first error met, NULL if none
+    int32     depth;     // the depth of the recursion
+    int32     nested;    // the number of the parentheses and brackets open
+    // the parameters of the function calls being parsed, the nested calls
+    // push theirs above the ones of the outer calls.
+    ASTExprVec params;
+}ExprParser;
 
-typedef struct OprdStackNode {
-    ASTNodeExpr* oprd;
-    struct OprdStackNode* next;
-}OprdStackNode;
-
-// the OprdStack is used to save a set of ASTNodeExpr to assist
-// to parse the expression.
-typedef struct {
-    OprdStackNode* top;
-    int            oprd_count;
-}OprdStack;
-
-extern void         oprdStackInit     (OprdStack* oprdstk);
-extern void         oprdStackPush     (OprdStack* oprdstk, ASTNodeExpr* oprdexpr);
-extern bool         oprdStackIsEmpty  (OprdStack* oprdstk);
-extern ASTNodeExpr* oprdStackTop      (OprdStack* oprdstk);
-extern void         oprdStackPop      (OprdStack* oprdstk);
-extern error        oprdStackCalcuOnce(OprdStack* oprdstk, OptrInfo   op);
-extern error        oprdStackCalcu    (OprdStack* oprdstk, OptrStack* optrstk);
-extern ASTNodeExpr* oprdStackGetResult(OprdStack* oprdstk);
-extern void         oprdStackDestroy  (OprdStack* oprdstk);
+extern void         exprParserInit   (ExprParser* ep, Lexer* lexer, Arena* ast_arena);
+extern ASTNodeExpr* exprParse        (ExprParser* ep);
+extern void         exprParserDestroy(ExprParser* ep);
 
 #endif
@@ -8,284 +8,301 @@
 
 // the id_placeholder represents the '_' which is called the anonymous
 // identifier.
-static Ident id_placeholder = {NULL, ACCESS_IN, ID_PLACEHOLDER, NULL};
+static Ident id_placeholder = {"_", ID_TYPE_UNRESOLVED, {NULL}};
+
+/****** methods of Ident ******/
+
+Ident* identNew(char* id_name, int8 id_type) {
+    Ident* id = (Ident*)mem_alloc_sized(sizeof(Ident));
+    id->id_name = id_name;
+    id->id_type = id_type;
+    id->id.id_unresolved = NULL;
+    return id;
+}
+
+void identFree(Ident* id) {
+    mem_free_sized(id, sizeof(Ident));
+}
 
 /****** methods of IdentTable ******/
 
+// the table will be extended when its load factor exceeds 3/4. the
+// first allocation happens on the first adding, so the empty tables
+// of the scopes cost nothing.
+#define IDENT_TABLE_INIT_CAP 16
+
+// the probe distance is kept in a uint8 and 0 marks the empty slot, so no
+// entry is placed farther than it. the table is extended instead, even if
+// its load factor is low.
+#define IDENT_TABLE_MAX_DIST 255
+
 void identTableInit(IdentTable* id_table) {
-    id_table->root = NULL;
+    id_table->entries = NULL;
+    id_table->dists   = NULL;
+    id_table->cap     = 0;
+    id_table->count   = 0;
+    id_table->frozen  = NULL;
 }
 
-// firstly compare every character of the two name from index 0:
-// (1) if name1[index] < name2[index] -> NODE_CMP_LT.
-// (2) if name1[index] > name2[index] -> NODE_CMP_GT.
+// make the table a frozen view of the records. the table must be empty, and
+// the records and the strings must live as long as the table. if the map is
+// not NULL, it is unmapped when the table is destroyed.
 //
-// if all characters compared are the same, then compare their names' length:
-// (1) if the name1's length is longer , return NODE_CMP_GT.
-// (2) if the name1's length is shorter, return NODE_CMP_LT.
-// (3) if tow names'  length are equal , return NODE_CMP_EQ.
-static int identTableCmp(char* name1, char* name2) {
-    int64 i;
-    for (i = 0; ; i++) {
-        if (name1[i] < name2[i]) {
-            return NODE_CMP_LT;
-        }
-        if (name1[i] > name2[i]) {
-            return NODE_CMP_GT;
-        }
-        if (name1[i] == '\0' && name2[i] == '\0') {
-            return NODE_CMP_EQ;
-        }
-        if (name1[i] == '\0' && name2[i] != '\0') {
-            return NODE_CMP_LT;
-        }
-        if (name1[i] != '\0' && name2[i] == '\0') {
-            return NODE_CMP_GT;
-        }
+error identTableInitFrozen(IdentTable* id_table, const IdentFrozenRecord* records, uint32 count,
+                           const char* strtab, uint32 strtab_size, void* map, int64 map_size) {
+    if (id_table->count != 0 || id_table->frozen != NULL) {
+        return new_error("only the empty table can be frozen.");
     }
+    IdentFrozen* frozen = (IdentFrozen*)mem_alloc(sizeof(IdentFrozen));
+    frozen->records     = records;
+    frozen->count       = count;
+    frozen->strtab      = strtab;
+    frozen->strtab_size = strtab_size;
+    frozen->map         = map;
+    frozen->map_size    = map_size;
+    // the idents are not touched until they are made, so only the pages of
+    // the idents made are used.
+    frozen->idents      = (Ident*)mem_alloc(sizeof(Ident) * (count + 1));
+    frozen->ready       = (uint8*)mem_alloc(sizeof(uint8) * (count + 1));
+    memset(frozen->ready, 0, sizeof(uint8) * (count + 1));
+    pthread_mutex_init(&frozen->lock, NULL);
+    id_table->frozen = frozen;
+    id_table->count  = count;
+    return NULL;
 }
 
-// example:
-//     |                       |
-//    node                   rchild
-//   /    \      ----\      /      \
-//  a   rchild   ----/    node      c
-//     /      \          /    \
-//    b        c        a      b
-static error identTableLeftRotate(IdentTable* id_table, IdentTableNode* node) {
-    if (node == id_table->root) {
-        id_table->root = node->rchild;
-        node->rchild->parent = NULL;
+// return the Ident of the records[i], or NULL if the record is broken. the
+// Idents are made on demand, and the double-checked ready flags let the
+// Idents made be read without the lock.
+static Ident* identFrozenGet(IdentFrozen* frozen, uint32 i) {
+    const IdentFrozenRecord* record = &frozen->records[i];
+    if (__atomic_load_n(&frozen->ready[i], __ATOMIC_ACQUIRE) == 1) {
+        return &frozen->idents[i];
     }
-    else {
-        (node == node->parent->lchild)?
-        (node->parent->lchild = node->rchild):
-        (node->parent->rchild = node->rchild);
-         node->rchild->parent = node->parent;
+    if (record->name_off > frozen->strtab_size || record->name_len > frozen->strtab_size - record->name_off ||
+        record->id_type < ID_TYPE_DATATYPE || record->id_type > ID_TYPE_EXPANDER) {
+        return NULL;
     }
-    node->parent = node->rchild;
-    node->rchild = node->rchild->lchild;
-    if (node->parent->lchild != NULL) {
-        node->parent->lchild->parent = node;
+    pthread_mutex_lock(&frozen->lock);
+    if (frozen->ready[i] == 0) {
+        frozen->idents[i].id_name = internStr((char*)frozen->strtab + record->name_off, record->name_len);
+        frozen->idents[i].id_type = record->id_type;
+        frozen->idents[i].id.id_unresolved = NULL;
+        __atomic_store_n(&frozen->ready[i], 1, __ATOMIC_RELEASE);
     }
-    node->parent->lchild = node;
+    pthread_mutex_unlock(&frozen->lock);
+    return &frozen->idents[i];
 }
 
-// example:
-//        |                |
-//       node            lchild
-//      /    \  ----\   /      \
-//   lchild   c ----/  a      node
-//  /      \                 /    \
-// a        b               b      c
-static error identTableRightRotate(IdentTable* id_table, IdentTableNode* node) {
-    if (node == id_table->root) {
-        id_table->root = node->lchild;
-        node->lchild->parent = NULL;
+// find the first record with the hash value by the binary search, then
+// compare the names of the records with the same hash value.
+static Ident* identFrozenSearch(IdentFrozen* frozen, char* id_name) {
+    uint32 hash = internHash(id_name);
+    uint32 len  = internLen(id_name);
+    uint32 low  = 0;
+    uint32 high = frozen->count;
+    uint32 mid;
+    Ident* id;
+    while (low < high) {
+        mid = low + (high - low) / 2;
+        frozen->records[mid].hash < hash ? (low = mid + 1) : (high = mid);
     }
-    else {
-        (node == node->parent->lchild)?
-        (node->parent->lchild = node->lchild):
-        (node->parent->rchild = node->lchild);
-         node->lchild->parent = node->parent;
+    for (; low < frozen->count && frozen->records[low].hash == hash; low++) {
+        if (frozen->records[low].name_len == len && (id = identFrozenGet(frozen, low)) != NULL && id->id_name == id_name) {
+            return id;
+        }
     }
-    node->parent = node->lchild;
-    node->lchild = node->lchild->rchild;
-    if (node->parent->rchild != NULL) {
-        node->parent->rchild->parent = node;
+    return NULL;
+}
+
+static void identFrozenDestroy(IdentFrozen* frozen) {
+    if (frozen->map != NULL) {
+        munmap(frozen->map, frozen->map_size);
     }
-    node->parent->rchild = node;
+    pthread_mutex_destroy(&frozen->lock);
+    mem_free(frozen->idents);
+    mem_free(frozen->ready);
+    mem_free(frozen);
 }
 
-// fix the balance of the tree and try to keep the properties
-// of the red black tree.
-static void identTableAddFixup(IdentTable* id_table, IdentTableNode* added) {
-    IdentTableNode* uncle = NULL;
+// insert the entry into the table without checking the redefinition
+// and the capacity. the entries met on the way are swapped if they are
+// closer to their home slots than the entry inserting. return false if
+// the entry carried would go farther than IDENT_TABLE_MAX_DIST, and the
+// entry is set to the one carried, which is not in the table then.
+static bool identTablePlace(IdentTable* id_table, IdentTableEntry* entry) {
+    uint32          mask = id_table->cap - 1;
+    uint32          i    = internHash(entry->id_name) & mask;
+    uint8           dist = 1;
+    IdentTableEntry temp_entry;
+    uint8           temp_dist;
     for (;;) {
-        if (added->parent == NULL || added->parent->parent == NULL)
-            break;
+        if (id_table->dists[i] == 0) {
+            id_table->entries[i] = *entry;
+            id_table->dists[i]   = dist;
+            return true;
+        }
+        if (id_table->dists[i] < dist) {
+            temp_entry = id_table->entries[i];
+            temp_dist  = id_table->dists[i];
+            id_table->entries[i] = *entry;
+            id_table->dists[i]   = dist;
+            *entry = temp_entry;
+            dist   = temp_dist;
+        }
+        if (dist == IDENT_TABLE_MAX_DIST) {
+            return false;
+        }
+        i = (i + 1) & mask;
+        dist++;
+    }
+}
 
-        if (added->color == NODE_COLOR_RED && added->parent->color == NODE_COLOR_RED) {
-            // the uncle is black or NULL
-            if (added->parent == added->parent->parent->lchild) {
-                uncle = added->parent->parent->rchild;
-                if (uncle == NULL || uncle->color == NODE_COLOR_BLACK) {
-                    if (added == added->parent->rchild) {
-                        added =  added->parent;
-                        identTableLeftRotate(id_table, added);
-                    }
-                    added->parent->color         = NODE_COLOR_BLACK;
-                    added->parent->parent->color = NODE_COLOR_RED;
-                    identTableRightRotate(id_table, added->parent->parent);
-                    break;
-                }
-            }
-            else {
-                uncle = added->parent->parent->lchild;
-                if (uncle == NULL || uncle->color == NODE_COLOR_BLACK) {
-                    if (added == added->parent->lchild) {
-                        added =  added->parent;
-                        identTableRightRotate(id_table, added);
-                    }
-                    added->parent->color         = NODE_COLOR_BLACK;
-                    added->parent->parent->color = NODE_COLOR_RED;
-                    identTableLeftRotate(id_table, added->parent->parent);
-                    break;
-                }
-            }
+// place the entries of the table again in the arrays of the capacity cap.
+// return false if some entry can not be placed, the table is unchanged then.
+static bool identTableRehash(IdentTable* id_table, uint32 cap) {
+    IdentTable      grown;
+    IdentTableEntry entry;
+    uint32          i;
 
-            // the uncle is red
-            uncle->color         = NODE_COLOR_BLACK;
-            uncle->parent->color = NODE_COLOR_RED;
-            added->parent->color = NODE_COLOR_BLACK;
-            added = added->parent->parent;
-        }
-        else {
-            break;
+    grown.cap     = cap;
+    grown.entries = (IdentTableEntry*)mem_alloc(sizeof(IdentTableEntry) * cap);
+    grown.dists   = (uint8*)mem_alloc(sizeof(uint8) * cap);
+    memset(grown.dists, 0, sizeof(uint8) * cap);
+    for (i = 0; i < id_table->cap; i++) {
+        entry = id_table->entries[i];
+        if (id_table->dists[i] != 0 && identTablePlace(&grown, &entry) == false) {
+            mem_free(grown.entries);
+            mem_free(grown.dists);
+            return false;
         }
     }
-    id_table->root->color = NODE_COLOR_BLACK;
+    mem_free(id_table->entries);
+    mem_free(id_table->dists);
+    id_table->entries = grown.entries;
+    id_table->dists   = grown.dists;
+    id_table->cap     = cap;
+    return true;
+}
+
+static void identTableGrow(IdentTable* id_table) {
+    uint32 cap = id_table->cap == 0 ? IDENT_TABLE_INIT_CAP : id_table->cap * 2;
+    while (identTableRehash(id_table, cap) == false) {
+        cap *= 2;
+    }
 }
 
 error identTableAdd(IdentTable* id_table, Ident* id) {
     if (id->id_name == NULL) {
         return new_error("the identifier's name can not be NULL.");
     }
-    IdentTableNode* create = (IdentTableNode*)mem_alloc(sizeof(IdentTableNode));
-    create->id       = id;
-    create->color    = NODE_COLOR_RED;
-    create->parent   = NULL;
-    create->lchild   = NULL;
-    create->rchild   = NULL;
-    if (id_table->root != NULL) {
-        IdentTableNode* ptr = id_table->root;
-        for (;;) {
-            switch (identTableCmp(id->id_name, ptr->id->id_name)) {
-            case NODE_CMP_LT:
-                if (ptr->lchild == NULL) {
-                    ptr->lchild = create;
-                    create->parent = ptr;
-                    identTableAddFixup(id_table, create);
-                    return NULL;
-                }
-                ptr = ptr->lchild;
-                break;
-
-            case NODE_CMP_GT:
-                if (ptr->rchild == NULL) {
-                    ptr->rchild = create;
-                    create->parent = ptr;
-                    identTableAddFixup(id_table, create);
-                    return NULL;
-                }
-                ptr = ptr->rchild;
-                break;
-
-            case NODE_CMP_EQ:
-                return new_error("err: identifier redefined.");
-            }
-        }
+    if (id_table->frozen != NULL) {
+        return new_error("the frozen table can not be changed.");
     }
-    else {
-        create->color = NODE_COLOR_BLACK;
-        id_table->root = create;
-        return NULL;
+    if (identTableSearch(id_table, id->id_name) != NULL) {
+        return new_error("err: identifier redefined.");
+    }
+    if ((id_table->count + 1) * 4 > id_table->cap * 3) {
+        identTableGrow(id_table);
     }
+    IdentTableEntry entry;
+    entry.id_name = id->id_name;
+    entry.id      = id;
+    // the entry carried is the one left over, which may not be the new one.
+    while (identTablePlace(id_table, &entry) == false) {
+        identTableGrow(id_table);
+    }
+    id_table->count++;
+    return NULL;
 }
 
 // return:
 //       NULL -> the identifier is not in the table.
 //   NOT NULL -> the identifier is found.
 Ident* identTableSearch(IdentTable* id_table, char* id_name) {
-    if (id_table->root == NULL) {
+    if (internLen(id_name) == 1 && id_name[0] == '_') {
+        return &id_placeholder;
+    }
+    if (id_table->count == 0) {
         return NULL;
     }
-    if (strcmp(id_name, "_") == 0) {
-        return &id_placeholder;
+    if (id_table->frozen != NULL) {
+        return identFrozenSearch(id_table->frozen, id_name);
     }
-    IdentTableNode* ptr = id_table->root;
+    uint32 mask = id_table->cap - 1;
+    uint32 i    = internHash(id_name) & mask;
+    uint8  dist = 1;
     for (;;) {
-        switch (identTableCmp(id_name, ptr->id->id_name)) {
-        case NODE_CMP_LT:
-            if (ptr->lchild != NULL) {
-                ptr = ptr->lchild;
-                break;
-            }
+        // the slot is empty or the entry in it is closer to its home slot,
+        // so the identifier can not be in the table.
+        if (id_table->dists[i] < dist) {
             return NULL;
-
-        case NODE_CMP_GT:
-            if (ptr->rchild != NULL) {
-                ptr = ptr->rchild;
-                break;
-            }
+        }
+        if (id_table->entries[i].id_name == id_name) {
+            return id_table->entries[i].id;
+        }
+        // no entry is placed farther than it.
+        if (dist == IDENT_TABLE_MAX_DIST) {
             return NULL;
-
-        case NODE_CMP_EQ:
-            return ptr->id;
         }
+        i = (i + 1) & mask;
+        dist++;
     }
 }
 
-static void identTableDestroyNode(IdentTableNode* node) {
-    if (node != NULL) {
-        if (node->lchild != NULL) identTableDestroyNode(node->lchild);
-        if (node->rchild != NULL) identTableDestroyNode(node->rchild);
-        switch (node->id->id_type) {
-        case ID_TYPE:
-            if (node->id->id.type->primitive == false) {
-                Member* temp;
-                Member* ptr = node->id->id.type->type.members;
-                for (;;) {
-                    if (ptr == NULL) {
-                        break;
-                    }
-                    temp = ptr;
-                    ptr  = ptr->next;
-                    mem_free(temp);
-                }
-            }
-            break;
+static void identTableDestroyIdent(Ident* id) {
+    switch (id->id_type) {
+    case ID_TYPE_DATATYPE:
+        if (id->id.id_datatype != NULL && id->id.id_datatype->id_table != NULL) {
+            identTableDestroy(id->id.id_datatype->id_table);
+        }
+        break;
 
-        case ID_FUNCTION: {
-                Parameter* del = NULL;
-                Parameter* ptr = node->id->id.function->params_passin;
-                while (ptr != NULL) {
-                    del = ptr;
-                    ptr = ptr->next;
-                    mem_free(del);
-                }
-                for (ptr = node->id->id.function->params_retout; ptr != NULL;) {
-                    del = ptr;
-                    ptr = ptr->next;
-                    mem_free(del);
-                }
-            }
-            break;
+    case ID_TYPE_MODULE:
+        if (id->id.id_module != NULL && id->id.id_module->id_table != NULL) {
+            identTableDestroy(id->id.id_module->id_table);
+        }
+        break;
+    }
+    identFree(id);
+}
 
-        case ID_EXPANDER: {
-                Parameter* del = NULL;
-                Parameter* ptr = node->id->id.expander->params_passin;
-                while (ptr != NULL) {
-                    del = ptr;
-                    ptr = ptr->next;
-                    mem_free(del);
-                }
+// iterate all identifiers in the table. the iter must be 0 at first, and
+// NULL is returned at the end.
+//
+// example:
+//    uint32 iter = 0;
+//    while ((id = identTableNext(id_table, &iter)) != NULL) {...}
+//
+Ident* identTableNext(IdentTable* id_table, uint32* iter) {
+    Ident* id;
+    if (id_table->frozen != NULL) {
+        while (*iter < id_table->frozen->count) {
+            if ((id = identFrozenGet(id_table->frozen, (*iter)++)) != NULL) {
+                return id;
             }
-            break;
-
-        case ID_INCLUDE:
-            identTableDestroy(node->id->id.include->id_table);
-            break;
-
-        case ID_MODULE:
-            identTableDestroy(node->id->id.module->id_table);
-            break;
         }
-        mem_free(node->id);
-        mem_free(node);
+        return NULL;
+    }
+    while (*iter < id_table->cap) {
+        if (id_table->dists[(*iter)++] != 0) {
+            return id_table->entries[*iter - 1].id;
+        }
     }
+    return NULL;
 }
 
 void identTableDestroy(IdentTable* id_table) {
-    identTableDestroyNode(id_table->root);
+    uint32 i;
+    if (id_table->frozen != NULL) {
+        identFrozenDestroy(id_table->frozen);
+    }
+    for (i = 0; i < id_table->cap; i++) {
+        if (id_table->dists[i] != 0) {
+            identTableDestroyIdent(id_table->entries[i].id);
+        }
+    }
+    mem_free(id_table->entries);
+    mem_free(id_table->dists);
+    identTableInit(id_table);
 }
@@ -3,14 +3,17 @@
  * Use of this source code is governed by a BSD-style
  * license that can be found in the LICENSE file.
  *
- *     This this implements a red-black tree to storage the
+ *     This file implements a hash table to storage the
  * information of nameable objects.
  **/
 
 #ifndef CPLUS_IDENT_H
 #define CPLUS_IDENT_H
 
+#include <pthread.h>
+#include <sys/mman.h>
 #include "common.h"
+#include "intern.h"
 
 typedef struct Ident           Ident;
 typedef struct IdentUnresolved IdentUnresolved;
@@ -20,7 +23,6 @@ typedef struct IdentArray      IdentArray;
 typedef struct IdentFunction   IdentFunction;
 typedef struct IdentExpander   IdentExpander;
 typedef struct IdentModule     IdentModule;
-typedef struct IdentTableNode  IdentTableNode;
 typedef struct IdentTable      IdentTable;
 
 #define ID_TYPE_UNRESOLVED 0
@@ -34,6 +36,9 @@ typedef struct IdentTable      IdentTable;
 // Ident can represent any identifier in Cplus. the member id will be used based on
 // the value of the id_type.
 //
+// the id_name must be interned by internStr()(see intern.h), because the identifiers
+// are compared by their names' pointers.
+//
 // for example, if the id_type is ID_TYPE_VARIABLE, then the actual effective pointer
 // of id is id.id_variable.
 //
@@ -52,7 +57,7 @@ struct Ident {
 };
 
 // IdentUnresolved represents an identifier can not resolved immediately but can be
-// resolved later.
+// resolved later. both the mod_name and the id_name are interned.
 //
 struct IdentUnresolved {  
     char* mod_name;
@@ -101,31 +106,78 @@ struct IdentModule {
     IdentTable* id_table;
 };
 
-#define NODE_COLOR_RED   0x00
-#define NODE_COLOR_BLACK 0x01
-
-#define NODE_CMP_LT      0x00
-#define NODE_CMP_EQ      0x01
-#define NODE_CMP_GT      0x02
-
-struct IdentTableNode {
-    Ident*          id;
-    int8            color;
-    IdentTableNode* parent;
-    IdentTableNode* lchild;
-    IdentTableNode* rchild;
-};
-
 // the IdentTable is used to storage a set of information about nameable objects in
 // Cplus language.
 //
+// it is an open addressing hash table with the Robin Hood hashing. the identifiers
+// are keyed by their interned names, so the hash values are read from the headers
+// of the names(see intern.h) and the names are compared by their pointers.
+//
+// the entries and their probe distances are saved in two flat arrays:
+//    dists[i] == 0 means the slot i is empty.
+//    dists[i] == n means the entry in the slot i is n-1 slots away from the slot
+//                  its hash value points to.
+// an entry which is closer to its home slot gives way to the one which is farther,
+// so a search can stop as soon as it meets an entry closer than itself.
+//
+// a table can also be frozen, then it is a read-only view of the records
+// saved by the other process(see iface.h) and the entries are not used.
+//
+typedef struct IdentTableEntry {
+    char*  id_name;
+    Ident* id;
+}IdentTableEntry;
+
+// the records of a frozen table are sorted by their hash values and then
+// by their names, and they are searched by the binary search. the names
+// are saved in a string table outside the records, so the records have
+// the same size.
+//
+typedef struct IdentFrozenRecord {
+    uint32 hash;     // the hash value of the name, the same as internHash()
+    uint32 name_off; // the offset of the name in the string table
+    uint32 name_len;
+    uint8  id_type;
+    uint8  pad[3];
+}IdentFrozenRecord;
+
+// the records are used where they are, usually in a mapped file, and an
+// Ident is made only when its record is found. so a table costs nothing
+// but the pages of the records touched and the ready flags.
+//
+typedef struct IdentFrozen {
+    const IdentFrozenRecord* records;
+    uint32                   count;
+    const char*              strtab;
+    uint32                   strtab_size;
+    void*                    map;      // unmapped with the table if it is not NULL
+    int64                    map_size;
+    Ident*                   idents;   // idents[i] is made from records[i] when ready[i] is 1
+    uint8*                   ready;
+    pthread_mutex_t          lock;     // guards making the idents
+}IdentFrozen;
+
 struct IdentTable {
-    IdentTableNode* root;
+    IdentTableEntry* entries;
+    uint8*           dists;
+    uint32           cap;    // always zero or a power of two
+    uint32           count;
+    IdentFrozen*     frozen; // not NULL if the table is frozen
 };
 
-extern void   identTableInit   (IdentTable* id_table);
-extern error  identTableAdd    (IdentTable* id_table, Ident* id);
-extern Ident* identTableSearch (IdentTable* id_table, char*  id_name);
-extern void   identTableDestroy(IdentTable* id_table);
+// the identifiers are taken from the pool of the small objects(see the
+// mem_alloc_sized in common.h), so an Ident must be created by the
+// identNew and released by the identFree, or by the identTableDestroy
+// if it is added to a table.
+extern Ident* identNew            (char* id_name, int8 id_type);
+extern void   identFree           (Ident* id);
+
+extern void   identTableInit      (IdentTable* id_table);
+extern error  identTableInitFrozen(IdentTable* id_table, const IdentFrozenRecord* records, uint32 count,
+                                   const char* strtab, uint32 strtab_size, void* map, int64 map_size);
+extern error  identTableAdd       (IdentTable* id_table, Ident* id);
+extern Ident* identTableSearch    (IdentTable* id_table, char*  id_name);
+extern Ident* identTableNext      (IdentTable* id_table, uint32* iter);
+extern void   identTableDestroy   (IdentTable* id_table);
 
 #endif
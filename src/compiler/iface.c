@@ -0,0 +1,350 @@
+/**
+ * Copyright 2015 JiKai. All rights reserved.
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file.
+ **/
+
+#include "iface.h"
+
+#define IFACE_READ_SIZE  65536
+#define IFACE_HASH_BASIS 14695981039346656037ull
+
+// the 64 bits FNV-1a hash function. the hash is continued from the
+// value passed in, so the data can be hashed piece by piece.
+static uint64 ifaceHash(uint64 hash, const void* data, int64 len) {
+    const uint8* ptr = (const uint8*)data;
+    int64        i;
+    for (i = 0; i < len; i++) {
+        hash ^= ptr[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// the hash covers the version of the compiler, the format of the file, and
+// the names, the content hashes and the sizes of all source files of the
+// module. the bytes is set to the total size of the source files.
+//
+// a source file is not read again if it has the same modified time and size
+// as the hash of its content recorded in the SourceFile(see buildstate.h),
+// and the SourceFile is updated after hashing.
+//
+error ifaceHashSources(Module* mod, uint64* hash, int64* bytes) {
+    SourceFile* src;
+    struct stat st;
+    char*       file;
+    char*       buff   = NULL;
+    uint64      h      = IFACE_HASH_BASIS;
+    uint64      content;
+    uint32      format = IFACE_FORMAT;
+    int64       mtime;
+    int64       size;
+    int64       n;
+    int         fd;
+    error       err    = NULL;
+
+    h = ifaceHash(h, CPLUS_VERSION, strlen(CPLUS_VERSION));
+    h = ifaceHash(h, &format, sizeof(format));
+    *bytes = 0;
+    moduleRewind(mod);
+    while (err == NULL && (src = mod->iterator) != NULL && (file = moduleGetNextSrcFile(mod)) != NULL) {
+        // the file stated when its directory was listed is not stated again.
+        if (src->scan_mtime >= 0) {
+            mtime = src->scan_mtime;
+            size  = src->scan_size;
+        }
+        else if (stat(file, &st) == 0) {
+            mtime = (int64)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+            size  = st.st_size;
+        }
+        else {
+            err = new_error("can not open the source file.");
+            mem_free(file);
+            break;
+        }
+        if (src->hash == 0 || src->mtime != mtime || src->size != size) {
+            if (buff == NULL) {
+                buff = (char*)mem_alloc(IFACE_READ_SIZE);
+            }
+            if ((fd = open(file, O_RDONLY)) < 0) {
+                err = new_error("can not open the source file.");
+            }
+            else {
+                content = IFACE_HASH_BASIS;
+                size    = 0;
+                while ((n = read(fd, buff, IFACE_READ_SIZE)) > 0) {
+                    content = ifaceHash(content, buff, n);
+                    size   += n;
+                }
+                if (n < 0) {
+                    err = new_error("can not read the source file.");
+                }
+                close(fd);
+                src->mtime = mtime;
+                src->size  = size;
+                src->hash  = content;
+            }
+        }
+        // the name is hashed with its terminator and the content with its
+        // size, so moving bytes between the files changes the hash.
+        h = ifaceHash(h, src->file_name, src->file_name_len + 1);
+        h = ifaceHash(h, &src->hash, sizeof(src->hash));
+        h = ifaceHash(h, &src->size, sizeof(src->size));
+        *bytes += src->size;
+        mem_free(file);
+    }
+    moduleRewind(mod);
+    mem_free(buff);
+    *hash = h;
+    return err;
+}
+
+// example:
+//    the module "/home/user/project/src/net.mod" will return
+//    "/home/user/project/src/net.mod/.cplusif".
+static char* ifacePath(Module* mod, char* suffix) {
+    char*          path;
+    DynamicArrStr  dstr;
+    dynamicArrStrInit   (&dstr, DYNAMIC_ARR_STR_SMALL);
+    dynamicArrStrAppend (&dstr, mod->mod_path, mod->mod_path_len);
+    dynamicArrStrAppendc(&dstr, '/');
+    dynamicArrStrAppend (&dstr, IFACE_FILE_NAME, strlen(IFACE_FILE_NAME));
+    if (suffix != NULL) {
+        dynamicArrStrAppend(&dstr, suffix, strlen(suffix));
+    }
+    path = dynamicArrStrDetach(&dstr);
+    return path;
+}
+
+typedef struct IfaceHeader {
+    uint32 magic;
+    uint32 format;
+    uint64 hash;
+    uint64 iface_hash;
+    uint32 dep_count;
+    uint32 export_count;
+    uint32 strtab_size;
+    uint32 reserved;
+}IfaceHeader;
+
+/****** loading ******/
+
+// check the sizes in the header against the size of the file, so all parts
+// of the file are in the mapping. the records themselves are checked when
+// they are touched.
+static error ifaceCheckHeader(IfaceHeader* header, int64 size, uint64 hash) {
+    if (header->magic != IFACE_MAGIC || header->format != IFACE_FORMAT) {
+        return new_error("the interface file is broken.");
+    }
+    if (header->hash != hash) {
+        return new_error("the interface file is out of date.");
+    }
+    // the counts are uint32, so the sum can not overflow the uint64, and the
+    // size is converted only after it is known to be non-negative.
+    if (size < 0 || sizeof(IfaceHeader) +
+        (uint64)header->dep_count    * sizeof(uint32) * 2 +
+        (uint64)header->export_count * sizeof(IdentFrozenRecord) +
+        (uint64)header->strtab_size != (uint64)size) {
+        return new_error("the interface file is broken.");
+    }
+    return NULL;
+}
+
+// map the interface file of the module. the included modules are added to
+// the module, and the export table of the module becomes a frozen view of
+// the records in the mapping, which is unmapped with the table. it fails if
+// the file is saved for other sources, and the module is left untouched then.
+//
+error ifaceLoad(Module* mod, uint64 hash) {
+    struct stat              st;
+    IfaceHeader*             header;
+    const uint32*            deps;
+    const IdentFrozenRecord* records;
+    const char*              strtab;
+    void*                    map;
+    int                      fd;
+    uint32                   i;
+    error                    err  = NULL;
+    char*                    path = ifacePath(mod, NULL);
+
+    fd = open(path, O_RDONLY);
+    mem_free(path);
+    if (fd < 0) {
+        return new_error("the interface file does not exist.");
+    }
+    if (fstat(fd, &st) != 0 || st.st_size < (int64)sizeof(IfaceHeader)) {
+        close(fd);
+        return new_error("the interface file is broken.");
+    }
+    // the mapping keeps the file after it is closed.
+    map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return new_error("can not map the interface file.");
+    }
+    header = (IfaceHeader*)map;
+    if ((err = ifaceCheckHeader(header, st.st_size, hash)) != NULL) {
+        munmap(map, st.st_size);
+        return err;
+    }
+    deps    = (const uint32*)(header + 1);
+    records = (const IdentFrozenRecord*)(deps + header->dep_count * 2);
+    strtab  = (const char*)(records + header->export_count);
+    for (i = 0; i < header->dep_count; i++) {
+        if (deps[i*2] > header->strtab_size || deps[i*2+1] > header->strtab_size - deps[i*2]) {
+            err = new_error("the interface file is broken.");
+            break;
+        }
+        moduleAddDep(mod, internStr((char*)strtab + deps[i*2], deps[i*2+1]));
+    }
+    if (err == NULL) {
+        err = identTableInitFrozen(mod->id_table, records, header->export_count, strtab, header->strtab_size, map, st.st_size);
+    }
+    if (err == NULL) {
+        mod->iface_hash = header->iface_hash;
+    }
+    if (err != NULL) {
+        mod->dep_count = 0;
+        munmap(map, st.st_size);
+    }
+    return err;
+}
+
+/****** saving ******/
+
+typedef struct IfaceExport {
+    IdentFrozenRecord record;
+    char*             name;
+}IfaceExport;
+
+// the same order as identFrozenSearch() expects.
+static int ifaceExportCmp(const void* a, const void* b) {
+    const IfaceExport* export1 = (const IfaceExport*)a;
+    const IfaceExport* export2 = (const IfaceExport*)b;
+    if (export1->record.hash != export2->record.hash) {
+        return export1->record.hash < export2->record.hash ? -1 : 1;
+    }
+    return strcmp(export1->name, export2->name);
+}
+
+// return the exports of the module in the order of the records, the offsets
+// of the names are not set. the result should be released by mem_free().
+static IfaceExport* ifaceCollectExports(Module* mod, uint32* count) {
+    IfaceExport* exports = (IfaceExport*)mem_alloc(sizeof(IfaceExport) * (mod->id_table->count + 1));
+    Ident*       id;
+    uint32       iter    = 0;
+    *count = 0;
+    while ((id = identTableNext(mod->id_table, &iter)) != NULL) {
+        memset(&exports[*count].record, 0, sizeof(IdentFrozenRecord));
+        exports[*count].record.hash     = internHash(id->id_name);
+        exports[*count].record.name_len = internLen(id->id_name);
+        exports[*count].record.id_type  = id->id_type;
+        exports[*count].name            = id->id_name;
+        (*count)++;
+    }
+    qsort(exports, *count, sizeof(IfaceExport), ifaceExportCmp);
+    return exports;
+}
+
+// the interface hash only covers the exports, the modules included by the
+// module are not seen by the modules including it. so the changes in the
+// bodies of the functions do not change it.
+//
+uint64 ifaceHashExports(Module* mod) {
+    uint32       count;
+    uint32       i;
+    uint64       h       = IFACE_HASH_BASIS;
+    IfaceExport* exports = ifaceCollectExports(mod, &count);
+    for (i = 0; i < count; i++) {
+        h = ifaceHash(h, exports[i].name, exports[i].record.name_len + 1);
+        h = ifaceHash(h, &exports[i].record.id_type, sizeof(exports[i].record.id_type));
+    }
+    mem_free(exports);
+    return h;
+}
+
+// save the included modules and the export table of the module with the
+// mod->iface_hash, which must be set by ifaceHashExports() before. the
+// modules are saved by the different threads, but every module has its
+// own file, and the temporary file is named with the process id so the
+// other compilers do not write the same one.
+//
+error ifaceSave(Module* mod, uint64 hash) {
+    IfaceHeader  header;
+    IfaceExport* exports;
+    uint32       dep_count;
+    uint32*      deps;
+    uint32       count;
+    uint32       off     = 0;
+    uint32       i;
+    char         suffix[32];
+    char*        tmp;
+    char*        path;
+    FILE*        file;
+    error        err     = NULL;
+
+    if (mod->dep_count < 0) {
+        return new_error("the included modules of the module are broken.");
+    }
+    dep_count = (uint32)mod->dep_count;
+    deps      = (uint32*)mem_alloc(sizeof(uint32) * 2 * (dep_count + 1));
+
+    // the names of the included modules come first in the string table,
+    // then the names of the exports in the order of their records.
+    for (i = 0; i < dep_count; i++) {
+        deps[i*2]   = off;
+        deps[i*2+1] = internLen(mod->deps[i]);
+        off += deps[i*2+1];
+    }
+    exports = ifaceCollectExports(mod, &count);
+    for (i = 0; i < count; i++) {
+        exports[i].record.name_off = off;
+        off += exports[i].record.name_len;
+    }
+
+    memset(&header, 0, sizeof(header));
+    header.magic        = IFACE_MAGIC;
+    header.format       = IFACE_FORMAT;
+    header.hash         = hash;
+    header.iface_hash   = mod->iface_hash;
+    header.dep_count    = dep_count;
+    header.export_count = count;
+    header.strtab_size  = off;
+
+    sprintf(suffix, ".%d.tmp", (int)getpid());
+    tmp = ifacePath(mod, suffix);
+    if ((file = fopen(tmp, "wb")) == NULL) {
+        err = new_error("can not create the interface file.");
+    }
+    else {
+        fwrite(&header, sizeof(header), 1, file);
+        fwrite(deps, sizeof(uint32) * 2, dep_count, file);
+        for (i = 0; i < count; i++) {
+            fwrite(&exports[i].record, sizeof(IdentFrozenRecord), 1, file);
+        }
+        for (i = 0; i < dep_count; i++) {
+            fwrite(mod->deps[i], 1, internLen(mod->deps[i]), file);
+        }
+        for (i = 0; i < count; i++) {
+            fwrite(exports[i].name, 1, exports[i].record.name_len, file);
+        }
+        if (ferror(file) != 0) {
+            err = new_error("can not write the interface file.");
+        }
+        if (fclose(file) != 0 && err == NULL) {
+            err = new_error("can not write the interface file.");
+        }
+        path = ifacePath(mod, NULL);
+        if (err == NULL && rename(tmp, path) != 0) {
+            err = new_error("can not write the interface file.");
+        }
+        if (err != NULL) {
+            unlink(tmp);
+        }
+        mem_free(path);
+    }
+    mem_free(tmp);
+    mem_free(exports);
+    mem_free(deps);
+    return err;
+}
@@ -0,0 +1,53 @@
+/**
+ * Copyright 2015 JiKai. All rights reserved.
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file.
+ *
+ *     The iface.h and iface.c implement the interface files
+ * of the modules. an interface file saves what the parse stage
+ * gets from a module, so the module can skip the lexer in the
+ * next build if its source files are not changed.
+ **/
+
+#ifndef CPLUS_IFACE_H
+#define CPLUS_IFACE_H
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include "common.h"
+#include "module.h"
+
+// every module directory has an interface file named IFACE_FILE_NAME. the
+// file is in the native byte order, and all parts of it are aligned to 4
+// bytes:
+//
+//   header:  magic        uint32  IFACE_MAGIC
+//            format       uint32  IFACE_FORMAT
+//            hash         uint64  the hash of the source files, see ifaceHashSources()
+//            iface_hash   uint64  the hash of the exports, see ifaceHashExports()
+//            dep_count    uint32
+//            export_count uint32
+//            strtab_size  uint32
+//            reserved     uint32
+//   deps:    dep_count records of {name_off uint32, name_len uint32}
+//   exports: export_count IdentFrozenRecords(see ident.h), sorted
+//   strtab:  strtab_size bytes, all names without the terminators
+//
+// the file is mapped and the export table is a frozen view of the records in
+// it, so loading a module does not depend on the number of its exports.
+//
+// the file is written to a temporary file and renamed, so a reader never
+// sees a half written file.
+//
+#define IFACE_FILE_NAME ".cplusif"
+#define IFACE_MAGIC     0x46495043 // "CPIF"
+#define IFACE_FORMAT    3
+
+extern error  ifaceHashSources(Module* mod, uint64* hash, int64* bytes);
+extern uint64 ifaceHashExports(Module* mod);
+extern error  ifaceLoad       (Module* mod, uint64 hash);
+extern error  ifaceSave       (Module* mod, uint64 hash);
+
+#endif
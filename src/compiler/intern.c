@@ -0,0 +1,136 @@
+/**
+ * Copyright 2015 JiKai. All rights reserved.
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file.
+ **/
+
+#include "intern.h"
+
+// the interned strings are allocated from a set of chunks. a chunk is
+// never moved, so the interned strings are stable.
+#define INTERN_CHUNK_SIZE 65536
+
+typedef struct InternChunk {
+    struct InternChunk* next;
+    int64               used;
+    int64               cap;
+    char                data[];
+}InternChunk;
+
+// the hash table is an array of the interned strings with the linear
+// probing. its capacity is always a power of two.
+typedef struct {
+    char**       slots;
+    uint32       cap;
+    uint32       count;
+    InternChunk* chunks;
+    pthread_mutex_t lock;
+}Interner;
+
+static Interner interner = {NULL, 0, 0, NULL, PTHREAD_MUTEX_INITIALIZER};
+
+// the FNV-1a hash function.
+static uint32 internHashStr(const char* str, int64 len) {
+    uint32 hash = 2166136261u;
+    int64  i;
+    for (i = 0; i < len; i++) {
+        hash ^= (uint8)str[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static char* internAllocStr(const char* str, int64 len, uint32 hash) {
+    int64 need = sizeof(InternHeader) + len + 1;
+    // keep the headers aligned.
+    need = (need + 7) & ~(int64)7;
+    if (interner.chunks == NULL || interner.chunks->used + need > interner.chunks->cap) {
+        int64 cap = need > INTERN_CHUNK_SIZE ? need : INTERN_CHUNK_SIZE;
+        InternChunk* chunk = (InternChunk*)mem_alloc(sizeof(InternChunk) + cap);
+        chunk->next = interner.chunks;
+        chunk->used = 0;
+        chunk->cap  = cap;
+        interner.chunks = chunk;
+    }
+    InternHeader* header = (InternHeader*)(interner.chunks->data + interner.chunks->used);
+    interner.chunks->used += need;
+    header->id   = interner.count + 1;
+    header->hash = hash;
+    header->len  = len;
+    char* interned = (char*)(header + 1);
+    memcpy(interned, str, len);
+    interned[len] = '\0';
+    return interned;
+}
+
+static void internGrow() {
+    uint32 cap   = interner.cap == 0 ? 1024 : interner.cap * 2;
+    char** slots = (char**)mem_alloc(sizeof(char*) * cap);
+    uint32 i;
+    memset(slots, 0, sizeof(char*) * cap);
+    for (i = 0; i < interner.cap; i++) {
+        char* str = interner.slots[i];
+        if (str != NULL) {
+            uint32 j = internHash(str) & (cap - 1);
+            while (slots[j] != NULL) {
+                j = (j + 1) & (cap - 1);
+            }
+            slots[j] = str;
+        }
+    }
+    mem_free(interner.slots);
+    interner.slots = slots;
+    interner.cap   = cap;
+}
+
+// return the interned string which has the same content as the str. the
+// str need not be terminated by '\0', so a span of the source code can be
+// interned directly.
+char* internStr(const char* str, int64 len) {
+    uint32 hash = internHashStr(str, len);
+    pthread_mutex_lock(&interner.lock);
+    // keep the load factor under 0.75.
+    if ((interner.count + 1) * 4 > interner.cap * 3) {
+        internGrow();
+    }
+    uint32 mask = interner.cap - 1;
+    uint32 i    = hash & mask;
+    for (;;) {
+        char* slot = interner.slots[i];
+        if (slot == NULL) {
+            break;
+        }
+        if (internHash(slot) == hash && internLen(slot) == len && memcmp(slot, str, len) == 0) {
+            pthread_mutex_unlock(&interner.lock);
+            return slot;
+        }
+        i = (i + 1) & mask;
+    }
+    char* interned = internAllocStr(str, len, hash);
+    interner.slots[i] = interned;
+    interner.count++;
+    pthread_mutex_unlock(&interner.lock);
+    return interned;
+}
+
+char* internCStr(const char* str) {
+    return internStr(str, strlen(str));
+}
+
+// return the number of the distinct strings interned.
+uint32 internCount() {
+    return interner.count;
+}
+
+void internDestroy() {
+    InternChunk* del;
+    while (interner.chunks != NULL) {
+        del = interner.chunks;
+        interner.chunks = interner.chunks->next;
+        mem_free(del);
+    }
+    mem_free(interner.slots);
+    interner.slots = NULL;
+    interner.cap   = 0;
+    interner.count = 0;
+}
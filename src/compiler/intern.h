@@ -0,0 +1,47 @@
+/**
+ * Copyright 2015 JiKai. All rights reserved.
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file.
+ *
+ *     The intern.h and intern.c implement the string
+ * interning. every distinct identifier text is stored only
+ * once, so two interned names are equal if and only if
+ * their pointers are equal.
+ **/
+
+#ifndef CPLUS_INTERN_H
+#define CPLUS_INTERN_H
+
+#include <pthread.h>
+#include "common.h"
+
+// the interning is shared by all threads compiling the modules, so the
+// internStr() is guarded by a mutex. reading the header of an interned
+// string needs no lock since the string is never changed after interned.
+//
+// the interned strings are terminated by '\0' and are valid until the
+// internDestroy() is called. there are some information saved before
+// every interned string, so the length, the hash value and the id of
+// the string can be got without any computing:
+//
+//    | id(4 bytes) | hash(4 bytes) | len(4 bytes) | s | t | r | \0 |
+//                                                 ^
+//                                           interned string
+//
+typedef struct InternHeader {
+    uint32 id;   // the sequence number of the string(start from 1)
+    uint32 hash; // the hash value of the string
+    uint32 len;  // the length of the string(without '\0')
+}InternHeader;
+
+#define internHeader(str) ((InternHeader*)((char*)(str) - sizeof(InternHeader)))
+#define internId(str)     (internHeader(str)->id)
+#define internHash(str)   (internHeader(str)->hash)
+#define internLen(str)    (internHeader(str)->len)
+
+extern char*  internStr    (const char* str, int64 len);
+extern char*  internCStr   (const char* str);
+extern uint32 internCount  ();
+extern void   internDestroy();
+
+#endif
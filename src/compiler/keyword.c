@@ -0,0 +1,102 @@
+/**
+ * Copyright 2015 JiKai. All rights reserved.
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file.
+ *
+ *     This file is generated by tool/kwgen.c from the
+ * lexer.h. DO NOT EDIT IT, run "make keyword.c" instead.
+ **/
+
+#include "keyword.h"
+
+#define KEYWORD_MIN_LEN 2
+#define KEYWORD_MAX_LEN 11
+#define KEYWORD_MASK    63
+
+typedef struct {
+    const char* word;
+    int8        len;
+    int16       token_code;
+}KeywordEntry;
+
+static const KeywordEntry keyword_table[64] = {
+    {"uint32", 6, TOKEN_TYPE_UINT32},
+    {NULL, 0, TOKEN_ID},
+    {"byte", 4, TOKEN_TYPE_BYTE},
+    {"float64", 7, TOKEN_TYPE_FLOAT64},
+    {NULL, 0, TOKEN_ID},
+    {"int8", 4, TOKEN_TYPE_INT8},
+    {"default", 7, TOKEN_KEYWORD_DEFAULT},
+    {NULL, 0, TOKEN_ID},
+    {NULL, 0, TOKEN_ID},
+    {NULL, 0, TOKEN_ID},
+    {NULL, 0, TOKEN_ID},
+    {NULL, 0, TOKEN_ID},
+    {NULL, 0, TOKEN_ID},
+    {"ef", 2, TOKEN_KEYWORD_EF},
+    {"int16", 5, TOKEN_TYPE_INT16},
+    {NULL, 0, TOKEN_ID},
+    {NULL, 0, TOKEN_ID},
+    {"deal", 4, TOKEN_KEYWORD_DEAL},
+    {NULL, 0, TOKEN_ID},
+    {"complex64", 9, TOKEN_TYPE_COMPLEX64},
+    {"func", 4, TOKEN_KEYWORD_FUNC},
+    {NULL, 0, TOKEN_ID},
+    {"uint64", 6, TOKEN_TYPE_UINT64},
+    {"const", 5, TOKEN_KEYWORD_CONST},
+    {"uint", 4, TOKEN_TYPE_UINT},
+    {"new", 3, TOKEN_KEYWORD_NEW},
+    {NULL, 0, TOKEN_ID},
+    {"char", 4, TOKEN_TYPE_CHAR},
+    {"break", 5, TOKEN_KEYWORD_BREAK},
+    {NULL, 0, TOKEN_ID},
+    {"complex128", 10, TOKEN_TYPE_COMPLEX128},
+    {"return", 6, TOKEN_KEYWORD_RETURN},
+    {NULL, 0, TOKEN_ID},
+    {NULL, 0, TOKEN_ID},
+    {"int32", 5, TOKEN_TYPE_INT32},
+    {"uint8", 5, TOKEN_TYPE_UINT8},
+    {NULL, 0, TOKEN_ID},
+    {"case", 4, TOKEN_KEYWORD_CASE},
+    {"else", 4, TOKEN_KEYWORD_ELSE},
+    {NULL, 0, TOKEN_ID},
+    {"type", 4, TOKEN_KEYWORD_TYPE},
+    {NULL, 0, TOKEN_ID},
+    {"switch", 6, TOKEN_KEYWORD_SWITCH},
+    {NULL, 0, TOKEN_ID},
+    {"uint16", 6, TOKEN_TYPE_UINT16},
+    {"float32", 7, TOKEN_TYPE_FLOAT32},
+    {NULL, 0, TOKEN_ID},
+    {"continue", 8, TOKEN_KEYWORD_CONTINUE},
+    {"fallthrough", 11, TOKEN_KEYWORD_FTHROUGH},
+    {"include", 7, TOKEN_KEYWORD_INCLUDE},
+    {NULL, 0, TOKEN_ID},
+    {NULL, 0, TOKEN_ID},
+    {"for", 3, TOKEN_KEYWORD_FOR},
+    {"expn", 4, TOKEN_KEYWORD_EXPN},
+    {NULL, 0, TOKEN_ID},
+    {NULL, 0, TOKEN_ID},
+    {"int64", 5, TOKEN_TYPE_INT64},
+    {"if", 2, TOKEN_KEYWORD_IF},
+    {"error", 5, TOKEN_KEYWORD_ERROR},
+    {NULL, 0, TOKEN_ID},
+    {"string", 6, TOKEN_TYPE_STRING},
+    {NULL, 0, TOKEN_ID},
+    {NULL, 0, TOKEN_ID},
+    {"module", 6, TOKEN_KEYWORD_MODULE},
+};
+
+// return the TOKEN_KEYWORD_XXX or TOKEN_TYPE_XXX of the word, or TOKEN_ID
+// if the word is not a keyword. the hash is perfect, so only one entry
+// needs to be compared.
+int16 keywordLookup(const char* word, int64 len) {
+    if (len < KEYWORD_MIN_LEN || len > KEYWORD_MAX_LEN) {
+        return TOKEN_ID;
+    }
+    uint32 h = ((uint8)word[0]*59u + (uint8)word[len-1]*43u + (uint32)len*31u + (uint8)word[1]) & KEYWORD_MASK;
+    const KeywordEntry* entry = &keyword_table[h];
+    if (entry->len == len && memcmp(entry->word, word, len) == 0) {
+        return entry->token_code;
+    }
+    return TOKEN_ID;
+}
@@ -0,0 +1,21 @@
+/**
+ * Copyright 2015 JiKai. All rights reserved.
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file.
+ *
+ *     The keyword.h declares the lookup of keywords and
+ * primitive types. the keyword.c is generated from the
+ * lexer.h by tool/kwgen.c, so the lookup table will never
+ * drift out of sync with the TOKEN_KEYWORD_XXX and the
+ * TOKEN_TYPE_XXX definitions.
+ **/
+
+#ifndef CPLUS_KEYWORD_H
+#define CPLUS_KEYWORD_H
+
+#include "common.h"
+#include "lexer.h"
+
+extern int16 keywordLookup(const char* word, int64 len);
+
+#endif
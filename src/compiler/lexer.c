@@ -4,9 +4,24 @@
  * license that can be found in the LICENSE file.
  **/
 
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "lexer.h"
+#include "keyword.h"
+#include "scan.h"
 
-static error err = NULL;
+// the modules are lexed by several threads at the same time(see workpool.h),
+// so every thread has its own err.
+static __thread error err = NULL;
+
+// move the index of the mapped source to the pointer p returned by the
+// scanners. only the column is updated here, the line-feeds are counted
+// by the callers the same as the byte-by-byte path.
+#define lexerJumpTo(lexer, p)                        \
+lexer->pos_col += (p) - (lexer->src + lexer->i);     \
+lexer->i        = (p) - lexer->src;
 
 // you should always use this micro definition to increase the
 // buffer's current index of the lexer.
@@ -23,32 +38,89 @@ if (lexer->i >= lexer->buff_end_index) { \
 /****** methods of LexToken ******/
 
 error lexTokenInit(LexToken* lextkn, int64 capacity) {
-    if ((err = dynamicArrCharInit(&lextkn->token, capacity)) != NULL) {
+    if ((err = dynamicArrStrInit(&lextkn->token, capacity)) != NULL) {
         return err;
     }
-    lextkn->token_len  = 0;
-    lextkn->token_code = TOKEN_UNKNOWN;
+    lextkn->token_len    = 0;
+    lextkn->token_code   = TOKEN_UNKNOWN;
+    lextkn->span.offset  = 0;
+    lextkn->span.line    = 0;
+    lextkn->span.col     = 0;
+    lextkn->span_src     = NULL;
+    lextkn->token_intern = NULL;
     return NULL;
 }
 
+// let the empty token point to the source buffer. the content appended
+// later will only extend the span as long as it is the same as the
+// source code.
+void lexTokenBeginSpan(LexToken* lextkn, char* src, int64 offset) {
+    dynamicArrStrClear(&lextkn->token);
+    lextkn->token_len   = 0;
+    lextkn->span.offset = offset;
+    lextkn->span_src    = src;
+}
+
+// copy the content of the span to the dynamic array. it is called when
+// the content appended is different from the source code.
+static void lexTokenMaterialize(LexToken* lextkn) {
+    dynamicArrStrAppend(&lextkn->token, lextkn->span_src + lextkn->span.offset, lextkn->token_len);
+    lextkn->span_src = NULL;
+}
+
 void lexTokenAppend(LexToken* lextkn, char* str, int64 len) {
-    dynamicArrCharAppend(&lextkn->token, str, len);
+    if (lextkn->span_src != NULL) {
+        if (str == lextkn->span_src + lextkn->span.offset + lextkn->token_len) {
+            lextkn->token_len += len;
+            return;
+        }
+        lexTokenMaterialize(lextkn);
+    }
+    dynamicArrStrAppend(&lextkn->token, str, len);
     lextkn->token_len += len;
 }
 
 void lexTokenAppendc(LexToken* lextkn, char ch) {
-    dynamicArrCharAppendc(&lextkn->token, ch);
+    if (lextkn->span_src != NULL) {
+        if (lextkn->span_src[lextkn->span.offset + lextkn->token_len] == ch) {
+            lextkn->token_len++;
+            return;
+        }
+        lexTokenMaterialize(lextkn);
+    }
+    dynamicArrStrAppendc(&lextkn->token, ch);
     lextkn->token_len++;
 }
 
+// return the pointer to the token's content in the source buffer without
+// any copying. the content is not terminated by '\0', so always use it
+// with the token_len.
+//
+// return NULL if the content is materialized in the dynamic array, and
+// then the lexTokenGetStr should be used.
+char* lexTokenSpanPtr(LexToken* lextkn) {
+    if (lextkn->span_src == NULL) {
+        return NULL;
+    }
+    return lextkn->span_src + lextkn->span.offset;
+}
+
 char* lexTokenGetStr(LexToken* lextkn) {
-    return dynamicArrCharGetStr(&lextkn->token);
+    if (lextkn->span_src != NULL) {
+        char* str = (char*)mem_alloc(sizeof(char)*lextkn->token_len + 1);
+        memcpy(str, lextkn->span_src + lextkn->span.offset, lextkn->token_len);
+        str[lextkn->token_len] = '\0';
+        return str;
+    }
+    return dynamicArrStrGetStr(&lextkn->token);
 }
 
 void lexTokenClear(LexToken* lextkn) {
-    dynamicArrCharClear(&lextkn->token);
+    dynamicArrStrClear(&lextkn->token);
     lextkn->token_len  = 0;
-    lextkn->token_code = TOKEN_UNKNOWN;
+    lextkn->token_code   = TOKEN_UNKNOWN;
+    lextkn->span_src     = NULL;
+    lextkn->token_intern = NULL;
 }
 
 void lexTokenDebug(LexToken* lextkn) {
@@ -142,20 +214,26 @@ void lexTokenDebug(LexToken* lextkn) {
 }
 
 void lexTokenDestroy(LexToken* lextkn) {
-    dynamicArrCharDestroy(&lextkn->token);
+    dynamicArrStrDestroy(&lextkn->token);
 }
 
 /****** methods of Lexer ******/
 
 error lexerInit(Lexer* lexer) {
     lexer->srcfile        = NULL;
+    lexer->src            = lexer->buffer;
+    lexer->src_map_len    = 0;
+    lexer->mode           = LEX_MODE_STREAM;
     lexer->pos_file       = NULL;
     lexer->pos_line       = 1;
     lexer->pos_col        = 1;
     lexer->buff_end_index = 0;
     lexer->i              = 0;
     lexer->parse_lock     = false;
-    if ((err = lexTokenInit(&lexer->lextkn, 255)) != NULL) {
+    scanInit();
+    // the most tokens fit in the small buffer of the token's content, so a
+    // lexer allocates nothing for them.
+    if ((err = lexTokenInit(&lexer->lextkn, DYNAMIC_ARR_STR_SMALL)) != NULL) {
         return err;
     }
     int16 j;
@@ -165,22 +243,117 @@ error lexerInit(Lexer* lexer) {
     return NULL;
 }
 
+static error lexerNotFoundErr(char* file) {
+    DynamicArrStr dstr;
+    dynamicArrStrInit(&dstr, DYNAMIC_ARR_STR_SMALL);
+    dynamicArrStrAppend(&dstr, "not found the source file: ", 27);
+    dynamicArrStrAppend(&dstr, file, strlen(file));
+    char* errmsg = dynamicArrStrDetach(&dstr);
+    return new_error(errmsg);
+}
+
 error lexerOpenSrcFile(Lexer* lexer, char* file) {
     lexer->srcfile = fopen(file, "r");
     if (lexer->srcfile == NULL) {
-        DynamicArrChar darr;
-        dynamicArrCharInit(&darr, 255);
-        dynamicArrCharAppend(&darr, "not found the source file: ", 27);
-        dynamicArrCharAppend(&darr, file, strlen(file));
-        char* errmsg = dynamicArrCharGetStr(&darr);
-        dynamicArrCharDestroy(&darr);
-        return new_error(errmsg);
+        return lexerNotFoundErr(file);
     }
-    lexer->pos_file = file;
+    lexer->src            = lexer->buffer;
+    lexer->mode           = LEX_MODE_STREAM;
+    lexer->buff_end_index = 0;
+    lexer->i              = 0;
+    lexer->pos_file       = file;
     return NULL;
 }
 
+// the empty file is represented by this sentinel, so mapping a zero
+// length file is never needed.
+static char lexer_empty_src[1] = {'\0'};
+
+// map the whole source file into the memory. the mapping is one byte
+// longer than the file and the extra byte is always '\0':
+//   (1) reserve an anonymous zero-filled region covering len+1 bytes.
+//   (2) map the file over the beginning of the region.
+// the bytes after the end of file in the last file page are zero as
+// well, so the sentinel exists even if len+1 is not a page boundary.
+error lexerOpenSrcFileMapped(Lexer* lexer, char* file) {
+    int fd = open(file, O_RDONLY);
+    if (fd < 0) {
+        return lexerNotFoundErr(file);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return new_error("err: get the source file's details failed.");
+    }
+    int64 len = st.st_size;
+    if (len == 0) {
+        close(fd);
+        lexer->src         = lexer_empty_src;
+        lexer->src_map_len = 0;
+    }
+    else {
+        int64 page     = sysconf(_SC_PAGESIZE);
+        int64 map_len  = ((len + 1) + page - 1) / page * page;
+        char* region   = (char*)mmap(NULL, map_len, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (region == MAP_FAILED) {
+            close(fd);
+            return new_error("err: map the source file failed.");
+        }
+        if (mmap(region, len, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+            munmap(region, map_len);
+            close(fd);
+            return new_error("err: map the source file failed.");
+        }
+        close(fd);
+        madvise(region, len, MADV_SEQUENTIAL);
+        lexer->src         = region;
+        lexer->src_map_len = map_len;
+    }
+    lexer->srcfile        = NULL;
+    lexer->mode           = LEX_MODE_MAPPED;
+    lexer->buff_end_index = len;
+    lexer->i              = 0;
+    lexer->pos_file       = file;
+    return NULL;
+}
+
+// lex a span of the source code already in the memory, like a chunk of a
+// file mapped by another lexer. the span is not released by the lexer. the
+// byte after the span must be readable and must not continue any token of
+// the span, like the '\0' sentinel or the first byte of the next line.
+void lexerOpenSrcSpan(Lexer* lexer, char* file, char* src, int64 len, int32 line) {
+    lexer->srcfile        = NULL;
+    lexer->src            = src;
+    lexer->src_map_len    = 0;
+    lexer->mode           = LEX_MODE_MAPPED;
+    lexer->buff_end_index = len;
+    lexer->i              = 0;
+    lexer->pos_file       = file;
+    lexer->pos_line       = line;
+    lexer->pos_col        = 1;
+}
+
+// open the source file with the specific mode. it is convenient to
+// compare the throughput of the two modes.
+error lexerOpenSrcFileMode(Lexer* lexer, char* file, int8 mode) {
+    if (mode == LEX_MODE_MAPPED) {
+        return lexerOpenSrcFileMapped(lexer, file);
+    }
+    return lexerOpenSrcFile(lexer, file);
+}
+
 void lexerCloseSrcFile(Lexer* lexer) {
+    if (lexer->mode == LEX_MODE_MAPPED) {
+        if (lexer->src_map_len > 0) {
+            munmap(lexer->src, lexer->src_map_len);
+        }
+        lexer->src            = lexer->buffer;
+        lexer->src_map_len    = 0;
+        lexer->mode           = LEX_MODE_STREAM;
+        lexer->buff_end_index = 0;
+        lexer->i              = 0;
+        return;
+    }
     if (lexer->srcfile == NULL) {
         printf("err: no file opened.\n");
         exit(EXIT_FAILURE);
@@ -194,7 +367,13 @@ void lexerCloseSrcFile(Lexer* lexer) {
 // now in the lexer->buffer are all processed completely. and now the lexical
 // analyzer can read next LEX_BUFF_SIZE bytes source codes from the source
 // file.
+//
+// in mapped mode the whole file is already in the memory, so reaching the
+// end of the span means reaching the end of file.
 static error lexerReadFile(Lexer* lexer) {
+    if (lexer->mode == LEX_MODE_MAPPED) {
+        return NEW_ERROR_CODE(LEX_ERROR_EOF);
+    }
     int64 read_len = fread(lexer->buffer, 1, LEX_BUFF_SIZE, lexer->srcfile);
     // process the end-of-file.
     if (feof(lexer->srcfile) != 0 && read_len == 0) {
@@ -210,7 +389,7 @@ static error lexerReadFile(Lexer* lexer) {
 }
 
 static char lexerReadc(Lexer* lexer) {
-    return lexer->buffer[lexer->i];
+    return lexer->src[lexer->i];
 }
 
 // used to parse scientific notation part of a number
@@ -265,6 +444,13 @@ error lexerParseToken(Lexer* lexer) {
 
     // skip the blank characters. all blank characters make no sense in c+.
     for (;;) {
+        if (lexer->mode == LEX_MODE_MAPPED) {
+            char* p = scanSkipBlank(lexer->src + lexer->i, lexer->src + lexer->buff_end_index);
+            lexerJumpTo(lexer, p);
+            if (lexer->i >= lexer->buff_end_index) {
+                return NEW_ERROR_CODE(LEX_ERROR_EOF);
+            }
+        }
         ch = lexerReadc(lexer);
         if (ch == ' ' || ch == '\t') {
             lexerNext(lexer);
@@ -286,210 +472,56 @@ error lexerParseToken(Lexer* lexer) {
         }
     }
 
+    // record the beginning of the token. in mapped mode the token's content
+    // is tracked as a span of the source code.
+    lexer->lextkn.span.line = lexer->pos_line;
+    lexer->lextkn.span.col  = lexer->pos_col;
+    if (lexer->mode == LEX_MODE_MAPPED) {
+        lexTokenBeginSpan(&lexer->lextkn, lexer->src, lexer->i);
+    }
+
     // parsing identifers and keywords
     if (('a' <= ch && ch <= 'z') || ('A' <= ch && ch <= 'Z') || ch == '_') {
-        lexTokenAppendc(&lexer->lextkn, ch);
-        lexerNext(lexer);
-        for (;;) {
-            ch = lexerReadc(lexer);
-            if (('a' <= ch && ch <= 'z') || ('A' <= ch && ch <= 'Z') || ('0' <= ch && ch <= '9') || ch == '_') {
-                lexTokenAppendc(&lexer->lextkn, ch);
-                lexerNext(lexer);
+        if (lexer->mode == LEX_MODE_MAPPED) {
+            // the whole file is in the memory, so the identifier can be scanned
+            // at once and appended to the token without any copying.
+            char* start = lexer->src + lexer->i;
+            char* p     = scanIdentEnd(start + 1, lexer->src + lexer->buff_end_index);
+            lexTokenAppend(&lexer->lextkn, start, p - start);
+            lexerJumpTo(lexer, p);
+            // the same as the lexerNext() at the end of the file in stream mode.
+            if (lexer->i >= lexer->buff_end_index) {
+                return NEW_ERROR_CODE(LEX_ERROR_EOF);
             }
-            else {
-                char* token_content = lexTokenGetStr(&lexer->lextkn);
-                if ('A' <= token_content[0] && token_content[0] <= 'Z') {
-                    if (lexer->lextkn.token_len == 4 && strcmp(token_content, "int8") == 0) {
-                        lexer->lextkn.token_code = TOKEN_TYPE_INT8;
-                        lexer->parse_lock = true;
-                        return NULL;
-                    }
-                    else if (lexer->lextkn.token_len == 5 && strcmp(token_content, "int16") == 0) {
-                        lexer->lextkn.token_code = TOKEN_TYPE_INT16;
-                        lexer->parse_lock = true;
-                        return NULL;
-                    }
-                    else if (lexer->lextkn.token_len == 5 && strcmp(token_content, "int32") == 0) {
-                        lexer->lextkn.token_code = TOKEN_TYPE_INT32;
-                        lexer->parse_lock = true;
-                        return NULL;
-                    }
-                    else if (lexer->lextkn.token_len == 5 && strcmp(token_content, "int64") == 0) {
-                        lexer->lextkn.token_code = TOKEN_TYPE_INT64;
-                        lexer->parse_lock = true;
-                        return NULL;
-                    }
-                    else if (lexer->lextkn.token_len == 6 && strcmp(token_content, "string") == 0) {
-                        lexer->lextkn.token_code = TOKEN_TYPE_STRING;
-                        lexer->parse_lock = true;
-                        return NULL;
-                    }
-                    else if (lexer->lextkn.token_len == 4 && strcmp(token_content, "char") == 0) {
-                        lexer->lextkn.token_code = TOKEN_TYPE_CHAR;
-                        lexer->parse_lock = true;
-                        return NULL;
-                    }
-                    else if (lexer->lextkn.token_len == 7 && strcmp(token_content, "float64") == 0) {
-                        lexer->lextkn.token_code = TOKEN_TYPE_FLOAT64;
-                        lexer->parse_lock = true;
-                        return NULL;
-                    }
-                    else if (lexer->lextkn.token_len == 7 && strcmp(token_content, "float32") == 0) {
-                        lexer->lextkn.token_code = TOKEN_TYPE_FLOAT32;
-                        lexer->parse_lock = true;
-                        return NULL;
-                    }
-                    else if (lexer->lextkn.token_len == 5 && strcmp(token_content, "uint8") == 0) {
-                        lexer->lextkn.token_code = TOKEN_TYPE_UINT8;
-                        lexer->parse_lock = true;
-                        return NULL;
-                    }
-                    else if (lexer->lextkn.token_len == 6 && strcmp(token_content, "uint16") == 0) {
-                        lexer->lextkn.token_code = TOKEN_TYPE_UINT16;
-                        lexer->parse_lock = true;
-                        return NULL;
-                    }
-                    else if (lexer->lextkn.token_len == 6 && strcmp(token_content, "uint32") == 0) {
-                        lexer->lextkn.token_code = TOKEN_TYPE_UINT32;
-                        lexer->parse_lock = true;
-                        return NULL;
-                    }
-                    else if (lexer->lextkn.token_len == 6 && strcmp(token_content, "uint64") == 0) {
-                        lexer->lextkn.token_code = TOKEN_TYPE_UINT64;
-                        lexer->parse_lock = true;
-                        return NULL;
-                    }
-                    else if (lexer->lextkn.token_len == 4 && strcmp(token_content, "byte") == 0) {
-                        lexer->lextkn.token_code = TOKEN_TYPE_BYTE;
-                        lexer->parse_lock = true;
-                        return NULL;
-                    }
-                    else if (lexer->lextkn.token_len == 9 && strcmp(token_content, "complex64") == 0) {
-                        lexer->lextkn.token_code = TOKEN_TYPE_COMPLEX64;
-                        lexer->parse_lock = true;
-                        return NULL;
-                    }
-                    else if (lexer->lextkn.token_len == 10 && strcmp(token_content, "complex128") == 0) {
-                        lexer->lextkn.token_code = TOKEN_TYPE_COMPLEX128;
-                        lexer->parse_lock = true;
-                        return NULL;
-                    }
-                }
-                if ('b' <= token_content[0] && token_content[0] <= 'f') {
-                    // for func fallthrough
-                    if (lexer->lextkn.token_len == 3 && strcmp(token_content, "for") == 0) {
-                        lexer->lextkn.token_code = TOKEN_KEYWORD_FOR;
-                        lexer->parse_lock = true;
-                        return NULL;
-                    }
-                    else if (lexer->lextkn.token_len == 4 && strcmp(token_content, "func") == 0) {
-                        lexer->lextkn.token_code = TOKEN_KEYWORD_FUNC;
-                        lexer->parse_lock = true;
-                        return NULL;
-                    }
-                    else if (lexer->lextkn.token_len == 11 && strcmp(token_content, "fallthrough") == 0) {
-                        lexer->lextkn.token_code = TOKEN_KEYWORD_FTHROUGH;
-                        lexer->parse_lock = true;
-                        return NULL;
-                    }
-                    // ef else error expn
-                    if (lexer->lextkn.token_len == 2 && strcmp(token_content, "ef") == 0) {
-                        lexer->lextkn.token_code = TOKEN_KEYWORD_EF;
-                        lexer->parse_lock = true;
-                        return NULL;
-                    }
-                    else if (lexer->lextkn.token_len == 4 && strcmp(token_content, "else") == 0) {
-                        lexer->lextkn.token_code = TOKEN_KEYWORD_ELSE;
-                        lexer->parse_lock = true;
-                        return NULL;
-                    }
-                    else if (lexer->lextkn.token_len == 5 && strcmp(token_content, "error") == 0) {
-                        lexer->lextkn.token_code = TOKEN_KEYWORD_ERROR;
-                        lexer->parse_lock = true;
-                        return NULL;
-                    }
-                    else if (lexer->lextkn.token_len == 4 && strcmp(token_content, "expn") == 0) {
-                        lexer->lextkn.token_code = TOKEN_KEYWORD_EXPN;
-                        lexer->parse_lock = true;
-                        return NULL;
-                    }
-                    // break
-                    if (lexer->lextkn.token_len == 5 && strcmp(token_content, "break") == 0) {
-                        lexer->lextkn.token_code = TOKEN_KEYWORD_BREAK;
-                        lexer->parse_lock = true;
-                        return NULL;
-                    }
-                    // deal default
-                    if (lexer->lextkn.token_len == 4 && strcmp(token_content, "deal") == 0) {
-                        lexer->lextkn.token_code = TOKEN_KEYWORD_DEAL;
-                        lexer->parse_lock = true;
-                        return NULL;
-                    }
-                    else if (lexer->lextkn.token_len == 7 && strcmp(token_content, "default") == 0) {
-                        lexer->lextkn.token_code = TOKEN_KEYWORD_DEFAULT;
-                        lexer->parse_lock = true;
-                        return NULL;
-                    }
-                    // case const continue
-                    if (lexer->lextkn.token_len == 4 && strcmp(token_content, "case") == 0) {
-                        lexer->lextkn.token_code = TOKEN_KEYWORD_CASE;
-                        lexer->parse_lock = true;
-                        return NULL;
-                    }
-                    else if (lexer->lextkn.token_len == 5 && strcmp(token_content, "const") == 0) {
-                        lexer->lextkn.token_code = TOKEN_KEYWORD_CONST;
-                        lexer->parse_lock = true;
-                        return NULL;
-                    }
-                    else if (lexer->lextkn.token_len == 8 && strcmp(token_content, "continue") == 0) {
-                        lexer->lextkn.token_code = TOKEN_KEYWORD_CONTINUE;
-                        lexer->parse_lock = true;
-                        return NULL;
-                    }
+        }
+        else {
+            lexTokenAppendc(&lexer->lextkn, ch);
+            lexerNext(lexer);
+            for (;;) {
+                ch = lexerReadc(lexer);
+                if (('a' <= ch && ch <= 'z') || ('A' <= ch && ch <= 'Z') || ('0' <= ch && ch <= '9') || ch == '_') {
+                    lexTokenAppendc(&lexer->lextkn, ch);
+                    lexerNext(lexer);
                 }
-                switch (token_content[0]) {
-                case 'i': // if in
-                    if (lexer->lextkn.token_len == 2 && strcmp(token_content, "if") == 0) {
-                        lexer->lextkn.token_code = TOKEN_KEYWORD_IF;
-                        lexer->parse_lock = true;
-                        return NULL;
-                    }
-                    else if (lexer->lextkn.token_len == 7 && strcmp(token_content, "include") == 0) {
-                        lexer->lextkn.token_code = TOKEN_KEYWORD_INCLUDE;
-                        lexer->parse_lock = true;
-                        return NULL;
-                    }
-                case 't': // type
-                    if (lexer->lextkn.token_len == 4 && strcmp(token_content, "type") == 0) {
-                        lexer->lextkn.token_code = TOKEN_KEYWORD_TYPE;
-                        lexer->parse_lock = true;
-                        return NULL;
-                    }
-                case 'r': // return
-                    if (lexer->lextkn.token_len == 6 && strcmp(token_content, "return") == 0) {
-                        lexer->lextkn.token_code = TOKEN_KEYWORD_RETURN;
-                        lexer->parse_lock = true;
-                        return NULL;
-                    }
-                case 's': // switch
-                    if (lexer->lextkn.token_len == 6 && strcmp(token_content, "switch") == 0) {
-                        lexer->lextkn.token_code = TOKEN_KEYWORD_SWITCH;
-                        lexer->parse_lock = true;
-                        return NULL;
-                    }
-                case 'm': // module
-                    if (lexer->lextkn.token_len == 6 && strcmp(token_content, "module") == 0) {
-                        lexer->lextkn.token_code = TOKEN_KEYWORD_MODULE;
-                        lexer->parse_lock = true;
-                        return NULL;
-                    }
+                else {
+                    break;
                 }
-                // variable or constant names
-                lexer->lextkn.token_code = TOKEN_ID;
-                lexer->parse_lock = true;
-                return NULL;
             }
         }
+        // the materialized content is contiguous in the token's dynamic array,
+        // so the content is always borrowed without copying.
+        const char* token_content = lexTokenSpanPtr(&lexer->lextkn);
+        if (token_content == NULL) {
+            token_content = dynamicArrStrView(&lexer->lextkn.token);
+        }
+        lexer->lextkn.token_code = keywordLookup(token_content, lexer->lextkn.token_len);
+        // the names of variables, functions, types and modules are interned
+        // here once, so the later stages never copy or compare them again.
+        if (lexer->lextkn.token_code == TOKEN_ID) {
+            lexer->lextkn.token_intern = internStr(token_content, lexer->lextkn.token_len);
+        }
+        lexer->parse_lock = true;
+        return NULL;
     }
 
     // parsing integer constants and float constants
@@ -588,9 +620,10 @@ error lexerParseToken(Lexer* lexer) {
                         lexerNext(lexer);
                     }
                     else {
-                        char* decimal = conv_itoa(conv_binary_to_decimal(lexTokenGetStr(&lexer->lextkn), lexer->lextkn.token_len));
+                        char  decimal[CONV_ITOA_SIZE];
+                        int32 decimal_len = conv_itoa_buf(conv_binary_to_decimal((char*)dynamicArrStrView(&lexer->lextkn.token), lexer->lextkn.token_len), decimal);
                         lexTokenClear(&lexer->lextkn);
-                        lexTokenAppend(&lexer->lextkn, decimal, strlen(decimal));
+                        lexTokenAppend(&lexer->lextkn, decimal, decimal_len);
                         lexer->lextkn.token_code = TOKEN_CONST_INTEGER;
                         lexer->parse_lock = true;
                         return NULL;
@@ -630,6 +663,12 @@ error lexerParseToken(Lexer* lexer) {
                     }
                 }
                 break;
+
+            // just a zero
+            default:
+                lexer->lextkn.token_code = TOKEN_CONST_INTEGER;
+                lexer->parse_lock = true;
+                return NULL;
             }
         }
     }
@@ -637,6 +676,15 @@ error lexerParseToken(Lexer* lexer) {
     // parsing string constants
     if (ch == '"') {
         lexerNext(lexer);
+        if (lexer->mode == LEX_MODE_MAPPED) {
+            lexTokenBeginSpan(&lexer->lextkn, lexer->src, lexer->i);
+            char* p = scanFindQuote(lexer->src + lexer->i, lexer->src + lexer->buff_end_index);
+            if (p >= lexer->src + lexer->buff_end_index) {
+                return NEW_ERROR_CODE(LEX_ERROR_EOF);
+            }
+            lexer->lextkn.token_len = p - (lexer->src + lexer->i);
+            lexerJumpTo(lexer, p);
+        }
         for (;;) {
             ch = lexerReadc(lexer);
             if (ch != '"') {
@@ -655,6 +703,9 @@ error lexerParseToken(Lexer* lexer) {
     // parsing char constants
     if (ch == '\'') {
         lexerNext(lexer);
+        if (lexer->mode == LEX_MODE_MAPPED) {
+            lexTokenBeginSpan(&lexer->lextkn, lexer->src, lexer->i);
+        }
         ch = lexerReadc(lexer);
         if (ch != '\\') {
             uint8 bytes = utf8_calcu_bytes(ch);
@@ -720,6 +771,7 @@ error lexerParseToken(Lexer* lexer) {
         }
         ch = lexerReadc(lexer);
         if (ch == '\'') {
+            lexerNext(lexer);
             lexer->lextkn.token_code = TOKEN_CONST_CHAR;
             lexer->parse_lock = true;
             return NULL;
@@ -950,6 +1002,18 @@ error lexerParseToken(Lexer* lexer) {
                 // parsing the single line comment
                 lexTokenClear(&lexer->lextkn);
                 lexerNext(lexer);
+                if (lexer->mode == LEX_MODE_MAPPED) {
+                    char* p = scanFindLineEnd(lexer->src + lexer->i, lexer->src + lexer->buff_end_index);
+                    lexTokenBeginSpan(&lexer->lextkn, lexer->src, lexer->i);
+                    lexer->lextkn.token_len  = p - (lexer->src + lexer->i);
+                    lexer->lextkn.token_code = TOKEN_OP_SINGLE_CMT;
+                    lexer->parse_lock = true;
+                    lexerJumpTo(lexer, p);
+                    if (lexer->i >= lexer->buff_end_index) {
+                        return NEW_ERROR_CODE(LEX_ERROR_EOF);
+                    }
+                    return NULL;
+                }
                 for (;;) {
                     ch = lexerReadc(lexer);
                     if (ch != '\r' && ch != '\n') {
@@ -969,10 +1033,19 @@ error lexerParseToken(Lexer* lexer) {
                 lexerNext(lexer);
                 int embed = 0;
                 for (;;) {
+                    if (lexer->mode == LEX_MODE_MAPPED) {
+                        // jump to the next byte which may change the state of the comment.
+                        char* p = scanFindCmtMark(lexer->src + lexer->i, lexer->src + lexer->buff_end_index);
+                        lexerJumpTo(lexer, p);
+                        if (lexer->i >= lexer->buff_end_index) {
+                            return NEW_ERROR_CODE(LEX_ERROR_EOF);
+                        }
+                    }
                     ch = lexerReadc(lexer);
                     if (ch == '*') {
                         lexerNext(lexer);
                         if (lexerReadc(lexer) == '/') {
+                            lexerNext(lexer);
                             if (embed <= 0) {
                                 lexer->lextkn.token_code = TOKEN_OP_MULTIL_CMT;
                                 lexer->parse_lock = true;
@@ -990,6 +1063,14 @@ error lexerParseToken(Lexer* lexer) {
                             lexerNext(lexer);
                         }
                     }
+                    else if (ch == '\n') {
+                        lexerNext(lexer);
+                        lexer->pos_line++;
+                        lexer->pos_col = 1;
+                    }
+                    else {
+                        lexerNext(lexer);
+                    }
                 }
             }
             else if (ch == '=') {
@@ -17,6 +17,7 @@
 #include "dynamicarr.h"
 #include "convert.h"
 #include "utf.h"
+#include "intern.h"
 
 #define TOKEN_UNKNOWN          000  // all unknown token type
 #define TOKEN_ID               100  // identifier
@@ -132,40 +133,74 @@
 #define EXTRA_INFO_OP_BINARY   3
 #define EXTRA_INFO_EXPR_END    4
 #define EXTRA_INFO_ASSIGN      5
+// the LexTokenSpan records where the token's content is in the source code.
+//
+// in mapped mode the content of most tokens(identifiers, numbers, strings and
+// operators) is exactly a substring of the source, so the token just points to
+// the source buffer with the span and nothing is copied. only the tokens whose
+// content differs from the source(e.g. the escaped char '\n', the binary number
+// 0b101 which is converted to "5") are materialized into the dynamic array.
+//
+typedef struct {
+    int64 offset; // the offset of the content's first byte in the source buffer
+    int32 line;   // the line where the token begins
+    int32 col;    // the column where the token begins
+}LexTokenSpan;
+
 typedef struct {
-    DynamicArrChar token;      // one dynamic char array to store the token's content
-    int64          token_len;  // save the token's length
-    int16          token_code; // will be assigned with one of micro definitions prefixed with 'TOKEN_...'
-    int8           extra_info; // extra information of the token
+    DynamicArrStr  token;        // one contiguous dynamic char array to store the token's content
+    int64          token_len;    // save the token's length
+    int16          token_code;   // will be assigned with one of micro definitions prefixed with 'TOKEN_...'
+    int8           extra_info;   // extra information of the token
+    LexTokenSpan   span;         // the position of the token in the source code
+    char*          span_src;     // the source buffer the span points into. NULL means the
+                                 // content is materialized in the dynamic array 'token'
+    char*          token_intern; // the interned content of the TOKEN_ID(see intern.h). it
+                                 // is NULL for other tokens
 }LexToken;
 
-extern error lexTokenInit   (LexToken* lextkn, int64 capacity);
-extern void  lexTokenAppend (LexToken* lextkn, char* str, int64 len);
-extern void  lexTokenAppendc(LexToken* lextkn, char  ch);
-extern char* lexTokenGetStr (LexToken* lextkn);
-extern void  lexTokenClear  (LexToken* lextkn);
-extern void  lexTokenDebug  (LexToken* lextkn);
-extern void  lexTokenDestroy(LexToken* lextkn);
+extern error lexTokenInit     (LexToken* lextkn, int64 capacity);
+extern void  lexTokenBeginSpan(LexToken* lextkn, char* src, int64 offset);
+extern void  lexTokenAppend   (LexToken* lextkn, char* str, int64 len);
+extern void  lexTokenAppendc  (LexToken* lextkn, char  ch);
+extern char* lexTokenSpanPtr  (LexToken* lextkn);
+extern char* lexTokenGetStr   (LexToken* lextkn);
+extern void  lexTokenClear    (LexToken* lextkn);
+extern void  lexTokenDebug    (LexToken* lextkn);
+extern void  lexTokenDestroy  (LexToken* lextkn);
 
 // if want to change the lexical analyzer's buffer size and file
 // read rate, just modify the under micro definition.
 //
-// node:
-//   the LEX_BUFF_SIZE should not exceed 32767(is 2^16/2-1), because
-//   the index 'i' and 'buff_end_index' are 16bits numbers.
-//
 #define LEX_BUFF_SIZE 4096
+
+// the lexer can read the source file in two ways:
+//   LEX_MODE_STREAM: read the file into the fixed-size buffer with fread
+//                    and refill it every LEX_BUFF_SIZE bytes.
+//   LEX_MODE_MAPPED: map the whole file into the memory once and scan it
+//                    as one contiguous span. the mapping is always followed
+//                    by a '\0' sentinel so the scanning loops can stop at the
+//                    end of file without checking the index every byte.
+//
+#define LEX_MODE_STREAM 0x00
+#define LEX_MODE_MAPPED 0x01
 typedef struct{
     FILE*    srcfile;               // source file descriptor
     char     buffer[LEX_BUFF_SIZE]; // the buffer used to read the source file
-    int16    i;                     // the array index of buffer
-    int16    buff_end_index;        // the last index of the buffer. the buffer will not be
+    char*    src;                   // the bytes now scanning. it points to the buffer in
+                                    // stream mode and to the mapped file in mapped mode
+    int64    src_map_len;           // the length of the mapping(0 if nothing is mapped)
+    int8     mode;                  // LEX_MODE_STREAM or LEX_MODE_MAPPED
+    int64    i;                     // the array index of src
+    int64    buff_end_index;        // the last index of src. the buffer will not be
                                     // always filled with the capacity of LEX_BUFF_SIZE so
                                     // the buff_end_index will flag this situation
     char*    pos_file;              // the source file name now parsing
     int32    pos_line;              // record the current analyzing line count
-    int16    pos_col;               // record the position in the current line
-    LexToken lextkn;                // to storage the information of the token which is parsing now
+    int32    pos_col;               // record the position in the current line
+    LexToken lextkn;                // to storage the information of the token which is parsing now.
+                                    // in mapped mode its span points to src, so the span is only
+                                    // valid until the file is closed
     bool     parse_lock;            // if the parse_lock == true, the lexical analyzer can not
                                     // continue to parse the next token
 }Lexer;
@@ -192,12 +227,15 @@ typedef struct{
 //   }
 //   ...
 //
-extern error     lexerInit        (Lexer* lexer);
-extern error     lexerOpenSrcFile (Lexer* lexer, char* file);
-extern void      lexerCloseSrcFile(Lexer* lexer);
-extern error     lexerParseToken  (Lexer* lexer);
-extern LexToken* lexerReadToken   (Lexer* lexer);
-extern void      lexerNextToken   (Lexer* lexer);
-extern void      lexerDestroy     (Lexer* lexer);
+extern error     lexerInit             (Lexer* lexer);
+extern error     lexerOpenSrcFile      (Lexer* lexer, char* file);
+extern error     lexerOpenSrcFileMapped(Lexer* lexer, char* file);
+extern error     lexerOpenSrcFileMode  (Lexer* lexer, char* file, int8 mode);
+extern void      lexerOpenSrcSpan      (Lexer* lexer, char* file, char* src, int64 len, int32 line);
+extern void      lexerCloseSrcFile     (Lexer* lexer);
+extern error     lexerParseToken       (Lexer* lexer);
+extern LexToken* lexerReadToken        (Lexer* lexer);
+extern void      lexerNextToken        (Lexer* lexer);
+extern void      lexerDestroy          (Lexer* lexer);
 
 #endif
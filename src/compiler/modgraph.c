@@ -0,0 +1,280 @@
+/**
+ * Copyright 2015 JiKai. All rights reserved.
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file.
+ **/
+
+#include "modgraph.h"
+
+void modGraphInit(ModuleGraph* graph) {
+    graph->mods        = NULL;
+    graph->order       = NULL;
+    graph->count       = 0;
+    graph->cap         = 0;
+    graph->edges       = 0;
+    graph->ready       = NULL;
+    graph->ready_count = 0;
+}
+
+void modGraphAdd(ModuleGraph* graph, Module* mod) {
+    if (graph->count == graph->cap) {
+        graph->cap  = graph->cap == 0 ? 64 : graph->cap * 2;
+        graph->mods = (Module**)mem_realloc(graph->mods, sizeof(Module*) * graph->cap);
+    }
+    mod->index = graph->count;
+    graph->mods[graph->count++] = mod;
+}
+
+/****** the ready heap ******/
+
+// return true if the mod1 should be built before the mod2. the ties are
+// broken by the order the modules were found, so the schedule is stable.
+static bool modGraphBefore(Module* mod1, Module* mod2) {
+    if (mod1->chain != mod2->chain) {
+        return mod1->chain > mod2->chain ? true : false;
+    }
+    return mod1->index < mod2->index ? true : false;
+}
+
+void modGraphPushReady(ModuleGraph* graph, Module* mod) {
+    int32   i = graph->ready_count++;
+    Module* parent;
+    while (i > 0) {
+        parent = graph->ready[(i - 1) / 2];
+        if (modGraphBefore(mod, parent) == false) {
+            break;
+        }
+        graph->ready[i] = parent;
+        i = (i - 1) / 2;
+    }
+    graph->ready[i] = mod;
+}
+
+// return NULL if no module is ready.
+Module* modGraphPopReady(ModuleGraph* graph) {
+    if (graph->ready_count == 0) {
+        return NULL;
+    }
+    Module* top  = graph->ready[0];
+    Module* last = graph->ready[--graph->ready_count];
+    int32   i    = 0;
+    int32   child;
+    for (;;) {
+        child = i * 2 + 1;
+        if (child >= graph->ready_count) {
+            break;
+        }
+        if (child + 1 < graph->ready_count && modGraphBefore(graph->ready[child+1], graph->ready[child]) == true) {
+            child++;
+        }
+        if (modGraphBefore(last, graph->ready[child]) == true) {
+            break;
+        }
+        graph->ready[i] = graph->ready[child];
+        i = child;
+    }
+    graph->ready[i] = last;
+    return top;
+}
+
+/****** building the graph ******/
+
+// the modules left by the sorting are in cycles or wait for a cycle. walk
+// the included modules from one of them until a module is met twice, and
+// report the cycle like "a -> b -> c -> a".
+static error modGraphCycleErr(ModuleGraph* graph, int8* sorted) {
+    Module*        mod = NULL;
+    Module*        dep;
+    int32          i, j;
+    int8*          seen = (int8*)mem_alloc(graph->count);
+    DynamicArrStr  dstr;
+
+    for (i = 0; i < graph->count; i++) {
+        seen[i] = false;
+    }
+    for (i = 0; i < graph->count; i++) {
+        if (sorted[i] == false) {
+            mod = graph->mods[i];
+            break;
+        }
+    }
+    // every unsorted module includes at least one unsorted module.
+    while (seen[mod->index] == false) {
+        seen[mod->index] = true;
+        for (j = 0; j < mod->dep_count; j++) {
+            dep = mod->dep_mods[j];
+            if (sorted[dep->index] == false) {
+                break;
+            }
+        }
+        mod = dep;
+    }
+    // now the mod is in the cycle.
+    dynamicArrStrInit  (&dstr, DYNAMIC_ARR_STR_SMALL);
+    dynamicArrStrAppend(&dstr, "the modules include each other circularly: ", 43);
+    dep = mod;
+    do {
+        dynamicArrStrAppend(&dstr, dep->mod_name, internLen(dep->mod_name));
+        dynamicArrStrAppend(&dstr, " -> ", 4);
+        for (j = 0; j < dep->dep_count && sorted[dep->dep_mods[j]->index] == true; j++);
+        // the next one in the cycle is an unsorted module which can reach
+        // the mod, walking the same way as above keeps us in the cycle.
+        dep = dep->dep_mods[j];
+    } while (dep != mod);
+    dynamicArrStrAppend(&dstr, mod->mod_name, internLen(mod->mod_name));
+    char* errmsg = dynamicArrStrDetach(&dstr);
+    mem_free(seen);
+    return new_error(errmsg);
+}
+
+// link the modules to the modules including them, check the cycles, and
+// emit the topological schedule which prefers the heavier chains.
+error modGraphBuild(ModuleGraph* graph) {
+    Module*  mod;
+    Module** queue = (Module**)mem_alloc(sizeof(Module*) * (graph->count + 1));
+    int8*    sorted = (int8*)mem_alloc(graph->count + 1);
+    int32    head = 0, tail = 0;
+    int32    i, j;
+    error    err = NULL;
+
+    graph->edges = 0;
+    for (i = 0; i < graph->count; i++) {
+        mod = graph->mods[i];
+        mod->pending         = mod->dep_count;
+        mod->dependent_count = 0;
+        sorted[i]            = false;
+    }
+    for (i = 0; i < graph->count; i++) {
+        mod = graph->mods[i];
+        for (j = 0; j < mod->dep_count; j++) {
+            moduleAddDependent(mod->dep_mods[j], mod);
+            graph->edges++;
+        }
+    }
+
+    // (1) sort the modules with the Kahn's algorithm.
+    for (i = 0; i < graph->count; i++) {
+        if (graph->mods[i]->pending == 0) {
+            queue[tail++] = graph->mods[i];
+        }
+    }
+    while (head < tail) {
+        mod = queue[head++];
+        sorted[mod->index] = true;
+        for (j = 0; j < mod->dependent_count; j++) {
+            if (--mod->dependents[j]->pending == 0) {
+                queue[tail++] = mod->dependents[j];
+            }
+        }
+    }
+    if (tail < graph->count) {
+        err = modGraphCycleErr(graph, sorted);
+        mem_free(queue);
+        mem_free(sorted);
+        return err;
+    }
+
+    // (2) compute the chains in the reverse topological order.
+    for (i = graph->count - 1; i >= 0; i--) {
+        mod = queue[i];
+        mod->chain      = mod->weight;
+        mod->chain_next = NULL;
+        for (j = 0; j < mod->dependent_count; j++) {
+            if (mod->dependents[j]->chain + mod->weight > mod->chain) {
+                mod->chain      = mod->dependents[j]->chain + mod->weight;
+                mod->chain_next = mod->dependents[j];
+            }
+        }
+    }
+
+    // (3) emit the schedule, the ready module with the heaviest chain
+    //     goes first.
+    graph->order       = (Module**)mem_realloc(graph->order, sizeof(Module*) * (graph->count + 1));
+    graph->ready       = (Module**)mem_realloc(graph->ready, sizeof(Module*) * (graph->count + 1));
+    graph->ready_count = 0;
+    for (i = 0; i < graph->count; i++) {
+        mod = graph->mods[i];
+        mod->pending = mod->dep_count;
+        if (mod->pending == 0) {
+            modGraphPushReady(graph, mod);
+        }
+    }
+    for (i = 0; (mod = modGraphPopReady(graph)) != NULL; i++) {
+        graph->order[i] = mod;
+        for (j = 0; j < mod->dependent_count; j++) {
+            if (--mod->dependents[j]->pending == 0) {
+                modGraphPushReady(graph, mod->dependents[j]);
+            }
+        }
+    }
+
+    // reset the pending counts, the scheduler consumes them again.
+    for (i = 0; i < graph->count; i++) {
+        graph->mods[i]->pending = graph->mods[i]->dep_count;
+    }
+    mem_free(queue);
+    mem_free(sorted);
+    return NULL;
+}
+
+/****** dumping the graph ******/
+
+int64 modGraphNow() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+#define modGraphMs(ns) ((double)(ns) / 1e6)
+
+// example:
+//    module graph: 3 modules, 2 edges
+//      #0 test.prog   bytes 120   chain 360   parse 0.05ms  resolve 0.01ms  include: base
+//      ...
+//    critical path: weight 360 bytes, parse 0.12ms, resolve 0.02ms
+//      base(0.03ms) -> test.prog(0.06ms)
+//
+void modGraphDump(ModuleGraph* graph, FILE* out) {
+    Module* mod;
+    Module* start = NULL;
+    int64   parse_ns = 0, resolve_ns = 0;
+    int32   i, j, rebuilt = 0;
+
+    for (i = 0; i < graph->count; i++) {
+        rebuilt += graph->mods[i]->rebuild == true ? 1 : 0;
+    }
+    fprintf(out, "module graph: %d modules, %d edges, %d rebuilt\r\n", graph->count, graph->edges, rebuilt);
+    for (i = 0; i < graph->count && graph->order != NULL; i++) {
+        mod = graph->order[i];
+        fprintf(out, "  #%-4d %-24s %-7s bytes %-8lld chain %-8lld parse %.3fms  resolve %.3fms  include:",
+            i, mod->mod_name, mod->rebuild == true ? "rebuilt" : "valid",
+            mod->weight, mod->chain, modGraphMs(mod->parse_ns), modGraphMs(mod->resolve_ns));
+        for (j = 0; j < mod->dep_count; j++) {
+            fprintf(out, " %s", mod->deps[j]);
+        }
+        fprintf(out, "\r\n");
+        // the critical path starts from the source module with the heaviest chain.
+        if (mod->dep_count == 0 && (start == NULL || mod->chain > start->chain)) {
+            start = mod;
+        }
+    }
+    if (start == NULL) {
+        return;
+    }
+    for (mod = start, j = 0; mod != NULL; mod = mod->chain_next, j++) {
+        parse_ns   += mod->parse_ns;
+        resolve_ns += mod->resolve_ns;
+    }
+    fprintf(out, "critical path: %d modules of %d, weight %lld bytes, parse %.3fms, resolve %.3fms\r\n  ",
+        j, graph->count, start->chain, modGraphMs(parse_ns), modGraphMs(resolve_ns));
+    for (mod = start; mod != NULL; mod = mod->chain_next) {
+        fprintf(out, "%s(%.3fms)%s", mod->mod_name, modGraphMs(mod->parse_ns + mod->resolve_ns), mod->chain_next != NULL ? " -> " : "\r\n");
+    }
+}
+
+void modGraphDestroy(ModuleGraph* graph) {
+    mem_free(graph->mods);
+    mem_free(graph->order);
+    mem_free(graph->ready);
+    modGraphInit(graph);
+}
@@ -0,0 +1,52 @@
+/**
+ * Copyright 2015 JiKai. All rights reserved.
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file.
+ *
+ *     The modgraph.h and modgraph.c implement the graph of
+ * the modules included by each other. it checks the cycles,
+ * sorts the modules topologically and finds the longest
+ * chain which serializes the build.
+ **/
+
+#ifndef CPLUS_MODGRAPH_H
+#define CPLUS_MODGRAPH_H
+
+#include <time.h>
+#include "common.h"
+#include "module.h"
+
+// the ModuleGraph is built after all modules are parsed. the edges are
+// got from the dep_mods of the modules: an edge points from a module to
+// the module including it(see Module.dependents).
+//
+// the weight of a module is the size of its source files, and the chain
+// of a module is the heaviest path from it to the last module built(the
+// main module usually). the module with a heavier chain is scheduled
+// first, so the critical path starts as early as possible.
+//
+typedef struct ModuleGraph {
+    Module** mods;      // all modules in the order they were added
+    Module** order;     // the topological schedule, filled by modGraphBuild()
+    int32    count;
+    int32    cap;
+    int32    edges;
+
+    // the modules ready to build, it is a max-heap on the chains.
+    Module** ready;
+    int32    ready_count;
+}ModuleGraph;
+
+extern void    modGraphInit     (ModuleGraph* graph);
+extern void    modGraphAdd      (ModuleGraph* graph, Module* mod);
+extern error   modGraphBuild    (ModuleGraph* graph);
+extern void    modGraphPushReady(ModuleGraph* graph, Module* mod);
+extern Module* modGraphPopReady (ModuleGraph* graph);
+extern void    modGraphDump     (ModuleGraph* graph, FILE* out);
+extern void    modGraphDestroy  (ModuleGraph* graph);
+
+// return the nanoseconds of the monotonic clock, it is used to time the
+// stages of the modules.
+extern int64   modGraphNow      ();
+
+#endif
@@ -5,8 +5,7 @@
  **/
 
 #include "module.h"
-
-static error err = NULL;
+#include "iface.h"
 
 /****** methods of Module ******/
 
@@ -14,25 +13,24 @@ static error err = NULL;
 //    if the source path is "/home/user/project/src".
 //    the module name "net/http" will return "/home/user/project/src/net.mod/http.mod".
 //                                                                   ^^^^^^^^^^^^^^^^
-static char* moduleGetModPathByName(const char* const mod_name, int mod_name_len, const ProjectConfig* projconf) {
+static char* moduleGetModPathByName(const char* const mod_name, int mod_name_len, const char* dir, int dir_len) {
     char* mod_path;
     int   i;
-    DynamicArrChar darr;
-    dynamicArrCharInit   (&darr, 255);
-    dynamicArrCharAppend (&darr, projconf->path_source, projconf->srcdir_path_len);
-    dynamicArrCharAppendc(&darr, '/');
+    DynamicArrStr dstr;
+    dynamicArrStrInit   (&dstr, DYNAMIC_ARR_STR_SMALL);
+    dynamicArrStrAppend (&dstr, (char*)dir, dir_len);
+    dynamicArrStrAppendc(&dstr, '/');
     for (i = 0; i < mod_name_len; i++) {
         if (mod_name[i] != '/') {
-            dynamicArrCharAppendc(&darr, mod_name[i]);
+            dynamicArrStrAppendc(&dstr, mod_name[i]);
         }
         else {
-            dynamicArrCharAppend (&darr, ".mod", 4);
-            dynamicArrCharAppendc(&darr, '/');
+            dynamicArrStrAppend (&dstr, ".mod", 4);
+            dynamicArrStrAppendc(&dstr, '/');
         }
     }
-    dynamicArrCharAppend (&darr, ".mod", 4);
-    mod_path = dynamicArrCharGetStr(&darr);
-    dynamicArrCharDestroy(&darr);
+    dynamicArrStrAppend (&dstr, ".mod", 4);
+    mod_path = dynamicArrStrDetach(&dstr);
     return mod_path;
 }
 
@@ -43,21 +41,21 @@ static char* moduleGetModPathByName(const char* const mod_name, int mod_name_len
 static char* moduleGetModNameByPath(const char* const mod_path, int mod_path_len, const ProjectConfig* projconf) {
     char* mod_name;
     int   i;
-    DynamicArrChar darr;
-    dynamicArrCharInit(&darr, 255);
-    for (i = projconf->srcdir_path_len+1; i < mod_path_len;) {
+    DynamicArrStr dstr;
+    dynamicArrStrInit(&dstr, DYNAMIC_ARR_STR_SMALL);
+    for (i = projconf->path_srcdir_len+1; i < mod_path_len;) {
         if (mod_path[i]   == '.' &&
             mod_path[i+1] == 'm' &&
             mod_path[i+2] == 'o' &&
             mod_path[i+3] == 'd' ){
             i += 4;
         } else {
-            dynamicArrCharAppendc(&darr, mod_path[i]);
+            dynamicArrStrAppendc(&dstr, mod_path[i]);
             i++;
         }
     }
-    mod_name = dynamicArrCharGetStr(&darr);
-    dynamicArrCharDestroy(&darr);
+    mod_name = internStr(dynamicArrStrView(&dstr), dstr.used);
+    dynamicArrStrDestroy(&dstr);
     return mod_name;
 }
 
@@ -78,96 +76,190 @@ static bool moduleIsSrcFile(char* file_name, int len) {
     return false;
 }
 
-static SourceFile* moduleGetSrcFileList(char* dir_path, int path_len) {
-    SourceFile*    head = NULL;
-    SourceFile*    tail = NULL;
-    SourceFile*    create;
-    DIR*           dir;
-    struct dirent* dir_entry;
-    int            len;
+// make the SourceFiles of the entries and their names in one block. the
+// count is at least 1.
+static SourceFile* moduleNewSrcFiles(DirScanEntry** entries, int count) {
+    SourceFile* files;
+    char*       name;
+    size_t      size = sizeof(SourceFile) * count;
+    int         i;
+    for (i = 0; i < count; i++) {
+        size += entries[i]->name_len + 1;
+    }
+    files = (SourceFile*)mem_alloc(size);
+    name  = (char*)(files + count);
+    for (i = 0; i < count; i++) {
+        memcpy(name, entries[i]->name, entries[i]->name_len + 1);
+        files[i].file_name     = name;
+        files[i].file_name_len = entries[i]->name_len;
+        files[i].mtime         = 0;
+        files[i].size          = 0;
+        files[i].hash          = 0;
+        files[i].scan_mtime    = entries[i]->mtime;
+        files[i].scan_size     = entries[i]->size;
+        files[i].next          = i+1 < count ? &files[i+1] : NULL;
+        name += entries[i]->name_len + 1;
+    }
+    return files;
+}
+
+// the source files are sorted by their names like the listing of the
+// directory, so the modules are always parsed in the same order whatever
+// the order of the directory entries is.
+static SourceFile* moduleGetSrcFileList(DirScanner* scanner, char* dir_path, int path_len) {
+    DirScanDir*    dir;
+    DirScanEntry** entries;
+    SourceFile*    head  = NULL;
+    int            count = 0;
+    int            i;
 
-    if ((dir = opendir(dir_path)) == NULL) {
+    if ((dir = dirScanList(scanner, dir_path, path_len)) == NULL) {
         return NULL;
     }
-    while ((dir_entry = readdir(dir)) != NULL) {
-        len = strlen(dir_entry->d_name);
-        if (dir_entry->d_type == DT_REG && moduleIsSrcFile(dir_entry->d_name, len) == true) {
-            // warning:
-            //    care about the dir_entry->d_name, it may cause the wild pointer. if it happened,
-            //    just copy every dir_entry->d_name to the create->file_name with a new memory.
-            //
-            create = (SourceFile*)mem_alloc(sizeof(SourceFile));
-            create->file_name     = dir_entry->d_name;
-            create->file_name_len = len;
-            create->next          = NULL;
-
-            head != NULL ? (tail->next = create) : (head = create);
-            tail  = create;
+    entries = (DirScanEntry**)mem_alloc(sizeof(DirScanEntry*) * (dir->count + 1));
+    for (i = 0; i < dir->count; i++) {
+        if (dir->entries[i].type == DIRSCAN_REG && moduleIsSrcFile(dir->entries[i].name, dir->entries[i].name_len) == true) {
+            entries[count++] = &dir->entries[i];
         }
     }
-    closedir(dir);
+    if (count > 0) {
+        head = moduleNewSrcFiles(entries, count);
+    }
+    mem_free(entries);
     return head;
 }
 
-static void moduleInitByName(Module* mod, char* mod_name, int mod_name_len, const ProjectConfig* projconf) {
-    mod->mod_name     = mod_name;
-    mod->mod_path     = moduleGetModPathByName(mod_name, mod_name_len, projconf);
-    mod->mod_path_len = strlen(mod->mod_path);
-    mod->mod_ismain   = false;
-    mod->preprocessed = false;
-    mod->srcfiles     = moduleGetSrcFileList(mod->mod_path, mod->mod_path_len);
-    mod->iterator     = mod->srcfiles;
+static Module* moduleNew(char* mod_name, char* mod_path, int mod_path_len, bool mod_ismain) {
+    Module* mod = (Module*)mem_alloc(sizeof(Module));
+    mod->mod_name        = mod_name;
+    mod->mod_path        = mod_path;
+    mod->mod_path_len    = mod_path_len;
+    mod->mod_ismain      = mod_ismain;
+    mod->srcfiles        = NULL;
+    mod->iterator        = NULL;
+    mod->deps            = NULL;
+    mod->dep_mods        = NULL;
+    mod->dep_count       = 0;
+    mod->dep_cap         = 0;
+    mod->id_table        = (IdentTable*)mem_alloc(sizeof(IdentTable));
+    identTableInit(mod->id_table);
+    identTableInit(&mod->imports);
+    mod->state           = MODULE_STATE_PARSE;
+    mod->pending         = 0;
+    mod->dependents      = NULL;
+    mod->dependent_count = 0;
+    mod->dependent_cap   = 0;
+    mod->err             = NULL;
+    mod->index           = 0;
+    mod->weight          = 1;
+    mod->chain           = 0;
+    mod->chain_next      = NULL;
+    mod->parse_ns        = 0;
+    mod->resolve_ns      = 0;
+    mod->iface           = MODULE_IFACE_UNKNOWN;
+    mod->src_hash        = 0;
+    mod->iface_hash      = 0;
+    mod->rebuild         = true;
+    mod->parsed          = false;
+    return mod;
+}
+
+// find the module in the source directory of the project first and then in
+// the directory of the standard modules. return NULL if the module is not
+// found. the scanner can be NULL, then the directories are listed without
+// the cache.
+Module* moduleNewByName(char* mod_name, const ProjectConfig* projconf, DirScanner* scanner) {
+    DirScanner local;
+    Module*    mod = NULL;
+    int        mod_name_len = strlen(mod_name);
+    char*      mod_path;
+    if (scanner == NULL) {
+        dirScanInit(&local);
+        mod = moduleNewByName(mod_name, projconf, &local);
+        dirScanDestroy(&local);
+        return mod;
+    }
+    mod_path = moduleGetModPathByName(mod_name, mod_name_len, projconf->path_srcdir, projconf->path_srcdir_len);
+    if (dirScanIsDir(scanner, mod_path, strlen(mod_path)) == false) {
+        mem_free(mod_path);
+        if (projconf->path_stdmods == NULL) {
+            return NULL;
+        }
+        mod_path = moduleGetModPathByName(mod_name, mod_name_len, projconf->path_stdmods, projconf->path_stdmods_len);
+        if (dirScanIsDir(scanner, mod_path, strlen(mod_path)) == false) {
+            mem_free(mod_path);
+            return NULL;
+        }
+    }
+    mod = moduleNew(internStr(mod_name, mod_name_len), mod_path, strlen(mod_path), false);
+    mod->srcfiles = moduleGetSrcFileList(scanner, mod->mod_path, mod->mod_path_len);
+    mod->iterator = mod->srcfiles;
+    return mod;
 }
 
-static void moduleInitByPath(Module* mod, char* mod_path, int mod_path_len, const ProjectConfig* projconf) {
+// the path can be a program directory, a module directory or a single source
+// file. return NULL if it is none of them. the scanner can be NULL like the
+// moduleNewByName().
+Module* moduleNewByPath(char* mod_path, int mod_path_len, const ProjectConfig* projconf, DirScanner* scanner) {
+    DirScanner    local;
+    DirScanEntry  entry;
+    DirScanEntry* entries[1];
+    Module*       mod;
+    char*         name;
+    if (scanner == NULL) {
+        dirScanInit(&local);
+        mod = moduleNewByPath(mod_path, mod_path_len, projconf, &local);
+        dirScanDestroy(&local);
+        return mod;
+    }
     if (is_cplus_program(mod_path, mod_path_len) == true) {
-        mod->mod_name     = path_last(mod_path, mod_path_len);
-        mod->mod_path     = mod_path;
-        mod->mod_path_len = mod_path_len;
-        mod->mod_ismain   = true;
-        mod->preprocessed = false;
-        mod->srcfiles     = moduleGetSrcFileList(mod_path, mod_path_len);
-        mod->iterator     = mod->srcfiles;
-    }
-    else if (is_cplus_module(mod_path, mod_path_len) == true) {
-        mod->mod_name     = moduleGetModNameByPath(mod_path, mod_path_len, projconf);
-        mod->mod_path     = mod_path;
-        mod->mod_path_len = mod_path_len;
-        mod->mod_ismain   = false;
-        mod->preprocessed = false;
-        mod->srcfiles     = moduleGetSrcFileList(mod_path, mod_path_len);
-        mod->iterator     = mod->srcfiles;
-    }
-    else if (is_cplus_source(mod_path, mod_path_len) == true) {
-        mod->mod_name     = path_last(mod_path, mod_path_len);
-        mod->mod_path     = path_prev(mod_path, mod_path_len);
-        mod->mod_path_len = mod_path_len;
-        mod->mod_ismain   = true;
-        mod->preprocessed = false;
-        mod->srcfiles     = (SourceFile*)mem_alloc(sizeof(SourceFile));
-        mod->iterator     = mod->srcfiles;
-        mod->srcfiles->file_name     = mod->mod_name;
-        mod->srcfiles->file_name_len = strlen(mod->srcfiles->file_name);
-        mod->srcfiles->next          = NULL;
-    }
-}
-
-// return NULL if all source files are trivaled once.
+        name = path_last(mod_path, mod_path_len);
+        mod  = moduleNew(internCStr(name), mem_strdup(mod_path), mod_path_len, true);
+        mod->srcfiles = moduleGetSrcFileList(scanner, mod->mod_path, mod->mod_path_len);
+        mod->iterator = mod->srcfiles;
+        mem_free(name);
+        return mod;
+    }
+    if (is_cplus_module(mod_path, mod_path_len) == true) {
+        name = moduleGetModNameByPath(mod_path, mod_path_len, projconf);
+        mod  = moduleNew(name, mem_strdup(mod_path), mod_path_len, false);
+        mod->srcfiles = moduleGetSrcFileList(scanner, mod->mod_path, mod->mod_path_len);
+        mod->iterator = mod->srcfiles;
+        return mod;
+    }
+    if (is_cplus_source(mod_path, mod_path_len) == true) {
+        name = path_last(mod_path, mod_path_len);
+        char* dir = path_prev(mod_path, mod_path_len);
+        mod  = moduleNew(internCStr(name), dir, strlen(dir), true);
+        entry.name     = name;
+        entry.name_len = strlen(name);
+        entry.mtime    = -1;
+        entry.size     = -1;
+        entries[0]     = &entry;
+        mod->srcfiles  = moduleNewSrcFiles(entries, 1);
+        mod->iterator  = mod->srcfiles;
+        mem_free(name);
+        return mod;
+    }
+    return NULL;
+}
+
+// return NULL if all source files are trivaled once. the returned path
+// should be released by mem_free().
 //
 char* moduleGetNextSrcFile(Module* mod) {
-    if (mod->srcfiles == NULL) {
+    if (mod->iterator == NULL) {
         return NULL;
     }
     char*          file;
-    DynamicArrChar darr;
-    dynamicArrCharInit   (&darr, 255);
-    dynamicArrCharAppend (&darr, mod->mod_path, mod->mod_path_len);
-    dynamicArrCharAppendc(&darr, '/');
-    dynamicArrCharAppend (&darr, mod->srcfiles->file_name, mod->srcfiles->file_name_len);
-    file = dynamicArrCharGetStr(&darr);
-    dynamicArrCharDestroy(&darr);
-
-    mod->srcfiles = mod->srcfiles->next;
+    DynamicArrStr  dstr;
+    dynamicArrStrInit   (&dstr, DYNAMIC_ARR_STR_SMALL);
+    dynamicArrStrAppend (&dstr, mod->mod_path, mod->mod_path_len);
+    dynamicArrStrAppendc(&dstr, '/');
+    dynamicArrStrAppend (&dstr, mod->iterator->file_name, mod->iterator->file_name_len);
+    file = dynamicArrStrDetach(&dstr);
+
+    mod->iterator = mod->iterator->next;
     return file;
 }
 
@@ -175,142 +267,545 @@ void moduleRewind(Module* mod) {
     mod->iterator = mod->srcfiles;
 }
 
-static void moduleDestroy(Module* mod) {
-//  mem_free(mod->mod_name);
-//  mem_free(mod->mod_path);
-    SourceFile* del;
-    for (;;) {
-        if (mod->srcfiles == NULL) {
-            mod->iterator =  NULL;
+// make the error message like "file: errmsg".
+static error moduleFileErr(char* file, char* errmsg) {
+    DynamicArrStr  dstr;
+    dynamicArrStrInit  (&dstr, DYNAMIC_ARR_STR_SMALL);
+    dynamicArrStrAppend(&dstr, file, strlen(file));
+    dynamicArrStrAppend(&dstr, ": ", 2);
+    dynamicArrStrAppend(&dstr, errmsg, strlen(errmsg));
+    errmsg = dynamicArrStrDetach(&dstr);
+    return new_error(errmsg);
+}
+
+void moduleAddDep(Module* mod, char* dep) {
+    int32 i;
+    for (i = 0; i < mod->dep_count; i++) {
+        if (mod->deps[i] == dep) {
             return;
         }
-        del = mod->srcfiles;
-        mod->srcfiles = mod->srcfiles->next;
-//      mem_free(del->file_name);
-        mem_free(del);
     }
+    if (mod->dep_count == mod->dep_cap) {
+        mod->dep_cap = mod->dep_cap == 0 ? 4 : mod->dep_cap * 2;
+        mod->deps    = (char**)mem_realloc(mod->deps, sizeof(char*) * mod->dep_cap);
+    }
+    mod->deps[mod->dep_count++] = dep;
 }
 
-/****** methods of ModuleScheduleQueue ******/
-
-static void moduleScheduleQueueInit(ModuleScheduleQueue* queue) {
-    queue->cur  = NULL;
-    queue->head = (ModuleScheduleQueueNode*)mem_alloc(sizeof(ModuleScheduleQueueNode));
-    queue->head->mod  = NULL;
-    queue->head->prev = NULL;
-    queue->head->next = NULL;
+error moduleAddExport(Module* mod, char* id_name, int8 id_type) {
+    Ident* id = identNew(id_name, id_type);
+    if (identTableAdd(mod->id_table, id) != NULL) {
+        identFree(id);
+        return new_error("redefined the identifier in the module.");
+    }
+    return NULL;
 }
 
-// return true if the queue is empty.
-//
-static bool moduleScheduleQueueIsEmpty(ModuleScheduleQueue* queue) {
-    return queue->head->next == NULL ? true : false;
+// the result of lexing one source file. the files of a module are lexed
+// independently, and the results are merged into the module in the order
+// of the files, so the module is the same however the files are lexed.
+typedef struct ModuleFileItem ModuleFileItem;
+struct ModuleFileItem {
+    char*           name;    // interned
+    int8            type;    // ID_TYPE_XXX for the exports, 0 for the includes
+    ModuleFileItem* next;
+};
+
+typedef struct ModuleFileResult {
+    char*           file;
+    char*           src;     // the chunk of the file split, NULL if the file is not split
+    int64           len;
+    int32           line;    // the line where the chunk begins
+    Lexer*          mapping; // the lexer mapping the file split, kept by the first chunk
+    bool            owner;   // false for the chunks sharing the file name of the first one
+    Arena           arena;   // the items
+    ModuleFileItem* items;   // the includes and the exports in the order met
+    ModuleFileItem* tail;
+    int64           bytes;
+    error           err;
+}ModuleFileResult;
+
+static void moduleFileAddItem(ModuleFileResult* result, char* name, int8 type) {
+    ModuleFileItem* item = arenaNew(&result->arena, ModuleFileItem);
+    item->name = name;
+    item->type = type;
+    item->next = NULL;
+    result->tail != NULL ? (result->tail->next = item) : (result->items = item);
+    result->tail = item;
 }
 
-static void moduleScheduleQueueAddMod(ModuleScheduleQueue* queue, Module* mod) {
-    ModuleScheduleQueueNode* create = (ModuleScheduleQueueNode*)mem_alloc(sizeof(ModuleScheduleQueueNode));
-    create->mod = mod;
-    if (queue->head->next != NULL) {
-        create->prev = queue->cur->prev;
-        create->next = queue->cur;
-        queue->cur->prev->next = create;
-        queue->cur->prev = create;
+// only the statements in the global scope are concerned:
+//   include "net/http" -> the module includes the module "net/http".
+//   func name          -> the module exports the function.
+//   type name          -> the module exports the datatype.
+// it does not touch the module, so the files and the chunks of the files
+// can be lexed by many threads.
+static void moduleLexFile(ModuleFileResult* result) {
+    Lexer     lexer;
+    LexToken* lextkn;
+    error     err;
+    int64     depth = 0;
+    int16     prev  = TOKEN_UNKNOWN;
+
+    if ((result->err = lexerInit(&lexer)) != NULL) {
+        return;
+    }
+    if (result->src != NULL) {
+        lexerOpenSrcSpan(&lexer, result->file, result->src, result->len, result->line);
+    }
+    else if ((result->err = lexerOpenSrcFileMapped(&lexer, result->file)) != NULL) {
+        lexTokenDestroy(&lexer.lextkn);
+        return;
     }
     else {
-        create->next = NULL;
-        create->prev = queue->head;
-        queue->head->next = create;
+        result->bytes = lexer.buff_end_index;
     }
+    for (;;) {
+        if ((err = lexerParseToken(&lexer)) != NULL) {
+            if (ERROR_CODE(err) != LEX_ERROR_EOF) {
+                result->err = moduleFileErr(result->file, err);
+            }
+            break;
+        }
+        lextkn = lexerReadToken(&lexer);
+        switch (lextkn->token_code) {
+        case TOKEN_OP_LBRACE:
+            depth++;
+            break;
+
+        case TOKEN_OP_RBRACE:
+            depth--;
+            break;
+
+        case TOKEN_CONST_STRING:
+            if (depth == 0 && prev == TOKEN_KEYWORD_INCLUDE) {
+                char* content = lexTokenGetStr(lextkn);
+                moduleFileAddItem(result, internStr(content, lextkn->token_len), 0);
+                mem_free(content);
+            }
+            break;
+
+        case TOKEN_ID:
+            if (depth == 0 && prev == TOKEN_KEYWORD_FUNC) {
+                moduleFileAddItem(result, lextkn->token_intern, ID_TYPE_FUNCTION);
+            }
+            else if (depth == 0 && prev == TOKEN_KEYWORD_TYPE) {
+                moduleFileAddItem(result, lextkn->token_intern, ID_TYPE_DATATYPE);
+            }
+            break;
+        }
+        prev = lextkn->token_code;
+        lexerNextToken(&lexer);
+    }
+    lexerDestroy(&lexer);
 }
 
-// return the module which is prepared to be compiled and set the corresponding node
-// to the 'cur' position. all new dependency nodes will be inserted into the previous
-// position of the 'cur' position.
-//
-// example:
-//    now state:
-//       [m1.mod m2.mod m3.mod m4.mod]
-//                        ^
-//                       cur
-//    ater call GetHeadMod:
-//       [m1.mod m2.mod m3.mod m4.mod]
-//          ^
-//         cur
+// merge the result into the module. the items before the error of the
+// file are still merged, like the file is parsed up to the error.
+static error moduleMergeFile(Module* mod, ModuleFileResult* result) {
+    ModuleFileItem* item;
+    error           err;
+    mod->weight += result->bytes;
+    for (item = result->items; item != NULL; item = item->next) {
+        if (item->type == 0) {
+            moduleAddDep(mod, item->name);
+        }
+        else if ((err = moduleAddExport(mod, item->name, item->type)) != NULL) {
+            return moduleFileErr(result->file, err);
+        }
+    }
+    return result->err;
+}
+
+static void moduleFileResultInit(ModuleFileResult* result, char* file) {
+    result->file    = file;
+    result->src     = NULL;
+    result->len     = 0;
+    result->line    = 1;
+    result->mapping = NULL;
+    result->owner   = true;
+    result->items   = NULL;
+    result->tail    = NULL;
+    result->bytes   = 0;
+    result->err     = NULL;
+    arenaInit(&result->arena, 1024);
+}
+
+static void moduleFileResultDestroy(ModuleFileResult* result) {
+    arenaDestroy(&result->arena);
+    if (result->mapping != NULL) {
+        lexerDestroy(result->mapping);
+        mem_free(result->mapping);
+    }
+    if (result->owner == true) {
+        mem_free(result->file);
+    }
+}
+
+static ModuleFileResult* moduleAddResult(ModuleFileResult** results, int32* count, int32* cap) {
+    if (*count == *cap) {
+        *cap     = *cap == 0 ? 16 : *cap * 2;
+        *results = (ModuleFileResult*)mem_realloc(*results, sizeof(ModuleFileResult) * *cap);
+    }
+    return &(*results)[(*count)++];
+}
+
+// split the large file of the results[first] into chunks at its top-level
+// declarations(see closeCounterSplit), so the chunks are lexed by several
+// workers. the first chunk maps the file and the others share the mapping.
+// if the file can not be mapped, it is lexed as a whole and the error is
+// met by the lexing.
+static void moduleSplitFile(ModuleFileResult** results, int32* count, int32* cap, int32 first, int32 max_chunks) {
+    ModuleFileResult* chunk;
+    Lexer*            mapping = (Lexer*)mem_alloc(sizeof(Lexer));
+    CloseSplit*       splits;
+    int64             len;
+    int32             n, i;
+
+    if (lexerInit(mapping) != NULL) {
+        mem_free(mapping);
+        return;
+    }
+    if (lexerOpenSrcFileMapped(mapping, (*results)[first].file) != NULL) {
+        lexTokenDestroy(&mapping->lextkn);
+        mem_free(mapping);
+        return;
+    }
+    len    = mapping->buff_end_index;
+    splits = (CloseSplit*)mem_alloc(sizeof(CloseSplit) * max_chunks);
+    n      = closeCounterSplit(mapping->src, len, len / max_chunks > MODULE_CHUNK_SIZE ? len / max_chunks : MODULE_CHUNK_SIZE,
+        splits, max_chunks);
+    for (i = 0; i < n; i++) {
+        chunk = i == 0 ? &(*results)[first] : moduleAddResult(results, count, cap);
+        if (i > 0) {
+            moduleFileResultInit(chunk, (*results)[first].file);
+            chunk->owner = false;
+        }
+        chunk->src  = mapping->src + splits[i].offset;
+        chunk->len  = (i + 1 < n ? splits[i+1].offset : len) - splits[i].offset;
+        chunk->line = splits[i].line;
+    }
+    (*results)[first].mapping = mapping;
+    (*results)[first].bytes   = len;
+    mem_free(splits);
+}
+
+// the files of a module lexed by the workers. the thread parsing the module
+// lexes the files as well, and the helpers submitted to the pool take the
+// files left. a helper may start after all files are taken, so the job is
+// released by the last one using it.
+typedef struct ModuleParseJob {
+    ModuleFileResult* results;
+    int32             count;
+    int32             next;      // the next file to take
+    int32             done;
+    int32             refs;
+    pthread_mutex_t   lock;
+    pthread_cond_t    cond_done;
+}ModuleParseJob;
+
+static void moduleParseJobRun(ModuleParseJob* job) {
+    int32 i;
+    while ((i = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED)) < job->count) {
+        moduleLexFile(&job->results[i]);
+        pthread_mutex_lock(&job->lock);
+        if (++job->done == job->count) {
+            pthread_cond_signal(&job->cond_done);
+        }
+        pthread_mutex_unlock(&job->lock);
+    }
+}
+
+static void moduleParseJobRelease(ModuleParseJob* job) {
+    int32 refs;
+    pthread_mutex_lock(&job->lock);
+    refs = --job->refs;
+    pthread_mutex_unlock(&job->lock);
+    if (refs == 0) {
+        pthread_mutex_destroy(&job->lock);
+        pthread_cond_destroy(&job->cond_done);
+        mem_free(job);
+    }
+}
+
+static void moduleParseHelper(void* arg) {
+    ModuleParseJob* job = (ModuleParseJob*)arg;
+    moduleParseJobRun(job);
+    moduleParseJobRelease(job);
+}
+
+// lex the files by the workers of the pool and wait for all of them.
+static void moduleLexFiles(ModuleFileResult* results, int32 count, WorkPool* pool) {
+    ModuleParseJob* job     = (ModuleParseJob*)mem_alloc(sizeof(ModuleParseJob));
+    int32           helpers = count - 1 < pool->workers - 1 ? count - 1 : pool->workers - 1;
+    int32           i;
+    job->results = results;
+    job->count   = count;
+    job->next    = 0;
+    job->done    = 0;
+    job->refs    = helpers + 1;
+    pthread_mutex_init(&job->lock, NULL);
+    pthread_cond_init (&job->cond_done, NULL);
+    for (i = 0; i < helpers; i++) {
+        workPoolSubmit(pool, moduleParseHelper, job);
+    }
+    moduleParseJobRun(job);
+    pthread_mutex_lock(&job->lock);
+    while (job->done < job->count) {
+        pthread_cond_wait(&job->cond_done, &job->lock);
+    }
+    pthread_mutex_unlock(&job->lock);
+    moduleParseJobRelease(job);
+}
+
+// parse the source files of the module. if the pool is not NULL, the files
+// are lexed by its workers at the same time, and the large files are split
+// into chunks lexed at the same time too. otherwise they are lexed one by
+// one.
+static error moduleParseFiles(Module* mod, WorkPool* pool) {
+    ModuleFileResult  result;
+    ModuleFileResult* results = NULL;
+    SourceFile*       src;
+    char*             file;
+    error             err   = NULL;
+    int32             count = 0;
+    int32             cap   = 0;
+    int32             i;
+
+    moduleRewind(mod);
+    if (pool == NULL || mod->srcfiles == NULL || (mod->srcfiles->next == NULL && mod->srcfiles->scan_size < MODULE_SPLIT_SIZE)) {
+        while (err == NULL && (file = moduleGetNextSrcFile(mod)) != NULL) {
+            moduleFileResultInit   (&result, file);
+            moduleLexFile          (&result);
+            err = moduleMergeFile  (mod, &result);
+            moduleFileResultDestroy(&result);
+        }
+        moduleRewind(mod);
+        return err;
+    }
+    for (src = mod->srcfiles; src != NULL; src = src->next) {
+        moduleFileResultInit(moduleAddResult(&results, &count, &cap), moduleGetNextSrcFile(mod));
+        if (src->scan_size >= MODULE_SPLIT_SIZE) {
+            moduleSplitFile(&results, &count, &cap, count - 1, pool->workers * 4);
+        }
+    }
+    moduleRewind  (mod);
+    moduleLexFiles(results, count, pool);
+    // the chunks share the file name of the first one, so the results are
+    // destroyed after all of them are merged.
+    for (i = 0; i < count && err == NULL; i++) {
+        err = moduleMergeFile(mod, &results[i]);
+    }
+    for (i = 0; i < count; i++) {
+        moduleFileResultDestroy(&results[i]);
+    }
+    mem_free(results);
+    return err;
+}
+
+// try to do the parse stage by the interface file of the module. return
+// false if the module has to be parsed. the sources of the main modules
+// are hashed too, but they do not have the interface files.
+static bool moduleLoadIface(Module* mod) {
+    uint64 hash;
+    int64  bytes;
+    if (mod->iface != MODULE_IFACE_UNKNOWN) {
+        return mod->iface == MODULE_IFACE_LOADED ? true : false;
+    }
+    if (mod->mod_path == NULL || ifaceHashSources(mod, &hash, &bytes) != NULL) {
+        mod->iface = MODULE_IFACE_NONE;
+        return false;
+    }
+    mod->src_hash = hash;
+    if (mod->mod_ismain == true) {
+        mod->iface = MODULE_IFACE_NONE;
+        return false;
+    }
+    if (ifaceLoad(mod, hash) != NULL) {
+        mod->iface = MODULE_IFACE_STALE;
+        return false;
+    }
+    mod->weight += bytes;
+    mod->iface   = MODULE_IFACE_LOADED;
+    return true;
+}
+
+// parse all source files of the module. it only touches the module itself,
+// so the modules can be parsed at the same time. if the pool is not NULL,
+// the files of the module are lexed by its workers too, and the module is
+// the same as the one parsed without the pool.
 //
-static Module* moduleScheduleQueueGetHeadMod(ModuleScheduleQueue* queue) {
-    queue->cur = queue->head->next;
-    return queue->cur != NULL ? queue->cur->mod : NULL;
+// the sources are hashed before they are parsed, so if they are changed
+// while parsing, the file saved is out of date in the next build rather
+// than wrong.
+error moduleParse(Module* mod, WorkPool* pool) {
+    error err;
+    if (mod->parsed == true) {
+        return NULL;
+    }
+    if (moduleLoadIface(mod) == true) {
+        mod->dep_mods = (Module**)mem_alloc(sizeof(Module*) * (mod->dep_count + 1));
+        memset(mod->dep_mods, 0, sizeof(Module*) * (mod->dep_count + 1));
+        mod->parsed   = true;
+        return NULL;
+    }
+    err = moduleParseFiles(mod, pool);
+    mod->dep_mods = (Module**)mem_alloc(sizeof(Module*) * (mod->dep_count + 1));
+    memset(mod->dep_mods, 0, sizeof(Module*) * (mod->dep_count + 1));
+    if (err == NULL) {
+        mod->iface_hash = ifaceHashExports(mod);
+        mod->parsed     = true;
+    }
+    if (err == NULL && mod->iface == MODULE_IFACE_STALE) {
+        // the file only saves the time of the next build, so the module is
+        // built even though it can not be saved.
+        ifaceSave(mod, mod->src_hash);
+    }
+    return err;
 }
 
-static void moduleScheduleQueueDelHeadMod(ModuleScheduleQueue* queue) {
-    ModuleScheduleQueueNode* del = queue->head->next;
-    if (del != NULL) {
-        if (del->next != NULL) {
-            queue->head->next = del->next;
-            del->next->prev = queue->head;
-            del->prev = NULL;
-            del->next = NULL;
+// bind the export tables of the included modules to the module. all
+// dep_mods must be done already.
+error moduleResolve(Module* mod) {
+    error err;
+    int32 i;
+    for (i = 0; i < mod->dep_count; i++) {
+        if (mod->dep_mods[i] == NULL || mod->dep_mods[i]->state != MODULE_STATE_DONE) {
+            return new_error("the included module is not compiled.");
         }
-        else {
-            queue->head->next = NULL;
-            del->prev = NULL;
+        Ident*       id     = identNew(mod->deps[i], ID_TYPE_MODULE);
+        IdentModule* id_mod = (IdentModule*)mem_alloc_sized(sizeof(IdentModule));
+        id_mod->id_table    = mod->dep_mods[i]->id_table;
+        id->id.id_module    = id_mod;
+        if ((err = identTableAdd(&mod->imports, id)) != NULL) {
+            mem_free_sized(id_mod, sizeof(IdentModule));
+            identFree(id);
+            return err;
         }
-        mem_free(del);
     }
+    return NULL;
 }
 
-static void moduleScheduleQueueDestroy(ModuleScheduleQueue* queue) {
-    ModuleScheduleQueueNode* del = NULL;
-    ModuleScheduleQueueNode* ptr = queue->head;
-    for (;;) {
-        if (ptr == NULL) {
-            queue->head = NULL;
-            queue->cur  = NULL;
-            return;
+void moduleAddDependent(Module* mod, Module* dependent) {
+    if (mod->dependent_count == mod->dependent_cap) {
+        mod->dependent_cap = mod->dependent_cap == 0 ? 4 : mod->dependent_cap * 2;
+        mod->dependents    = (Module**)mem_realloc(mod->dependents, sizeof(Module*) * mod->dependent_cap);
+    }
+    mod->dependents[mod->dependent_count++] = dependent;
+}
+
+// the export tables of the included modules are owned by themselves.
+static void moduleClearImports(Module* mod) {
+    uint32 i;
+    for (i = 0; i < mod->imports.cap; i++) {
+        if (mod->imports.dists[i] != 0) {
+            mem_free_sized(mod->imports.entries[i].id->id.id_module, sizeof(IdentModule));
+            mod->imports.entries[i].id->id.id_module = NULL;
+        }
+    }
+    identTableDestroy(&mod->imports);
+}
+
+// make the module ready for the next build. the results of the parse stage
+// are kept, so the module is not parsed again. the other modules are not
+// touched, the caller should reset all modules of the build together.
+void moduleReset(Module* mod) {
+    SourceFile* src;
+    moduleClearImports(mod);
+    moduleRewind(mod);
+    // the files may be changed since they were listed.
+    for (src = mod->srcfiles; src != NULL; src = src->next) {
+        src->scan_mtime = -1;
+        src->scan_size  = -1;
+    }
+    if (mod->dep_mods != NULL) {
+        memset(mod->dep_mods, 0, sizeof(Module*) * (mod->dep_count + 1));
+    }
+    mod->state           = MODULE_STATE_PARSE;
+    mod->pending         = 0;
+    mod->dependent_count = 0;
+    mod->err             = NULL;
+    mod->index           = 0;
+    mod->chain           = 0;
+    mod->chain_next      = NULL;
+    mod->parse_ns        = 0;
+    mod->resolve_ns      = 0;
+    mod->rebuild         = true;
+}
+
+void moduleDestroy(Module* mod) {
+    mem_free(mod->srcfiles);
+    mod->srcfiles = NULL;
+    mod->iterator = NULL;
+
+    moduleClearImports(mod);
+    identTableDestroy(mod->id_table);
+    mem_free(mod->id_table);
+    mem_free(mod->deps);
+    mem_free(mod->dep_mods);
+    mem_free(mod->dependents);
+    mem_free(mod->mod_path);
+    mem_free(mod);
+}
+
+/****** methods of ModuleScheduleQueue ******/
+
+void moduleScheduleQueueInit(ModuleScheduleQueue* queue) {
+    queue->head = NULL;
+    queue->tail = NULL;
+}
+
+// return true if the queue is empty.
+//
+bool moduleScheduleQueueIsEmpty(ModuleScheduleQueue* queue) {
+    return queue->head == NULL ? true : false;
+}
+
+void moduleScheduleQueueAddMod(ModuleScheduleQueue* queue, Module* mod) {
+    ModuleScheduleQueueNode* create = (ModuleScheduleQueueNode*)mem_alloc_sized(sizeof(ModuleScheduleQueueNode));
+    create->mod  = mod;
+    create->next = NULL;
+    queue->head != NULL ? (queue->tail->next = create) : (queue->head = create);
+    queue->tail  = create;
+}
+
+// return the module at the head of the queue, or NULL if the queue is empty.
+//
+Module* moduleScheduleQueueGetHeadMod(ModuleScheduleQueue* queue) {
+    return queue->head != NULL ? queue->head->mod : NULL;
+}
+
+void moduleScheduleQueueDelHeadMod(ModuleScheduleQueue* queue) {
+    ModuleScheduleQueueNode* del = queue->head;
+    if (del != NULL) {
+        queue->head = del->next;
+        if (queue->head == NULL) {
+            queue->tail = NULL;
         }
-        del = ptr;
-        ptr = ptr->next;
+        mem_free_sized(del, sizeof(ModuleScheduleQueueNode));
+    }
+}
 
-        del->prev = NULL;
-        del->next = NULL;
-        mem_free(del);
+void moduleScheduleQueueDestroy(ModuleScheduleQueue* queue) {
+    while (queue->head != NULL) {
+        moduleScheduleQueueDelHeadMod(queue);
     }
 }
 
 /****** methods of ModuleCacheTable ******/
 
-static void moduleCacheTableInit(ModuleCacheTable* cachetable) {
+void moduleCacheTableInit(ModuleCacheTable* cachetable) {
     cachetable->root = NULL;
 }
 
-// firstly compare every character of the two name from index 0:
-// (1) if name1[index] < name2[index] -> NODE_CMP_LT.
-// (2) if name1[index] > name2[index] -> NODE_CMP_GT.
-//
-// if all characters compared are the same, then compare their names' length:
-// (1) if the name1's length is longer , return NODE_CMP_GT.
-// (2) if the name1's length is shorter, return NODE_CMP_LT.
-// (3) if tow names'  length are equal , return NODE_CMP_EQ.
+// the module names are interned, so the tree is ordered by the ids of
+// the interned names without comparing the characters.
 //
 static int moduleCacheTableCmp(char* name1, char* name2) {
-    int64 i;
-    for (i = 0; ; i++) {
-        if (name1[i] < name2[i]) {
-            return NODE_CMP_LT;
-        }
-        if (name1[i] > name2[i]) {
-            return NODE_CMP_GT;
-        }
-        if (name1[i] == '\0' && name2[i] == '\0') {
-            return NODE_CMP_EQ;
-        }
-        if (name1[i] == '\0' && name2[i] != '\0') {
-            return NODE_CMP_LT;
-        }
-        if (name1[i] != '\0' && name2[i] == '\0') {
-            return NODE_CMP_GT;
-        }
+    if (name1 == name2) {
+        return NODE_CMP_EQ;
     }
+    return internId(name1) < internId(name2) ? NODE_CMP_LT : NODE_CMP_GT;
 }
 
 // example:
@@ -321,7 +816,7 @@ static int moduleCacheTableCmp(char* name1, char* name2) {
 //     /      \          /    \
 //    b        c        a      b
 //
-static error moduleCacheTableLeftRotate(ModuleCacheTable* cachetable, ModuleCacheTableNode* node) {
+static void moduleCacheTableLeftRotate(ModuleCacheTable* cachetable, ModuleCacheTableNode* node) {
     if (node == cachetable->root) {
         cachetable->root = node->rchild;
         node->rchild->parent = NULL;
@@ -334,8 +829,8 @@ static error moduleCacheTableLeftRotate(ModuleCacheTable* cachetable, ModuleCach
     }
     node->parent = node->rchild;
     node->rchild = node->rchild->lchild;
-    if (node->parent->lchild != NULL) {
-        node->parent->lchild->parent = node;
+    if (node->rchild != NULL) {
+        node->rchild->parent = node;
     }
     node->parent->lchild = node;
 }
@@ -348,7 +843,7 @@ static error moduleCacheTableLeftRotate(ModuleCacheTable* cachetable, ModuleCach
 //  /      \                 /    \
 // a        b               b      c
 //
-static error moduleCacheTableRightRotate(ModuleCacheTable* cachetable, ModuleCacheTableNode* node) {
+static void moduleCacheTableRightRotate(ModuleCacheTable* cachetable, ModuleCacheTableNode* node) {
     if (node == cachetable->root) {
         cachetable->root = node->lchild;
         node->lchild->parent = NULL;
@@ -361,8 +856,8 @@ static error moduleCacheTableRightRotate(ModuleCacheTable* cachetable, ModuleCac
     }
     node->parent = node->lchild;
     node->lchild = node->lchild->rchild;
-    if (node->parent->rchild != NULL) {
-        node->parent->rchild->parent = node;
+    if (node->lchild != NULL) {
+        node->lchild->parent = node;
     }
     node->parent->rchild = node;
 }
@@ -418,16 +913,13 @@ static void moduleCacheTableAddFixup(ModuleCacheTable* cachetable, ModuleCacheTa
     cachetable->root->color = NODE_COLOR_BLACK;
 }
 
-static error moduleCacheTableAdd(ModuleCacheTable* cachetable, char* mod_name, IdentTable* id_table) {
-    if (mod_name == NULL) {
+error moduleCacheTableAdd(ModuleCacheTable* cachetable, Module* mod) {
+    if (mod == NULL || mod->mod_name == NULL) {
         return new_error("the module name can not be NULL.");
     }
-    if (id_table == NULL) {
-        return new_error("the identifier table can not be NULL.");
-    }
-    ModuleCacheTableNode* create = (ModuleCacheTableNode*)mem_alloc(sizeof(ModuleCacheTableNode));
-    create->mod_name = mod_name;
-    create->id_table = id_table;
+    ModuleCacheTableNode* create = (ModuleCacheTableNode*)mem_alloc_sized(sizeof(ModuleCacheTableNode));
+    create->mod_name = mod->mod_name;
+    create->mod      = mod;
     create->color    = NODE_COLOR_RED;
     create->parent   = NULL;
     create->lchild   = NULL;
@@ -435,7 +927,7 @@ static error moduleCacheTableAdd(ModuleCacheTable* cachetable, char* mod_name, I
     if (cachetable->root != NULL) {
         ModuleCacheTableNode* ptr = cachetable->root;
         for (;;) {
-            switch (moduleCacheTableCmp(mod_name, ptr->mod_name)) {
+            switch (moduleCacheTableCmp(mod->mod_name, ptr->mod_name)) {
             case NODE_CMP_LT:
                 if (ptr->lchild == NULL) {
                     ptr->lchild = create;
@@ -457,6 +949,7 @@ static error moduleCacheTableAdd(ModuleCacheTable* cachetable, char* mod_name, I
                 break;
 
             case NODE_CMP_EQ:
+                mem_free_sized(create, sizeof(ModuleCacheTableNode));
                 return new_error("the module information is already in the database.");
             }
         }
@@ -470,7 +963,7 @@ static error moduleCacheTableAdd(ModuleCacheTable* cachetable, char* mod_name, I
 
 // return NULL if module does not have the cache entry.
 //
-static IdentTable* moduleCacheTableGet(ModuleCacheTable* cachetable, char* mod_name) {
+Module* moduleCacheTableGetMod(ModuleCacheTable* cachetable, char* mod_name) {
     if (cachetable->root == NULL || mod_name == NULL) {
         return NULL;
     }
@@ -492,23 +985,60 @@ static IdentTable* moduleCacheTableGet(ModuleCacheTable* cachetable, char* mod_n
             return NULL;
 
         case NODE_CMP_EQ:
-            return ptr->id_table;
+            return ptr->mod;
         }
     }
 }
 
-static void moduleCacheTableDestroyNode(ModuleCacheTableNode* node) {
+// return NULL if module does not have the cache entry, or the module is
+// not done yet and its interface file can not be loaded. it must not be
+// called while the module is being parsed.
+//
+IdentTable* moduleCacheTableGet(ModuleCacheTable* cachetable, char* mod_name) {
+    Module* mod = moduleCacheTableGetMod(cachetable, mod_name);
+    if (mod == NULL) {
+        return NULL;
+    }
+    if (mod->state == MODULE_STATE_DONE || (mod->state == MODULE_STATE_PARSE && moduleLoadIface(mod) == true)) {
+        return mod->id_table;
+    }
+    return NULL;
+}
+
+static void moduleCacheTableWalkNode(ModuleCacheTableNode* node, ModuleVisitFunc visit, void* arg) {
     if (node != NULL) {
-        if (node->lchild != NULL) moduleCacheTableDestroyNode(node->lchild);
-        if (node->rchild != NULL) moduleCacheTableDestroyNode(node->rchild);
-        if (node->id_table != NULL) {
-            identTableDestroy(node->id_table);
+        moduleCacheTableWalkNode(node->lchild, visit, arg);
+        visit(node->mod, arg);
+        moduleCacheTableWalkNode(node->rchild, visit, arg);
+    }
+}
+
+// visit all modules in the order of the ids of their names. the table
+// must not be changed by the visit.
+//
+void moduleCacheTableWalk(ModuleCacheTable* cachetable, ModuleVisitFunc visit, void* arg) {
+    moduleCacheTableWalkNode(cachetable->root, visit, arg);
+}
+
+static void moduleCacheTableDestroyNode(ModuleCacheTableNode* node, bool destroy_mod) {
+    if (node != NULL) {
+        if (node->lchild != NULL) moduleCacheTableDestroyNode(node->lchild, destroy_mod);
+        if (node->rchild != NULL) moduleCacheTableDestroyNode(node->rchild, destroy_mod);
+        if (destroy_mod == true) {
+            moduleDestroy(node->mod);
         }
-        mem_free(node->mod_name);
-        mem_free(node);
+        mem_free_sized(node, sizeof(ModuleCacheTableNode));
     }
 }
 
-static void moduleCacheTableDestroy(ModuleCacheTable* cachetable) {
-    moduleCacheTableDestroyNode(cachetable->root);
+// remove all modules from the table without destroying them.
+//
+void moduleCacheTableClear(ModuleCacheTable* cachetable) {
+    moduleCacheTableDestroyNode(cachetable->root, false);
+    cachetable->root = NULL;
+}
+
+void moduleCacheTableDestroy(ModuleCacheTable* cachetable) {
+    moduleCacheTableDestroyNode(cachetable->root, true);
+    cachetable->root = NULL;
 }
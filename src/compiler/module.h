@@ -11,55 +11,143 @@
 #define CPLUS_IMPORT_H
 
 #include <unistd.h>
-#include <dirent.h>
 #include "common.h"
 #include "project.h"
+#include "dirscan.h"
 #include "lexer.h"
 #include "ident.h"
+#include "intern.h"
+#include "arena.h"
+#include "workpool.h"
+#include "closectr.h"
 
-typedef struct SourceFile            SourceFile;
-typedef struct Module                Module;
-typedef struct ModuleQueueNode       ModuleQueueNode;
-typedef struct ModuleQueue           ModuleQueue;
-typedef struct ModuleExportTableNode ModuleExportTableNode;
-typedef struct ModuleExportTable     ModuleExportTable;
+typedef struct SourceFile              SourceFile;
+typedef struct Module                  Module;
+typedef struct ModuleScheduleQueueNode ModuleScheduleQueueNode;
+typedef struct ModuleScheduleQueue     ModuleScheduleQueue;
+typedef struct ModuleCacheTableNode    ModuleCacheTableNode;
+typedef struct ModuleCacheTable        ModuleCacheTable;
 
 // represent a source file in one module or program directory.
 //
+// the mtime, the size and the hash of the content are the ones recorded by
+// the last build(see buildstate.h) before the file is hashed, and the
+// current ones after that. the hash is 0 if it is unknown. the scan_mtime
+// and the scan_size are the ones seen when the directory was listed(see
+// dirscan.h), the scan_mtime is -1 if the file is not stated yet.
+//
+// the SourceFiles of a module and their names are in one block, which is
+// released with the module.
+//
 struct SourceFile {
     char*       file_name;
     int         file_name_len;
+    int64       mtime;
+    int64       size;
+    uint64      hash;
+    int64       scan_mtime;
+    int64       scan_size;
     SourceFile* next;
 };
 
+// a module is compiled in two stages:
+//   (1) parse:   lex all source files of the module, record the modules
+//                included and build the export table. the modules do not
+//                depend on each other in this stage.
+//   (2) resolve: bind the export tables of the included modules to the
+//                module. it can only run after all included modules are
+//                done.
+//
+#define MODULE_STATE_PARSE   0x00 // waiting to be parsed
+#define MODULE_STATE_WAIT    0x01 // parsed, waiting for the included modules
+#define MODULE_STATE_RESOLVE 0x02 // all included modules are done
+#define MODULE_STATE_DONE    0x03 // the export table is in the ModuleCacheTable
+#define MODULE_STATE_FAILED  0x04
+
+// the states of the interface file of the module(see iface.h).
+#define MODULE_IFACE_UNKNOWN 0x00 // the sources are not hashed yet
+#define MODULE_IFACE_NONE    0x01 // the module does not have the interface file
+#define MODULE_IFACE_STALE   0x02 // the module must be parsed, then the file is saved
+#define MODULE_IFACE_LOADED  0x03 // the parse stage is done by the file
+
+// the files not smaller than MODULE_SPLIT_SIZE are split into the chunks
+// of MODULE_CHUNK_SIZE bytes at least, when the module is parsed by a pool.
+#define MODULE_SPLIT_SIZE (1 << 20)
+#define MODULE_CHUNK_SIZE (1 << 18)
+
 struct Module {
-    char*       mod_name;
+    char*       mod_name;        // interned
     char*       mod_path;
     int         mod_path_len;
     bool        mod_ismain;
     SourceFile* srcfiles;
     SourceFile* iterator;
+
+    // the interned names of the modules included by the "include" statements,
+    // they are filled by the moduleParse(). the dep_mods[i] is the module of
+    // the deps[i] and it is filled by the scheduler.
+    char**      deps;
+    Module**    dep_mods;
+    int32       dep_count;
+    int32       dep_cap;
+
+    IdentTable* id_table;        // the identifiers exported by the module
+    IdentTable  imports;         // the included modules, filled by the moduleResolve() of the modules rebuilt
+
+    // the scheduling states. they are guarded by the scheduler.
+    int8        state;
+    int32       pending;         // the number of the included modules not done
+    Module**    dependents;      // the modules waiting for this module
+    int32       dependent_count;
+    int32       dependent_cap;
+    error       err;
+
+    // used by the ModuleGraph(see modgraph.h).
+    int32       index;           // the order the module was found
+    int64       weight;          // the size of the source files in bytes, at least 1
+    int64       chain;           // the weight of the heaviest chain from this module
+    Module*     chain_next;      // the next module on the heaviest chain
+    int64       parse_ns;        // the time spent on the stages
+    int64       resolve_ns;
+
+    int8        iface;           // the state of the interface file
+    uint64      src_hash;        // the hash of the source files if it is hashed
+    uint64      iface_hash;      // the hash of the exports, set by the parse stage
+    bool        rebuild;         // false if the last build of the module is still valid, it is not resolved then
+    bool        parsed;          // the parse stage is done, it is kept by moduleReset()
 };
 
-static void  moduleInitByName    (Module* mod, char* mod_name, int mod_name_len, const ProjectConfig* projconf);
-static void  moduleInitByPath    (Module* mod, char* mod_path, int mod_path_len, const ProjectConfig* projconf);
-extern char* moduleGetNextSrcFile(Module* mod);
-extern void  moduleRewind        (Module* mod);
-static void  moduleDestroy       (Module* mod);
+extern Module* moduleNewByName     (char* mod_name, const ProjectConfig* projconf, DirScanner* scanner);
+extern Module* moduleNewByPath     (char* mod_path, int mod_path_len, const ProjectConfig* projconf, DirScanner* scanner);
+extern char*   moduleGetNextSrcFile(Module* mod);
+extern void    moduleRewind        (Module* mod);
+extern error   moduleParse         (Module* mod, WorkPool* pool);
+extern error   moduleResolve       (Module* mod);
+extern void    moduleAddDep        (Module* mod, char* dep);
+extern error   moduleAddExport     (Module* mod, char* id_name, int8 id_type);
+extern void    moduleAddDependent  (Module* mod, Module* dependent);
+extern void    moduleReset         (Module* mod);
+extern void    moduleDestroy       (Module* mod);
 
-struct ModuleQueueNode {
-    Module*          mod;
-    ModuleQueueNode* next;
+struct ModuleScheduleQueueNode {
+    Module*                  mod;
+    ModuleScheduleQueueNode* next;
 };
 
-struct ModuleQueue {
-    ModuleQueueNode* head;
-    ModuleQueueNode* tail;
+// the ModuleScheduleQueue saves the modules ready to run one by one when
+// the modules are compiled serially.
+//
+struct ModuleScheduleQueue {
+    ModuleScheduleQueueNode* head;
+    ModuleScheduleQueueNode* tail;
 };
 
-extern void moduleQueueInit   (ModuleQueue* modqueue);
-extern void moduleQueueEnqueue(ModuleQueue* modqueue, Module* modqueue);
-extern void moduleQueueDestroy(ModuleQueue* modqueue);
+extern void    moduleScheduleQueueInit      (ModuleScheduleQueue* queue);
+extern bool    moduleScheduleQueueIsEmpty   (ModuleScheduleQueue* queue);
+extern void    moduleScheduleQueueAddMod    (ModuleScheduleQueue* queue, Module* mod);
+extern Module* moduleScheduleQueueGetHeadMod(ModuleScheduleQueue* queue);
+extern void    moduleScheduleQueueDelHeadMod(ModuleScheduleQueue* queue);
+extern void    moduleScheduleQueueDestroy   (ModuleScheduleQueue* queue);
 
 #define NODE_COLOR_RED   0x00
 #define NODE_COLOR_BLACK 0x01
@@ -70,7 +158,7 @@ extern void moduleQueueDestroy(ModuleQueue* modqueue);
 
 struct ModuleCacheTableNode {
     char*                 mod_name;
-    IdentTable*           id_table;
+    Module*               mod;
     int8                  color;
     ModuleCacheTableNode* parent;
     ModuleCacheTableNode* lchild;
@@ -78,15 +166,24 @@ struct ModuleCacheTableNode {
 };
 
 // the ModuleCache is used to save some information and the states of all modules
-// in a cplus project.
+// in a cplus project. a module is added as soon as it is found, and its export
+// table can be got after the module is done. the export table of a module not
+// parsed yet is loaded from its interface file when it is got.
+//
+// the table is not thread-safe, the scheduler guards it with its own lock.
 //
 struct ModuleCacheTable {
     ModuleCacheTableNode* root;
 };
 
-static void        moduleCacheTableInit   (ModuleCacheTable* cachetable);
-static error       moduleCacheTableAdd    (ModuleCacheTable* cachetable, char* mod_name, IdentTable* id_table);
-static IdentTable* moduleCacheTableGet    (ModuleCacheTable* cachetable, char* mod_name);
-static void        moduleCacheTableDestroy(ModuleCacheTable* cachetable);
+typedef void (*ModuleVisitFunc)(Module* mod, void* arg);
+
+extern void        moduleCacheTableInit   (ModuleCacheTable* cachetable);
+extern error       moduleCacheTableAdd    (ModuleCacheTable* cachetable, Module* mod);
+extern IdentTable* moduleCacheTableGet    (ModuleCacheTable* cachetable, char* mod_name);
+extern Module*     moduleCacheTableGetMod (ModuleCacheTable* cachetable, char* mod_name);
+extern void        moduleCacheTableWalk   (ModuleCacheTable* cachetable, ModuleVisitFunc visit, void* arg);
+extern void        moduleCacheTableClear  (ModuleCacheTable* cachetable);
+extern void        moduleCacheTableDestroy(ModuleCacheTable* cachetable);
 
 #endif
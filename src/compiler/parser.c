@@ -21,6 +21,9 @@ if (err != NULL) {                          \
 }                                           \
 parser->cur_token = lexerReadToken(parser->lexer);
 
+// all nodes are allocated from the arena of the AST being built.
+#define parserNew(parser, type) arenaNew(&(parser)->ast->arena, type)
+
 // report and count syntax errors founded in AST building stage.
 // if the number of the errors is more than 50, the work of the
 // syntax parsing will be stoped and notify the programmer to
@@ -43,160 +46,55 @@ void parserReportErr(Parser* parser, char* errmsg) {
 // parse the source file and build the abstract syntax tree. 
 static AST* parserBuildAST(Parser* parser) {
     AST* ast = (AST*)mem_alloc(sizeof(AST));
+    astInit(ast);
+    parser->ast = ast;
     if ((ast->global_scope = parserParseGlobalScope(parser)) == NULL) {
         parserReportErr(parser, "build failed");
     }
     return ast;
 }
 
-// parse constant literals.
-static ASTNodeConstLit* parserParseConstLit(Parser* parser) {
-    ASTNodeConstLit* node_const = (ASTNodeConstLit*)mem_alloc(sizeof(ASTNodeConstLit));
-    node_const->pos_line    = parser->lexer->pos_line;
-    node_const->pos_col     = parser->lexer->pos_col;
-    node_const->const_type  = parser->cur_token->token_code;
-    node_const->const_value = lexTokenGetStr(parser->cur_token);
-    lexerNextToken(parser->lexer);
-    return node_const;
-}
-
-// parse identifiers of the C+ language.
-static ASTNodeID* parserParseID(Parser* parser) {
-    ASTNodeID* node_id = (ASTNodeID*)mem_alloc(sizeof(ASTNodeID));
-    node_id->pos_line = parser->lexer->pos_line;
-    node_id->pos_col  = parser->lexer->pos_col;
-    node_id->id       = lexTokenGetStr(parser->cur_token);
-    lexerNextToken(parser->lexer);
-    return node_id;
-}
-
-// parse expressions of the C+ language.
+// parse expressions of the C+ language by the precedence climbing of the
+// ExprParser(see expression.h). the token ending the expression is left in
+// the lexer.
 static ASTNodeExpr* parserParseExpr(Parser* parser) {
-    OprdStack oprdstk;
-    OptrStack optrstk;
-    oprdStackInit(&oprdstk);
-    optrStackInit(&optrstk);
-    for (;;) {
-        parserGetCurToken(parser);
-
-        // operands are pushed into the stack.
-        if (tokenIsID(parser->cur_token->token_code)) {
-            lexerNextToken(parser->lexer);
-            ASTNodeExpr* oprd = (ASTNodeExpr*)mem_alloc(sizeof(ASTNodeExpr));
-
-            switch (parser->cur_token->token_code) {
-            // id( => function call
-            case TOKEN_OP_LPARENTHESE:
-                oprd->expr_type = AST_NODE_FUNC_CALL;
-                oprd->expr.expr_func_call = parserParseFuncCall(parser);
-                oprdStackPush(&oprdstk, oprd);
-                return NULL;
-
-            // id id => declaration
-            case TOKEN_ID:
-                oprd->expr_type = AST_NODE_ID;
-                oprd->expr.expr_id = parserParseID(parser);
-                oprdStackCalcu(&oprdstk, &optrstk);
-                return oprdStackGetResult(&oprdstk);
-
-            // id[ => indexing
-            case TOKEN_OP_LBRACKET:
-                oprd->expr_type = AST_NODE_INDEX;
-                oprd->expr.expr_index = parserParseIndex(parser);
-                oprdStackPush(&oprdstk, oprd);
-                break;
-
-            // just identifier
-            default:
-                oprd->expr_type = AST_NODE_ID;
-                oprd->expr.expr_id = parserParseID(parser);
-                oprdStackPush(&oprdstk, oprd);
-                break;
-            }
-        }
-        else if (tokenIsConstLit(parser->cur_token->token_code)) {
-            lexerNextToken(parser->lexer);
-            ASTNodeExpr* oprd = (ASTNodeExpr*)mem_alloc(sizeof(ASTNodeExpr));
-            oprd->expr_type = AST_NODE_CONST_LIT;
-            oprd->expr.expr_const_lit = parserParseConstLit(parser);
-            oprdStackPush(&oprdstk, oprd);
-        }
-
-        // operators will be processed based on the previous operators.
-        else if (TOKEN_OP_SPOT <= parser->cur_token->token_code && parser->cur_token->token_code <= TOKEN_OP_LOGIC_OR) {
-            OptrInfo cur_optr;
-            cur_optr.op_token_code = parser->cur_token->token_code;
-            cur_optr.op_type       = parser->cur_token->extra_info;
-            cur_optr.op_priority   = getOptrPriority(parser->cur_token->token_code);
-
-            // the '(' will be directly pushed into the operator stack.
-            // the unary operator like $(dereference) and @(get address) will be pushed into stack
-            // as well, because the operand needed by them will be parsed later.
-            if (cur_optr.op_token_code == TOKEN_OP_LPARENTHESE || cur_optr.op_token_code == OP_TYPE_LUNARY) {
-                optrStackPush(&optrstk, cur_optr);
-                continue;
-            }
-
-            OptrInfo* top_optr;
-            for (;;) {
-                top_optr = optrStackIsEmpty(&optrstk) == false ? optrStackTop(&optrstk) : NULL;
-                if (top_optr == NULL || cur_optr.op_priority > top_optr->op_priority) {
-                    optrStackPush(&optrstk, cur_optr);
-                    break;
-                }
-                if (top_optr->op_type == OP_TYPE_EXPR_END) {
-                    oprdStackCalcu(&oprdstk, &optrstk);
-                    break;
-                }
-                oprdStackCalcuOnce(&oprdstk, *top_optr);
-            }
-        }
-
-        else {
-            oprdStackCalcu(&oprdstk, &optrstk);
-            break;
-        }
+    ExprParser   ep;
+    ASTNodeExpr* expr;
+    exprParserInit(&ep, parser->lexer, &parser->ast->arena);
+    expr = exprParse(&ep);
+    exprParserDestroy(&ep);
+    if (expr == NULL) {
+        parserReportErr(parser, ep.err);
+        return NULL;
     }
-    oprdStackDestroy(&oprdstk);
-    optrStackDestroy(&optrstk);
-
-    return oprdStackGetResult(&oprdstk);
+    parser->cur_token = ep.cur_token;
+    return expr;
 }
 
 // parsing the expression list which represents a set of expressions
 // separated by comma.
 static ASTNodeExprList* parserParseExprList(Parser* parser) {
-    ASTNodeExprList*     node_expr_list = (ASTNodeExprList*)mem_alloc(sizeof(ASTNodeExprList));
-    ASTNodeExprListNode* cur            = NULL;
-    ASTNodeExprListNode* create         = NULL;
+    ASTNodeExprList* node_expr_list = parserNew(parser, ASTNodeExprList);
+    ASTExprVec       exprs;
+    astExprVecInit(&exprs, NULL);
     for (;;) {
-        create = (ASTNodeExprListNode*)mem_alloc(sizeof(ASTNodeExprListNode));
-        create->expr = parserParseExpr(parser);
-        create->next = NULL;
-
-        cur != NULL ? (cur->next = create) : (node_expr_list->exprs = create);
-        cur = create;
+        astExprVecPush(&exprs, parserParseExpr(parser));
 
         // stop parsing if not meet the comma
         parserGetCurToken(parser);
         if (parser->cur_token->token_code != TOKEN_OP_COMMA) {
+            node_expr_list->count = exprs.count;
+            node_expr_list->exprs = astExprVecDup(&exprs, 0, &parser->ast->arena);
+            astExprVecDestroy(&exprs);
             return node_expr_list;
         }
         lexerNextToken(parser->lexer);
     }
 }
 
-// parse the indexing statement.
-static ASTNodeIndex* parserParseIndex(Parser* parser) {
-    ASTNodeIndex* node_index = (ASTNodeIndex*)mem_alloc(sizeof(ASTNodeIndex));
-    node_index->array = parserParseID(parser);
-    node_index->index = parserParseExpr(parser);
-    return node_index;
-}
-
 // parsing the if statement.
 static ASTNodeIf* parserParseIf(Parser* parser) {
-    ASTNodeIf* node_if = (ASTNodeIf*)mem_alloc(sizeof(ASTNodeIf));
+    ASTNodeIf* node_if = parserNew(parser, ASTNodeIf);
     node_if->cond        = parserParseExpr(parser);
     node_if->block       = parserParseBlock(parser);
     node_if->branch_ef   = NULL;
@@ -221,7 +119,7 @@ static ASTNodeEf* parserParseEf(Parser* parser) {
     ASTNodeEf* cur     = NULL;
     ASTNodeEf* create  = NULL;
     for (;;) {
-        create = (ASTNodeEf*)mem_alloc(sizeof(ASTNodeEf));
+        create = parserNew(parser, ASTNodeEf);
         create->cond  = parserParseExpr(parser);
         create->block = parserParseBlock(parser);
         create->next  = NULL;
@@ -239,14 +137,14 @@ static ASTNodeEf* parserParseEf(Parser* parser) {
 
 // parsing the else statement.
 static ASTNodeElse* parserParseElse(Parser* parser) {
-    ASTNodeElse* node_else = (ASTNodeElse*)mem_alloc(sizeof(ASTNodeElse));
+    ASTNodeElse* node_else = parserNew(parser, ASTNodeElse);
     node_else->block = parserParseBlock(parser);
     return node_else;
 }
 
 // parsing the switch statement.
 static ASTNodeSwitch* parserParseSwitch(Parser* parser) {
-    ASTNodeSwitch* node_switch = (ASTNodeSwitch*)mem_alloc(sizeof(ASTNodeSwitch));
+    ASTNodeSwitch* node_switch = parserNew(parser, ASTNodeSwitch);
     node_switch->option         = parserParseExpr(parser);
     node_switch->branch_case    = NULL;
     node_switch->branch_default = NULL;
@@ -295,7 +193,7 @@ static ASTNodeSwitch* parserParseSwitch(Parser* parser) {
 
 // parsing the case branch of the switch statement.
 static ASTNodeSwitchCase* parserParseSwitchCase(Parser* parser) {
-    ASTNodeSwitchCase* node_switch_case = (ASTNodeSwitchCase*)mem_alloc(sizeof(ASTNodeSwitchCase));
+    ASTNodeSwitchCase* node_switch_case = parserNew(parser, ASTNodeSwitchCase);
     node_switch_case->value = parserParseExpr(parser);
 
     parserGetCurToken(parser);
@@ -312,7 +210,7 @@ static ASTNodeSwitchCase* parserParseSwitchCase(Parser* parser) {
 
 // parsing the default branch of the switch statement.
 static ASTNodeSwitchDeft* parserParseSwitchDeft(Parser* parser) {
-    ASTNodeSwitchDeft* node_switch_deft = (ASTNodeSwitchDeft*)mem_alloc(sizeof(ASTNodeSwitchDeft));
+    ASTNodeSwitchDeft* node_switch_deft = parserNew(parser, ASTNodeSwitchDeft);
     node_switch_deft->block = parserParseBlock(parser);
     return node_switch_deft;
 }
@@ -325,14 +223,6 @@ static ASTNodeLoopFor* parserParseLoopFor(Parser* parser) {
     return NULL;
 }
 
-// parsing function call statement.
-static ASTNodeFuncCall* parserParseFuncCall(Parser* parser) {
-    ASTNodeFuncCall* node_func_call = (ASTNodeFuncCall*)mem_alloc(sizeof(ASTNodeFuncCall));
-    node_func_call->func_name   = parserParseID(parser);
-    node_func_call->func_params = parserParseExprList(parser);
-    return node_func_call;
-}
-
 // parsing block which represents a set of statements between
 // a couple of braces.
 static ASTNodeBlock* parserParseBlock(Parser* parser) {
@@ -345,7 +235,7 @@ static ASTNodeBlock* parserParseBlock(Parser* parser) {
     }
     lexerNextToken(parser->lexer);
 
-    ASTNodeBlock* node_block = (ASTNodeBlock*)mem_alloc(sizeof(ASTNodeBlock));
+    ASTNodeBlock* node_block = parserNew(parser, ASTNodeBlock);
     ASTNodeStmt*  stmt_cur   = NULL;
     ASTNodeStmt*  stmt_new   = NULL;
     for (;;) {
@@ -433,7 +323,7 @@ static ASTNodeBlock* parserParseBlock(Parser* parser) {
 }
 
 static ASTNodeCaseBody* parserParseCaseBody(Parser* parser) {
-    ASTNodeCaseBody* node_case_body = (ASTNodeCaseBody*)mem_alloc(sizeof(ASTNodeCaseBody));
+    ASTNodeCaseBody* node_case_body = parserNew(parser, ASTNodeCaseBody);
     ASTNodeStmt*     stmt_cur       = NULL;
     ASTNodeStmt*     stmt_new       = NULL;
 
@@ -503,7 +393,7 @@ static ASTNodeCaseBody* parserParseCaseBody(Parser* parser) {
 }
 
 static ASTNodeGlobalScope* parserParseGlobalScope(Parser* parser) {
-    ASTNodeGlobalScope* node_global_scope = (ASTNodeGlobalScope*)mem_alloc(sizeof(ASTNodeGlobalScope));
+    ASTNodeGlobalScope* node_global_scope = parserNew(parser, ASTNodeGlobalScope);
     ASTNodeStmt*        stmt_cur          = NULL;
     ASTNodeStmt*        stmt_new          = NULL;
 
@@ -536,7 +426,11 @@ static ASTNodeGlobalScope* parserParseGlobalScope(Parser* parser) {
 }
 
 void parserInit(Parser* parser) {
-
+    parser->lexer     = NULL;
+    parser->ast       = NULL;
+    parser->cur_token = NULL;
+    parser->cur_scope = NULL;
+    parser->err_count = 0;
 }
 
 error parserStart(Parser* parser, char* main_file) {
@@ -547,8 +441,10 @@ void parserDestroy(Parser* parser) {
     // compileWaitQueueDestroy(&parser->file_queue);
     // compileCacheTreeDestroy(&parser->file_cache);
 
-    if (parser->ast != NULL)
+    if (parser->ast != NULL) {
         astDestroy(parser->ast);
+        mem_free(parser->ast);
+    }
     if (parser->lexer != NULL)
         lexerDestroy(parser->lexer);
     if (parser->cur_scope != NULL)
@@ -562,4 +458,5 @@ void parserDestroy(Parser* parser) {
 }
 
 #undef parserGetCurToken
+#undef parserNew
 #undef parserCheckRetNode
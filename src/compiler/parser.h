@@ -18,6 +18,7 @@
 #include "ast.h"
 #include "expression.h"
 #include "scope.h"
+#include "arena.h"
 
 // the parser is used to parse the source code based on
 // the rules of C+ programming language syntax.
@@ -40,11 +41,8 @@ static ASTNodeModule*      parserParseModule     (Parser* parser);
 static ASTNodeBlock*       parserParseBlock      (Parser* parser);
 static ASTNodeCaseBody*    parserParseCaseBody   (Parser* parser);
 static ASTNodeGlobalScope* parserParseGlobalScope(Parser* parser);
-static ASTNodeConstLit*    parserParseConstLit   (Parser* parser);
-static ASTNodeID*          parserParseID         (Parser* parser);
 static ASTNodeExpr*        parserParseExpr       (Parser* parser);
 static ASTNodeExprList*    parserParseExprList   (Parser* parser);
-static ASTNodeIndex*       parserParseIndex      (Parser* parser);
 static ASTNodeDecl*        parserParseDecl       (Parser* parser);
 static ASTNodeAssign*      parserParseAssign     (Parser* parser);
 static ASTNodeIf*          parserParseIf         (Parser* parser);
@@ -58,7 +56,6 @@ static ASTNodeLoopWhile*   parserParseLoopWhile  (Parser* parser);
 static ASTNodeLoopInf*     parserParseLoopInf    (Parser* parser);
 static ASTNodeLoopForeach* parserParseLoopForeach(Parser* parser);
 static ASTNodeFuncDef*     parserParseFuncDef    (Parser* parser);
-static ASTNodeFuncCall*    parserParseFuncCall   (Parser* parser);
 static ASTNodeReturn*      parserParseReturn     (Parser* parser);
 static ASTNodeTypeDecl*    parserParseTypeDecl   (Parser* parser);
 static ASTNodeTypeDef*     parserParseTypeDef    (Parser* parser);
@@ -27,13 +27,13 @@ char* path_prev(const char* path, int path_len) {
     int i;
     for (i = path_len-1; i >= 0; i--) {
         if (i == 0) {
-            return path[0] == '/' ? "/" : NULL;
+            return path[0] == '/' ? mem_strdup("/") : NULL;
         }
         if (path[i] == path_separator) {
             break;
         }
     }
-    char* path_ret = (char*)mem_alloc(sizeof(char)*i);
+    char* path_ret = (char*)mem_alloc(sizeof(char)*(i+1));
     int j;
     for (j = 0; j < i; j++) {
         path_ret[j] = path[j];
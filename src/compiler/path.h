@@ -15,9 +15,9 @@
 #include "unistd.h"
 
 #ifdef PLATFORM_WINDOWS
-    const char path_separator = '\\';
+    static const char path_separator = '\\';
 #else
-    const char path_separator = '/';
+    static const char path_separator = '/';
 #endif
 
 // note:
@@ -6,38 +6,159 @@
 
 #include "project.h"
 
+static bool projectHasSuffix(const char* path, int path_len, const char* suffix) {
+    int len = strlen(suffix);
+    if (path_len > len && strncmp(path + path_len - len, suffix, len) == 0) {
+        return true;
+    }
+    return false;
+}
+
+// join the dir and the name with the path separator. the returned
+// path is allocated by mem_alloc().
+static char* projectJoinPath(const char* dir, int dir_len, const char* name) {
+    char*          path;
+    DynamicArrStr  dstr;
+    dynamicArrStrInit   (&dstr, DYNAMIC_ARR_STR_SMALL);
+    dynamicArrStrAppend (&dstr, (char*)dir, dir_len);
+    dynamicArrStrAppendc(&dstr, path_separator);
+    dynamicArrStrAppend (&dstr, (char*)name, strlen(name));
+    path = dynamicArrStrDetach(&dstr);
+    return path;
+}
+
+bool is_cplus_project(const char* path, int path_len) {
+    bool  ret;
+    char* src = projectJoinPath(path, path_len, "src");
+    ret = path_isdir(src) == NULL ? true : false;
+    mem_free(src);
+    return ret;
+}
+
+bool is_cplus_program(const char* path, int path_len) {
+    if (projectHasSuffix(path, path_len, ".prog") == true && path_isdir(path) == NULL) {
+        return true;
+    }
+    return false;
+}
+
+bool is_cplus_module(const char* path, int path_len) {
+    if (projectHasSuffix(path, path_len, ".mod") == true && path_isdir(path) == NULL) {
+        return true;
+    }
+    return false;
+}
+
+bool is_cplus_source(const char* path, int path_len) {
+    if (projectHasSuffix(path, path_len, ".cplus") == true && path_isreg(path) == NULL) {
+        return true;
+    }
+    return false;
+}
+
+// the source directory is the nearest "src" directory which contains the
+// build target, or the "src" directory in the build target if the target
+// is the project itself.
+static error projectFindSrcdir(ProjectConfig* projconf) {
+    char* path     = projconf->path_buildmod;
+    int   path_len = projconf->path_buildmod_len;
+    char* prev;
+    char* last;
+
+    if (is_cplus_project(path, path_len) == true) {
+        projconf->path_srcdir     = projectJoinPath(path, path_len, "src");
+        projconf->path_srcdir_len = strlen(projconf->path_srcdir);
+        return NULL;
+    }
+    path = mem_strdup(path);
+    for (;;) {
+        last = path_last(path, path_len);
+        if (strcmp(last, "src") == 0) {
+            mem_free(last);
+            projconf->path_srcdir     = path;
+            projconf->path_srcdir_len = path_len;
+            return NULL;
+        }
+        mem_free(last);
+        prev = path_prev(path, path_len);
+        mem_free(path);
+        if (prev == NULL || strcmp(prev, "/") == 0) {
+            mem_free(prev);
+            return new_error("the build target is not in a cplus project.");
+        }
+        path     = prev;
+        path_len = strlen(prev);
+    }
+}
+
 error projectConfigInit(ProjectConfig* projconf, char* path_compiler, char* path_buildmod) {
     char*          path;
-    int            path_len;
-    DynamicArrChar darr;
-    dynamicArrCharInit(&darr, 255);
+    char*          prev;
+    error          err;
+    DynamicArrStr  dstr;
+    dynamicArrStrInit(&dstr, DYNAMIC_ARR_STR_SMALL);
     
     projconf->path_compiler = path_compiler;
     projconf->path_compiler_len = strlen(path_compiler);
 
-    projconf->path_buildmod = path_buildmod;
+    projconf->path_buildmod = mem_strdup(path_buildmod);
     projconf->path_buildmod_len = strlen(path_buildmod);
     
     if (path_isabs(projconf->path_buildmod, projconf->path_buildmod_len) == false) {
         if ((path = getcwd(NULL, 0)) == NULL) {
+            dynamicArrStrDestroy(&dstr);
+            mem_free(projconf->path_buildmod);
+            projconf->path_buildmod = NULL;
             return new_error("get current work path failed.");
         }
-        dynamicArrCharAppend (&darr, path, strlen(path));
-        dynamicArrCharAppendc(&darr, path_separator);
-        dynamicArrCharAppend (&darr, projconf->path_buildmod, projconf->path_buildmod_len);
-        projconf->path_buildmod = dynamicArrCharGetStr(&darr);
-        projconf->path_buildmod_len = darr.used;
+        dynamicArrStrAppend (&dstr, path, strlen(path));
+        dynamicArrStrAppendc(&dstr, path_separator);
+        dynamicArrStrAppend (&dstr, projconf->path_buildmod, projconf->path_buildmod_len);
+        mem_free(projconf->path_buildmod);
+        projconf->path_buildmod_len = dstr.used;
+        projconf->path_buildmod = dynamicArrStrDetach(&dstr);
+
+        free(path); // the getcwd allocates it by the malloc
+    }
+    dynamicArrStrDestroy(&dstr);
+    while (projconf->path_buildmod_len > 1 && projconf->path_buildmod[projconf->path_buildmod_len-1] == path_separator) {
+        projconf->path_buildmod[--projconf->path_buildmod_len] = '\0';
+    }
 
+    if ((err = projectFindSrcdir(projconf)) != NULL) {
+        mem_free(projconf->path_buildmod);
+        projconf->path_buildmod = NULL;
+        return err;
+    }
+    projconf->path_project     = path_prev(projconf->path_srcdir, projconf->path_srcdir_len);
+    projconf->path_project_len = strlen(projconf->path_project);
+    projconf->path_bindir      = projectJoinPath(projconf->path_project, projconf->path_project_len, "bin");
+    projconf->path_bindir_len  = strlen(projconf->path_bindir);
+
+    // the compiler is installed as "<root>/bin/cplus" and the standard
+    // modules are in "<root>/stdmods".
+    projconf->path_stdmods     = NULL;
+    projconf->path_stdmods_len = 0;
+    if ((prev = path_prev(projconf->path_compiler, projconf->path_compiler_len)) != NULL && strcmp(prev, "/") != 0) {
+        if ((path = path_prev(prev, strlen(prev))) != NULL && strcmp(path, "/") != 0) {
+            projconf->path_stdmods     = projectJoinPath(path, strlen(path), "stdmods");
+            projconf->path_stdmods_len = strlen(projconf->path_stdmods);
+        }
         mem_free(path);
-        dynamicArrCharClear(&darr);
     }
+    mem_free(prev);
+    return NULL;
 }
 
 void projectConfigDestroy(ProjectConfig* projconf) {
-//  mem_free(projconf->path_compiler);
-//  mem_free(projconf->path_compile_obj);
-    mem_free(projconf->path_stdmod);
-//  mem_free(projconf->path_project);
-//  mem_free(projconf->path_source);
-//  mem_free(projconf->path_binary);
+    mem_free(projconf->path_buildmod);
+    mem_free(projconf->path_stdmods);
+    mem_free(projconf->path_project);
+    mem_free(projconf->path_srcdir);
+    mem_free(projconf->path_bindir);
+    projconf->path_buildmod = NULL;
+    projconf->path_stdmods  = NULL;
+    projconf->path_project  = NULL;
+    projconf->path_srcdir   = NULL;
+    projconf->path_bindir   = NULL;
 }
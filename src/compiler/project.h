@@ -15,6 +15,16 @@
 #include "dynamicarr.h"
 #include "path.h"
 
+// the structure of a cplus project:
+//
+//   project
+//    |- bin
+//    |- src
+//        |- net.mod        -> a module named "net"
+//        |   |- http.mod   -> a module named "net/http"
+//        |- hello.prog     -> a program which can be built as an executable file
+//            |- main.cplus -> a source file
+//
 // The ProjectConfig is used to save some information about the project.
 //
 typedef struct {
@@ -46,4 +56,10 @@ typedef struct {
 extern error projectConfigInit   (ProjectConfig* projconf, char* path_compiler, char* path_buildmod);
 extern void  projectConfigDestroy(ProjectConfig* projconf);
 
+// check the kind of the path based on its suffix and the file type.
+extern bool  is_cplus_project(const char* path, int path_len);
+extern bool  is_cplus_program(const char* path, int path_len);
+extern bool  is_cplus_module (const char* path, int path_len);
+extern bool  is_cplus_source (const char* path, int path_len);
+
 #endif
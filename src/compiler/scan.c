@@ -0,0 +1,243 @@
+/**
+ * Copyright 2015 JiKai. All rights reserved.
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file.
+ **/
+
+#include "scan.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SCAN_X86
+#include <immintrin.h>
+#endif
+
+#define scanIsBlank(ch) ((ch) == ' ' || (ch) == '\t')
+#define scanIsIdent(ch) (('a' <= (ch) && (ch) <= 'z') || ('A' <= (ch) && (ch) <= 'Z') || ('0' <= (ch) && (ch) <= '9') || (ch) == '_')
+
+/****** scalar scanners ******/
+
+static char* scanSkipBlankScalar(char* p, char* end) {
+    while (p < end && scanIsBlank(*p)) p++;
+    return p;
+}
+
+static char* scanIdentEndScalar(char* p, char* end) {
+    while (p < end && scanIsIdent(*p)) p++;
+    return p;
+}
+
+static char* scanFindLineEndScalar(char* p, char* end) {
+    while (p < end && *p != '\r' && *p != '\n') p++;
+    return p;
+}
+
+static char* scanFindCmtMarkScalar(char* p, char* end) {
+    while (p < end && *p != '*' && *p != '/' && *p != '\n') p++;
+    return p;
+}
+
+static char* scanFindQuoteScalar(char* p, char* end) {
+    while (p < end && *p != '"') p++;
+    return p;
+}
+
+#ifdef SCAN_X86
+
+/****** SSE2 scanners ******/
+
+// every scanner computes a mask in which the bit i is set if the byte i
+// is the byte searching, so the index of the lowest set bit is the answer.
+
+static uint32 scanMaskBlankSSE2(__m128i v) {
+    __m128i m = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t')));
+    return ~(uint32)_mm_movemask_epi8(m) & 0xFFFF;
+}
+
+// the bytes larger than 0x7F are negative as signed chars, so they are never
+// in the ranges and are not parts of identifiers.
+static uint32 scanMaskIdentSSE2(__m128i v) {
+    __m128i lower = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('a'-1)), _mm_cmpgt_epi8(_mm_set1_epi8('z'+1), v));
+    __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('A'-1)), _mm_cmpgt_epi8(_mm_set1_epi8('Z'+1), v));
+    __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0'-1)), _mm_cmpgt_epi8(_mm_set1_epi8('9'+1), v));
+    __m128i under = _mm_cmpeq_epi8(v, _mm_set1_epi8('_'));
+    __m128i m     = _mm_or_si128(_mm_or_si128(lower, upper), _mm_or_si128(digit, under));
+    return ~(uint32)_mm_movemask_epi8(m) & 0xFFFF;
+}
+
+static uint32 scanMaskLineEndSSE2(__m128i v) {
+    __m128i m = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\r')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\n')));
+    return (uint32)_mm_movemask_epi8(m);
+}
+
+static uint32 scanMaskCmtMarkSSE2(__m128i v) {
+    __m128i m = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('*')), _mm_cmpeq_epi8(v, _mm_set1_epi8('/')));
+    m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8('\n')));
+    return (uint32)_mm_movemask_epi8(m);
+}
+
+static uint32 scanMaskQuoteSSE2(__m128i v) {
+    return (uint32)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')));
+}
+
+#define SCAN_DEFINE_SSE2(name, maskfn, scalarfn)             \
+static char* name(char* p, char* end) {                      \
+    while (p + 16 <= end) {                                  \
+        uint32 mask = maskfn(_mm_loadu_si128((__m128i*)p));  \
+        if (mask != 0) {                                     \
+            return p + __builtin_ctz(mask);                  \
+        }                                                    \
+        p += 16;                                             \
+    }                                                        \
+    return scalarfn(p, end);                                 \
+}
+
+SCAN_DEFINE_SSE2(scanSkipBlankSSE2  , scanMaskBlankSSE2  , scanSkipBlankScalar  )
+SCAN_DEFINE_SSE2(scanIdentEndSSE2   , scanMaskIdentSSE2  , scanIdentEndScalar   )
+SCAN_DEFINE_SSE2(scanFindLineEndSSE2, scanMaskLineEndSSE2, scanFindLineEndScalar)
+SCAN_DEFINE_SSE2(scanFindCmtMarkSSE2, scanMaskCmtMarkSSE2, scanFindCmtMarkScalar)
+SCAN_DEFINE_SSE2(scanFindQuoteSSE2  , scanMaskQuoteSSE2  , scanFindQuoteScalar  )
+
+/****** AVX2 scanners ******/
+
+// the AVX2 functions are compiled with the target attribute, so the whole
+// program can still run on the CPU without AVX2.
+#define SCAN_AVX2 __attribute__((target("avx2")))
+
+SCAN_AVX2 static uint32 scanMaskBlankAVX2(__m256i v) {
+    __m256i m = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t')));
+    return ~(uint32)_mm256_movemask_epi8(m);
+}
+
+SCAN_AVX2 static uint32 scanMaskIdentAVX2(__m256i v) {
+    __m256i lower = _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('a'-1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('z'+1), v));
+    __m256i upper = _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('A'-1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('Z'+1), v));
+    __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('0'-1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('9'+1), v));
+    __m256i under = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_'));
+    __m256i m     = _mm256_or_si256(_mm256_or_si256(lower, upper), _mm256_or_si256(digit, under));
+    return ~(uint32)_mm256_movemask_epi8(m);
+}
+
+SCAN_AVX2 static uint32 scanMaskLineEndAVX2(__m256i v) {
+    __m256i m = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')));
+    return (uint32)_mm256_movemask_epi8(m);
+}
+
+SCAN_AVX2 static uint32 scanMaskCmtMarkAVX2(__m256i v) {
+    __m256i m = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('*')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('/')));
+    m = _mm256_or_si256(m, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')));
+    return (uint32)_mm256_movemask_epi8(m);
+}
+
+SCAN_AVX2 static uint32 scanMaskQuoteAVX2(__m256i v) {
+    return (uint32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')));
+}
+
+#define SCAN_DEFINE_AVX2(name, maskfn, tailfn)                        \
+SCAN_AVX2 static char* name(char* p, char* end) {                     \
+    while (p + 32 <= end) {                                           \
+        uint32 mask = maskfn(_mm256_loadu_si256((__m256i*)p));        \
+        if (mask != 0) {                                              \
+            return p + __builtin_ctz(mask);                           \
+        }                                                             \
+        p += 32;                                                      \
+    }                                                                 \
+    return tailfn(p, end);                                            \
+}
+
+SCAN_DEFINE_AVX2(scanSkipBlankAVX2  , scanMaskBlankAVX2  , scanSkipBlankSSE2  )
+SCAN_DEFINE_AVX2(scanIdentEndAVX2   , scanMaskIdentAVX2  , scanIdentEndSSE2   )
+SCAN_DEFINE_AVX2(scanFindLineEndAVX2, scanMaskLineEndAVX2, scanFindLineEndSSE2)
+SCAN_DEFINE_AVX2(scanFindCmtMarkAVX2, scanMaskCmtMarkAVX2, scanFindCmtMarkSSE2)
+SCAN_DEFINE_AVX2(scanFindQuoteAVX2  , scanMaskQuoteAVX2  , scanFindQuoteSSE2  )
+
+#endif
+
+/****** dispatching ******/
+
+typedef char* (*ScanFunc)(char* p, char* end);
+
+// the scanners now using. they are the scalar versions until the
+// scanInit() selects the better ones.
+static int8     scan_impl          = SCAN_IMPL_SCALAR;
+static ScanFunc scan_skip_blank    = scanSkipBlankScalar;
+static ScanFunc scan_ident_end     = scanIdentEndScalar;
+static ScanFunc scan_find_line_end = scanFindLineEndScalar;
+static ScanFunc scan_find_cmt_mark = scanFindCmtMarkScalar;
+static ScanFunc scan_find_quote    = scanFindQuoteScalar;
+
+// select the scanners based on the CPU features. the environment variable
+// CPLUS_SCAN=scalar|sse2|avx2 can lower the selection to compare them.
+static void scanSelect() {
+#ifdef SCAN_X86
+    int8  impl = SCAN_IMPL_SSE2;
+    char* force;
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        impl = SCAN_IMPL_AVX2;
+    }
+    if ((force = getenv("CPLUS_SCAN")) != NULL) {
+        if (strcmp(force, "scalar") == 0) {
+            impl = SCAN_IMPL_SCALAR;
+        }
+        else if (strcmp(force, "sse2") == 0) {
+            impl = SCAN_IMPL_SSE2;
+        }
+    }
+    switch (impl) {
+    case SCAN_IMPL_AVX2:
+        scan_skip_blank    = scanSkipBlankAVX2;
+        scan_ident_end     = scanIdentEndAVX2;
+        scan_find_line_end = scanFindLineEndAVX2;
+        scan_find_cmt_mark = scanFindCmtMarkAVX2;
+        scan_find_quote    = scanFindQuoteAVX2;
+        break;
+    case SCAN_IMPL_SSE2:
+        scan_skip_blank    = scanSkipBlankSSE2;
+        scan_ident_end     = scanIdentEndSSE2;
+        scan_find_line_end = scanFindLineEndSSE2;
+        scan_find_cmt_mark = scanFindCmtMarkSSE2;
+        scan_find_quote    = scanFindQuoteSSE2;
+        break;
+    default:
+        scan_skip_blank    = scanSkipBlankScalar;
+        scan_ident_end     = scanIdentEndScalar;
+        scan_find_line_end = scanFindLineEndScalar;
+        scan_find_cmt_mark = scanFindCmtMarkScalar;
+        scan_find_quote    = scanFindQuoteScalar;
+        break;
+    }
+    scan_impl = impl;
+#endif
+}
+
+// every lexer calls scanInit(), and the lexers may be initialized by several
+// threads at the same time, so the selection is only done once.
+static pthread_once_t scan_once = PTHREAD_ONCE_INIT;
+
+void scanInit() {
+    pthread_once(&scan_once, scanSelect);
+}
+
+int8 scanImpl() {
+    return scan_impl;
+}
+
+char* scanSkipBlank(char* p, char* end) {
+    return scan_skip_blank(p, end);
+}
+
+char* scanIdentEnd(char* p, char* end) {
+    return scan_ident_end(p, end);
+}
+
+char* scanFindLineEnd(char* p, char* end) {
+    return scan_find_line_end(p, end);
+}
+
+char* scanFindCmtMark(char* p, char* end) {
+    return scan_find_cmt_mark(p, end);
+}
+
+char* scanFindQuote(char* p, char* end) {
+    return scan_find_quote(p, end);
+}
@@ -0,0 +1,44 @@
+/**
+ * Copyright 2015 JiKai. All rights reserved.
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file.
+ *
+ *     The scan.h and scan.c provide the scanners used by
+ * the lexer to skip a run of bytes in a contiguous buffer.
+ * they are vectorized with SSE2 or AVX2 and the best one
+ * is selected at runtime by CPUID. the scalar versions are
+ * used on other platforms.
+ **/
+
+#ifndef CPLUS_SCAN_H
+#define CPLUS_SCAN_H
+
+#include <pthread.h>
+#include "common.h"
+
+// all scanners search the bytes in [p, end) and return the pointer to the
+// first byte found, or end if no such byte exists. they never read the
+// bytes at or after the end.
+//
+//   scanSkipBlank  : the first byte which is not ' ' or '\t'.
+//   scanIdentEnd   : the first byte which is not in [A-Za-z0-9_].
+//   scanFindLineEnd: the first '\r' or '\n'. (the end of single line comment)
+//   scanFindCmtMark: the first '*', '/' or '\n'. (the candidates of '*' '/', '/' '*'
+//                    and the line-feed inside the multiple line comment)
+//   scanFindQuote  : the first '"'. (the end of string literal)
+//
+extern void  scanInit       ();
+extern char* scanSkipBlank  (char* p, char* end);
+extern char* scanIdentEnd   (char* p, char* end);
+extern char* scanFindLineEnd(char* p, char* end);
+extern char* scanFindCmtMark(char* p, char* end);
+extern char* scanFindQuote  (char* p, char* end);
+
+#define SCAN_IMPL_SCALAR 0x00
+#define SCAN_IMPL_SSE2   0x01
+#define SCAN_IMPL_AVX2   0x02
+
+// return the implementation selected by scanInit().
+extern int8 scanImpl();
+
+#endif
@@ -6,27 +6,83 @@
 
 #include "scope.h"
 
+static ScopeStats scope_stats = {0, 0, 0, 0, 0};
+
+#define scopeBloomBit1(hash) ((hash) % SCOPE_BLOOM_BITS)
+#define scopeBloomBit2(hash) (((hash) >> 16) % SCOPE_BLOOM_BITS)
+
+static void scopeBloomAdd(Scope* scope, uint32 hash) {
+    uint32 bit1 = scopeBloomBit1(hash);
+    uint32 bit2 = scopeBloomBit2(hash);
+    scope->bloom[bit1 >> 6] |= (uint64)1 << (bit1 & 63);
+    scope->bloom[bit2 >> 6] |= (uint64)1 << (bit2 & 63);
+}
+
+// return:
+//   true  -> the identifier may be in the scope.
+//   false -> the identifier is not in the scope absolutely.
+static bool scopeBloomMayHave(Scope* scope, uint32 hash) {
+    uint32 bit1 = scopeBloomBit1(hash);
+    uint32 bit2 = scopeBloomBit2(hash);
+    if ((scope->bloom[bit1 >> 6] & ((uint64)1 << (bit1 & 63))) == 0 ||
+        (scope->bloom[bit2 >> 6] & ((uint64)1 << (bit2 & 63))) == 0) {
+        return false;
+    }
+    return true;
+}
+
 void scopeInit(Scope* scope, Scope* outer) {
     identTableInit(&scope->id_table);
+    memset(scope->bloom, 0, sizeof(scope->bloom));
     scope->outer = outer;
 }
 
 error scopeAddID(Scope* scope, Ident* id) {
-    return identTableAdd(&scope->id_table, id);
+    error err = identTableAdd(&scope->id_table, id);
+    if (err == NULL) {
+        scopeBloomAdd(scope, internHash(id->id_name));
+    }
+    return err;
 }
 
-// search an identifier from the outermost scope to the innermost
+// the scope_stats is shared by the whole process, so the counts of one
+// search are kept in the locals and added by the atomic adds at its end.
+static void scopeStatsCount(uint64 levels, uint64 bloom_skips, uint64 table_hits, uint64 table_misses) {
+    __atomic_add_fetch(&scope_stats.searches,     1,            __ATOMIC_RELAXED);
+    __atomic_add_fetch(&scope_stats.levels,       levels,       __ATOMIC_RELAXED);
+    __atomic_add_fetch(&scope_stats.bloom_skips,  bloom_skips,  __ATOMIC_RELAXED);
+    __atomic_add_fetch(&scope_stats.table_hits,   table_hits,   __ATOMIC_RELAXED);
+    __atomic_add_fetch(&scope_stats.table_misses, table_misses, __ATOMIC_RELAXED);
+}
+
+// search an identifier from the innermost scope to the outermost
 // scope. return NULL if the identify is not in all scopes.
 Ident* scopeSearchID(Scope* scope, char* id_name) {
     Ident* id;
-    Scope* ptr = scope;
+    Scope* ptr    = scope;
+    uint32 hash   = internHash(id_name);
+    uint64 levels = 0, bloom_skips = 0, table_misses = 0;
+
+    // the anonymous identifier is never added but always found.
+    if (internLen(id_name) == 1 && id_name[0] == '_') {
+        return identTableSearch(&scope->id_table, id_name);
+    }
     for (;;) {
-        id = identTableSearch(&ptr->id_table, id_name);
-        if (id != NULL) {
-            return id;
+        levels++;
+        if (scopeBloomMayHave(ptr, hash) == false) {
+            bloom_skips++;
+        }
+        else {
+            id = identTableSearch(&ptr->id_table, id_name);
+            if (id != NULL) {
+                scopeStatsCount(levels, bloom_skips, 1, table_misses);
+                return id;
+            }
+            table_misses++;
         }
         ptr = ptr->outer;
         if (ptr == NULL) {
+            scopeStatsCount(levels, bloom_skips, 0, table_misses);
             return NULL;
         }
     }
@@ -34,5 +90,22 @@ Ident* scopeSearchID(Scope* scope, char* id_name) {
 
 void scopeDestroy(Scope* scope) {
     identTableDestroy(&scope->id_table);
+    memset(scope->bloom, 0, sizeof(scope->bloom));
     scope->outer = NULL;
 }
+
+void scopeStatsGet(ScopeStats* stats) {
+    stats->searches     = __atomic_load_n(&scope_stats.searches,     __ATOMIC_RELAXED);
+    stats->levels       = __atomic_load_n(&scope_stats.levels,       __ATOMIC_RELAXED);
+    stats->bloom_skips  = __atomic_load_n(&scope_stats.bloom_skips,  __ATOMIC_RELAXED);
+    stats->table_hits   = __atomic_load_n(&scope_stats.table_hits,   __ATOMIC_RELAXED);
+    stats->table_misses = __atomic_load_n(&scope_stats.table_misses, __ATOMIC_RELAXED);
+}
+
+void scopeStatsReset() {
+    __atomic_store_n(&scope_stats.searches,     0, __ATOMIC_RELAXED);
+    __atomic_store_n(&scope_stats.levels,       0, __ATOMIC_RELAXED);
+    __atomic_store_n(&scope_stats.bloom_skips,  0, __ATOMIC_RELAXED);
+    __atomic_store_n(&scope_stats.table_hits,   0, __ATOMIC_RELAXED);
+    __atomic_store_n(&scope_stats.table_misses, 0, __ATOMIC_RELAXED);
+}
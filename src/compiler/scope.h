@@ -13,15 +13,43 @@
 #include "common.h"
 #include "ident.h"
 
+// the bloom filter of a scope has SCOPE_BLOOM_WORDS*64 bits. two bits
+// are set for each identifier, they are taken from the hash value of
+// the interned name so nothing is hashed again.
+#define SCOPE_BLOOM_WORDS 4
+#define SCOPE_BLOOM_BITS  (SCOPE_BLOOM_WORDS * 64)
+
 // a scope saves a set of named object and manages their lifecycle.
+//
+// the bloom records which names may be in the id_table. most searches
+// miss the inner scopes, so a search can skip a scope without touching
+// its table when one of the two bits is not set.
 typedef struct Scope {
-    IdentTable id_table;
+    IdentTable    id_table;
+    uint64        bloom[SCOPE_BLOOM_WORDS];
     struct Scope* outer;
 }Scope;
 
-extern void   scopeInit    (Scope* scope, Scope* outer);
-extern error  scopeAddID   (Scope* scope, Ident* id);
-extern Ident* scopeSearchID(Scope* scope, char*  id_name);
-extern void   scopeDestroy (Scope* scope);
+// ScopeStats counts how the scopes are visited by scopeSearchID.
+//   searches     -> the number of the searches, except the ones of "_".
+//   levels       -> the number of the scopes visited.
+//   bloom_skips  -> the scopes skipped by the bloom filters.
+//   table_hits   -> the table searches which found the identifier.
+//   table_misses -> the table searches passed the bloom filter but
+//                   failed, namely the false positives.
+typedef struct ScopeStats {
+    uint64 searches;
+    uint64 levels;
+    uint64 bloom_skips;
+    uint64 table_hits;
+    uint64 table_misses;
+}ScopeStats;
+
+extern void   scopeInit      (Scope* scope, Scope* outer);
+extern error  scopeAddID     (Scope* scope, Ident* id);
+extern Ident* scopeSearchID  (Scope* scope, char*  id_name);
+extern void   scopeDestroy   (Scope* scope);
+extern void   scopeStatsGet  (ScopeStats* stats);
+extern void   scopeStatsReset();
 
 #endif
@@ -0,0 +1,456 @@
+/**
+ * Copyright 2015 JiKai. All rights reserved.
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file.
+ **/
+
+#include "server.h"
+
+#define SERVER_WATCH_MASK (IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | IN_CREATE | IN_DELETE | \
+                           IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR)
+#define SERVER_EVENT_SIZE 65536
+
+// example:
+//    the project "/home/user/project" will return "/home/user/project/bin/.cplusserve".
+char* serverDefaultSocket(const ProjectConfig* projconf) {
+    char*          path;
+    DynamicArrStr  dstr;
+    dynamicArrStrInit   (&dstr, DYNAMIC_ARR_STR_SMALL);
+    dynamicArrStrAppend (&dstr, projconf->path_bindir, projconf->path_bindir_len);
+    dynamicArrStrAppendc(&dstr, '/');
+    dynamicArrStrAppend (&dstr, SERVER_SOCKET_NAME, strlen(SERVER_SOCKET_NAME));
+    path = dynamicArrStrDetach(&dstr);
+    return path;
+}
+
+static error serverSocketAddr(char* socket_path, struct sockaddr_un* addr) {
+    if (strlen(socket_path) >= sizeof(addr->sun_path)) {
+        return new_error("the path of the socket is too long.");
+    }
+    memset(addr, 0, sizeof(struct sockaddr_un));
+    addr->sun_family = AF_UNIX;
+    strcpy(addr->sun_path, socket_path);
+    return NULL;
+}
+
+/****** watching ******/
+
+// watch the directory and all directories in it. the directories which can
+// not be watched are skipped.
+static void serverWatchDir(Server* server, char* path) {
+    DIR*           dir;
+    struct dirent* entry;
+    char*          sub;
+    int            wd;
+    int32          i;
+
+    if ((wd = inotify_add_watch(server->inotify_fd, path, SERVER_WATCH_MASK)) < 0) {
+        return;
+    }
+    // the same directory may be watched again after it is moved.
+    for (i = 0; i < server->watch_count && server->watches[i].wd != wd; i++);
+    if (i == server->watch_count) {
+        if (server->watch_count == server->watch_cap) {
+            server->watch_cap = server->watch_cap == 0 ? 64 : server->watch_cap * 2;
+            server->watches   = (ServerWatch*)mem_realloc(server->watches, sizeof(ServerWatch) * server->watch_cap);
+        }
+        server->watches[server->watch_count].wd   = wd;
+        server->watches[server->watch_count].path = mem_strdup(path);
+        server->watch_count++;
+    }
+    else {
+        mem_free(server->watches[i].path);
+        server->watches[i].path = mem_strdup(path);
+    }
+
+    if ((dir = opendir(path)) == NULL) {
+        return;
+    }
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_type != DT_DIR || strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+            continue;
+        }
+        sub = (char*)mem_alloc(strlen(path) + strlen(entry->d_name) + 2);
+        sprintf(sub, "%s/%s", path, entry->d_name);
+        serverWatchDir(server, sub);
+        mem_free(sub);
+    }
+    closedir(dir);
+}
+
+static char* serverWatchPath(Server* server, int wd) {
+    int32 i;
+    for (i = 0; i < server->watch_count; i++) {
+        if (server->watches[i].wd == wd) {
+            return server->watches[i].path;
+        }
+    }
+    return NULL;
+}
+
+static void serverAddDirty(Server* server, char* path) {
+    int32 i;
+    for (i = 0; i < server->dirty_count; i++) {
+        if (strcmp(server->dirty[i], path) == 0) {
+            return;
+        }
+    }
+    if (server->dirty_count == server->dirty_cap) {
+        server->dirty_cap = server->dirty_cap == 0 ? 16 : server->dirty_cap * 2;
+        server->dirty     = (char**)mem_realloc(server->dirty, sizeof(char*) * server->dirty_cap);
+    }
+    server->dirty[server->dirty_count++] = mem_strdup(path);
+}
+
+// the interface files are written by the builds themselves, so they do not
+// make the modules dirty.
+static bool serverIsOwnFile(char* name) {
+    return strncmp(name, IFACE_FILE_NAME, strlen(IFACE_FILE_NAME)) == 0 ? true : false;
+}
+
+static void serverReadEvents(Server* server) {
+    char                        buff[SERVER_EVENT_SIZE] __attribute__((aligned(__alignof__(struct inotify_event))));
+    const struct inotify_event* event;
+    char*                       path;
+    char*                       sub;
+    int64                       len;
+    int64                       off;
+
+    while ((len = read(server->inotify_fd, buff, sizeof(buff))) > 0) {
+        for (off = 0; off < len; off += sizeof(struct inotify_event) + event->len) {
+            event = (const struct inotify_event*)(buff + off);
+            if ((event->mask & IN_Q_OVERFLOW) != 0) {
+                server->dirty_all = true;
+                continue;
+            }
+            if (event->len > 0 && serverIsOwnFile((char*)event->name) == true) {
+                continue;
+            }
+            if ((event->mask & (IN_ISDIR | IN_DELETE_SELF | IN_MOVE_SELF)) != 0) {
+                server->dirty_all = true;
+                if ((event->mask & (IN_CREATE | IN_MOVED_TO)) != 0 && (path = serverWatchPath(server, event->wd)) != NULL) {
+                    sub = (char*)mem_alloc(strlen(path) + event->len + 2);
+                    sprintf(sub, "%s/%s", path, event->name);
+                    serverWatchDir(server, sub);
+                    mem_free(sub);
+                }
+                continue;
+            }
+            if ((path = serverWatchPath(server, event->wd)) != NULL) {
+                serverAddDirty(server, path);
+            }
+        }
+    }
+}
+
+typedef struct ServerSweep {
+    Server*  server;
+    Module** kept;
+    int32    kept_count;
+    int32    kept_cap;
+}ServerSweep;
+
+static void serverSweepModule(Module* mod, void* arg) {
+    ServerSweep* sweep  = (ServerSweep*)arg;
+    Server*      server = sweep->server;
+    int32        i;
+    for (i = 0; i < server->dirty_count; i++) {
+        if (strcmp(server->dirty[i], mod->mod_path) == 0) {
+            moduleDestroy(mod);
+            return;
+        }
+    }
+    if (sweep->kept_count == sweep->kept_cap) {
+        sweep->kept_cap = sweep->kept_cap == 0 ? 16 : sweep->kept_cap * 2;
+        sweep->kept     = (Module**)mem_realloc(sweep->kept, sizeof(Module*) * sweep->kept_cap);
+    }
+    sweep->kept[sweep->kept_count++] = mod;
+}
+
+// drop the modules changed since the last build from the warm table. the
+// modules including them are kept, they are linked to the new ones by the
+// next build.
+static void serverInvalidate(Server* server) {
+    ServerSweep sweep;
+    int32       i;
+
+    serverReadEvents(server);
+    if (server->dirty_all == true) {
+        moduleCacheTableDestroy(&server->warm);
+    }
+    else if (server->dirty_count > 0) {
+        sweep.server     = server;
+        sweep.kept       = NULL;
+        sweep.kept_count = 0;
+        sweep.kept_cap   = 0;
+        moduleCacheTableWalk (&server->warm, serverSweepModule, &sweep);
+        moduleCacheTableClear(&server->warm);
+        for (i = 0; i < sweep.kept_count; i++) {
+            moduleCacheTableAdd(&server->warm, sweep.kept[i]);
+        }
+        mem_free(sweep.kept);
+    }
+    for (i = 0; i < server->dirty_count; i++) {
+        mem_free(server->dirty[i]);
+    }
+    server->dirty_count = 0;
+    server->dirty_all   = false;
+}
+
+/****** serving ******/
+
+error serverInit(Server* server, ProjectConfig* projconf, char* socket_path, int32 jobs) {
+    struct sockaddr_un addr;
+    struct stat        st;
+    error              err;
+    int                fd;
+
+    if ((err = serverSocketAddr(socket_path, &addr)) != NULL) {
+        return err;
+    }
+    if ((fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)) < 0) {
+        return new_error("can not create the socket.");
+    }
+    // only a socket left by a server not running any more is removed, the
+    // other files on the path are never touched.
+    if (lstat(socket_path, &st) == 0) {
+        if (S_ISSOCK(st.st_mode) == 0) {
+            close(fd);
+            return new_error("the path of the socket is not a socket.");
+        }
+        if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) == 0) {
+            close(fd);
+            return new_error("the other server is running on the socket.");
+        }
+        if (errno != ECONNREFUSED) {
+            close(fd);
+            return new_error("can not check the socket left on the path.");
+        }
+        unlink(socket_path);
+    }
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, 16) != 0) {
+        close(fd);
+        return new_error("can not listen on the socket.");
+    }
+    if ((server->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) < 0) {
+        close(fd);
+        unlink(socket_path);
+        return new_error("can not watch the source directories.");
+    }
+    // the clients may go away before they read the answers.
+    signal(SIGPIPE, SIG_IGN);
+
+    server->project_config = projconf;
+    server->socket_path    = mem_strdup(socket_path);
+    server->jobs           = jobs;
+    server->listen_fd      = fd;
+    server->watches        = NULL;
+    server->watch_count    = 0;
+    server->watch_cap      = 0;
+    server->dirty          = NULL;
+    server->dirty_count    = 0;
+    server->dirty_cap      = 0;
+    server->dirty_all      = false;
+    server->stopping       = false;
+    server->builds         = 0;
+    moduleCacheTableInit(&server->warm);
+    serverWatchDir(server, projconf->path_srcdir);
+    if (projconf->path_stdmods != NULL) {
+        serverWatchDir(server, projconf->path_stdmods);
+    }
+    return NULL;
+}
+
+static error serverBuild(Server* server, int32 jobs, bool graph, char* path, FILE* out) {
+    ProjectConfig projconf;
+    Compiler      compiler;
+    error         err;
+    int64         begin;
+
+    if ((err = projectConfigInit(&projconf, server->project_config->path_compiler, path)) != NULL) {
+        return err;
+    }
+    if (strcmp(projconf.path_srcdir, server->project_config->path_srcdir) != 0) {
+        projectConfigDestroy(&projconf);
+        return new_error("the build target is not in the project served.");
+    }
+    serverInvalidate(server);
+    compilerInit(&compiler, &projconf);
+    compiler.jobs = jobs > 0 ? jobs : server->jobs;
+    compiler.warm = &server->warm;
+    begin = modGraphNow();
+    err   = compilerBuild(&compiler);
+    if (graph == true) {
+        compilerDumpGraph(&compiler, out);
+    }
+    fprintf(out, "built %d modules in %.3fms, %d parsed, %d rebuilt\r\n", compiler.mods_total,
+        (modGraphNow() - begin) / 1e6, compiler.mods_parsed, compiler.mods_rebuilt);
+    compilerDestroy(&compiler);
+    projectConfigDestroy(&projconf);
+    server->builds++;
+    return err;
+}
+
+// read the request from the connection and answer it.
+static void serverHandle(Server* server, int conn) {
+    FILE*          in;
+    FILE*          out;
+    char*          line = NULL;
+    size_t         cap  = 0;
+    int64          len;
+    int            jobs, graph, offset;
+    error          err;
+    struct timeval timeout;
+
+    // the socket is blocking, so the reading and the writing are limited
+    // to keep the server from waiting for a client forever.
+    timeout.tv_sec  = SERVER_REQUEST_TIMEOUT;
+    timeout.tv_usec = 0;
+    setsockopt(conn, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(conn, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    if ((in = fdopen(dup(conn), "r")) == NULL) {
+        return;
+    }
+    if ((out = fdopen(dup(conn), "w")) == NULL) {
+        fclose(in);
+        return;
+    }
+    if ((len = getline(&line, &cap, in)) <= 0) {
+        err = new_error("the request is empty.");
+    }
+    else if (line[len-1] != '\n') {
+        err = new_error("the request line is not finished in time.");
+    }
+    else {
+        while (len > 0 && (line[len-1] == '\n' || line[len-1] == '\r')) {
+            line[--len] = '\0';
+        }
+        if (strcmp(line, "stop") == 0) {
+            server->stopping = true;
+            err = NULL;
+        }
+        else if (sscanf(line, "build %d %d %n", &jobs, &graph, &offset) == 2 && line[offset] == '/') {
+            err = serverBuild(server, jobs, graph == 1 ? true : false, line + offset, out);
+        }
+        else {
+            err = new_error("unknown request.");
+        }
+    }
+    err == NULL ? fprintf(out, "ok\n") : fprintf(out, "error: %s\n", err);
+    free(line);
+    fclose(out);
+    fclose(in);
+}
+
+// serve the requests until the stop request. the events of the source
+// directories are read while the server is idle, so the queue of the
+// events does not overflow.
+error serverRun(Server* server) {
+    struct pollfd fds[2];
+    int           conn;
+
+    while (server->stopping == false) {
+        fds[0].fd     = server->listen_fd;
+        fds[0].events = POLLIN;
+        fds[1].fd     = server->inotify_fd;
+        fds[1].events = POLLIN;
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return new_error("can not wait for the requests.");
+        }
+        if ((fds[1].revents & POLLIN) != 0) {
+            serverReadEvents(server);
+        }
+        if ((fds[0].revents & POLLIN) != 0) {
+            if ((conn = accept(server->listen_fd, NULL, NULL)) < 0) {
+                continue;
+            }
+            serverHandle(server, conn);
+            close(conn);
+        }
+    }
+    return NULL;
+}
+
+void serverDestroy(Server* server) {
+    int32 i;
+    close(server->listen_fd);
+    close(server->inotify_fd);
+    unlink(server->socket_path);
+    for (i = 0; i < server->watch_count; i++) {
+        mem_free(server->watches[i].path);
+    }
+    for (i = 0; i < server->dirty_count; i++) {
+        mem_free(server->dirty[i]);
+    }
+    mem_free(server->watches);
+    mem_free(server->dirty);
+    mem_free(server->socket_path);
+    moduleCacheTableDestroy(&server->warm);
+    server->watches     = NULL;
+    server->dirty       = NULL;
+    server->socket_path = NULL;
+    internDestroy();
+}
+
+/****** requesting ******/
+
+// send the request to the server and copy the answer to the out. return
+// the error answered by the server.
+error serverRequest(char* socket_path, char* request, FILE* out) {
+    struct sockaddr_un addr;
+    FILE*              in;
+    char*              line = NULL;
+    char*              prev = NULL;
+    size_t             cap  = 0;
+    ssize_t            len = (ssize_t)strlen(request);
+    error              err;
+    int                fd;
+
+    if ((err = serverSocketAddr(socket_path, &addr)) != NULL) {
+        return err;
+    }
+    if ((fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)) < 0) {
+        return new_error("can not create the socket.");
+    }
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return new_error("the server is not running.");
+    }
+    if (write(fd, request, len) != len || write(fd, "\n", 1) != 1) {
+        close(fd);
+        return new_error("can not send the request.");
+    }
+    shutdown(fd, SHUT_WR);
+    if ((in = fdopen(fd, "r")) == NULL) {
+        close(fd);
+        return new_error("can not read the answer.");
+    }
+    // every line but the last one is the output of the build.
+    while (getline(&line, &cap, in) > 0) {
+        if (prev != NULL) {
+            fputs(prev, out);
+            mem_free(prev);
+        }
+        prev = mem_strdup(line);
+    }
+    free(line);
+    fclose(in);
+    if (prev == NULL) {
+        return new_error("the server closed the connection.");
+    }
+    if (strncmp(prev, "ok", 2) == 0) {
+        err = NULL;
+    }
+    else if (strncmp(prev, "error: ", 7) == 0) {
+        prev[strcspn(prev, "\r\n")] = '\0';
+        err = mem_strdup(prev + 7);
+    }
+    else {
+        err = new_error("the answer of the server is broken.");
+    }
+    mem_free(prev);
+    return err;
+}
@@ -0,0 +1,80 @@
+/**
+ * Copyright 2015 JiKai. All rights reserved.
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file.
+ *
+ *     The server.h and server.c implement the compile server.
+ * the server keeps the modules parsed in the memory between the
+ * builds and watches the source directories to drop the modules
+ * changed. the builds are requested over a unix socket.
+ **/
+
+#ifndef CPLUS_SERVER_H
+#define CPLUS_SERVER_H
+
+#include <poll.h>
+#include <signal.h>
+#include <dirent.h>
+#include <sys/inotify.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include "common.h"
+#include "project.h"
+#include "module.h"
+#include "compiler.h"
+#include "iface.h"
+
+// the protocol is line based. the client sends one request line:
+//
+//   build <jobs> <graph> <path> -> build the target at the absolute path, the
+//                                  jobs 0 means the jobs of the server and the
+//                                  graph 1 means dumping the module graph
+//   stop                        -> stop the server
+//
+// the server answers with the output of the build, and the last line is
+// "ok" or "error: <message>". the connection is closed after the answer.
+// the requests are served one by one, so the client which does not send
+// the whole request line in SERVER_REQUEST_TIMEOUT seconds is answered
+// with an error, and the server goes on with the next one.
+//
+#define SERVER_SOCKET_NAME     ".cplusserve"
+#define SERVER_REQUEST_TIMEOUT 2
+
+typedef struct ServerWatch {
+    int   wd;
+    char* path;
+}ServerWatch;
+
+// the modules are dropped from the warm table when their directories are
+// changed. if the events are lost, or the directories themselves are
+// created, removed or moved, all modules are dropped, because a module
+// may be found in the other place then.
+//
+typedef struct Server {
+    ProjectConfig*   project_config; // the project served
+    char*            socket_path;
+    int32            jobs;
+    int              listen_fd;
+    int              inotify_fd;
+    ServerWatch*     watches;
+    int32            watch_count;
+    int32            watch_cap;
+    char**           dirty;          // the directories changed since the last build
+    int32            dirty_count;
+    int32            dirty_cap;
+    bool             dirty_all;
+    ModuleCacheTable warm;           // the modules parsed by the last builds
+    bool             stopping;
+    int64            builds;
+}Server;
+
+extern char* serverDefaultSocket(const ProjectConfig* projconf);
+extern error serverInit         (Server* server, ProjectConfig* projconf, char* socket_path, int32 jobs);
+extern error serverRun          (Server* server);
+extern void  serverDestroy      (Server* server);
+extern error serverRequest      (char* socket_path, char* request, FILE* out);
+
+#endif
@@ -0,0 +1,138 @@
+/**
+ * Copyright 2015 JiKai. All rights reserved.
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file.
+ *
+ *     The test for arena.h and arena.c. it also builds the
+ * same list of expressions with the mem_alloc and with the
+ * arena, and compares the time and the memory they take.
+ **/
+
+#include <time.h>
+#include "../arena.h"
+#include "../ast.h"
+
+#define NODE_COUNT 1000000
+
+static double now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+// the binary expressions like "a + b" chained by the list nodes.
+typedef struct ExprNode {
+    ASTNodeExpr*     expr;
+    struct ExprNode* next;
+}ExprNode;
+
+static ExprNode* build_malloc(size_t* bytes) {
+    ExprNode* head = NULL;
+    ExprNode* node;
+    int i;
+    *bytes = 0;
+    for (i = 0; i < NODE_COUNT; i++) {
+        node       = (ExprNode*)mem_alloc(sizeof(ExprNode));
+        node->expr = (ASTNodeExpr*)mem_alloc(sizeof(ASTNodeExpr));
+        node->expr->expr_type = AST_NODE_EXPR_BNRY;
+        node->expr->expr.expr_binary = (ASTNodeExprBnry*)mem_alloc(sizeof(ASTNodeExprBnry));
+        node->expr->expr.expr_binary->oprd1 = NULL;
+        node->expr->expr.expr_binary->oprd2 = NULL;
+        node->next = head;
+        head       = node;
+        *bytes += malloc_usable_size(node) + malloc_usable_size(node->expr) + malloc_usable_size(node->expr->expr.expr_binary) + 3 * sizeof(size_t);
+    }
+    return head;
+}
+
+static void free_malloc(ExprNode* head) {
+    ExprNode* next;
+    for (; head != NULL; head = next) {
+        next = head->next;
+        mem_free(head->expr->expr.expr_binary);
+        mem_free(head->expr);
+        mem_free(head);
+    }
+}
+
+static ExprNode* build_arena(Arena* arena) {
+    ExprNode* head = NULL;
+    ExprNode* node;
+    int i;
+    for (i = 0; i < NODE_COUNT; i++) {
+        node       = arenaNew(arena, ExprNode);
+        node->expr = arenaNew(arena, ASTNodeExpr);
+        node->expr->expr_type = AST_NODE_EXPR_BNRY;
+        node->expr->expr.expr_binary = arenaNew(arena, ASTNodeExprBnry);
+        node->expr->expr.expr_binary->oprd1 = NULL;
+        node->expr->expr.expr_binary->oprd2 = NULL;
+        node->next = head;
+        head       = node;
+    }
+    return head;
+}
+
+int main() {
+    Arena     arena;
+    ArenaMark mark;
+    char*     ptrs[64];
+    char*     str;
+    size_t    bytes;
+    double    begin, malloc_ms, arena_ms;
+    int       i, ok;
+
+    arenaInit(&arena, 1024);
+
+    printf("the memory is aligned: ");
+    for (i = 0, ok = 1; i < 64; i++) {
+        ptrs[i] = (char*)arenaAlloc(&arena, i % 13 + 1);
+        ok = ok && ((size_t)ptrs[i] % ARENA_ALIGN) == 0;
+    }
+    ok ? printf("[YES]\r\n\r\n") : printf("[test failed]\r\n\r\n");
+
+    printf("the string is copied with the terminator: ");
+    str = arenaStrdup(&arena, "hello world", 5);
+    strcmp(str, "hello") == 0 ? printf("[YES]\r\n\r\n") : printf("[test failed]\r\n\r\n");
+
+    printf("rewinding releases the blocks allocated after the mark: ");
+    mark  = arenaMark(&arena);
+    bytes = arena.reserved;
+    for (i = 0; i < 100; i++) {
+        arenaAlloc(&arena, 200);
+    }
+    arenaAlloc(&arena, 5000);
+    arenaRewind(&arena, mark);
+    str = (char*)arenaAlloc(&arena, 8);
+    arena.allocated == mark.allocated + 8 && arena.reserved <= bytes + sizeof(ArenaBlock) + 1024 && str == mark.block->data + mark.used ?
+        printf("[YES]\r\n\r\n") : printf("[test failed]\r\n\r\n");
+
+    printf("the spare block is reused at the edge of a block: ");
+    mark  = arenaMark(&arena);
+    arenaAlloc(&arena, 1000);
+    arenaRewind(&arena, mark);
+    bytes = arena.reserved;
+    for (i = 0; i < 1000; i++) {
+        arenaAlloc(&arena, 1000);
+        arenaRewind(&arena, mark);
+    }
+    arena.reserved == bytes ? printf("[YES]\r\n\r\n") : printf("[test failed]\r\n\r\n");
+    arenaDestroy(&arena);
+
+    ExprNode* list;
+    begin     = now_ms();
+    list      = build_malloc(&bytes);
+    free_malloc(list);
+    malloc_ms = now_ms() - begin;
+    printf("%d expressions with the mem_alloc: %.2fms, %.2fMB\r\n", NODE_COUNT, malloc_ms, bytes / 1048576.0);
+
+    arenaInit(&arena, ARENA_BLOCK_SIZE);
+    begin    = now_ms();
+    list     = build_arena(&arena);
+    bytes    = arena.reserved;
+    arenaDestroy(&arena);
+    arena_ms = now_ms() - begin;
+    printf("%d expressions with the arena    : %.2fms, %.2fMB\r\n", NODE_COUNT, arena_ms, bytes / 1048576.0);
+
+    debug("\r\ntest over\r\n");
+    return 0;
+}
@@ -0,0 +1,177 @@
+/**
+ * Copyright 2015 JiKai. All rights reserved.
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file.
+ *
+ *     The test for the ASTFlat of ast.h and ast.c. the tree is
+ * built by hand, converted to the flat form and displayed, and
+ * the bytes taken by the two forms are compared.
+ **/
+
+#include "../ast.h"
+#include "../lexer.h"
+
+#define STMT_COUNT 100000
+
+static ASTNodeExpr* new_id(AST* ast, char* id, int32 line, int32 col) {
+    ASTNodeExpr* expr = arenaNew(&ast->arena, ASTNodeExpr);
+    expr->expr_type         = AST_NODE_ID;
+    expr->expr.expr_id      = arenaNew(&ast->arena, ASTNodeID);
+    expr->expr.expr_id->id       = id;
+    expr->expr.expr_id->id_len   = strlen(id);
+    expr->expr.expr_id->pos_line = line;
+    expr->expr.expr_id->pos_col  = col;
+    return expr;
+}
+
+static ASTNodeExpr* new_lit(AST* ast, char* value, int32 line, int32 col) {
+    ASTNodeExpr* expr = arenaNew(&ast->arena, ASTNodeExpr);
+    expr->expr_type           = AST_NODE_CONST_LIT;
+    expr->expr.expr_const_lit = arenaNew(&ast->arena, ASTNodeConstLit);
+    expr->expr.expr_const_lit->const_type  = TOKEN_CONST_INTEGER;
+    expr->expr.expr_const_lit->const_value = value;
+    expr->expr.expr_const_lit->const_len   = strlen(value);
+    expr->expr.expr_const_lit->pos_line    = line;
+    expr->expr.expr_const_lit->pos_col     = col;
+    return expr;
+}
+
+static ASTNodeExpr* new_binary(AST* ast, int16 op, ASTNodeExpr* oprd1, ASTNodeExpr* oprd2) {
+    ASTNodeExpr* expr = arenaNew(&ast->arena, ASTNodeExpr);
+    expr->expr_type        = AST_NODE_EXPR_BNRY;
+    expr->expr.expr_binary = arenaNew(&ast->arena, ASTNodeExprBnry);
+    expr->expr.expr_binary->op_token_code = op;
+    expr->expr.expr_binary->oprd1         = oprd1;
+    expr->expr.expr_binary->oprd2         = oprd2;
+    return expr;
+}
+
+static ASTNodeStmt* new_assign(AST* ast, ASTNodeExpr* lhs, ASTNodeExpr* rhs, ASTNodeStmt* next) {
+    ASTNodeStmt* stmt = arenaNew(&ast->arena, ASTNodeStmt);
+    stmt->stmt = arenaNew(&ast->arena, ASTNode);
+    stmt->stmt->node_type = AST_NODE_ASSIGN;
+    stmt->stmt->node.node_assign = arenaNew(&ast->arena, ASTNodeAssign);
+    stmt->stmt->node.node_assign->expr_lhs = lhs;
+    stmt->stmt->node.node_assign->expr_rhs = rhs;
+    stmt->next = next;
+    return stmt;
+}
+
+// module main
+// x = a + b * 2
+// while x < 10 {
+//     x = x + 1
+// }
+static void build(AST* ast) {
+    ASTNodeGlobalScope* scope = arenaNew(&ast->arena, ASTNodeGlobalScope);
+    ASTNodeStmt*        loop  = arenaNew(&ast->arena, ASTNodeStmt);
+    ASTNodeLoopWhile*   node_while;
+
+    node_while        = arenaNew(&ast->arena, ASTNodeLoopWhile);
+    node_while->cond  = new_binary(ast, TOKEN_OP_LT, new_id(ast, "x", 3, 7), new_lit(ast, "10", 3, 11));
+    node_while->block = arenaNew(&ast->arena, ASTNodeBlock);
+    node_while->block->stmts = new_assign(ast, new_id(ast, "x", 4, 5),
+        new_binary(ast, TOKEN_OP_ADD, new_id(ast, "x", 4, 9), new_lit(ast, "1", 4, 13)), NULL);
+    loop->stmt = arenaNew(&ast->arena, ASTNode);
+    loop->stmt->node_type = AST_NODE_LOOP_WHILE;
+    loop->stmt->node.node_loop_while = node_while;
+    loop->next = NULL;
+
+    scope->modules = arenaNew(&ast->arena, ASTNodeModule);
+    scope->modules->module   = "main";
+    scope->modules->pos_line = 1;
+    scope->modules->next     = NULL;
+    scope->includes = NULL;
+    scope->stmts    = new_assign(ast, new_id(ast, "x", 2, 1),
+        new_binary(ast, TOKEN_OP_ADD, new_id(ast, "a", 2, 5),
+            new_binary(ast, TOKEN_OP_MUL, new_id(ast, "b", 2, 9), new_lit(ast, "2", 2, 13))), loop);
+    ast->global_scope = scope;
+}
+
+static char* expected =
+    "global_scope\r\n"
+    "  module main\r\n"
+    "  assign\r\n"
+    "    id x\r\n"
+    "    binary +\r\n"
+    "      id a\r\n"
+    "      binary *\r\n"
+    "        id b\r\n"
+    "        const 2\r\n"
+    "  while\r\n"
+    "    binary <\r\n"
+    "      id x\r\n"
+    "      const 10\r\n"
+    "    block\r\n"
+    "      assign\r\n"
+    "        id x\r\n"
+    "        binary +\r\n"
+    "          id x\r\n"
+    "          const 1\r\n";
+
+int main() {
+    AST          ast;
+    ASTFlat      flat;
+    ASTIndex     stmt, rhs;
+    ASTNodeStmt* stmts = NULL;
+    FILE*        out;
+    char         buff[1024];
+    size_t       len;
+    int          i;
+
+    astInit(&ast);
+    build(&ast);
+    astFlatInit(&flat);
+    astFlatFromAST(&flat, &ast);
+
+    printf("the root is the global scope: ");
+    flat.kinds[flat.root] == AST_NODE_GLOBAL_SCOPE && flat.root == flat.count - 1 ?
+        printf("[YES]\r\n\r\n") : printf("[test failed]\r\n\r\n");
+
+    printf("the statements are kept in order: ");
+    stmt = flat.extra[flat.rhs[flat.root] + 1];
+    flat.extra[flat.rhs[flat.root]] == 2 && flat.kinds[stmt] == AST_NODE_ASSIGN &&
+        flat.kinds[flat.extra[flat.rhs[flat.root] + 2]] == AST_NODE_LOOP_WHILE ?
+        printf("[YES]\r\n\r\n") : printf("[test failed]\r\n\r\n");
+
+    printf("the binary expression keeps its operator and its position: ");
+    rhs = flat.rhs[stmt];
+    flat.kinds[rhs] == AST_NODE_EXPR_BNRY && flat.ops[rhs] == TOKEN_OP_ADD && flat.lines[rhs] == 2 && flat.cols[rhs] == 5 &&
+        flat.ops[flat.rhs[rhs]] == TOKEN_OP_MUL && strcmp(flat.strs[flat.lhs[flat.lhs[rhs]]], "a") == 0 ?
+        printf("[YES]\r\n\r\n") : printf("[test failed]\r\n\r\n");
+
+    printf("the flat form is displayed as the tree: ");
+    out = tmpfile();
+    astFlatDisplay(&flat, out);
+    rewind(out);
+    len = fread(buff, 1, sizeof(buff) - 1, out);
+    buff[len] = '\0';
+    fclose(out);
+    strcmp(buff, expected) == 0 ? printf("[YES]\r\n\r\n") : printf("[test failed]\r\n%s\r\n", buff);
+
+    astFlatDestroy(&flat);
+    astDestroy(&ast);
+
+    astInit(&ast);
+    for (i = 0; i < STMT_COUNT; i++) {
+        stmts = new_assign(&ast, new_id(&ast, "x", i, 1),
+            new_binary(&ast, TOKEN_OP_ADD, new_id(&ast, "a", i, 5), new_lit(&ast, "1", i, 9)), stmts);
+    }
+    ast.global_scope = arenaNew(&ast.arena, ASTNodeGlobalScope);
+    ast.global_scope->modules  = NULL;
+    ast.global_scope->includes = NULL;
+    ast.global_scope->stmts    = stmts;
+    astFlatInit(&flat);
+    astFlatFromAST(&flat, &ast);
+    printf("%d statements in the tree: %.2fMB, %.1f bytes per node\r\n", STMT_COUNT,
+        ast.arena.allocated / 1048576.0, (double)ast.arena.allocated / (flat.count - 1));
+    printf("%d statements in the flat: %.2fMB, %.1f bytes per node\r\n", STMT_COUNT,
+        astFlatBytes(&flat) / 1048576.0, (double)astFlatBytes(&flat) / (flat.count - 1));
+    printf("the flat form is smaller: ");
+    astFlatBytes(&flat) < ast.arena.allocated ? printf("[YES]\r\n\r\n") : printf("[test failed]\r\n\r\n");
+    astFlatDestroy(&flat);
+    astDestroy(&ast);
+
+    debug("\r\ntest over\r\n");
+    return 0;
+}
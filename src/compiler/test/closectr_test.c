@@ -0,0 +1,119 @@
+/**
+ * Copyright 2015 JiKai. All rights reserved.
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file.
+ *
+ *     The test for the closeCounterSplit of closectr.c. the
+ * chunks split are lexed one by one and compared with the
+ * lexing of the whole source code, and the speed of the
+ * prescan is measured.
+ **/
+
+#include <time.h>
+#include "../closectr.h"
+#include "../lexer.h"
+
+#define MAX_SPLITS 64
+#define BENCH_SIZE (64 << 20)
+
+static double now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+// the tokens and their lines of the source code, joined into one string.
+// the line-feeds are left out, because the lexer drops the last one before
+// the end of every chunk.
+static void lex_span(char* src, int64 len, int32 line, char* out) {
+    Lexer     lexer;
+    LexToken* token;
+    lexerInit(&lexer);
+    lexerOpenSrcSpan(&lexer, "test.cplus", src, len, line);
+    while (lexerParseToken(&lexer) == NULL) {
+        token = lexerReadToken(&lexer);
+        if (token->token_code != TOKEN_LINEFEED) {
+            out += sprintf(out, "%d:%d:%.*s ", lexer.pos_line, token->token_code, (int)token->token_len,
+                lexTokenSpanPtr(token) != NULL ? lexTokenSpanPtr(token) : "");
+        }
+        lexerNextToken(&lexer);
+    }
+    *out = '\0';
+    lexerDestroy(&lexer);
+}
+
+static bool split_equal(char* src, int32* count) {
+    static char whole[65536], chunks[65536];
+    CloseSplit  splits[MAX_SPLITS];
+    int64       len = strlen(src);
+    int32       i;
+    char*       out = chunks;
+
+    lex_span(src, len, 1, whole);
+    *count = closeCounterSplit(src, len, 1, splits, MAX_SPLITS);
+    chunks[0] = '\0';
+    for (i = 0; i < *count; i++) {
+        lex_span(src + splits[i].offset, (i + 1 < *count ? splits[i+1].offset : len) - splits[i].offset, splits[i].line, out);
+        out += strlen(out);
+    }
+    return strcmp(whole, chunks) == 0 ? true : false;
+}
+
+int main() {
+    CloseSplit splits[MAX_SPLITS];
+    char*      src;
+    char*      bench;
+    double     begin, ms;
+    int64      i, len;
+    int32      count;
+
+    printf("the source code is split at the top-level declarations: ");
+    src   = "include \"net\"\nfunc get() {\n    s = \"func }\"\n}\ntype Request {\n}\n";
+    count = closeCounterSplit(src, strlen(src), 1, splits, MAX_SPLITS);
+    count == 3 && splits[1].offset == 14 && splits[1].line == 2 && splits[2].line == 5 && memcmp(src + splits[2].offset, "type", 4) == 0 ?
+        printf("[YES]\r\n\r\n") : printf("[test failed]\r\n\r\n");
+
+    printf("the declarations in the braces are not split: ");
+    src   = "type A {\nfunc f() {\n}\n}\nfunc g() {\n    if a {\nfunc\n    }\n}\n";
+    count = closeCounterSplit(src, strlen(src), 1, splits, MAX_SPLITS);
+    count == 2 && splits[1].line == 5 ? printf("[YES]\r\n\r\n") : printf("[test failed]\r\n\r\n");
+
+    printf("the braces in the strings, the chars and the comments are skipped: ");
+    src   = "func a() {\n    s = \"{\n\"\n    c = '{'\n    d = '\\''\n    // {\n    /* /* { */ } */\n}\nfunc b() {\n}\n";
+    count = closeCounterSplit(src, strlen(src), 1, splits, MAX_SPLITS);
+    count == 2 && splits[1].line == 8 && memcmp(src + splits[1].offset, "func b", 6) == 0 ?
+        printf("[YES]\r\n\r\n") : printf("[test failed]\r\n\r\n");
+
+    printf("the names beginning with func are not declarations: ");
+    src   = "a = 1\nfunction = 2\ntypes = 3\n  func f() {\n}\n";
+    count = closeCounterSplit(src, strlen(src), 1, splits, MAX_SPLITS);
+    count == 2 && splits[1].line == 4 ? printf("[YES]\r\n\r\n") : printf("[test failed]\r\n\r\n");
+
+    printf("the chunks are not smaller than the min_size: ");
+    src   = "func a() {\n}\nfunc b() {\n}\nfunc c() {\n}\nfunc d() {\n}\n";
+    count = closeCounterSplit(src, strlen(src), 20, splits, MAX_SPLITS);
+    count == 2 && splits[1].offset == 26 ? printf("[YES]\r\n\r\n") : printf("[test failed]\r\n\r\n");
+
+    printf("the number of the chunks is limited: ");
+    count = closeCounterSplit(src, strlen(src), 1, splits, 2);
+    count == 2 && splits[1].offset == 13 ? printf("[YES]\r\n\r\n") : printf("[test failed]\r\n\r\n");
+
+    printf("the chunks are lexed with the same tokens and lines as the whole: ");
+    split_equal("include \"net\"\r\nfunc get() {\r\n    /* func\n */\r\n    c = 'f'\r\n}\r\n\r\ntype T {\r\n    a = [1, 2]\r\n}\r\nfunc set() {\r\n}\r\n", &count) == true && count == 4 ?
+        printf("[YES]\r\n\r\n") : printf("[test failed]\r\n\r\n");
+
+    src   = "func f(a, b) {\n    s = \"text { with } braces\"\n    // a comment }\n    return a + b * 2\n}\n";
+    len   = strlen(src);
+    bench = (char*)mem_alloc(BENCH_SIZE + len);
+    for (i = 0; i + len <= BENCH_SIZE; i += len) {
+        memcpy(bench + i, src, len);
+    }
+    begin = now_ms();
+    count = closeCounterSplit(bench, i, 256 << 10, splits, MAX_SPLITS);
+    ms    = now_ms() - begin;
+    printf("the prescan of %.0fMB: %d chunks, %.2fms, %.0fMB/s\r\n", i / 1048576.0, count, ms, i / 1048576.0 / (ms / 1e3));
+    mem_free(bench);
+
+    debug("\r\ntest over\r\n");
+    return 0;
+}
@@ -0,0 +1,234 @@
+/**
+ * Copyright 2015 JiKai. All rights reserved.
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file.
+ *
+ *     The test for compiler.h and compiler.c. it builds a
+ * generated project serially and in parallel, and checks
+ * that the export tables of all modules are the same.
+ **/
+
+#include <time.h>
+#include "../compiler.h"
+
+#define MOD_COUNT  300
+#define PROJ_PATH  "/tmp/cplus_compiler_test"
+
+// the module mi includes at most 3 modules before it, exports 4 functions
+// and a datatype, and the program includes all modules.
+static void create_temp_project() {
+    char  path[256];
+    FILE* file;
+    int   i, j;
+    system("rm -rf " PROJ_PATH);
+    system("mkdir -p " PROJ_PATH "/bin " PROJ_PATH "/src/test.prog");
+    for (i = 0; i < MOD_COUNT; i++) {
+        sprintf(path, "mkdir -p " PROJ_PATH "/src/m%d.mod", i);
+        system(path);
+        sprintf(path, PROJ_PATH "/src/m%d.mod/m%d.cplus", i, i);
+        file = fopen(path, "w");
+        for (j = 1; j <= 3 && i - j * 7 >= 0; j++) {
+            fprintf(file, "include \"m%d\"\n", i - j * 7);
+        }
+        for (j = 0; j < 4; j++) {
+            fprintf(file, "func f_%d_%d(a int32, b int32) {\n    if a > b {\n        return a\n    }\n    return b\n}\n\n", i, j);
+        }
+        fprintf(file, "type T_%d {\n}\n", i);
+        fclose(file);
+    }
+    file = fopen(PROJ_PATH "/src/test.prog/main.cplus", "w");
+    for (i = 0; i < MOD_COUNT; i++) {
+        fprintf(file, "include \"m%d\"\n", i);
+    }
+    fprintf(file, "func main() {\n    return 0\n}\n");
+    fclose(file);
+}
+
+static int cmp_str(const void* a, const void* b) {
+    return strcmp(*(char**)a, *(char**)b);
+}
+
+static int   search_failed = 0;
+static int   last_rebuilt  = 0;
+static bool  last_rebuild[MOD_COUNT];  // the rebuild flags of the last build
+static int32 last_imports[MOD_COUNT];  // the imports resolved in the last build
+
+// dump the sorted export names of every module into the dump. return the
+// number of the modules loaded from their interface files. every name is
+// searched in the table too, the tables loaded are frozen.
+static int dump_exports(Compiler* compiler, char** dump) {
+    char   name[32];
+    char*  names[16];
+    int    i, n, loaded = 0;
+    uint32 k, iter;
+    Ident* id;
+    for (i = 0; i < MOD_COUNT; i++) {
+        sprintf(name, "m%d", i);
+        Module* mod = moduleCacheTableGetMod(&compiler->cachetable, internCStr(name));
+        if (mod != NULL && mod->iface == MODULE_IFACE_LOADED) {
+            loaded++;
+        }
+        IdentTable* table = moduleCacheTableGet(&compiler->cachetable, internCStr(name));
+        dump[i] = (char*)mem_alloc(512);
+        dump[i][0] = '\0';
+        if (table == NULL) {
+            continue;
+        }
+        for (iter = 0, n = 0; (id = identTableNext(table, &iter)) != NULL;) {
+            names[n++] = id->id_name;
+            if (identTableSearch(table, id->id_name) != id) {
+                search_failed++;
+            }
+        }
+        sprintf(name, "f_%d_9", i);
+        if (identTableSearch(table, internCStr(name)) != NULL) {
+            search_failed++;
+        }
+        qsort(names, n, sizeof(char*), cmp_str);
+        for (k = 0; k < n; k++) {
+            strcat(dump[i], names[k]);
+            strcat(dump[i], " ");
+        }
+    }
+    return loaded;
+}
+
+static double build(int32 jobs, char** dump, int* loaded, bool graph) {
+    ProjectConfig   projconf;
+    Compiler        compiler;
+    error           err;
+    struct timespec begin, end;
+    Module*         mod;
+    char            name[32];
+    int             i;
+
+    projectConfigInit(&projconf, "/usr/local/cplus-1.0/bin/cplus", PROJ_PATH "/src/test.prog");
+    compilerInit(&compiler, &projconf);
+    compiler.jobs = jobs;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    if ((err = compilerBuild(&compiler)) != NULL) {
+        printf("[build failed: %s] ", err);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    last_rebuilt = compiler.mods_rebuilt;
+    for (i = 0; i < MOD_COUNT; i++) {
+        sprintf(name, "m%d", i);
+        mod = moduleCacheTableGetMod(&compiler.cachetable, internCStr(name));
+        last_rebuild[i] = mod != NULL ? mod->rebuild : false;
+        last_imports[i] = mod != NULL ? (int32)mod->imports.count : 0;
+    }
+    if (graph == true) {
+        compilerDumpGraph(&compiler, stdout);
+    }
+    *loaded = dump_exports(&compiler, dump);
+    compilerDestroy(&compiler);
+    projectConfigDestroy(&projconf);
+    return (end.tv_sec - begin.tv_sec) * 1e3 + (end.tv_nsec - begin.tv_nsec) / 1e6;
+}
+
+int main() {
+    char*  serial[MOD_COUNT];
+    char*  parallel[MOD_COUNT];
+    char*  rebuilt[MOD_COUNT];
+    double ms;
+    int    i, loaded;
+
+    create_temp_project();
+
+    // the first build saves the interface files and the second one loads
+    // them, so the export tables are compared with the loaded ones too.
+    ms = build(1, serial, &loaded, false);
+    printf("build %d modules serially in %.2fms, %d modules loaded from the interface files\r\n", MOD_COUNT, ms, loaded);
+    ms = build(8, parallel, &loaded, false);
+    printf("build %d modules with 8 jobs in %.2fms, %d modules loaded from the interface files\r\n\r\n", MOD_COUNT, ms, loaded);
+
+    printf("all modules are loaded from the interface files in the second build: ");
+    loaded == MOD_COUNT ? printf("[YES]\r\n\r\n") : printf("[test failed]\r\n\r\n");
+
+    printf("no module is rebuilt in the second build: ");
+    last_rebuilt == 0 ? printf("[YES]\r\n\r\n") : printf("[test failed: %d]\r\n\r\n", last_rebuilt);
+
+    printf("all exports can be searched in the tables: ");
+    search_failed == 0 ? printf("[YES]\r\n\r\n") : printf("[test failed]\r\n\r\n");
+
+    printf("the export tables of the two builds are the same: ");
+    for (i = 0; i < MOD_COUNT; i++) {
+        if (serial[i][0] == '\0' || strcmp(serial[i], parallel[i]) != 0) {
+            printf("[test failed at m%d]\r\n\r\n", i);
+            break;
+        }
+    }
+    if (i == MOD_COUNT) {
+        printf("[YES]\r\n\r\n");
+    }
+    printf("the exports of m42: %s\r\n\r\n", serial[42]);
+
+    printf("the broken interface file of m42 should be ignored: ");
+    system("printf 'broken' > " PROJ_PATH "/src/m42.mod/.cplusif");
+    build(1, rebuilt, &loaded, false);
+    loaded == MOD_COUNT - 1 && strcmp(serial[42], rebuilt[42]) == 0 && last_rebuilt == 0 ?
+        printf("[YES]\r\n\r\n") : printf("[test failed]\r\n\r\n");
+    for (i = 0; i < MOD_COUNT; i++) {
+        mem_free(rebuilt[i]);
+    }
+
+    // m3 is included by m10, m17, m24 and the program.
+    printf("only m3 is rebuilt after the bodies of its functions are changed: ");
+    system("sed -i 's/return b/return a/' " PROJ_PATH "/src/m3.mod/m3.cplus");
+    build(4, rebuilt, &loaded, false);
+    last_rebuilt == 1 ? printf("[YES]\r\n\r\n") : printf("[test failed: %d]\r\n\r\n", last_rebuilt);
+    for (i = 0; i < MOD_COUNT; i++) {
+        mem_free(rebuilt[i]);
+    }
+
+    printf("the modules including m3 are not marked for rebuild and not resolved again: ");
+    last_rebuild[3] == true && last_rebuild[10] == false && last_rebuild[17] == false && last_rebuild[24] == false &&
+        last_imports[10] == 0 && last_imports[17] == 0 && last_imports[24] == 0 ?
+        printf("[YES]\r\n\r\n") : printf("[test failed]\r\n\r\n");
+
+    printf("m3 and the modules including it are rebuilt after m3 exports a new function: ");
+    system("printf 'func f_3_4() {\\n}\\n' >> " PROJ_PATH "/src/m3.mod/m3.cplus");
+    build(1, rebuilt, &loaded, false);
+    last_rebuilt == 5 && strstr(rebuilt[3], "f_3_4") != NULL ?
+        printf("[YES]\r\n\r\n") : printf("[test failed: %d]\r\n\r\n", last_rebuilt);
+
+    // m0 includes m294, which closes the cycle m294 -> m287 -> ... -> m0.
+    printf("the cycle should be reported:\r\n");
+    FILE* file = fopen(PROJ_PATH "/src/m0.mod/m0.cplus", "a");
+    fprintf(file, "include \"m294\"\n");
+    fclose(file);
+    ProjectConfig projconf;
+    Compiler      compiler;
+    error         err;
+    projectConfigInit(&projconf, "/usr/local/cplus-1.0/bin/cplus", PROJ_PATH "/src/m14.mod");
+    compilerInit(&compiler, &projconf);
+    compiler.jobs = 4;
+    (err = compilerBuild(&compiler)) != NULL ? printf("%s\r\n\r\n", err) : printf("[test failed]\r\n\r\n");
+    compilerDestroy(&compiler);
+    projectConfigDestroy(&projconf);
+
+    // the program is not in the cycle ca -> cb -> ca, it is only reached
+    // through ca.
+    printf("the cycle reached through a module outside it should be reported: ");
+    system("mkdir -p " PROJ_PATH "/src/cycle.prog " PROJ_PATH "/src/ca.mod " PROJ_PATH "/src/cb.mod");
+    system("printf 'include \"ca\"\\nfunc main() {\\n    return 0\\n}\\n' > " PROJ_PATH "/src/cycle.prog/main.cplus");
+    system("printf 'include \"cb\"\\n' > " PROJ_PATH "/src/ca.mod/ca.cplus");
+    system("printf 'include \"ca\"\\n' > " PROJ_PATH "/src/cb.mod/cb.cplus");
+    projectConfigInit(&projconf, "/usr/local/cplus-1.0/bin/cplus", PROJ_PATH "/src/cycle.prog");
+    compilerInit(&compiler, &projconf);
+    compiler.jobs = 1;
+    err = compilerBuild(&compiler);
+    err != NULL && (strstr(err, "ca -> cb -> ca") != NULL || strstr(err, "cb -> ca -> cb") != NULL) ?
+        printf("[YES]\r\n\r\n") : printf("[test failed: %s]\r\n\r\n", err == NULL ? "no error" : err);
+    compilerDestroy(&compiler);
+    projectConfigDestroy(&projconf);
+
+    for (i = 0; i < MOD_COUNT; i++) {
+        mem_free(serial[i]);
+        mem_free(parallel[i]);
+        mem_free(rebuilt[i]);
+    }
+    system("rm -rf " PROJ_PATH);
+    debug("\r\ntest over\r\n");
+    return 0;
+}
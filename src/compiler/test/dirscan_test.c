@@ -0,0 +1,105 @@
+/**
+ * Copyright 2015 JiKai. All rights reserved.
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file.
+ *
+ *     The test for dirscan.h and dirscan.c.
+ **/
+
+#include "../dirscan.h"
+
+#define TEST_PATH  "/tmp/cplus_dirscan_test"
+#define BIG_COUNT  3000
+#define DIR_COUNT  200
+
+static void create_temp_dirs() {
+    char  path[256];
+    FILE* file;
+    int   i;
+    system("rm -rf " TEST_PATH);
+    system("mkdir -p " TEST_PATH "/src/a.mod " TEST_PATH "/src/net.mod/http.mod " TEST_PATH "/big " TEST_PATH "/many");
+    system("printf 'func f() {\\n}\\n' > " TEST_PATH "/src/a.mod/x.cplus");
+    system("touch " TEST_PATH "/src/a.mod/y.cplus " TEST_PATH "/src/a.mod/notes.txt " TEST_PATH "/src/fake.mod");
+    system("ln -s a.mod " TEST_PATH "/src/link.mod");
+    for (i = 0; i < BIG_COUNT; i++) {
+        sprintf(path, TEST_PATH "/big/file_with_a_long_name_%05d.cplus", i);
+        file = fopen(path, "w");
+        fclose(file);
+    }
+    for (i = 0; i < DIR_COUNT; i++) {
+        sprintf(path, "mkdir -p " TEST_PATH "/many/d%d", i);
+        system(path);
+    }
+}
+
+static bool is_dir(DirScanner* scanner, char* path) {
+    return dirScanIsDir(scanner, path, strlen(path));
+}
+
+int main() {
+    DirScanner    scanner;
+    DirScanDir*   dir;
+    DirScanEntry* entry;
+    char          path[256];
+    int           i;
+
+    create_temp_dirs();
+    dirScanInit(&scanner);
+
+    printf("the entries of the source directory are sorted: ");
+    dir = dirScanList(&scanner, TEST_PATH "/src", strlen(TEST_PATH "/src"));
+    if (dir == NULL) {
+        printf("[test failed]\r\n\r\n");
+        return EXIT_FAILURE;
+    }
+    for (i = 0; i < dir->count; i++) {
+        printf("%s ", dir->entries[i].name);
+    }
+    dir->count == 4 && strcmp(dir->entries[0].name, "a.mod") == 0 && strcmp(dir->entries[3].name, "net.mod") == 0 ?
+        printf("[YES]\r\n\r\n") : printf("[test failed]\r\n\r\n");
+
+    printf("the types of the entries: ");
+    is_dir(&scanner, TEST_PATH "/src/a.mod")            == true  &&
+    is_dir(&scanner, TEST_PATH "/src/link.mod")         == true  &&
+    is_dir(&scanner, TEST_PATH "/src/fake.mod")         == false &&
+    is_dir(&scanner, TEST_PATH "/src/missing.mod")      == false &&
+    is_dir(&scanner, TEST_PATH "/src/net.mod/http.mod") == true  &&
+    is_dir(&scanner, TEST_PATH "/src/no.mod/http.mod")  == false ?
+        printf("[YES]\r\n\r\n") : printf("[test failed]\r\n\r\n");
+
+    printf("the regular files are stated when they are listed: ");
+    dir   = dirScanList(&scanner, TEST_PATH "/src/a.mod", strlen(TEST_PATH "/src/a.mod"));
+    entry = dirScanLookup(dir, "x.cplus", 7);
+    entry != NULL && entry->type == DIRSCAN_REG && entry->size == 13 && entry->mtime > 0 &&
+    dirScanLookup(dir, "x.cplu", 6) == NULL && dirScanLookup(dir, "x.cplus2", 8) == NULL ?
+        printf("[YES]\r\n\r\n") : printf("[test failed]\r\n\r\n");
+
+    printf("every directory is listed once: ");
+    is_dir(&scanner, TEST_PATH "/src/net.mod/http.mod");
+    dirScanList(&scanner, TEST_PATH "/src", strlen(TEST_PATH "/src"));
+    printf("[%lld listed, %lld stated] ", scanner.listed, scanner.stated);
+    scanner.listed == 3 ? printf("[YES]\r\n\r\n") : printf("[test failed]\r\n\r\n");
+
+    printf("the big directory is listed completely: ");
+    dir = dirScanList(&scanner, TEST_PATH "/big", strlen(TEST_PATH "/big"));
+    for (i = 1; dir != NULL && i < dir->count && strcmp(dir->entries[i-1].name, dir->entries[i].name) < 0; i++);
+    dir != NULL && dir->count == BIG_COUNT && i == BIG_COUNT ? printf("[YES]\r\n\r\n") : printf("[test failed]\r\n\r\n");
+
+    printf("all directories can be found after the table grows: ");
+    for (i = 0; i < DIR_COUNT; i++) {
+        sprintf(path, TEST_PATH "/many/d%d", i);
+        dirScanList(&scanner, path, strlen(path));
+    }
+    for (i = 0; i < DIR_COUNT; i++) {
+        sprintf(path, TEST_PATH "/many/d%d", i);
+        if (dirScanList(&scanner, path, strlen(path)) == NULL) {
+            break;
+        }
+    }
+    i == DIR_COUNT && scanner.listed == 4 + DIR_COUNT ? printf("[YES]\r\n\r\n") : printf("[test failed]\r\n\r\n");
+
+    dirScanDestroy(&scanner);
+    system("rm -rf " TEST_PATH);
+    debug("\r\ntest over\r\n");
+    return 0;
+}
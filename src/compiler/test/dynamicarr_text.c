@@ -8,6 +8,8 @@
 
 #include "../dynamicarr.h"
 
+DYNAMIC_ARR_DEFINE(Int32Vec, int32Vec, int32)
+
 static void dynamicArrCharDebug(DynamicArrChar* darr) {
     if (darr->first == NULL) {
         printf("the dynamic array is destroy\r\n.");
@@ -34,6 +36,8 @@ static void dynamicArrCharDebug(DynamicArrChar* darr) {
 }
 
 int main() {
+    char*          content;
+    char*          str;
     DynamicArrChar darr;
     dynamicArrCharInit(&darr, 10);
 
@@ -78,6 +82,87 @@ int main() {
 
     dynamicArrCharDestroy(&darr);
     dynamicArrCharDebug  (&darr);
+
+    DynamicArrStr dstr, _dstr;
+    int           i;
+    dynamicArrStrInit(&dstr, 4);
+
+    printf("the short content is kept in the small buffer and terminated by '\\0': ");
+    dynamicArrStrAppend (&dstr, msg1, strlen(msg1));
+    dynamicArrStrAppendc(&dstr, ',');
+    dynamicArrStrAppend (&dstr, msg2, strlen(msg2));
+    strcmp(dynamicArrStrView(&dstr), "hello,world") == 0 && dstr.used == 11 && dstr.cap == DYNAMIC_ARR_STR_SMALL && dstr.heap == NULL ?
+        printf("[YES]\r\n\r\n") : printf("[test failed] %s\r\n\r\n", dynamicArrStrView(&dstr));
+
+    printf("the capacity is doubled for the chars appended one by one: ");
+    for (i = 0; i < 1000; i++) {
+        dynamicArrStrAppendc(&dstr, '0' + i % 10);
+    }
+    dstr.used == 1011 && dstr.cap == 1024 && dstr.heap != NULL && strncmp(dynamicArrStrView(&dstr), "hello,world0123", 15) == 0 &&
+        strlen(dynamicArrStrView(&dstr)) == 1011 ?
+        printf("[YES]\r\n\r\n") : printf("[test failed]\r\n\r\n");
+
+    printf("the content is compared and copied: ");
+    dynamicArrStrClear(&dstr);
+    dynamicArrStrInit (&_dstr, 5);
+    dynamicArrStrAppend    (&_dstr, msg4, strlen(msg4));
+    dynamicArrStrAppendDstr(&dstr, &_dstr);
+    content = dynamicArrStrGetStr(&dstr);
+    dynamicArrStrEqual(&dstr, msg4, strlen(msg4)) == true && dynamicArrStrEqual(&dstr, msg4, 10) == false &&
+        strcmp(content, msg4) == 0 && content != dynamicArrStrView(&dstr) ?
+        printf("[YES]\r\n\r\n") : printf("[test failed]\r\n\r\n");
+    mem_free(content);
+
+    printf("the buffer is kept by the clear: ");
+    i = dstr.cap;
+    dynamicArrStrClear(&dstr);
+    dstr.used == 0 && dstr.cap == i && dynamicArrStrView(&dstr)[0] == '\0' ?
+        printf("[YES]\r\n\r\n") : printf("[test failed]\r\n\r\n");
+
+    printf("the buffer on the heap is detached without copying: ");
+    dynamicArrStrAppend(&dstr, msg4, strlen(msg4));
+    str     = dstr.heap;
+    content = dynamicArrStrDetach(&dstr);
+    content == str && strcmp(content, msg4) == 0 && dstr.heap == NULL && dstr.used == 0 ?
+        printf("[YES]\r\n\r\n") : printf("[test failed]\r\n\r\n");
+    mem_free(content);
+
+    Int32Vec vec;
+    Arena    arena;
+    int32*   arr;
+    int32    sum = 0;
+    printf("the typed vector is pushed, popped and iterated: ");
+    int32VecInit(&vec, NULL);
+    for (i = 0; i < 100; i++) {
+        int32VecPush(&vec, i);
+    }
+    int32VecPop(&vec);
+    dynamicArrForEach(&vec, i) {
+        sum += vec.arr[i];
+    }
+    vec.count == 99 && vec.cap == 128 && *int32VecTop(&vec) == 98 && sum == 99 * 98 / 2 ?
+        printf("[YES]\r\n\r\n") : printf("[test failed]\r\n\r\n");
+
+    printf("the elements above the base are copied into the arena: ");
+    arenaInit(&arena, ARENA_BLOCK_SIZE);
+    arr = int32VecDup(&vec, 90, &arena);
+    int32VecTruncate(&vec, 90);
+    vec.count == 90 && arr[0] == 90 && arr[8] == 98 && int32VecDup(&vec, 90, &arena) == NULL ?
+        printf("[YES]\r\n\r\n") : printf("[test failed]\r\n\r\n");
+    int32VecDestroy(&vec);
+
+    printf("the vector of the arena grows in the arena: ");
+    int32VecInit(&vec, &arena);
+    for (i = 0; i < 1000; i++) {
+        int32VecPush(&vec, i);
+    }
+    vec.count == 1000 && vec.arr[999] == 999 && arena.allocated >= 1000 * sizeof(int32) ?
+        printf("[YES]\r\n\r\n") : printf("[test failed]\r\n\r\n");
+    int32VecDestroy(&vec);
+    arenaDestroy(&arena);
+
+    dynamicArrStrDestroy(&_dstr);
+    dynamicArrStrDestroy(&dstr);
     debug("run over");
     return 0;
 }
@@ -0,0 +1,234 @@
+/**
+ * Copyright 2015 JiKai. All rights reserved.
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file.
+ *
+ *     The test for the ExprParser of expression.h and
+ * expression.c. it also parses a large file of arithmetic
+ * expressions and compares the time with the lexing only.
+ **/
+
+#include <time.h>
+#include "../expression.h"
+
+#define TEST_FILE   "/tmp/cplus_expression_test.cplus"
+#define BENCH_FILE  "/tmp/cplus_expression_bench.cplus"
+#define BENCH_LINES 200000
+
+static double now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static char* op_str(int16 op) {
+    static char* names[] = {
+        "=", "+=", "-=", "*=", "/=", "%=", "&=", "|=", "^=", ".", "(", ")", "{", "}", "++", "--",
+        "-", "$", "@", "[", "]", "*", "/", "%", "+", "-", "<<", ">>", "&", "|", "^", "!",
+        "==", "!=", "<", ">", "<=", ">=", "&&", "||"
+    };
+    return names[op - TOKEN_OP_ASSIGN];
+}
+
+// print the expression with all parentheses.
+static void show(ASTNodeExpr* expr, char* out) {
+    int32 i;
+    out += strlen(out);
+    switch (expr->expr_type) {
+    case AST_NODE_ID:
+        sprintf(out, "%.*s", expr->expr.expr_id->id_len, expr->expr.expr_id->id);
+        break;
+    case AST_NODE_CONST_LIT:
+        sprintf(out, "%.*s", expr->expr.expr_const_lit->const_len, expr->expr.expr_const_lit->const_value);
+        break;
+    case AST_NODE_EXPR_UNRY:
+        if (expr->expr.expr_unary->op_token_code == TOKEN_OP_INC || expr->expr.expr_unary->op_token_code == TOKEN_OP_DEC) {
+            strcat(out, "(");
+            show(expr->expr.expr_unary->oprd, out);
+            strcat(out, op_str(expr->expr.expr_unary->op_token_code));
+            strcat(out, ")");
+        }
+        else {
+            sprintf(out, "(%s", op_str(expr->expr.expr_unary->op_token_code));
+            show(expr->expr.expr_unary->oprd, out);
+            strcat(out, ")");
+        }
+        break;
+    case AST_NODE_EXPR_BNRY:
+        strcat(out, "(");
+        show(expr->expr.expr_binary->oprd1, out);
+        sprintf(out + strlen(out), " %s ", op_str(expr->expr.expr_binary->op_token_code));
+        show(expr->expr.expr_binary->oprd2, out);
+        strcat(out, ")");
+        break;
+    case AST_NODE_INDEX:
+        sprintf(out, "%s[", expr->expr.expr_index->array->id);
+        show(expr->expr.expr_index->index, out);
+        strcat(out, "]");
+        break;
+    case AST_NODE_FUNC_CALL:
+        sprintf(out, "%s(", expr->expr.expr_func_call->func_name->id);
+        for (i = 0; i < expr->expr.expr_func_call->func_params->count; i++) {
+            show(expr->expr.expr_func_call->func_params->exprs[i], out);
+            if (i + 1 < expr->expr.expr_func_call->func_params->count) {
+                strcat(out, ", ");
+            }
+        }
+        strcat(out, ")");
+        break;
+    }
+}
+
+// parse the source and print the first expression, or the error. the code
+// of the token ending the expression is saved in the end.
+static void parse(char* src, char* out, int16* end) {
+    Lexer        lexer;
+    Arena        arena;
+    ExprParser   ep;
+    ASTNodeExpr* expr;
+    FILE*        file = fopen(TEST_FILE, "w");
+    fputs(src, file);
+    fclose(file);
+
+    lexerInit(&lexer);
+    lexerOpenSrcFileMapped(&lexer, TEST_FILE);
+    arenaInit(&arena, 4096);
+    exprParserInit(&ep, &lexer, &arena);
+    out[0] = '\0';
+    if ((expr = exprParse(&ep)) != NULL) {
+        show(expr, out);
+    }
+    else {
+        strcpy(out, ep.err);
+    }
+    *end = ep.cur_token != NULL ? ep.cur_token->token_code : -1;
+    exprParserDestroy(&ep);
+    arenaDestroy(&arena);
+    lexerDestroy(&lexer);
+}
+
+static void check(char* src, char* expected, int16 expected_end) {
+    char  out[4096];
+    int16 end;
+    int   i;
+    parse(src, out, &end);
+    for (i = 0; src[i] != '\0' && i < 32; i++) {
+        src[i] == '\n' ? printf("\\n") : putchar(src[i]);
+    }
+    printf(src[i] != '\0' ? "...: " : ": ");
+    strcmp(out, expected) == 0 && end == expected_end ?
+        printf("[YES]\r\n\r\n") : printf("[test failed] %s\r\n\r\n", out);
+}
+
+// the lines like "x1 + (y2 * 3 - f(z4, 5)) % arr[i6] << 2".
+static void gen_bench(char* path) {
+    static char* ops[] = { "+", "-", "*", "/", "%", "<<", ">>", "&", "|", "^", "==", "<", "&&", "||" };
+    FILE* file = fopen(path, "w");
+    int   i, j, k;
+    srand(7);
+    for (i = 0; i < BENCH_LINES; i++) {
+        fprintf(file, "x%d", rand() % 100);
+        k = 4 + rand() % 9;
+        for (j = 0; j < k; j++) {
+            fprintf(file, " %s ", ops[rand() % 14]);
+            switch (rand() % 6) {
+            case 0:  fprintf(file, "(y%d * %d - z%d)", rand() % 100, rand() % 1000, rand() % 100); break;
+            case 1:  fprintf(file, "f(y%d, %d)", rand() % 100, rand() % 1000); break;
+            case 2:  fprintf(file, "arr[i%d]", rand() % 100); break;
+            case 3:  fprintf(file, "%d", rand() % 1000); break;
+            default: fprintf(file, "y%d", rand() % 100); break;
+            }
+        }
+        fprintf(file, "\n");
+    }
+    fclose(file);
+}
+
+static void bench() {
+    Lexer        lexer;
+    Arena        arena;
+    ExprParser   ep;
+    int          count, tokens;
+    double       begin, lex_ms, parse_ms;
+    gen_bench(BENCH_FILE);
+
+    lexerInit(&lexer);
+    lexerOpenSrcFileMapped(&lexer, BENCH_FILE);
+    tokens = 0;
+    begin  = now_ms();
+    while (lexerParseToken(&lexer) == NULL) {
+        lexerNextToken(&lexer);
+        tokens++;
+    }
+    lex_ms = now_ms() - begin;
+    lexerDestroy(&lexer);
+
+    lexerInit(&lexer);
+    lexerOpenSrcFileMapped(&lexer, BENCH_FILE);
+    arenaInit(&arena, ARENA_BLOCK_SIZE);
+    exprParserInit(&ep, &lexer, &arena);
+    count = 0;
+    begin = now_ms();
+    while (exprParse(&ep) != NULL) {
+        count++;
+        // pass the line-feed ending the expression.
+        if (ep.cur_token == NULL) {
+            break;
+        }
+        lexerNextToken(&lexer);
+    }
+    parse_ms = now_ms() - begin;
+    printf("%d tokens lexed only     : %.2fms\r\n", tokens, lex_ms);
+    printf("%d expressions parsed : %.2fms, %.0fns per expression, the AST takes %.2fMB\r\n",
+        count, parse_ms, parse_ms * 1e6 / count, arena.allocated / 1048576.0);
+    printf("all expressions are parsed: ");
+    count == BENCH_LINES && ep.err == NULL ? printf("[YES]\r\n\r\n") : printf("[test failed] %s\r\n\r\n", ep.err);
+    exprParserDestroy(&ep);
+    arenaDestroy(&arena);
+    lexerDestroy(&lexer);
+    remove(BENCH_FILE);
+}
+
+int main() {
+    const OptrBinding* binding;
+    int16              code;
+    int                ok;
+    char               deep[2048];
+
+    printf("the bindings agree with getOptrPriority: ");
+    for (code = TOKEN_OP_ASSIGN, ok = 1; code <= TOKEN_OP_LOGIC_OR; code++) {
+        binding = getOptrBinding(code);
+        ok = ok && (binding->infix   == OP_PRIORITY_NULL || binding->infix   == getOptrPriority(code));
+        ok = ok && (binding->postfix == OP_PRIORITY_NULL || binding->postfix == getOptrPriority(code));
+        ok = ok && (binding->prefix  == OP_PRIORITY_NULL || binding->prefix  == getOptrPriority(code == TOKEN_OP_SUB ? TOKEN_OP_NEG : code));
+    }
+    ok && getOptrBinding(TOKEN_OP_COMMA) == NULL ? printf("[YES]\r\n\r\n") : printf("[test failed]\r\n\r\n");
+
+    check("a + b * c - d\n",              "((a + (b * c)) - d)",                -1);
+    check("a - b - c\nd\n",               "((a - b) - c)",                      TOKEN_LINEFEED);
+    check("(a + b) * c\n",                "((a + b) * c)",                      -1);
+    check("-a * b\n",                     "((-a) * b)",                         -1);
+    check("$p++ + @q\n",                  "(($(p++)) + (@q))",                  -1);
+    check("f(a, b + 1) * arr[i + 1]\n",   "(f(a, (b + 1)) * arr[(i + 1)])",     -1);
+    check("g() << 2\n",                   "(g() << 2)",                         -1);
+    check("mod.get(x) == 3 && !y\n",      "(((mod . get(x)) == 3) && (!y))",    -1);
+    check("a | b ^ c & d || e < f\n",     "((((a | b) ^ c) & d) || (e < f))",   -1);
+    check("a +\n    b\n",                 "(a + b)",                            -1);
+    check("f(a,\n    (b\n    + c))\n",    "f(a, (b + c))",                      -1);
+    check("x + 1 = y\n",                  "(x + 1)",                            TOKEN_OP_ASSIGN);
+    check("a b\n",                        "a",                                  TOKEN_ID);
+    check("a + )\n",                      "unexpected token in the expression.", TOKEN_OP_RPARENTHESE);
+    check("(a + b\n",                     "miss the ) to close the parenthesized expression.", -1);
+    check("a[1][2]\n",                    "only the identifiers can be indexed.", TOKEN_OP_LBRACKET);
+    check("f(a b)\n",                     "miss the ) to close the function call.", TOKEN_ID);
+
+    memset(deep, '(', 1000);
+    strcpy(deep + 1000, "a\n");
+    check(deep,                           "the expression is nested too deeply.", TOKEN_OP_LPARENTHESE);
+    remove(TEST_FILE);
+
+    bench();
+
+    debug("\r\ntest over\r\n");
+    return 0;
+}
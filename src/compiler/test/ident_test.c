@@ -0,0 +1,78 @@
+/**
+ * Copyright 2015 JiKai. All rights reserved.
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file.
+ *
+ *     The test for the IdentTable of ident.h and ident.c.
+ **/
+
+#include "../ident.h"
+
+#define ID_COUNT    10000
+#define CROWD_IDS   300
+#define CROWD_MASK  0x3ff
+
+int main() {
+    IdentTable id_table;
+    IdentTable crowd;
+    char*      names[ID_COUNT];
+    char*      crowd_names[CROWD_IDS];
+    char       name[32];
+    Ident*     id;
+    uint32     iter;
+    int        i, j;
+
+    printf("add 10000 identifiers and search them: ");
+    identTableInit(&id_table);
+    for (i = 0; i < ID_COUNT; i++) {
+        sprintf(name, "ident_%d", i);
+        names[i] = internCStr(name);
+        identTableAdd(&id_table, identNew(names[i], ID_TYPE_UNRESOLVED));
+    }
+    for (i = 0; i < ID_COUNT; i++) {
+        if ((id = identTableSearch(&id_table, names[i])) == NULL || id->id_name != names[i]) {
+            printf("[test failed at %s]\r\n\r\n", names[i]);
+            break;
+        }
+    }
+    if (i == ID_COUNT) {
+        printf("[YES]\r\n\r\n");
+    }
+
+    printf("search an undefined identifier: ");
+    identTableSearch(&id_table, internCStr("undefined")) == NULL ? printf("[YES]\r\n\r\n") : printf("[test failed]\r\n\r\n");
+
+    printf("add an identifier again should fail: ");
+    id = identNew(names[42], ID_TYPE_UNRESOLVED);
+    identTableAdd(&id_table, id) != NULL ? printf("[YES]\r\n\r\n") : printf("[test failed]\r\n\r\n");
+    identFree(id);
+
+    printf("every identifier is iterated once: ");
+    for (iter = 0, j = 0; identTableNext(&id_table, &iter) != NULL; j++);
+    j == ID_COUNT && id_table.count == ID_COUNT ? printf("[YES]\r\n\r\n") : printf("[test failed: %d]\r\n\r\n", j);
+    identTableDestroy(&id_table);
+
+    // the names share their home slot until the table is larger than
+    // CROWD_MASK, so their probe distances go beyond the uint8.
+    printf("the names of the same home slot can all be found: ");
+    identTableInit(&crowd);
+    for (i = 0, j = 0; i < CROWD_IDS; j++) {
+        sprintf(name, "crowd_%d", j);
+        if ((internHash(internCStr(name)) & CROWD_MASK) == 0) {
+            crowd_names[i++] = internCStr(name);
+            identTableAdd(&crowd, identNew(internCStr(name), ID_TYPE_UNRESOLVED));
+        }
+    }
+    for (i = 0; i < CROWD_IDS; i++) {
+        if (identTableSearch(&crowd, crowd_names[i]) == NULL) {
+            break;
+        }
+    }
+    i == CROWD_IDS && crowd.count == CROWD_IDS && identTableSearch(&crowd, internCStr("undefined")) == NULL ?
+        printf("[YES]\r\n\r\n") : printf("[test failed]\r\n\r\n");
+    identTableDestroy(&crowd);
+
+    internDestroy();
+    debug("\r\ntest over\r\n");
+    return 0;
+}
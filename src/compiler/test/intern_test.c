@@ -0,0 +1,44 @@
+/**
+ * Copyright 2015 JiKai. All rights reserved.
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file.
+ *
+ *     The test for intern.h and intern.c.
+ **/
+
+#include "../intern.h"
+
+int main() {
+    char  name[32];
+    char* interned[10000];
+    int   i;
+
+    printf("intern 10000 different names...\r\n");
+    for (i = 0; i < 10000; i++) {
+        sprintf(name, "ident_%d", i);
+        interned[i] = internStr(name, strlen(name));
+    }
+    printf("the count of the interned names is %u\r\n\r\n", internCount());
+
+    printf("intern them again and the pointers should be the same: ");
+    for (i = 0; i < 10000; i++) {
+        sprintf(name, "ident_%d", i);
+        if (internCStr(name) != interned[i] || strcmp(interned[i], name) != 0) {
+            printf("[test failed at %s]\r\n\r\n", name);
+            break;
+        }
+    }
+    if (i == 10000) {
+        printf("[YES]\r\n\r\n");
+    }
+
+    printf("a span of a longer string can be interned: ");
+    char* span = "ident_42 = ident_43";
+    internStr(span, 8) == interned[42] ? printf("[YES]\r\n\r\n") : printf("[test failed]\r\n\r\n");
+
+    printf("the length and the id of ident_42 is: %u %u\r\n", internLen(interned[42]), internId(interned[42]));
+
+    internDestroy();
+    debug("\r\ntest over\r\n");
+    return 0;
+}
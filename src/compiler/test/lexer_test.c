@@ -0,0 +1,82 @@
+/**
+ * Copyright 2015 JiKai. All rights reserved.
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file.
+ *
+ *     The test for lexer.h and lexer.c. the same files are
+ * lexed in the stream mode and the mapped mode, and the two
+ * modes should give the same tokens and the same end.
+ **/
+
+#include "../lexer.h"
+
+#define SRC_PATH   "/tmp/cplus_lexer_test.cplus"
+#define LONG_BLANK 40000
+
+static void write_src(char* src, int64 len) {
+    FILE* file = fopen(SRC_PATH, "w");
+    fwrite(src, 1, len, file);
+    fclose(file);
+}
+
+// the tokens with their columns joined into the out. return the error which
+// stops the lexing.
+static error lex_file(int8 mode, char* out) {
+    Lexer     lexer;
+    LexToken* token;
+    char*     str;
+    error     err;
+    lexerInit(&lexer);
+    if ((err = lexerOpenSrcFileMode(&lexer, SRC_PATH, mode)) != NULL) {
+        lexerDestroy(&lexer);
+        return err;
+    }
+    while ((err = lexerParseToken(&lexer)) == NULL) {
+        token = lexerReadToken(&lexer);
+        str   = lexTokenGetStr(token);
+        out  += sprintf(out, "%d:%d:%s ", token->span.col, token->token_code, str);
+        mem_free(str);
+        lexerNextToken(&lexer);
+    }
+    *out = '\0';
+    lexerDestroy(&lexer);
+    return err;
+}
+
+static bool modes_equal(char* stream, char* mapped) {
+    error stream_err = lex_file(LEX_MODE_STREAM, stream);
+    error mapped_err = lex_file(LEX_MODE_MAPPED, mapped);
+    return stream_err == mapped_err && strcmp(stream, mapped) == 0 ? true : false;
+}
+
+int main() {
+    static char stream[65536], mapped[65536];
+    char*       src;
+    int         i;
+
+    printf("the identifier which ends the file ends the two modes the same: ");
+    src = "a = b";
+    write_src(src, strlen(src));
+    modes_equal(stream, mapped) == true && ERROR_CODE(lex_file(LEX_MODE_MAPPED, mapped)) == LEX_ERROR_EOF ?
+        printf("[YES]\r\n\r\n") : printf("[test failed: %s | %s]\r\n\r\n", stream, mapped);
+
+    printf("the comment which ends the file ends the two modes the same: ");
+    src = "a = b // the end";
+    write_src(src, strlen(src));
+    modes_equal(stream, mapped) == true ? printf("[YES]\r\n\r\n") : printf("[test failed: %s | %s]\r\n\r\n", stream, mapped);
+
+    printf("the column of the token after %d blanks: ", LONG_BLANK);
+    src = (char*)mem_alloc(LONG_BLANK + 8);
+    for (i = 0; i < LONG_BLANK; i++) {
+        src[i] = ' ';
+    }
+    memcpy(src + LONG_BLANK, "x = 1\n", 6);
+    write_src(src, LONG_BLANK + 6);
+    mem_free(src);
+    modes_equal(stream, mapped) == true && atoi(mapped) == LONG_BLANK + 1 ?
+        printf("[YES]\r\n\r\n") : printf("[test failed: %s | %s]\r\n\r\n", stream, mapped);
+
+    remove(SRC_PATH);
+    debug("\r\ntest over\r\n");
+    return 0;
+}
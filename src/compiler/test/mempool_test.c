@@ -0,0 +1,127 @@
+/**
+ * Copyright 2015 JiKai. All rights reserved.
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file.
+ *
+ *     The test for the mem_alloc_sized and mem_free_sized of
+ * common.c. the objects are reused in their size classes, and
+ * they can be released by other threads. the time of the pool
+ * is compared with the mem_alloc for the nodes of the same
+ * size.
+ **/
+
+#include <pthread.h>
+#include <time.h>
+#include "../common.h"
+
+#define NODE_COUNT  1000000
+#define NODE_SIZE   24
+#define THREAD_OBJS 1000
+
+static void* objs[THREAD_OBJS];
+
+static double now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static void* alloc_objs(void* arg) {
+    int i;
+    for (i = 0; i < THREAD_OBJS; i++) {
+        objs[i] = mem_alloc_sized(NODE_SIZE);
+        memset(objs[i], 0x5a, NODE_SIZE);
+    }
+    return NULL;
+}
+
+// the objects left by the thread are taken back by the thread after it.
+static void* free_objs(void* arg) {
+    int i;
+    for (i = 0; i < THREAD_OBJS; i++) {
+        mem_free_sized(objs[i], NODE_SIZE);
+    }
+    return NULL;
+}
+
+static void* reuse_objs(void* arg) {
+    void* obj = mem_alloc_sized(NODE_SIZE);
+    int   i;
+    *(bool*)arg = false;
+    for (i = 0; i < THREAD_OBJS; i++) {
+        if (objs[i] == obj) {
+            *(bool*)arg = true;
+        }
+    }
+    mem_free_sized(obj, NODE_SIZE);
+    return NULL;
+}
+
+int main() {
+    pthread_t thread;
+    void*     list;
+    void*     node;
+    void*     a;
+    void*     b;
+    double    begin, malloc_ms, pool_ms;
+    bool      reused;
+    int       i;
+
+    printf("the object released is reused in its size class: ");
+    a = mem_alloc_sized(20);
+    mem_free_sized(a, 20);
+    b = mem_alloc_sized(32);
+    b == a ? printf("[YES]\r\n\r\n") : printf("[test failed]\r\n\r\n");
+
+    printf("the objects of the same class do not overlap: ");
+    a = mem_alloc_sized(32);
+    (char*)a - (char*)b >= 32 || (char*)b - (char*)a >= 32 ?
+        printf("[YES]\r\n\r\n") : printf("[test failed]\r\n\r\n");
+    mem_free_sized(a, 32);
+    mem_free_sized(b, 32);
+
+    printf("the objects bigger than MEM_POOL_MAX are allocated by the mem_alloc: ");
+    a = mem_alloc_sized(MEM_POOL_MAX + 1);
+    memset(a, 0, MEM_POOL_MAX + 1);
+    mem_free_sized(a, MEM_POOL_MAX + 1);
+    printf("[YES]\r\n\r\n");
+
+    printf("the objects released by another thread are reused after it exits: ");
+    pthread_create(&thread, NULL, alloc_objs, NULL);
+    pthread_join(thread, NULL);
+    pthread_create(&thread, NULL, free_objs, NULL);
+    pthread_join(thread, NULL);
+    pthread_create(&thread, NULL, reuse_objs, &reused);
+    pthread_join(thread, NULL);
+    reused == true ? printf("[YES]\r\n\r\n") : printf("[test failed]\r\n\r\n");
+
+    // the nodes are linked by their first bytes and released together, like
+    // the nodes of a tree destroyed.
+    begin = now_ms();
+    for (list = NULL, i = 0; i < NODE_COUNT; i++) {
+        node = mem_alloc(NODE_SIZE);
+        *(void**)node = list;
+        list = node;
+    }
+    for (; list != NULL; list = node) {
+        node = *(void**)list;
+        mem_free(list);
+    }
+    malloc_ms = now_ms() - begin;
+
+    begin = now_ms();
+    for (list = NULL, i = 0; i < NODE_COUNT; i++) {
+        node = mem_alloc_sized(NODE_SIZE);
+        *(void**)node = list;
+        list = node;
+    }
+    for (; list != NULL; list = node) {
+        node = *(void**)list;
+        mem_free_sized(list, NODE_SIZE);
+    }
+    pool_ms = now_ms() - begin;
+    printf("%d nodes of %d bytes, mem_alloc: %.2fms, mem_alloc_sized: %.2fms\r\n", NODE_COUNT, NODE_SIZE, malloc_ms, pool_ms);
+
+    debug("\r\ntest over\r\n");
+    return 0;
+}
@@ -8,14 +8,14 @@
 
 #include "../module.h"
 
-static void moduleInfoDatabaseShow(ModuleInfoDatabaseNode* node) {
+static void moduleCacheTableShow(ModuleCacheTableNode* node) {
     if (node != NULL) {
         if (node->lchild != NULL) {
-            moduleInfoDatabaseShow(node->lchild);
+            moduleCacheTableShow(node->lchild);
         }
-        printf("%s ", node->mod_info->mod_name);
+        printf("%s ", node->mod_name);
         if (node->rchild != NULL) {
-            moduleInfoDatabaseShow(node->rchild);
+            moduleCacheTableShow(node->rchild);
         }
     }
 }
@@ -23,117 +23,203 @@ static void moduleInfoDatabaseShow(ModuleInfoDatabaseNode* node) {
 static void moduleScheduleQueueShow(ModuleScheduleQueue* queue) {
     ModuleScheduleQueueNode* ptr;
     printf("[NODES] ");
-    for (ptr = queue->head->next; ptr != NULL; ptr = ptr->next) {
-        printf("%s ", ptr->mod->mod_info->mod_name);
+    for (ptr = queue->head; ptr != NULL; ptr = ptr->next) {
+        printf("%s ", ptr->mod->mod_name);
     }
     printf("\r\n");
 }
 
+static void create_temp_project_dir() {
+    system("mkdir -p /tmp/cplus_project/bin");
+    system("mkdir -p /tmp/cplus_project/src/net.mod/http.mod");
+    system("mkdir -p /tmp/cplus_project/src/test.prog");
+    system("printf 'include \"net\"\\ninclude \"net/http\"\\nfunc main() {\\n    return 0\\n}\\n' > /tmp/cplus_project/src/test.prog/main.cplus");
+    system("printf 'func get(url string) {\\n}\\ntype Request {\\n}\\n' > /tmp/cplus_project/src/net.mod/http.mod/get.cplus");
+    system("printf 'func dial(addr string) {\\n}\\n' > /tmp/cplus_project/src/net.mod/dial.cplus");
+}
+
+// the module "many" has 40 files, every file includes a module and exports
+// a function. if dup is true, the f10 is exported by 3 files.
+static void create_many_files(bool dup) {
+    char cmd[256];
+    int  i;
+    system("rm -rf /tmp/cplus_project/src/many.mod");
+    system("mkdir -p /tmp/cplus_project/src/many.mod");
+    for (i = 0; i < 40; i++) {
+        sprintf(cmd, "printf 'include \"dep%d\"\\nfunc f%d() {\\n    x = %d\\n}\\n' > /tmp/cplus_project/src/many.mod/f%02d.cplus",
+            39 - i, dup == true && (i == 10 || i == 30 || i == 35) ? 10 : i, i, i);
+        system(cmd);
+    }
+}
+
+// one file of about 2MB, large enough to be split into chunks. the strings
+// and the comments hide the braces and the declarations from the split.
+static void create_big_file(bool dup) {
+    FILE* file;
+    int   i;
+    system("rm -rf /tmp/cplus_project/src/many.mod");
+    system("mkdir -p /tmp/cplus_project/src/many.mod");
+    file = fopen("/tmp/cplus_project/src/many.mod/big.cplus", "w");
+    for (i = 0; i < 30000; i++) {
+        if (i % 5000 == 0) {
+            fprintf(file, "include \"dep%d\"\n", i / 5000);
+        }
+        fprintf(file, "func f%d() {\n    s = \"}\nfunc g%d\"\n    /* } */\n}\n", dup == true && i == 29000 ? 100 : i, i);
+    }
+    fclose(file);
+}
+
+// parse the module "many" and print the includes, the number of the exports
+// and the error into the out.
+static void parse_many(const ProjectConfig* projconf, WorkPool* pool, char* out) {
+    Module* mod = moduleNewByName("many", projconf, NULL);
+    error   err = moduleParse(mod, pool);
+    int32   i;
+    out[0] = '\0';
+    for (i = 0; i < mod->dep_count; i++) {
+        sprintf(out + strlen(out), "%s ", mod->deps[i]);
+    }
+    sprintf(out + strlen(out), "| %d exported %ld bytes | %s", mod->id_table->count, (long)mod->weight, err != NULL ? err : "");
+    moduleDestroy(mod);
+}
+
 int main() {
-    printf("****** test ModuleInfoDatabase ******\r\n\r\n");
+    printf("****** test ModuleCacheTable ******\r\n\r\n");
 
-    int i;
+    int   i;
+    char  name[8];
     error err = NULL;
-    ModuleInfo mod_infos[8];
-    mod_infos[0].mod_name = "m1";
-    mod_infos[1].mod_name = "m2";
-    mod_infos[2].mod_name = "m3";
-    mod_infos[3].mod_name = "m4";
-    mod_infos[4].mod_name = "m5";
-    mod_infos[5].mod_name = "m6";
-    mod_infos[6].mod_name = "m7";
-    mod_infos[7].mod_name = "m8";
-
-    ModuleInfoDatabase mod_info_db;
-    moduleInfoDatabaseInit(&mod_info_db);
+    Module* mods[8];
+    ModuleCacheTable cachetable;
+    moduleCacheTableInit(&cachetable);
+    for (i = 0; i < 8; i++) {
+        sprintf(name, "m%d", i+1);
+        mods[i] = (Module*)mem_alloc(sizeof(Module));
+        memset(mods[i], 0, sizeof(Module));
+        mods[i]->mod_name = internCStr(name);
+        mods[i]->id_table = (IdentTable*)mem_alloc(sizeof(IdentTable));
+        identTableInit(mods[i]->id_table);
+        identTableInit(&mods[i]->imports);
+    }
     for (i = 0; i < 3; i++) {
-        mod_infos[i].compile_over = false;
-        mod_infos[i].id_table     = NULL;
-        if ((err = moduleInfoDatabaseAdd(&mod_info_db, &mod_infos[i])) != NULL) {
+        if ((err = moduleCacheTableAdd(&cachetable, mods[i])) != NULL) {
             debug(err);
         }
     }
-    printf("all node in the ModuleInfoDatabase: ");
-    moduleInfoDatabaseShow(mod_info_db.root);
+    printf("all node in the ModuleCacheTable: ");
+    moduleCacheTableShow(cachetable.root);
     printf("\r\n\r\n");
 
-    printf("now try to test the exist function(test the m3): ");
-    moduleInfoDatabaseExist(&mod_info_db, "m3") == true ? printf("[m3 exists]\r\n\r\n") : printf("[test failed]\r\n\r\n");
+    printf("add the m1 again should fail: ");
+    moduleCacheTableAdd(&cachetable, mods[0]) != NULL ? printf("[YES]\r\n\r\n") : printf("[test failed]\r\n\r\n");
 
-    ModuleInfo* mod_info;
-    printf("now try to get the m3 and m1: ");
-    if ((mod_info = moduleInfoDatabaseGet(&mod_info_db, "m3")) == NULL) {
-        printf("[get m3 failed] ");
-    } else {
-        printf("[get m3 success] ");
-    }
-    if ((mod_info = moduleInfoDatabaseGet(&mod_info_db, "m1")) == NULL) {
-        printf("[get m1 failed]\r\n\r\n");
-    } else {
-        printf("[get m1 success]\r\n\r\n");
-    }
+    printf("now try to get the m3 and m4: ");
+    moduleCacheTableGetMod(&cachetable, internCStr("m3")) == mods[2] ? printf("[get m3 success] ") : printf("[get m3 failed] ");
+    moduleCacheTableGetMod(&cachetable, internCStr("m4")) == NULL    ? printf("[m4 not found]\r\n\r\n") : printf("[test failed]\r\n\r\n");
+
+    printf("the export table of m3 can be got after it is done: ");
+    moduleCacheTableGet(&cachetable, internCStr("m3")) == NULL ? printf("[not done] ") : printf("[test failed] ");
+    mods[2]->state = MODULE_STATE_DONE;
+    moduleCacheTableGet(&cachetable, internCStr("m3")) == mods[2]->id_table ? printf("[done]\r\n\r\n") : printf("[test failed]\r\n\r\n");
 
     printf("\r\n****** test ModuleScheduleQueue ******\r\n\r\n");
 
-    ModuleScheduleQueue mod_schd_queue;
-    moduleScheduleQueueInit(&mod_schd_queue);
+    ModuleScheduleQueue queue;
+    moduleScheduleQueueInit(&queue);
     printf("test the isempty function, now the queue should be empty, right? ");
-    moduleScheduleQueueIsEmpty(&mod_schd_queue) == true ? printf("[YES]\r\n\r\n") : printf("[test failed]\r\n\r\n");
+    moduleScheduleQueueIsEmpty(&queue) == true ? printf("[YES]\r\n\r\n") : printf("[test failed]\r\n\r\n");
 
-    Module mods[8];
-    for (i = 0; i < 3; i++) {
-        if ((err = moduleInfoDatabaseAdd(&mod_info_db, &mod_infos[i])) != NULL) {
-            printf("add the module %s failed: err: %s\r\n", mod_infos[i].mod_name, err);
-            continue;
-        } else {
-            printf("test failed once...\r\n");
-        }
-    }
-    for (i = 0; i < 8; i++) {
-        mods[i].mod_info           = &mod_infos[i];
-        mods[i].mod_path           = NULL;
-        mods[i].mod_path_len       = 0;
-        mods[i].is_main            = false;
-        mods[i].dependences_parsed = false;
-        mods[i].srcfiles           = NULL;
-    }
+    printf("add the m4, m5 and m6:\r\n");
+    moduleScheduleQueueAddMod(&queue, mods[3]);
+    moduleScheduleQueueAddMod(&queue, mods[4]);
+    moduleScheduleQueueAddMod(&queue, mods[5]);
+    moduleScheduleQueueShow(&queue);
 
-    printf("\r\nnow we will test the add function of the ModuleScheduleQueue, we add the m4 and call get function:\r\n");
-    moduleScheduleQueueAddMod(&mod_schd_queue, &mods[3]);
-    moduleScheduleQueueGetHeadMod(&mod_schd_queue);
-    moduleScheduleQueueShow(&mod_schd_queue);
-
-    printf("next we add the m5 and m6, and then call get function:\r\n");
-    moduleScheduleQueueAddMod(&mod_schd_queue, &mods[4]);
-    moduleScheduleQueueAddMod(&mod_schd_queue, &mods[5]);
-    moduleScheduleQueueGetHeadMod(&mod_schd_queue);
-    moduleScheduleQueueShow(&mod_schd_queue);
-
-    printf("next we add the m7 and m8, and then call get function:\r\n");
-    moduleScheduleQueueAddMod(&mod_schd_queue, &mods[6]);
-    moduleScheduleQueueAddMod(&mod_schd_queue, &mods[7]);
-    moduleScheduleQueueGetHeadMod(&mod_schd_queue);
-    moduleScheduleQueueShow(&mod_schd_queue);
-
-    printf("\r\nnow test the get function: ");
-    Module* mod = moduleScheduleQueueGetHeadMod(&mod_schd_queue);
-    if (mod == NULL) {
-        printf("[test failed]\r\n\r\n");
-    } else {
-        printf("[the name of the mod is %s]\r\n\r\n", mod->mod_info->mod_name);
-    }
+    printf("now test the get function: ");
+    Module* mod = moduleScheduleQueueGetHeadMod(&queue);
+    mod == mods[3] ? printf("[the name of the mod is %s]\r\n\r\n", mod->mod_name) : printf("[test failed]\r\n\r\n");
 
-    printf("now we test the delete function, try to delete twice and now the nodes in the queue is:\r\n");
-    moduleScheduleQueueDelHeadMod(&mod_schd_queue);
-    moduleScheduleQueueDelHeadMod(&mod_schd_queue);
-    moduleScheduleQueueShow(&mod_schd_queue);
+    printf("delete the head twice and add the m7:\r\n");
+    moduleScheduleQueueDelHeadMod(&queue);
+    moduleScheduleQueueDelHeadMod(&queue);
+    moduleScheduleQueueAddMod(&queue, mods[6]);
+    moduleScheduleQueueShow(&queue);
 
     printf("\r\nnow we delete all nodes in the queue and check whether the queue is empty: ");
-    moduleScheduleQueueDelHeadMod(&mod_schd_queue);
-    moduleScheduleQueueDelHeadMod(&mod_schd_queue);
-    moduleScheduleQueueDelHeadMod(&mod_schd_queue);
-    moduleScheduleQueueIsEmpty(&mod_schd_queue) == true ? printf("[is empty]\r\n\r\n") : printf("[test failed]\r\n\r\n");
+    moduleScheduleQueueDelHeadMod(&queue);
+    moduleScheduleQueueDelHeadMod(&queue);
+    moduleScheduleQueueIsEmpty(&queue) == true ? printf("[is empty]\r\n\r\n") : printf("[test failed]\r\n\r\n");
 
+    for (i = 3; i < 8; i++) {
+        moduleDestroy(mods[i]);
+    }
+    moduleCacheTableDestroy(&cachetable);
+
+    printf("\r\n****** test Module ******\r\n\r\n");
+
+    create_temp_project_dir();
+    ProjectConfig projconf;
+    projectConfigInit(&projconf, "/usr/local/cplus-1.0/bin/cplus", "/tmp/cplus_project/src/test.prog");
+
+    Module* main_mod = moduleNewByPath(projconf.path_buildmod, projconf.path_buildmod_len, &projconf, NULL);
+    Module* http_mod = moduleNewByName("net/http", &projconf, NULL);
+    printf("the name of the main module is: %s\r\n", main_mod->mod_name);
+    printf("the path of the net/http is   : %s\r\n\r\n", http_mod->mod_path);
+
+    printf("parse the main module and its included modules: ");
+    if ((err = moduleParse(main_mod, NULL)) != NULL || (err = moduleParse(http_mod, NULL)) != NULL) {
+        printf("[test failed: %s]\r\n\r\n", err);
+    }
+    else {
+        printf("[%d included, %d exported] ", main_mod->dep_count, main_mod->id_table->count);
+        printf("[%d exported by net/http]\r\n\r\n", http_mod->id_table->count);
+    }
+    printf("the type Request is exported by net/http: ");
+    identTableSearch(http_mod->id_table, internCStr("Request")) != NULL ? printf("[YES]\r\n\r\n") : printf("[test failed]\r\n\r\n");
+
+    moduleDestroy(main_mod);
+    moduleDestroy(http_mod);
+
+    WorkPool pool;
+    char     serial[2048];
+    char     parallel[2048];
+    workPoolInit(&pool, 4);
+
+    printf("the files lexed by the pool are merged in order: ");
+    create_many_files(false);
+    parse_many(&projconf, NULL, serial);
+    parse_many(&projconf, &pool, parallel);
+    strcmp(serial, parallel) == 0 && strncmp(serial, "dep39 dep38 ", 12) == 0 && strstr(serial, "| 40 exported") != NULL ?
+        printf("[YES]\r\n\r\n") : printf("[test failed]\r\n%s\r\n%s\r\n\r\n", serial, parallel);
+
+    printf("the error is the same as the one without the pool: ");
+    create_many_files(true);
+    parse_many(&projconf, NULL, serial);
+    for (i = 0, err = NULL; i < 20 && err == NULL; i++) {
+        parse_many(&projconf, &pool, parallel);
+        err = strcmp(serial, parallel) != 0 ? "" : NULL;
+    }
+    err == NULL && strstr(serial, "f30.cplus: redefined") != NULL ?
+        printf("[YES]\r\n\r\n") : printf("[test failed]\r\n%s\r\n%s\r\n\r\n", serial, parallel);
+
+    printf("the large file split into chunks is merged in order: ");
+    create_big_file(false);
+    parse_many(&projconf, NULL, serial);
+    parse_many(&projconf, &pool, parallel);
+    strcmp(serial, parallel) == 0 && strncmp(serial, "dep0 dep1 dep2 dep3 dep4 dep5 |", 31) == 0 && strstr(serial, "| 30000 exported") != NULL ?
+        printf("[YES]\r\n\r\n") : printf("[test failed]\r\n%s\r\n%s\r\n\r\n", serial, parallel);
+
+    printf("the error of the chunk is the same as the one without the pool: ");
+    create_big_file(true);
+    parse_many(&projconf, NULL, serial);
+    parse_many(&projconf, &pool, parallel);
+    strcmp(serial, parallel) == 0 && strstr(serial, "redefined") != NULL ?
+        printf("[YES]\r\n\r\n") : printf("[test failed]\r\n%s\r\n%s\r\n\r\n", serial, parallel);
+    workPoolDestroy(&pool);
+
+    projectConfigDestroy(&projconf);
+    system("rm -rf /tmp/cplus_project");
+    internDestroy();
     debug("test over");
     return 0;
 }
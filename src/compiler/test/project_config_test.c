@@ -23,28 +23,11 @@ void delete_temp_project_dir() {
 
 void show_project_config(ProjectConfig* projconf) {
     printf("compiler path           : %s\r\n", projconf->path_compiler);
-    printf("standard module path    : %s\r\n", projconf->path_stdmod);
+    printf("standard module path    : %s\r\n", projconf->path_stdmods);
     printf("project directory path  : %s\r\n", projconf->path_project);
-    printf("project source directory: %s\r\n", projconf->path_source);
-    printf("project binary directory: %s\r\n", projconf->path_binary);
-    printf("compile target path     : %s\r\n", projconf->path_compile_obj);
-    switch (projconf->compile_obj_type) {
-    case COMPILE_OBJ_TYPE_PROJ:
-        printf("compile target type     : project\r\n");
-        break;
-    case COMPILE_OBJ_TYPE_PROG:
-        printf("compile target type     : program\r\n");
-        break;
-    case COMPILE_OBJ_TYPE_MOD:
-        printf("compile target type     : module\r\n");
-        break;
-    case COMPILE_OBJ_TYPE_SRC:
-        printf("compile target type     : source\r\n");
-        break;
-    default:
-        printf("compile target type     : not valid\r\n");
-        break;
-    }
+    printf("project source directory: %s\r\n", projconf->path_srcdir);
+    printf("project binary directory: %s\r\n", projconf->path_bindir);
+    printf("compile target path     : %s\r\n", projconf->path_buildmod);
 }
 
 int main() {
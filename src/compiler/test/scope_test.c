@@ -0,0 +1,64 @@
+/**
+ * Copyright 2015 JiKai. All rights reserved.
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file.
+ *
+ *     The test for scope.h and scope.c.
+ **/
+
+#include "../scope.h"
+
+#define SCOPE_DEPTH     8
+#define IDS_PER_SCOPE   6
+
+static Ident* newIdent(char* name) {
+    return identNew(internCStr(name), ID_TYPE_UNRESOLVED);
+}
+
+int main() {
+    Scope      scopes[SCOPE_DEPTH];
+    ScopeStats stats;
+    char       name[32];
+    int        i, j;
+
+    // build 8 nested scopes, the scope i holds the names var_i_0 ~ var_i_5.
+    for (i = 0; i < SCOPE_DEPTH; i++) {
+        scopeInit(&scopes[i], i == 0 ? NULL : &scopes[i-1]);
+        for (j = 0; j < IDS_PER_SCOPE; j++) {
+            sprintf(name, "var_%d_%d", i, j);
+            scopeAddID(&scopes[i], newIdent(name));
+        }
+    }
+
+    printf("search all names from the innermost scope: ");
+    Scope* inner = &scopes[SCOPE_DEPTH-1];
+    for (i = 0; i < SCOPE_DEPTH; i++) {
+        for (j = 0; j < IDS_PER_SCOPE; j++) {
+            sprintf(name, "var_%d_%d", i, j);
+            Ident* id = scopeSearchID(inner, internCStr(name));
+            if (id == NULL || id->id_name != internCStr(name)) {
+                printf("[test failed at %s]\r\n\r\n", name);
+                goto stats;
+            }
+        }
+    }
+    printf("[YES]\r\n\r\n");
+
+    printf("search undefined names: ");
+    scopeSearchID(inner, internCStr("undefined")) == NULL ? printf("[YES]\r\n\r\n") : printf("[test failed]\r\n\r\n");
+
+    printf("the anonymous identifier can always be found: ");
+    scopeSearchID(inner, internCStr("_")) != NULL ? printf("[YES]\r\n\r\n") : printf("[test failed]\r\n\r\n");
+
+stats:
+    scopeStatsGet(&stats);
+    printf("searches: %llu, levels: %llu, bloom skips: %llu, table hits: %llu, table misses: %llu\r\n",
+        stats.searches, stats.levels, stats.bloom_skips, stats.table_hits, stats.table_misses);
+
+    for (i = SCOPE_DEPTH - 1; i >= 0; i--) {
+        scopeDestroy(&scopes[i]);
+    }
+    internDestroy();
+    debug("\r\ntest over\r\n");
+    return 0;
+}
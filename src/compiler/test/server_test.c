@@ -0,0 +1,149 @@
+/**
+ * Copyright 2015 JiKai. All rights reserved.
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file.
+ *
+ *     The test for server.h and server.c. it serves a small
+ * project in a thread, and checks that the modules not changed
+ * are not parsed again by the later builds.
+ **/
+
+#include <pthread.h>
+#include <time.h>
+#include "../server.h"
+
+#define PROJ_PATH   "/tmp/cplus_server_test"
+#define SOCKET_PATH PROJ_PATH "/bin/.cplusserve"
+
+// the program includes net/http and base, and net/http includes base.
+static void create_temp_project() {
+    FILE* file;
+    system("rm -rf " PROJ_PATH);
+    system("mkdir -p " PROJ_PATH "/bin " PROJ_PATH "/src/hello.prog " PROJ_PATH "/src/net.mod/http.mod " PROJ_PATH "/src/base.mod");
+    file = fopen(PROJ_PATH "/src/hello.prog/main.cplus", "w");
+    fprintf(file, "include \"net/http\"\ninclude \"base\"\nfunc main() {\n    return 0\n}\n");
+    fclose(file);
+    file = fopen(PROJ_PATH "/src/net.mod/http.mod/http.cplus", "w");
+    fprintf(file, "include \"base\"\nfunc get(a int32) {\n    return a\n}\n");
+    fclose(file);
+    file = fopen(PROJ_PATH "/src/base.mod/base.cplus", "w");
+    fprintf(file, "func max(a int32, b int32) {\n    if a > b {\n        return a\n    }\n    return b\n}\n");
+    fclose(file);
+}
+
+static void* serve(void* arg) {
+    serverRun((Server*)arg);
+    return NULL;
+}
+
+// connect to the server and send the part of a request line, then keep
+// the connection open without finishing the line.
+static int stalled_client(char* partial) {
+    struct sockaddr_un addr;
+    int                fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, SOCKET_PATH);
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    if (partial[0] != '\0') {
+        write(fd, partial, strlen(partial));
+    }
+    return fd;
+}
+
+// request the build and read the numbers from the last line of its output.
+static error build(char* target, int* parsed, int* rebuilt) {
+    char*  output = NULL;
+    size_t size   = 0;
+    char*  line;
+    char   request[256];
+    FILE*  out    = open_memstream(&output, &size);
+    error  err;
+    int    total;
+
+    sprintf(request, "build 2 0 %s", target);
+    err = serverRequest(SOCKET_PATH, request, out);
+    fclose(out);
+    *parsed  = -1;
+    *rebuilt = -1;
+    if ((line = strstr(output, "built ")) != NULL) {
+        sscanf(line, "built %d modules in %*fms, %d parsed, %d rebuilt", &total, parsed, rebuilt);
+    }
+    free(output);
+    return err;
+}
+
+int main() {
+    ProjectConfig projconf;
+    Server        server;
+    pthread_t     thread;
+    error         err;
+    int           parsed, rebuilt;
+
+    create_temp_project();
+    projectConfigInit(&projconf, "/usr/local/cplus-1.0/bin/cplus", PROJ_PATH "/src/hello.prog");
+    if ((err = serverInit(&server, &projconf, SOCKET_PATH, 2)) != NULL) {
+        printf("[test failed: %s]\r\n", err);
+        return EXIT_FAILURE;
+    }
+    pthread_create(&thread, NULL, serve, &server);
+
+    printf("the second server on the same socket should fail: ");
+    Server other;
+    serverInit(&other, &projconf, SOCKET_PATH, 2) != NULL ? printf("[YES]\r\n\r\n") : printf("[test failed]\r\n\r\n");
+
+    printf("the ordinary file on the path of the socket is not removed: ");
+    system("echo keep > " PROJ_PATH "/bin/not_socket");
+    serverInit(&other, &projconf, PROJ_PATH "/bin/not_socket", 2) != NULL && access(PROJ_PATH "/bin/not_socket", F_OK) == 0 ?
+        printf("[YES]\r\n\r\n") : printf("[test failed]\r\n\r\n");
+
+    printf("the first build parses all modules: ");
+    err = build(PROJ_PATH "/src/hello.prog", &parsed, &rebuilt);
+    err == NULL && parsed == 3 ? printf("[YES]\r\n\r\n") : printf("[test failed: %d]\r\n\r\n", parsed);
+
+    printf("the second build parses no module: ");
+    err = build(PROJ_PATH "/src/hello.prog", &parsed, &rebuilt);
+    err == NULL && parsed == 0 && rebuilt == 0 ? printf("[YES]\r\n\r\n") : printf("[test failed: %d]\r\n\r\n", parsed);
+
+    // the new export of net/http rebuilds the program too.
+    printf("only net/http is parsed again after it is changed: ");
+    system("printf 'func put(a int32) {\\n    return a\\n}\\n' >> " PROJ_PATH "/src/net.mod/http.mod/http.cplus");
+    err = build(PROJ_PATH "/src/hello.prog", &parsed, &rebuilt);
+    err == NULL && parsed == 1 && rebuilt == 2 ?
+        printf("[YES]\r\n\r\n") : printf("[test failed: %d parsed, %d rebuilt]\r\n\r\n", parsed, rebuilt);
+
+    printf("the module not built before is parsed by the server: ");
+    system("mkdir -p " PROJ_PATH "/src/util.mod");
+    system("printf 'include \"base\"\\n' > " PROJ_PATH "/src/util.mod/util.cplus");
+    system("printf 'include \"util\"\\n' >> " PROJ_PATH "/src/hello.prog/main.cplus");
+    err = build(PROJ_PATH "/src/hello.prog", &parsed, &rebuilt);
+    err == NULL && parsed >= 2 ? printf("[YES]\r\n\r\n") : printf("[test failed: %d]\r\n\r\n", parsed);
+
+    printf("the clients sending nothing or a partial line do not block the others: ");
+    int    silent  = stalled_client("");
+    int    partial = stalled_client("build 2 0 /tm");
+    time_t begin   = time(NULL);
+    err = build(PROJ_PATH "/src/hello.prog", &parsed, &rebuilt);
+    silent >= 0 && partial >= 0 && err == NULL && parsed == 0 && time(NULL) - begin <= 4 * SERVER_REQUEST_TIMEOUT ?
+        printf("[YES]\r\n\r\n") : printf("[test failed]\r\n\r\n");
+    close(silent);
+    close(partial);
+
+    printf("the target out of the project should fail: ");
+    err = build("/tmp", &parsed, &rebuilt);
+    err != NULL ? printf("%s [YES]\r\n\r\n", err) : printf("[test failed]\r\n\r\n");
+
+    printf("the server stops after the stop request: ");
+    err = serverRequest(SOCKET_PATH, "stop", stdout);
+    pthread_join(thread, NULL);
+    err == NULL && server.stopping == true ? printf("[YES]\r\n\r\n") : printf("[test failed]\r\n\r\n");
+
+    serverDestroy(&server);
+    projectConfigDestroy(&projconf);
+    system("rm -rf " PROJ_PATH);
+    debug("\r\ntest over\r\n");
+    return 0;
+}
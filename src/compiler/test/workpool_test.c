@@ -0,0 +1,44 @@
+/**
+ * Copyright 2015 JiKai. All rights reserved.
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file.
+ *
+ *     The test for workpool.h and workpool.c.
+ **/
+
+#include "../workpool.h"
+
+static WorkPool pool;
+static int64    visited = 0;
+
+// every task submits two smaller tasks until the depth is zero, so there
+// are 2^(depth+1)-1 tasks in all and most of them are submitted by the
+// workers themselves.
+static void spread(void* arg) {
+    int64 depth = (int64)arg;
+    __sync_fetch_and_add(&visited, 1);
+    if (depth > 0) {
+        workPoolSubmit(&pool, spread, (void*)(depth - 1));
+        workPoolSubmit(&pool, spread, (void*)(depth - 1));
+    }
+}
+
+int main() {
+    workPoolInit(&pool, 8);
+
+    printf("run 2^17-1 tasks spread by the workers: ");
+    workPoolSubmit(&pool, spread, (void*)16);
+    workPoolWait(&pool);
+    visited == (1 << 17) - 1 ? printf("[YES]\r\n\r\n") : printf("[test failed: %lld]\r\n\r\n", visited);
+
+    printf("the pool can be waited again: ");
+    visited = 0;
+    workPoolSubmit(&pool, spread, (void*)4);
+    workPoolWait(&pool);
+    visited == (1 << 5) - 1 ? printf("[YES]\r\n\r\n") : printf("[test failed: %lld]\r\n\r\n", visited);
+
+    printf("the number of the tasks stolen: %lld\r\n", pool.steals);
+    workPoolDestroy(&pool);
+    debug("\r\ntest over\r\n");
+    return 0;
+}
@@ -0,0 +1,222 @@
+/**
+ * Copyright 2015 JiKai. All rights reserved.
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file.
+ *
+ *     The corpusgen.c generates a synthetic C+ source file
+ * for the benchmarks of the lexer and the parser. the size
+ * and the shape of the code can be dialed, and the same seed
+ * always generates the same file.
+ *
+ * usage:
+ *    corpusgen [options] out.cplus
+ *
+ * options:
+ *    -size    KB   the size of the file, 4096 by default
+ *    -ident   pct  the percent of the operands which are identifiers,
+ *                  the others are the literals. 70 by default
+ *    -depth   n    the deepest nesting of the blocks, 3 by default
+ *    -expr    n    the average number of the operators of an
+ *                  expression, 6 by default
+ *    -comment pct  the percent of the lines which are comments, 15 by
+ *                  default
+ *    -utf8    pct  the percent of the strings, the chars and the
+ *                  comments written in UTF-8, 20 by default
+ *    -seed    n    the seed of the random numbers, 1 by default
+ **/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    long size;
+    int  ident;
+    int  depth;
+    int  expr;
+    int  comment;
+    int  utf8;
+    unsigned long long seed;
+}CorpusShape;
+
+static char* ops[]   = { "+", "-", "*", "/", "%", "<<", ">>", "&", "|", "^", "==", "!=", "<", ">=", "&&", "||" };
+static char* words[] = { "request", "buffer", "count", "index", "value", "node", "left", "right", "total", "offset" };
+static char* utf8s[] = { "中文的内容", "données réseau", "Привет мир", "αβγ δέλτα", "日本語のテキスト", "한국어 문장" };
+static char* chars[] = { "中", "é", "ж", "λ", "ü" };
+
+static FILE*              out;
+static long               written;
+static CorpusShape        shape;
+static unsigned long long state;
+
+// the xorshift keeps the corpus the same on every platform.
+static unsigned corpusRand(unsigned n) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return (unsigned)(state % n);
+}
+
+static void corpusPut(const char* fmt, const char* s, unsigned n) {
+    int len = fprintf(out, fmt, s, n);
+    written += len > 0 ? len : 0;
+}
+
+static void corpusIndent(int depth) {
+    int i;
+    for (i = 0; i < depth; i++) {
+        corpusPut("%s", "    ", 0);
+    }
+}
+
+static void corpusOperand(int nested) {
+    if (corpusRand(100) >= (unsigned)shape.ident) {
+        corpusRand(4) == 0 ? corpusPut("%s%u.5", "", corpusRand(1000)) : corpusPut("%s%u", "", corpusRand(100000));
+        return;
+    }
+    switch (corpusRand(nested < 2 ? 8 : 5)) {
+    case 0:
+        corpusPut("%s_%u[i]", words[corpusRand(10)], corpusRand(100));
+        break;
+    case 1:
+        corpusPut("%s(a, %u)", words[corpusRand(10)], corpusRand(100));
+        break;
+    case 5:
+    case 6:
+        corpusPut("%s", "(", 0);
+        corpusOperand(nested + 1);
+        corpusPut(" %s %u)", ops[corpusRand(16)], corpusRand(1000));
+        break;
+    // the operand negated is never negated again, the "--" is the decrement.
+    case 7:
+        corpusPut("%s", "-", 0);
+        corpusOperand(2);
+        break;
+    default:
+        corpusPut("%s_%u", words[corpusRand(10)], corpusRand(100));
+        break;
+    }
+}
+
+static void corpusExpr() {
+    int count = shape.expr > 0 ? (int)corpusRand(shape.expr * 2 + 1) : 0;
+    int i;
+    corpusOperand(0);
+    for (i = 0; i < count; i++) {
+        corpusPut(" %s ", ops[corpusRand(16)], 0);
+        corpusOperand(0);
+    }
+}
+
+static void corpusComment(int depth) {
+    char* text = corpusRand(100) < (unsigned)shape.utf8 ? utf8s[corpusRand(6)] : "the value is checked before it is used";
+    corpusIndent(depth);
+    if (corpusRand(4) == 0) {
+        corpusPut("/* %s,\n", text, 0);
+        corpusIndent(depth);
+        corpusPut("   and the %s is kept. */\n", words[corpusRand(10)], 0);
+        return;
+    }
+    corpusPut("// %s\n", text, 0);
+}
+
+static void corpusStmt(int depth) {
+    unsigned kind = corpusRand(10);
+    if (corpusRand(100) < (unsigned)shape.comment) {
+        corpusComment(depth);
+        return;
+    }
+    corpusIndent(depth);
+    if (kind < 2 && depth < shape.depth) {
+        corpusPut("%s ", kind == 0 ? "if" : "for", 0);
+        corpusExpr();
+        corpusPut("%s\n", " {", 0);
+        for (kind = 1 + corpusRand(4); kind > 0; kind--) {
+            corpusStmt(depth + 1);
+        }
+        corpusIndent(depth);
+        corpusPut("%s\n", "}", 0);
+    }
+    else if (kind == 2) {
+        corpusPut("name = \"%s\"\n", corpusRand(100) < (unsigned)shape.utf8 ? utf8s[corpusRand(6)] : "plain ascii text", 0);
+    }
+    else if (kind == 3) {
+        corpusPut("ch = '%s'\n", corpusRand(100) < (unsigned)shape.utf8 ? chars[corpusRand(5)] : "c", 0);
+    }
+    else {
+        corpusPut("%s_%u = ", words[corpusRand(10)], corpusRand(100));
+        corpusExpr();
+        corpusPut("%s", "\n", 0);
+    }
+}
+
+static void corpusFunc(unsigned id) {
+    unsigned count;
+    if (id % 16 == 0) {
+        corpusPut("%stype Type%u {\n    field int32\n", "", id);
+        corpusPut("%s", "    next  int64\n}\n\n", 0);
+    }
+    corpusPut("func %s_func_%u(a, b) {\n", words[id % 10], id);
+    for (count = 4 + corpusRand(8); count > 0; count--) {
+        corpusStmt(1);
+    }
+    corpusPut("%s", "    return ", 0);
+    corpusExpr();
+    corpusPut("%s", "\n}\n\n", 0);
+}
+
+static int corpusArg(int argc, char* argv[], int i, long* value) {
+    if (i + 1 >= argc - 1) {
+        fprintf(stderr, "corpusgen: %s needs a value\n", argv[i]);
+        return -1;
+    }
+    *value = atol(argv[i+1]);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    unsigned id;
+    long     value;
+    int      i;
+
+    shape.size    = 4096;
+    shape.ident   = 70;
+    shape.depth   = 3;
+    shape.expr    = 6;
+    shape.comment = 15;
+    shape.utf8    = 20;
+    shape.seed    = 1;
+    if (argc < 2) {
+        fprintf(stderr, "usage: corpusgen [-size KB] [-ident pct] [-depth n] [-expr n] [-comment pct] [-utf8 pct] [-seed n] out.cplus\n");
+        return 1;
+    }
+    for (i = 1; i < argc - 1; i += 2) {
+        if (corpusArg(argc, argv, i, &value) != 0) {
+            return 1;
+        }
+        if      (strcmp(argv[i], "-size")    == 0) shape.size    = value;
+        else if (strcmp(argv[i], "-ident")   == 0) shape.ident   = (int)value;
+        else if (strcmp(argv[i], "-depth")   == 0) shape.depth   = (int)value;
+        else if (strcmp(argv[i], "-expr")    == 0) shape.expr    = (int)value;
+        else if (strcmp(argv[i], "-comment") == 0) shape.comment = (int)value;
+        else if (strcmp(argv[i], "-utf8")    == 0) shape.utf8    = (int)value;
+        else if (strcmp(argv[i], "-seed")    == 0) shape.seed    = (unsigned long long)value;
+        else {
+            fprintf(stderr, "corpusgen: unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if ((out = fopen(argv[argc-1], "w")) == NULL) {
+        fprintf(stderr, "corpusgen: can not open %s\n", argv[argc-1]);
+        return 1;
+    }
+    state = shape.seed * 2654435761ULL + 88172645463325252ULL;
+    corpusPut("%s", "include \"net\"\ninclude \"io\"\n\n", 0);
+    for (id = 0; written < shape.size * 1024; id++) {
+        corpusFunc(id);
+    }
+    fclose(out);
+    printf("corpusgen: %s, %ldKB, %u functions, ident %d%%, depth %d, expr %d, comment %d%%, utf8 %d%%, seed %llu\n",
+        argv[argc-1], written / 1024, id, shape.ident, shape.depth, shape.expr, shape.comment, shape.utf8, shape.seed);
+    return 0;
+}
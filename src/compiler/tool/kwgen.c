@@ -0,0 +1,202 @@
+/**
+ * Copyright 2015 JiKai. All rights reserved.
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file.
+ *
+ *     The kwgen.c generates the keyword.c from the lexer.h.
+ * It collects all keywords and primitive types defined as
+ * TOKEN_KEYWORD_XXX and TOKEN_TYPE_XXX and then searches a
+ * perfect hash function for them, so the lexer can map an
+ * identifier to its token code in constant comparisons.
+ *
+ * usage:
+ *    kwgen lexer.h keyword.c
+ **/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define KWGEN_MAX_WORDS 128
+#define KWGEN_MAX_LEN   32
+
+typedef struct {
+    char name[64];          // the micro name like TOKEN_KEYWORD_IF
+    char word[KWGEN_MAX_LEN]; // the keyword like if
+    int  len;
+}KeywordDef;
+
+static KeywordDef kwdefs[KWGEN_MAX_WORDS];
+static int        kwcount = 0;
+
+// the hash function searched. it must be the same as the one written
+// into the keyword.c by kwgenWrite().
+static unsigned kwgenHash(const char* word, int len, unsigned c0, unsigned c1, unsigned c2, unsigned mask) {
+    return ((unsigned char)word[0]*c0 + (unsigned char)word[len-1]*c1 + (unsigned)len*c2 + (unsigned char)word[1]) & mask;
+}
+
+// collect the definitions like this:
+//    #define TOKEN_KEYWORD_IF       201  // if
+//
+static int kwgenCollect(const char* header) {
+    FILE* file = fopen(header, "r");
+    if (file == NULL) {
+        fprintf(stderr, "kwgen: can not open %s\n", header);
+        return -1;
+    }
+    char line[512];
+    while (fgets(line, sizeof(line), file) != NULL) {
+        char name[64];
+        char word[KWGEN_MAX_LEN];
+        int  code;
+        if (sscanf(line, "#define %63s %d // %31s", name, &code, word) != 3) {
+            continue;
+        }
+        if (strncmp(name, "TOKEN_KEYWORD_", 14) != 0 && strncmp(name, "TOKEN_TYPE_", 11) != 0) {
+            continue;
+        }
+        if (kwcount >= KWGEN_MAX_WORDS) {
+            fprintf(stderr, "kwgen: too many keywords\n");
+            fclose(file);
+            return -1;
+        }
+        int i;
+        for (i = 0; i < kwcount; i++) {
+            if (strcmp(kwdefs[i].word, word) == 0) {
+                fprintf(stderr, "kwgen: keyword '%s' is defined twice\n", word);
+                fclose(file);
+                return -1;
+            }
+        }
+        strcpy(kwdefs[kwcount].name, name);
+        strcpy(kwdefs[kwcount].word, word);
+        kwdefs[kwcount].len = strlen(word);
+        if (kwdefs[kwcount].len < 2) {
+            fprintf(stderr, "kwgen: keyword '%s' is too short\n", word);
+            fclose(file);
+            return -1;
+        }
+        kwcount++;
+    }
+    fclose(file);
+    return 0;
+}
+
+// search the coefficients which make the hash function collision-free
+// over all keywords. the table size starts from the smallest power of
+// two larger than the count of keywords.
+static int kwgenSearch(unsigned* c0, unsigned* c1, unsigned* c2, unsigned* size) {
+    static char used[4096];
+    unsigned n;
+    for (n = 1; n < (unsigned)kwcount; n <<= 1);
+    for (; n <= 4096; n <<= 1) {
+        unsigned a, b, c;
+        for (a = 1; a < 64; a++) {
+            for (b = 0; b < 64; b++) {
+                for (c = 0; c < 64; c++) {
+                    int i;
+                    memset(used, 0, n);
+                    for (i = 0; i < kwcount; i++) {
+                        unsigned h = kwgenHash(kwdefs[i].word, kwdefs[i].len, a, b, c, n-1);
+                        if (used[h]) {
+                            break;
+                        }
+                        used[h] = 1;
+                    }
+                    if (i == kwcount) {
+                        *c0 = a; *c1 = b; *c2 = c; *size = n;
+                        return 0;
+                    }
+                }
+            }
+        }
+    }
+    return -1;
+}
+
+static int kwgenWrite(const char* output, unsigned c0, unsigned c1, unsigned c2, unsigned size) {
+    const KeywordDef* slots[4096];
+    int i, min_len = KWGEN_MAX_LEN, max_len = 0;
+    memset(slots, 0, sizeof(slots));
+    for (i = 0; i < kwcount; i++) {
+        slots[kwgenHash(kwdefs[i].word, kwdefs[i].len, c0, c1, c2, size-1)] = &kwdefs[i];
+        if (kwdefs[i].len < min_len) {
+            min_len = kwdefs[i].len;
+        }
+        if (kwdefs[i].len > max_len) {
+            max_len = kwdefs[i].len;
+        }
+    }
+
+    FILE* file = fopen(output, "w");
+    if (file == NULL) {
+        fprintf(stderr, "kwgen: can not create %s\n", output);
+        return -1;
+    }
+    fprintf(file,
+        "/**\n"
+        " * Copyright 2015 JiKai. All rights reserved.\n"
+        " * Use of this source code is governed by a BSD-style\n"
+        " * license that can be found in the LICENSE file.\n"
+        " *\n"
+        " *     This file is generated by tool/kwgen.c from the\n"
+        " * lexer.h. DO NOT EDIT IT, run \"make keyword.c\" instead.\n"
+        " **/\n\n"
+        "#include \"keyword.h\"\n\n"
+        "#define KEYWORD_MIN_LEN %d\n"
+        "#define KEYWORD_MAX_LEN %d\n"
+        "#define KEYWORD_MASK    %u\n\n"
+        "typedef struct {\n"
+        "    const char* word;\n"
+        "    int8        len;\n"
+        "    int16       token_code;\n"
+        "}KeywordEntry;\n\n"
+        "static const KeywordEntry keyword_table[%u] = {\n",
+        min_len, max_len, size-1, size);
+    for (i = 0; i < (int)size; i++) {
+        if (slots[i] != NULL) {
+            fprintf(file, "    {\"%s\", %d, %s},\n", slots[i]->word, slots[i]->len, slots[i]->name);
+        }
+        else {
+            fprintf(file, "    {NULL, 0, TOKEN_ID},\n");
+        }
+    }
+    fprintf(file,
+        "};\n\n"
+        "// return the TOKEN_KEYWORD_XXX or TOKEN_TYPE_XXX of the word, or TOKEN_ID\n"
+        "// if the word is not a keyword. the hash is perfect, so only one entry\n"
+        "// needs to be compared.\n"
+        "int16 keywordLookup(const char* word, int64 len) {\n"
+        "    if (len < KEYWORD_MIN_LEN || len > KEYWORD_MAX_LEN) {\n"
+        "        return TOKEN_ID;\n"
+        "    }\n"
+        "    uint32 h = ((uint8)word[0]*%uu + (uint8)word[len-1]*%uu + (uint32)len*%uu + (uint8)word[1]) & KEYWORD_MASK;\n"
+        "    const KeywordEntry* entry = &keyword_table[h];\n"
+        "    if (entry->len == len && memcmp(entry->word, word, len) == 0) {\n"
+        "        return entry->token_code;\n"
+        "    }\n"
+        "    return TOKEN_ID;\n"
+        "}\n",
+        c0, c1, c2);
+    fclose(file);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        fprintf(stderr, "usage: kwgen lexer.h keyword.c\n");
+        return EXIT_FAILURE;
+    }
+    if (kwgenCollect(argv[1]) != 0) {
+        return EXIT_FAILURE;
+    }
+    unsigned c0, c1, c2, size;
+    if (kwgenSearch(&c0, &c1, &c2, &size) != 0) {
+        fprintf(stderr, "kwgen: no perfect hash function is found\n");
+        return EXIT_FAILURE;
+    }
+    if (kwgenWrite(argv[2], c0, c1, c2, size) != 0) {
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
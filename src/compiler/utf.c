@@ -12,16 +12,18 @@
 // the current position's rune contains. you can call this
 // function to get the number.
 uint8 utf8_calcu_bytes(char ch) {
-    if (ch < 0x80) {
+    // the char may be signed, so the byte is compared as unsigned.
+    uint8 byte = (uint8)ch;
+    if (byte < 0x80) {
         return 1;
     }
-    else if (0xC0 <= ch && ch < 0xE0) {
+    else if (0xC0 <= byte && byte < 0xE0) {
         return 2;
     }
-    else if (0xE0 <= ch && ch < 0xF0) {
+    else if (0xE0 <= byte && byte < 0xF0) {
         return 3;
     }
-    else if (ch >= 0xF0) {
+    else if (byte >= 0xF0) {
         return 4;
     }
     return 0;
@@ -0,0 +1,218 @@
+/**
+ * Copyright 2015 JiKai. All rights reserved.
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file.
+ **/
+
+#include "workpool.h"
+
+#define WORK_DEQUE_INIT_CAP 64
+
+// the worker running on the current thread. it is -1 on the threads
+// which are not the workers of any pool.
+static __thread WorkPool* cur_pool   = NULL;
+static __thread int32     cur_worker = -1;
+
+typedef struct WorkerArg {
+    WorkPool* pool;
+    int32     id;
+}WorkerArg;
+
+/****** methods of WorkDeque ******/
+
+static void workDequeInit(WorkDeque* deque) {
+    pthread_mutex_init(&deque->lock, NULL);
+    deque->tasks = (WorkTask*)mem_alloc(sizeof(WorkTask) * WORK_DEQUE_INIT_CAP);
+    deque->head  = 0;
+    deque->tail  = 0;
+    deque->cap   = WORK_DEQUE_INIT_CAP;
+}
+
+static void workDequePush(WorkDeque* deque, WorkTask task) {
+    pthread_mutex_lock(&deque->lock);
+    if (deque->tail - deque->head == deque->cap) {
+        WorkTask* tasks = (WorkTask*)mem_alloc(sizeof(WorkTask) * deque->cap * 2);
+        int64     i;
+        for (i = deque->head; i < deque->tail; i++) {
+            tasks[i & (deque->cap * 2 - 1)] = deque->tasks[i & (deque->cap - 1)];
+        }
+        mem_free(deque->tasks);
+        deque->tasks = tasks;
+        deque->cap  *= 2;
+    }
+    deque->tasks[deque->tail & (deque->cap - 1)] = task;
+    deque->tail++;
+    pthread_mutex_unlock(&deque->lock);
+}
+
+// return:
+//   true  -> a task is popped into the task.
+//   false -> the deque is empty.
+static bool workDequePopTail(WorkDeque* deque, WorkTask* task) {
+    bool ok = false;
+    pthread_mutex_lock(&deque->lock);
+    if (deque->tail > deque->head) {
+        deque->tail--;
+        *task = deque->tasks[deque->tail & (deque->cap - 1)];
+        ok = true;
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return ok;
+}
+
+static bool workDequePopHead(WorkDeque* deque, WorkTask* task) {
+    bool ok = false;
+    pthread_mutex_lock(&deque->lock);
+    if (deque->tail > deque->head) {
+        *task = deque->tasks[deque->head & (deque->cap - 1)];
+        deque->head++;
+        ok = true;
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return ok;
+}
+
+static void workDequeDestroy(WorkDeque* deque) {
+    pthread_mutex_destroy(&deque->lock);
+    mem_free(deque->tasks);
+    deque->tasks = NULL;
+}
+
+/****** methods of WorkPool ******/
+
+// get a task from the worker's own deque first. if it is empty, try to
+// steal one from the other workers beginning at the next one.
+static bool workPoolTake(WorkPool* pool, int32 id, WorkTask* task) {
+    int32 i;
+    if (workDequePopTail(&pool->deques[id], task) == true) {
+        return true;
+    }
+    for (i = 1; i < pool->workers; i++) {
+        if (workDequePopHead(&pool->deques[(id + i) % pool->workers], task) == true) {
+            __sync_fetch_and_add(&pool->steals, 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+static void* workPoolWorker(void* arg) {
+    WorkPool* pool = ((WorkerArg*)arg)->pool;
+    int32     id   = ((WorkerArg*)arg)->id;
+    WorkTask  task;
+    mem_free(arg);
+
+    cur_pool   = pool;
+    cur_worker = id;
+    for (;;) {
+        if (workPoolTake(pool, id, &task) == true) {
+            __sync_fetch_and_sub(&pool->queued, 1);
+            task.func(task.arg);
+            if (__sync_sub_and_fetch(&pool->pending, 1) == 0) {
+                pthread_mutex_lock(&pool->lock);
+                pthread_cond_broadcast(&pool->cond_done);
+                pthread_mutex_unlock(&pool->lock);
+            }
+            continue;
+        }
+        pthread_mutex_lock(&pool->lock);
+        while (__atomic_load_n(&pool->queued, __ATOMIC_SEQ_CST) == 0 && pool->stopping == false) {
+            pthread_cond_wait(&pool->cond_work, &pool->lock);
+        }
+        if (__atomic_load_n(&pool->queued, __ATOMIC_SEQ_CST) == 0 && pool->stopping == true) {
+            pthread_mutex_unlock(&pool->lock);
+            return NULL;
+        }
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+// return the number of the online processors. it is used when the number
+// of the jobs is not specified.
+int32 workPoolCPUCount() {
+    int64 count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int32)count : 1;
+}
+
+error workPoolInit(WorkPool* pool, int32 workers) {
+    int32 i;
+    if (workers <= 0) {
+        return new_error("the number of the workers must be positive.");
+    }
+    pool->workers  = workers;
+    pool->threads  = (pthread_t*)mem_alloc(sizeof(pthread_t) * workers);
+    pool->deques   = (WorkDeque*)mem_alloc(sizeof(WorkDeque) * workers);
+    pool->pending  = 0;
+    pool->queued   = 0;
+    pool->stopping = false;
+    pool->next     = 0;
+    pool->steals   = 0;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init (&pool->cond_work, NULL);
+    pthread_cond_init (&pool->cond_done, NULL);
+    for (i = 0; i < workers; i++) {
+        workDequeInit(&pool->deques[i]);
+    }
+    for (i = 0; i < workers; i++) {
+        WorkerArg* arg = (WorkerArg*)mem_alloc(sizeof(WorkerArg));
+        arg->pool = pool;
+        arg->id   = i;
+        if (pthread_create(&pool->threads[i], NULL, workPoolWorker, arg) != 0) {
+            fatal("create the worker thread failed.");
+        }
+    }
+    return NULL;
+}
+
+// the task may be submitted by the workers of the pool or by any other
+// threads. it is safe to submit new tasks in a running task.
+void workPoolSubmit(WorkPool* pool, WorkFunc func, void* arg) {
+    WorkTask task;
+    int32    id;
+    task.func = func;
+    task.arg  = arg;
+    if (cur_pool == pool) {
+        id = cur_worker;
+    }
+    else {
+        id = __sync_fetch_and_add(&pool->next, 1) % pool->workers;
+    }
+    __sync_fetch_and_add(&pool->pending, 1);
+    workDequePush(&pool->deques[id], task);
+    __sync_fetch_and_add(&pool->queued, 1);
+
+    pthread_mutex_lock(&pool->lock);
+    pthread_cond_signal(&pool->cond_work);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+// wait until all submitted tasks and the tasks submitted by them are
+// finished. it must not be called by the workers.
+void workPoolWait(WorkPool* pool) {
+    pthread_mutex_lock(&pool->lock);
+    while (__atomic_load_n(&pool->pending, __ATOMIC_SEQ_CST) > 0) {
+        pthread_cond_wait(&pool->cond_done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void workPoolDestroy(WorkPool* pool) {
+    int32 i;
+    pthread_mutex_lock(&pool->lock);
+    pool->stopping = true;
+    pthread_cond_broadcast(&pool->cond_work);
+    pthread_mutex_unlock(&pool->lock);
+    for (i = 0; i < pool->workers; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    for (i = 0; i < pool->workers; i++) {
+        workDequeDestroy(&pool->deques[i]);
+    }
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy (&pool->cond_work);
+    pthread_cond_destroy (&pool->cond_done);
+    mem_free(pool->threads);
+    mem_free(pool->deques);
+    pool->threads = NULL;
+    pool->deques  = NULL;
+}
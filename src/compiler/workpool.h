@@ -0,0 +1,65 @@
+/**
+ * Copyright 2015 JiKai. All rights reserved.
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file.
+ *
+ *     The workpool.h and workpool.c implement a thread
+ * pool with work stealing. it is used to compile the
+ * independent modules at the same time.
+ **/
+
+#ifndef CPLUS_WORKPOOL_H
+#define CPLUS_WORKPOOL_H
+
+#include <pthread.h>
+#include <unistd.h>
+#include "common.h"
+
+typedef void (*WorkFunc)(void* arg);
+
+typedef struct WorkTask {
+    WorkFunc func;
+    void*    arg;
+}WorkTask;
+
+// every worker owns a WorkDeque. the owner pushes and pops the tasks at
+// the tail so the latest task(usually with the hottest data) runs first,
+// and the other workers steal the tasks at the head when they are idle.
+//
+typedef struct WorkDeque {
+    pthread_mutex_t lock;
+    WorkTask*       tasks; // a ring buffer, its capacity is always a power of two
+    int64           head;
+    int64           tail;
+    int64           cap;
+}WorkDeque;
+
+// the WorkPool runs the tasks with a fixed number of workers. the tasks
+// submitted by a worker are pushed into its own deque, and the tasks
+// submitted by other threads are spread over the deques in turn.
+//
+//   pending -> the number of tasks submitted but not finished.
+//   queued  -> the number of tasks waiting in the deques, the workers
+//              sleep when it is zero.
+//
+typedef struct WorkPool {
+    pthread_t*      threads;
+    WorkDeque*      deques;
+    int32           workers;
+    pthread_mutex_t lock;
+    pthread_cond_t  cond_work;
+    pthread_cond_t  cond_done;
+    int64           pending;
+    int64           queued;
+    bool            stopping;
+    uint32          next;     // the deque which the next outside task goes into
+    int64           steals;   // the number of tasks stolen, only for statistics
+}WorkPool;
+
+extern int32 workPoolCPUCount();
+extern error workPoolInit   (WorkPool* pool, int32 workers);
+extern void  workPoolSubmit (WorkPool* pool, WorkFunc func, void* arg);
+extern void  workPoolWait   (WorkPool* pool);
+extern void  workPoolDestroy(WorkPool* pool);
+
+#endif